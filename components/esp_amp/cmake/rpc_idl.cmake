@@ -0,0 +1,57 @@
+# Generate rpc client stubs and server skeletons from an IDL file, see scripts/rpc_idl_gen.py
+# Shared by maincore (project_include.cmake) and subcore (subcore_project.cmake) builds
+#
+#   esp_amp_rpc_idl_generate(rpc_service.idl [SERVER] [OUTPUT_DIR dir])
+#
+# Call it in component CMakeLists.txt after idf_component_register(). Generated sources are added to the
+# component and the generated header <name>_rpc.h is available to the component and its dependents.
+# Pass SERVER in the project which executes the services: their link-time definitions are not referenced
+# by anything else, so the linker is told to keep them. Without it, only client stubs are linked.
+
+include_guard(GLOBAL)
+
+set(ESP_AMP_RPC_IDL_GEN ${CMAKE_CURRENT_LIST_DIR}/../scripts/rpc_idl_gen.py)
+
+function(esp_amp_rpc_idl_generate idl_file)
+
+    set(options SERVER)
+    set(single_value OUTPUT_DIR)
+    set(multi_value )
+    cmake_parse_arguments(_ "${options}" "${single_value}" "${multi_value}" ${ARGN})
+
+    if(CMAKE_BUILD_EARLY_EXPANSION)
+        return()
+    endif()
+
+    idf_build_get_property(python PYTHON)
+
+    get_filename_component(idl_path ${idl_file} ABSOLUTE BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+    get_filename_component(idl_name ${idl_file} NAME_WE)
+    if(__OUTPUT_DIR)
+        set(output_dir ${__OUTPUT_DIR})
+    else()
+        set(output_dir ${CMAKE_CURRENT_BINARY_DIR}/rpc_idl)
+    endif()
+
+    set(generated_files
+        ${output_dir}/${idl_name}_rpc.h
+        ${output_dir}/${idl_name}_rpc_client.c
+        ${output_dir}/${idl_name}_rpc_server.c
+        )
+
+    add_custom_command(
+        OUTPUT ${generated_files}
+        COMMAND ${python} ${ESP_AMP_RPC_IDL_GEN} ${idl_path} --output_dir ${output_dir}
+        DEPENDS ${idl_path} ${ESP_AMP_RPC_IDL_GEN}
+        COMMENT "Generating rpc stubs from ${idl_file}"
+        VERBATIM
+        )
+
+    target_sources(${COMPONENT_LIB} PRIVATE ${generated_files})
+    target_include_directories(${COMPONENT_LIB} PUBLIC ${output_dir})
+
+    if(__SERVER)
+        target_link_libraries(${COMPONENT_LIB} INTERFACE "-u ${idl_name}_rpc_server_include")
+    endif()
+
+endfunction()
@@ -29,6 +29,7 @@ set(CMAKE_TOOLCHAIN_FILE ${TOOLCHAIN_FLAG} CACHE PATH "" FORCE)
 set(BOOTLOADER_BUILD 1 CACHE BOOL "" FORCE)
 set(NON_OS_BUILD 1 CACHE BOOL "" FORCE)
 include("${IDF_PATH}/tools/cmake/project.cmake")
+include(${CMAKE_CURRENT_LIST_DIR}/rpc_idl.cmake)
 
 ## set build properties
 # disable subcore sdkconfig output in unified build mode
@@ -0,0 +1,173 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Host port of the functions used by queue/rpmsg code.
+ * Both cores are simulated in one thread. Software interrupts are latched by the trigger side and delivered
+ * to the registered handler by esp_amp_host_sw_intr_dispatch(), in place of the interrupt controller.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_amp_env.h"
+#include "esp_amp_platform.h"
+#include "esp_amp_sw_intr.h"
+#include "esp_amp_sys_info.h"
+#include "port_host.h"
+
+#define HOST_SHM_SIZE           (256 * 1024)
+#define HOST_SYS_INFO_NUM_MAX   (16)
+
+typedef struct {
+    uint16_t info_id;
+    uint16_t size;
+    void* buffer;
+} host_sys_info_t;
+
+/* virtqueue descriptors carry 32-bit buffer addresses, the executable is linked as non-PIE to keep this pool below 4GB */
+static uint32_t s_host_shm[HOST_SHM_SIZE / sizeof(uint32_t)];
+static uint32_t s_host_shm_used;
+static host_sys_info_t s_host_sys_info[HOST_SYS_INFO_NUM_MAX];
+static int s_host_sys_info_num;
+
+int32_t esp_amp_host_time_skew_us;
+void (*esp_amp_host_critical_hook)(void);
+
+static struct {
+    esp_amp_sw_intr_handler_t handler;
+    void* arg;
+} s_host_sw_intr[SW_INTR_ID_MAX];
+static uint32_t s_host_sw_intr_pending;
+
+void esp_amp_env_enter_critical(void)
+{
+    if (esp_amp_host_critical_hook != NULL) {
+        void (*hook)(void) = esp_amp_host_critical_hook;
+        esp_amp_host_critical_hook = NULL;
+        hook();
+    }
+}
+
+void esp_amp_env_exit_critical(void)
+{
+}
+
+int esp_amp_env_in_isr(void)
+{
+    return 0;
+}
+
+static uint64_t host_get_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint32_t esp_amp_platform_get_time_us(void)
+{
+    return (uint32_t)(host_get_time_ns() / 1000) + (uint32_t)esp_amp_host_time_skew_us;
+}
+
+uint32_t esp_amp_platform_get_time_ms(void)
+{
+    return (uint32_t)(host_get_time_ns() / 1000000);
+}
+
+void esp_amp_platform_delay_us(uint32_t time)
+{
+    usleep(time);
+}
+
+void esp_amp_platform_delay_ms(uint32_t time)
+{
+    usleep(time * 1000);
+}
+
+int esp_amp_sw_intr_add_handler(esp_amp_sw_intr_id_t intr_id, esp_amp_sw_intr_handler_t handler, void *arg)
+{
+    if (intr_id >= SW_INTR_ID_MAX || s_host_sw_intr[intr_id].handler != NULL) {
+        return -1;
+    }
+    s_host_sw_intr[intr_id].handler = handler;
+    s_host_sw_intr[intr_id].arg = arg;
+    return 0;
+}
+
+void esp_amp_sw_intr_trigger(esp_amp_sw_intr_id_t intr_id)
+{
+    if (intr_id < SW_INTR_ID_MAX) {
+        s_host_sw_intr_pending |= (1U << intr_id);
+    }
+}
+
+bool esp_amp_host_sw_intr_pending(esp_amp_sw_intr_id_t intr_id)
+{
+    return (s_host_sw_intr_pending & (1U << intr_id)) != 0;
+}
+
+int esp_amp_host_sw_intr_dispatch(void)
+{
+    int handled = 0;
+    for (int intr_id = 0; intr_id < SW_INTR_ID_MAX; intr_id++) {
+        if ((s_host_sw_intr_pending & (1U << intr_id)) == 0) {
+            continue;
+        }
+        s_host_sw_intr_pending &= ~(1U << intr_id);
+        if (s_host_sw_intr[intr_id].handler != NULL) {
+            s_host_sw_intr[intr_id].handler(s_host_sw_intr[intr_id].arg);
+            handled++;
+        }
+    }
+    return handled;
+}
+
+int esp_amp_sys_info_init(void)
+{
+    if ((uintptr_t)s_host_shm + HOST_SHM_SIZE > UINT32_MAX) {
+        fprintf(stderr, "shared memory pool is out of 32-bit address space, link as non-PIE\n");
+        return -1;
+    }
+    s_host_shm_used = 0;
+    s_host_sys_info_num = 0;
+    memset(s_host_sw_intr, 0, sizeof(s_host_sw_intr));
+    s_host_sw_intr_pending = 0;
+    return 0;
+}
+
+void* esp_amp_sys_info_alloc(uint16_t info_id, uint16_t size)
+{
+    uint32_t size_aligned = (size + 3) & ~3;
+    if (esp_amp_sys_info_get(info_id, NULL) != NULL || s_host_sys_info_num == HOST_SYS_INFO_NUM_MAX ||
+            s_host_shm_used + size_aligned > HOST_SHM_SIZE) {
+        return NULL;
+    }
+
+    host_sys_info_t* info = &s_host_sys_info[s_host_sys_info_num++];
+    info->info_id = info_id;
+    info->size = size;
+    info->buffer = (uint8_t*)s_host_shm + s_host_shm_used;
+    s_host_shm_used += size_aligned;
+    return info->buffer;
+}
+
+void* esp_amp_sys_info_get(uint16_t info_id, uint16_t* size)
+{
+    for (int i = 0; i < s_host_sys_info_num; i++) {
+        if (s_host_sys_info[i].info_id == info_id) {
+            if (size != NULL) {
+                *size = s_host_sys_info[i].size;
+            }
+            return s_host_sys_info[i].buffer;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,24 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_amp_sw_intr.h"
+
+/* added to esp_amp_platform_get_time_us(), switch it while running one side to emulate unsynchronized core clocks */
+extern int32_t esp_amp_host_time_skew_us;
+
+/* called once from the next esp_amp_env_enter_critical(), then cleared. Emulates the other core acting at that point */
+extern void (*esp_amp_host_critical_hook)(void);
+
+/* whether the software interrupt is triggered and not yet delivered */
+bool esp_amp_host_sw_intr_pending(esp_amp_sw_intr_id_t intr_id);
+
+/* deliver all pending software interrupts to their handlers, return the number of handlers invoked */
+int esp_amp_host_sw_intr_dispatch(void);
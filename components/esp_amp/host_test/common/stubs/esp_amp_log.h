@@ -0,0 +1,25 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/* host replacement of priv_include/esp_amp_log.h, logs go to stderr */
+
+#pragma once
+
+#include <stdio.h>
+
+#define ESP_AMP_HOST_LOG(level, tag, format, ...) fprintf(stderr, level " (%s) " format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_AMP_LOGE(tag, format, ...) ESP_AMP_HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_AMP_LOGW(tag, format, ...) ESP_AMP_HOST_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_AMP_LOGI(tag, format, ...) ESP_AMP_HOST_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_AMP_LOGD(tag, format, ...) do { } while (0)
+#define ESP_AMP_LOGV(tag, format, ...) do { } while (0)
+
+#define ESP_AMP_DRAM_LOGE ESP_AMP_LOGE
+#define ESP_AMP_DRAM_LOGW ESP_AMP_LOGW
+#define ESP_AMP_DRAM_LOGI ESP_AMP_LOGI
+#define ESP_AMP_DRAM_LOGD ESP_AMP_LOGD
+#define ESP_AMP_DRAM_LOGV ESP_AMP_LOGV
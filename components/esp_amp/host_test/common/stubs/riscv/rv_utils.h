@@ -0,0 +1,9 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/* host build: CSR accessors are guarded by __riscv in esp_amp_arch.h */
+
+#pragma once
@@ -0,0 +1,30 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/* sdkconfig used by host tests, only options read by the sources built on host */
+
+#pragma once
+
+#define CONFIG_ESP_AMP_ENABLED 1
+#define CONFIG_ESP_AMP_RPMSG_ADAPTIVE_INTR_BUDGET 8
+#define CONFIG_ESP_AMP_RPMSG_ADAPTIVE_POLL_BUDGET 16
+#define CONFIG_ESP_AMP_RPMSG_TRACE 1
+#define CONFIG_ESP_AMP_RPMSG_TRACE_RECORD_NUM 1024
+#define CONFIG_ESP_AMP_RPMSG_TRACE_PAYLOAD_LEN 16
+#define CONFIG_ESP_AMP_RPMSG_SERIAL_ITEM_SIZE 128
+#define CONFIG_ESP_AMP_RPMSG_SERIAL_TX_BUF_NUM 4
+#define CONFIG_ESP_AMP_RPMSG_SERIAL_RX_BUF_NUM 4
+#define CONFIG_ESP_AMP_RPMSG_TIMESTAMP 1
+#define CONFIG_ESP_AMP_PUBSUB_REMOTE_TOPIC_NUM 2
+#define CONFIG_ESP_AMP_RPC_MAX_PENDING_REQ 8
+#define CONFIG_ESP_AMP_RPC_BATCH_MAX_REQ 8
+#define CONFIG_ESP_AMP_RPC_CLIENT_INSTANCE_NUM 1
+#define CONFIG_ESP_AMP_RPC_SERVER_INSTANCE_NUM 1
+#define CONFIG_ESP_AMP_RPC_METRICS 1
+#define CONFIG_ESP_AMP_RPC_METRICS_SERVICE_NUM 4
+#define CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM 4
+#define CONFIG_ESP_AMP_RPC_CLIENT_CACHE_DATA_LEN 16
+#define CONFIG_ESP_AMP_RPC_PRIORITY_NUM 4
@@ -0,0 +1,232 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Pub/sub brokers on main-core and sub-core rpmsg devices in one process. Sub-core publishes, main-core subscribes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_amp_sys_info.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_pubsub.h"
+#include "test_utils.h"
+
+#define TEST_SYSINFO_ID         (0x100)
+#define TEST_BROKER_ADDR        (0x20)
+#define TEST_QUEUE_LEN          (4)
+#define TEST_HELD_MAX           (8)
+
+typedef struct {
+    bool hold;                                  /* keep messages instead of releasing them in the callback */
+    int rx_cnt;
+    int held_num;
+    esp_amp_pubsub_msg_t* held[TEST_HELD_MAX];
+    uint32_t last_val;
+} test_subscriber_t;
+
+static esp_amp_rpmsg_dev_t s_main_dev;
+static esp_amp_rpmsg_dev_t s_sub_dev;
+static esp_amp_pubsub_t s_main_broker;
+static esp_amp_pubsub_t s_sub_broker;
+
+static void test_sub_cb(esp_amp_pubsub_msg_t* msg, uint32_t topic_id, void* data, uint16_t data_len, void* cb_arg)
+{
+    test_subscriber_t* subscriber = (test_subscriber_t*)cb_arg;
+    subscriber->rx_cnt++;
+    memcpy(&subscriber->last_val, data, sizeof(uint32_t));
+    if (subscriber->hold && subscriber->held_num < TEST_HELD_MAX) {
+        subscriber->held[subscriber->held_num++] = msg;
+    } else {
+        esp_amp_pubsub_msg_release(&s_main_broker, msg);
+    }
+}
+
+static void test_poll(void)
+{
+    for (int i = 0; i < 2; i++) {
+        while (esp_amp_rpmsg_poll(&s_sub_dev) == 0) {
+        }
+        while (esp_amp_rpmsg_poll(&s_main_dev) == 0) {
+        }
+    }
+}
+
+static int test_publish(uint32_t topic_id, uint32_t val)
+{
+    return esp_amp_pubsub_publish(&s_sub_broker, topic_id, &val, sizeof(val));
+}
+
+static int test_interest_gating(void)
+{
+    static esp_amp_pubsub_sub_t sub0;
+    static esp_amp_pubsub_sub_t sub1;
+    static test_subscriber_t subscriber0;
+    static test_subscriber_t subscriber1;
+    uint32_t topic = esp_amp_pubsub_topic_id("gating");
+    uint32_t other = esp_amp_pubsub_topic_id("other");
+
+    /* nobody subscribes yet, nothing crosses the core boundary */
+    TEST_ASSERT(test_publish(topic, 1) == 1);
+
+    TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &sub0, topic, test_sub_cb, &subscriber0) == 0);
+    TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &sub1, topic, test_sub_cb, &subscriber1) == 0);
+    test_poll();
+    TEST_ASSERT(esp_amp_pubsub_has_remote_subscriber(&s_sub_broker, topic));
+    TEST_ASSERT(s_sub_broker.remote_topic_num == 1);
+    TEST_ASSERT(test_publish(other, 2) == 1);
+
+    TEST_ASSERT(test_publish(topic, 3) == 0);
+    test_poll();
+    TEST_ASSERT(subscriber0.rx_cnt == 1 && subscriber1.rx_cnt == 1 && subscriber1.last_val == 3);
+
+    /* topic stays announced until its last local subscriber leaves */
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &sub0) == 0);
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &sub0) == -1);
+    test_poll();
+    TEST_ASSERT(esp_amp_pubsub_has_remote_subscriber(&s_sub_broker, topic));
+
+    /* published before the unsubscription arrives: dropped on arrival and its buffer given back */
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        TEST_ASSERT(test_publish(topic, 4) == 0);
+    }
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &sub1) == 0);
+    test_poll();
+    TEST_ASSERT(subscriber1.rx_cnt == 1);
+    TEST_ASSERT(!esp_amp_pubsub_has_remote_subscriber(&s_sub_broker, topic));
+    TEST_ASSERT(test_publish(topic, 5) == 1);
+
+    /* all buffers are back */
+    TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &sub1, topic, test_sub_cb, &subscriber1) == 0);
+    test_poll();
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        TEST_ASSERT(test_publish(topic, 6) == 0);
+    }
+    test_poll();
+    TEST_ASSERT(subscriber1.rx_cnt == 1 + TEST_QUEUE_LEN);
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &sub1) == 0);
+    test_poll();
+    TEST_ASSERT(s_sub_broker.remote_topic_num == 0);
+    return 0;
+}
+
+static int test_multi_subscriber_release(void)
+{
+    static esp_amp_pubsub_sub_t sub0;
+    static esp_amp_pubsub_sub_t sub1;
+    static esp_amp_pubsub_sub_t sub2;
+    static test_subscriber_t subscriber0 = { .hold = true };
+    static test_subscriber_t subscriber1 = { .hold = true };
+    static test_subscriber_t subscriber2 = { .hold = false };
+    uint32_t topic = esp_amp_pubsub_topic_id("shared");
+
+    TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &sub0, topic, test_sub_cb, &subscriber0) == 0);
+    TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &sub1, topic, test_sub_cb, &subscriber1) == 0);
+    TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &sub2, topic, test_sub_cb, &subscriber2) == 0);
+    test_poll();
+
+    /* every buffer is delivered in place to three subscribers, two of them keep it */
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        TEST_ASSERT(test_publish(topic, 10 + i) == 0);
+    }
+    TEST_ASSERT(test_publish(topic, 99) == -1);
+    test_poll();
+    TEST_ASSERT(subscriber0.held_num == TEST_QUEUE_LEN && subscriber1.held_num == TEST_QUEUE_LEN);
+    TEST_ASSERT(subscriber2.rx_cnt == TEST_QUEUE_LEN && subscriber2.last_val == 10 + TEST_QUEUE_LEN - 1);
+    TEST_ASSERT(subscriber0.held[0] == subscriber1.held[0]);
+    TEST_ASSERT(test_publish(topic, 99) == -1);
+
+    /* one subscriber releases everything in reverse order, the other one still holds every buffer */
+    for (int i = TEST_QUEUE_LEN - 1; i >= 0; i--) {
+        esp_amp_pubsub_msg_release(&s_main_broker, subscriber0.held[i]);
+    }
+    subscriber0.held_num = 0;
+    TEST_ASSERT(test_publish(topic, 99) == -1);
+
+    /* last reference of each buffer in shuffled order, one buffer back per release */
+    static const int order[TEST_QUEUE_LEN] = { 2, 0, 3, 1 };
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        esp_amp_pubsub_msg_release(&s_main_broker, subscriber1.held[order[i]]);
+        TEST_ASSERT(test_publish(topic, 20 + i) == 0);
+        TEST_ASSERT(test_publish(topic, 99) == -1);
+    }
+    subscriber1.held_num = 0;
+
+    /* released inside the callbacks this time */
+    subscriber0.hold = false;
+    subscriber1.hold = false;
+    test_poll();
+    TEST_ASSERT(subscriber0.rx_cnt == 2 * TEST_QUEUE_LEN && subscriber1.rx_cnt == 2 * TEST_QUEUE_LEN);
+    TEST_ASSERT(subscriber1.last_val == 20 + TEST_QUEUE_LEN - 1);
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        TEST_ASSERT(test_publish(topic, 30) == 0);
+    }
+    test_poll();
+
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &sub0) == 0);
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &sub1) == 0);
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &sub2) == 0);
+    test_poll();
+    return 0;
+}
+
+static int test_topic_table_full(void)
+{
+    static esp_amp_pubsub_sub_t subs[4];
+    static test_subscriber_t subscriber;
+    uint32_t topics[3] = {
+        esp_amp_pubsub_topic_id("t0"), esp_amp_pubsub_topic_id("t1"), esp_amp_pubsub_topic_id("t2"),
+    };
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &subs[i], topics[i], test_sub_cb, &subscriber) == 0);
+    }
+    test_poll();
+
+    /* the third topic doesn't fit in the table of the other core, which replies with a rejection */
+    TEST_ASSERT(s_sub_broker.remote_topic_num == 2);
+    TEST_ASSERT(!esp_amp_pubsub_has_remote_subscriber(&s_sub_broker, topics[2]));
+    TEST_ASSERT(!subs[0].rejected && !subs[1].rejected && subs[2].rejected);
+    TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &subs[3], topics[2], test_sub_cb, &subscriber) == 0);
+    TEST_ASSERT(subs[3].rejected);
+
+    /* room is made on the other core, subscribe again */
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &subs[0]) == 0);
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &subs[2]) == 0);
+    TEST_ASSERT(esp_amp_pubsub_unsubscribe(&s_main_broker, &subs[3]) == 0);
+    test_poll();
+    TEST_ASSERT(esp_amp_pubsub_subscribe(&s_main_broker, &subs[2], topics[2], test_sub_cb, &subscriber) == 0);
+    test_poll();
+    TEST_ASSERT(!subs[2].rejected);
+    TEST_ASSERT(esp_amp_pubsub_has_remote_subscriber(&s_sub_broker, topics[2]));
+    TEST_ASSERT(test_publish(topics[2], 40) == 0);
+    test_poll();
+    TEST_ASSERT(subscriber.rx_cnt == 1 && subscriber.last_val == 40);
+    return 0;
+}
+
+int main(void)
+{
+    static esp_amp_queue_t main_vqueue[2];
+    static esp_amp_queue_t sub_vqueue[2];
+
+    if (esp_amp_sys_info_init() != 0 ||
+            esp_amp_rpmsg_main_init_by_id(&s_main_dev, main_vqueue, TEST_QUEUE_LEN, 64, false, true, TEST_SYSINFO_ID) != 0 ||
+            esp_amp_rpmsg_sub_init_by_id(&s_sub_dev, sub_vqueue, false, true, TEST_SYSINFO_ID) != 0 ||
+            esp_amp_pubsub_init(&s_main_broker, &s_main_dev, TEST_BROKER_ADDR) != 0 ||
+            esp_amp_pubsub_init(&s_sub_broker, &s_sub_dev, TEST_BROKER_ADDR) != 0) {
+        fprintf(stderr, "failed to init pubsub brokers\n");
+        return 1;
+    }
+    test_poll();
+
+    int ret = test_interest_gating() || test_multi_subscriber_release() || test_topic_table_full();
+
+    printf("pubsub test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
@@ -0,0 +1,210 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_amp_rpc_batch_priv.h"
+#include "test_utils.h"
+
+#define TEST_SRV_ADD 1
+#define TEST_SRV_ECHO 2
+#define TEST_SRV_FAIL 3
+#define TEST_SRV_NONE 4
+
+#define TEST_PKT_SIZE 256
+
+static uint32_t s_batch_buf[TEST_PKT_SIZE / 4];
+static uint32_t s_rsp_buf[TEST_PKT_SIZE / 4];
+
+static int s_acquired;
+static int s_released;
+static int s_batch_calls;
+static int s_batch_items;
+
+/* sum of two uint32 */
+static esp_amp_rpc_status_t add_handler(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    uint32_t in[2];
+    uint32_t out;
+    if (params_in_len != sizeof(in) || *params_out_len < sizeof(out)) {
+        return ESP_AMP_RPC_STATUS_EXEC_FAILED;
+    }
+    memcpy(in, params_in, sizeof(in));
+    out = in[0] + in[1];
+    memcpy(params_out, &out, sizeof(out));
+    *params_out_len = sizeof(out);
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static void add_batch_handler(esp_amp_rpc_batch_item_t *items, int num)
+{
+    s_batch_calls++;
+    s_batch_items += num;
+    for (int i = 0; i < num; i++) {
+        if (add_handler(items[i].params_in, items[i].params_in_len, items[i].params_out, &items[i].params_out_len) != ESP_AMP_RPC_STATUS_OK) {
+            items[i].status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
+        }
+    }
+}
+
+static esp_amp_rpc_status_t echo_handler(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    if (params_in_len > *params_out_len) {
+        return ESP_AMP_RPC_STATUS_EXEC_FAILED;
+    }
+    memcpy(params_out, params_in, params_in_len);
+    *params_out_len = params_in_len;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static esp_amp_rpc_status_t fail_handler(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    return ESP_AMP_RPC_STATUS_EXEC_FAILED;
+}
+
+static esp_amp_rpc_service_t s_services[] = {
+    { .id = TEST_SRV_ADD, .handler = add_handler },
+    { .id = TEST_SRV_ECHO, .handler = echo_handler },
+    { .id = TEST_SRV_FAIL, .handler = fail_handler },
+};
+
+static const esp_amp_rpc_service_t *test_acquire(void *arg, uint16_t service_id, int idx, int num)
+{
+    for (int i = 0; i < sizeof(s_services) / sizeof(s_services[0]); i++) {
+        if (s_services[i].id == service_id) {
+            s_acquired += num;
+            return &s_services[i];
+        }
+    }
+    return NULL;
+}
+
+static void test_release(void *arg, int idx, int num)
+{
+    s_released += num;
+}
+
+static const esp_amp_rpc_batch_ops_t s_ops = {
+    .acquire = test_acquire,
+    .release = test_release,
+};
+
+static esp_amp_rpc_pkt_t *test_batch_init(void)
+{
+    esp_amp_rpc_pkt_t *batch = (esp_amp_rpc_pkt_t *)s_batch_buf;
+    memset(s_batch_buf, 0, sizeof(s_batch_buf));
+    batch->service_id = ESP_AMP_RPC_BATCH_SERVICE_ID;
+    return batch;
+}
+
+static int test_append(void)
+{
+    esp_amp_rpc_pkt_t *batch = test_batch_init();
+    uint32_t capacity = TEST_PKT_SIZE - sizeof(esp_amp_rpc_pkt_t);
+    uint8_t data[5] = { 1, 2, 3, 4, 5 };
+
+    TEST_ASSERT(esp_amp_rpc_batch_count(batch->params, batch->params_len) == 0);
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ECHO, data, sizeof(data)) == 0);
+    TEST_ASSERT(batch->params_len == sizeof(esp_amp_rpc_pkt_t) + 8);
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ECHO, NULL, 0) == 1);
+    TEST_ASSERT(esp_amp_rpc_batch_count(batch->params, batch->params_len) == 2);
+
+    /* no room for the sub-request */
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ECHO, NULL, capacity) == -1);
+    TEST_ASSERT(esp_amp_rpc_batch_count(batch->params, batch->params_len) == 2);
+
+    /* no more than ESP_AMP_RPC_BATCH_MAX_REQ sub-requests */
+    batch = test_batch_init();
+    for (int i = 0; i < ESP_AMP_RPC_BATCH_MAX_REQ; i++) {
+        TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ECHO, NULL, 0) == i);
+    }
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ECHO, NULL, 0) == -1);
+
+    /* sub-request running past the end */
+    batch = test_batch_init();
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ECHO, data, sizeof(data)) == 0);
+    batch->params_len -= 4;
+    TEST_ASSERT(esp_amp_rpc_batch_count(batch->params, batch->params_len) == -1);
+    return 0;
+}
+
+static int test_execute(void)
+{
+    esp_amp_rpc_pkt_t *batch = test_batch_init();
+    uint32_t capacity = TEST_PKT_SIZE - sizeof(esp_amp_rpc_pkt_t);
+    uint32_t add[3][2] = { { 1, 2 }, { 10, 20 }, { 100, 200 } };
+    uint8_t data[3] = { 'a', 'b', 'c' };
+
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ADD, add[0], sizeof(add[0])) == 0);
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ADD, add[1], sizeof(add[1])) == 1);
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ECHO, data, sizeof(data)) == 2);
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_NONE, NULL, 0) == 3);
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_FAIL, NULL, 0) == 4);
+    TEST_ASSERT(esp_amp_rpc_batch_append(batch, capacity, TEST_SRV_ADD, add[2], sizeof(add[2])) == 5);
+
+    s_services[0].batch_handler = add_batch_handler;
+    s_acquired = s_released = s_batch_calls = s_batch_items = 0;
+    int len = esp_amp_rpc_batch_execute(batch->params, batch->params_len, s_rsp_buf, capacity, &s_ops);
+    TEST_ASSERT(len > 0);
+
+    /* runs of the same service are passed to batch handler at once, missing service is not acquired */
+    TEST_ASSERT(s_batch_calls == 2 && s_batch_items == 3);
+    TEST_ASSERT(s_acquired == 5 && s_released == 5);
+
+    /* sub-responses are compacted in request order */
+    uint32_t sum;
+    int i = 0;
+    for (esp_amp_rpc_pkt_t *rsp = esp_amp_rpc_batch_next(s_rsp_buf, len, NULL); rsp != NULL; rsp = esp_amp_rpc_batch_next(s_rsp_buf, len, rsp), i++) {
+        TEST_ASSERT(rsp->req_id == i);
+        switch (i) {
+        case 0:
+        case 1:
+        case 5:
+            TEST_ASSERT(rsp->service_id == TEST_SRV_ADD && rsp->status == ESP_AMP_RPC_STATUS_OK && rsp->params_len == sizeof(sum));
+            memcpy(&sum, rsp->params, sizeof(sum));
+            TEST_ASSERT(sum == add[i == 5 ? 2 : i][0] + add[i == 5 ? 2 : i][1]);
+            break;
+        case 2:
+            TEST_ASSERT(rsp->status == ESP_AMP_RPC_STATUS_OK && rsp->params_len == sizeof(data));
+            TEST_ASSERT(memcmp(rsp->params, data, sizeof(data)) == 0);
+            break;
+        case 3:
+            TEST_ASSERT(rsp->status == ESP_AMP_RPC_STATUS_NO_SERVICE && rsp->params_len == 0);
+            break;
+        case 4:
+            TEST_ASSERT(rsp->status == ESP_AMP_RPC_STATUS_EXEC_FAILED && rsp->params_len == 0);
+            break;
+        }
+    }
+    TEST_ASSERT(i == 6);
+
+    /* per-item handler is used without batch handler */
+    s_services[0].batch_handler = NULL;
+    s_batch_calls = 0;
+    TEST_ASSERT(esp_amp_rpc_batch_execute(batch->params, batch->params_len, s_rsp_buf, capacity, &s_ops) == len);
+    TEST_ASSERT(s_batch_calls == 0);
+
+    /* response slot too small for a header per sub-request, nothing is executed */
+    s_acquired = 0;
+    TEST_ASSERT(esp_amp_rpc_batch_execute(batch->params, batch->params_len, s_rsp_buf, 6 * sizeof(esp_amp_rpc_pkt_t) - 1, &s_ops) == -1);
+    TEST_ASSERT(s_acquired == 0);
+
+    /* empty batch */
+    batch = test_batch_init();
+    TEST_ASSERT(esp_amp_rpc_batch_execute(batch->params, batch->params_len, s_rsp_buf, capacity, &s_ops) == 0);
+    TEST_ASSERT(esp_amp_rpc_batch_next(s_rsp_buf, 0, NULL) == NULL);
+    return 0;
+}
+
+int main(void)
+{
+    int ret = test_append() || test_execute();
+
+    printf("rpc batch test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
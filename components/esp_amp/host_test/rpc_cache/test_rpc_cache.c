@@ -0,0 +1,307 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_amp_rpc_cache_priv.h"
+#include "port_host.h"
+#include "test_utils.h"
+
+#define SRV_STATUS  (1)
+#define SRV_OTHER   (2)
+
+static esp_amp_rpc_cache_t s_cache;
+
+/* request served from cache returns its response, or -1 on miss. entry is released either way */
+static int cached_rsp(uint16_t service_id, uint32_t param, uint32_t now_ms)
+{
+    bool hit = false;
+    uint32_t rsp = 0;
+    uint16_t rsp_len = 0;
+
+    int idx = esp_amp_rpc_cache_acquire(&s_cache, service_id, &param, sizeof(param), now_ms, &hit);
+    if (idx != -1 && hit) {
+        memcpy(&rsp, esp_amp_rpc_cache_get_rsp(&s_cache, idx, &rsp_len), sizeof(rsp));
+    }
+    if (idx != -1) {
+        esp_amp_rpc_cache_release(&s_cache, idx);
+    }
+    return hit && rsp_len == sizeof(rsp) ? (int)rsp : -1;
+}
+
+/* request missing the cache, filled with rsp */
+static int fill(uint16_t service_id, uint32_t param, uint32_t rsp, uint32_t now_ms)
+{
+    bool hit = true;
+    int idx = esp_amp_rpc_cache_acquire(&s_cache, service_id, &param, sizeof(param), now_ms, &hit);
+    if (idx == -1 || hit) {
+        return -1;
+    }
+    esp_amp_rpc_cache_fill(&s_cache, idx, &rsp, sizeof(rsp), now_ms);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    return 0;
+}
+
+static int test_hit_and_ttl(void)
+{
+    bool hit;
+
+    esp_amp_rpc_cache_init(&s_cache);
+
+    /* service not configured is never cached */
+    TEST_ASSERT(esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, NULL, 0, 0, &hit) == -1);
+
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, SRV_STATUS, 100) == 0);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 7, 0) == -1);
+    TEST_ASSERT(fill(SRV_STATUS, 7, 70, 1000) == 0);
+
+    /* same params hit until ttl expires, other params and services miss */
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 7, 1000) == 70);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 7, 1099) == 70);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 8, 1050) == -1);
+    TEST_ASSERT(cached_rsp(SRV_OTHER, 7, 1050) == -1);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 7, 1100) == -1);
+
+    /* ms counter wraps within ttl */
+    TEST_ASSERT(fill(SRV_STATUS, 7, 71, UINT32_MAX - 10) == 0);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 7, 50) == 71);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 7, 89) == -1);
+
+    /* ttl 0 stops caching */
+    TEST_ASSERT(fill(SRV_STATUS, 7, 72, 0) == 0);
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, SRV_STATUS, 0) == 0);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 7, 0) == -1);
+    TEST_ASSERT(esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, NULL, 0, 0, &hit) == -1);
+
+    /* no more policy slots */
+    for (int i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+        TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, 10 + i, 100) == 0);
+    }
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, 100, 100) == -1);
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, 10, 200) == 0);
+    return 0;
+}
+
+static int test_invalidate(void)
+{
+    esp_amp_rpc_cache_init(&s_cache);
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, SRV_STATUS, 1000) == 0);
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, SRV_OTHER, 1000) == 0);
+
+    TEST_ASSERT(fill(SRV_STATUS, 1, 10, 0) == 0);
+    TEST_ASSERT(fill(SRV_OTHER, 1, 20, 0) == 0);
+    esp_amp_rpc_cache_invalidate(&s_cache, SRV_STATUS);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 1, 0) == -1);
+    TEST_ASSERT(cached_rsp(SRV_OTHER, 1, 0) == 20);
+
+    /* response in flight during invalidation may be old, it is not cached */
+    bool hit;
+    uint32_t param = 1;
+    uint32_t rsp = 11;
+    int idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &hit);
+    TEST_ASSERT(idx != -1 && !hit);
+    esp_amp_rpc_cache_invalidate(&s_cache, SRV_STATUS);
+    esp_amp_rpc_cache_fill(&s_cache, idx, &rsp, sizeof(rsp), 0);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 1, 0) == -1);
+
+    /* response held by a req stays readable after invalidation */
+    TEST_ASSERT(fill(SRV_STATUS, 1, 12, 0) == 0);
+    idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &hit);
+    TEST_ASSERT(idx != -1 && hit);
+    esp_amp_rpc_cache_invalidate(&s_cache, SRV_STATUS);
+    uint16_t rsp_len;
+    const void *held = esp_amp_rpc_cache_get_rsp(&s_cache, idx, &rsp_len);
+    TEST_ASSERT(rsp_len == sizeof(uint32_t) && memcmp(held, &(uint32_t){12}, sizeof(uint32_t)) == 0);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 1, 0) == -1);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    return 0;
+}
+
+static int test_eviction(void)
+{
+    bool hit;
+    uint32_t param = 0;
+
+    esp_amp_rpc_cache_init(&s_cache);
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, SRV_STATUS, 1000) == 0);
+
+    for (uint32_t i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+        TEST_ASSERT(fill(SRV_STATUS, i, i * 10, 0) == 0);
+    }
+    /* use 0 again, 1 is the least recently used */
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 0, 0) == 0);
+    TEST_ASSERT(fill(SRV_STATUS, 100, 1000, 0) == 0);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 1, 0) == -1);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 0, 0) == 0);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 100, 0) == 1000);
+
+    /* refilling the same request reuses its entry */
+    TEST_ASSERT(fill(SRV_STATUS, 100, 1001, 2000) == 0);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 100, 2000) == 1001);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 0, 0) == 0);
+
+    /* entries held by reqs are never evicted */
+    int held[ESP_AMP_RPC_CACHE_NUM];
+    for (int i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+        param = 200 + i;
+        held[i] = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &hit);
+        TEST_ASSERT(held[i] != -1 && !hit);
+    }
+    param = 300;
+    TEST_ASSERT(esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &hit) == -1);
+
+    /* reqs failed without response, entries are freed */
+    for (int i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+        esp_amp_rpc_cache_release(&s_cache, held[i]);
+    }
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 200, 0) == -1);
+    TEST_ASSERT(fill(SRV_STATUS, 300, 3000, 0) == 0);
+    return 0;
+}
+
+static int test_too_large(void)
+{
+    bool hit;
+    uint8_t params[ESP_AMP_RPC_CACHE_DATA_LEN + 1] = { 0 };
+    uint8_t rsp[ESP_AMP_RPC_CACHE_DATA_LEN] = { 0 };
+
+    esp_amp_rpc_cache_init(&s_cache);
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, SRV_STATUS, 1000) == 0);
+
+    /* params alone too large */
+    TEST_ASSERT(esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, params, sizeof(params), 0, &hit) == -1);
+
+    /* params filled later by caller */
+    TEST_ASSERT(esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, NULL, 4, 0, &hit) == -1);
+
+    /* params and response too large */
+    int idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, params, 4, 0, &hit);
+    TEST_ASSERT(idx != -1 && !hit);
+    esp_amp_rpc_cache_fill(&s_cache, idx, rsp, sizeof(rsp), 0);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, params, 4, 0, &hit);
+    TEST_ASSERT(idx != -1 && !hit);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+
+    /* empty params and response */
+    idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, NULL, 0, 0, &hit);
+    TEST_ASSERT(idx != -1 && !hit);
+    esp_amp_rpc_cache_fill(&s_cache, idx, NULL, 0, 0);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, NULL, 0, 0, &hit);
+    TEST_ASSERT(idx != -1 && hit);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    return 0;
+}
+
+static int test_hash_collision(void)
+{
+    bool hit;
+    /* different params of the same fnv-1a hash */
+    const uint8_t params_a[8] = { 0x33, 0xac, 0x00, 0x55, 0x65, 0x00, 0x00, 0x00 };
+    const uint8_t params_b[8] = { 0xd6, 0x84, 0x02, 0x55, 0xda, 0x00, 0x00, 0x00 };
+    uint32_t rsp = 10;
+
+    esp_amp_rpc_cache_init(&s_cache);
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, SRV_STATUS, 1000) == 0);
+
+    int idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, params_a, sizeof(params_a), 0, &hit);
+    TEST_ASSERT(idx != -1 && !hit);
+    esp_amp_rpc_cache_fill(&s_cache, idx, &rsp, sizeof(rsp), 0);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+
+    /* matched by hash, told apart by params: not served, and the entry is not left held */
+    TEST_ASSERT(esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, params_b, sizeof(params_b), 0, &hit) == -1);
+    TEST_ASSERT(!hit);
+    TEST_ASSERT(s_cache.entries[idx].refs == 0);
+
+    idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, params_a, sizeof(params_a), 0, &hit);
+    TEST_ASSERT(idx != -1 && hit);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    return 0;
+}
+
+/* the other task acts while fill copies the response: fill takes the lock once before the copy and once after it */
+static void (*s_in_copy)(void);
+static int s_in_copy_idx;
+static bool s_in_copy_hit;
+
+static void in_copy_hook(void)
+{
+    esp_amp_host_critical_hook = s_in_copy;
+}
+
+static void in_copy_acquire(void)
+{
+    uint32_t param = 1;
+    s_in_copy_idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &s_in_copy_hit);
+}
+
+static void in_copy_invalidate(void)
+{
+    esp_amp_rpc_cache_invalidate(&s_cache, SRV_STATUS);
+}
+
+static int test_fill_concurrent(void)
+{
+    bool hit;
+    uint32_t param = 1;
+    uint32_t rsp = 10;
+
+    esp_amp_rpc_cache_init(&s_cache);
+    TEST_ASSERT(esp_amp_rpc_cache_config(&s_cache, SRV_STATUS, 1000) == 0);
+
+    /* same request acquired while the response is copied: entry is not served half written, another one is taken */
+    int idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &hit);
+    TEST_ASSERT(idx != -1 && !hit);
+    s_in_copy = in_copy_acquire;
+    esp_amp_host_critical_hook = in_copy_hook;
+    esp_amp_rpc_cache_fill(&s_cache, idx, &rsp, sizeof(rsp), 0);
+    TEST_ASSERT(esp_amp_host_critical_hook == NULL);
+    TEST_ASSERT(s_in_copy_idx != -1 && s_in_copy_idx != idx && !s_in_copy_hit);
+    esp_amp_rpc_cache_release(&s_cache, s_in_copy_idx);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 1, 0) == 10);
+    TEST_ASSERT(s_cache.entries[s_in_copy_idx].state == CACHE_FREE);
+
+    /* invalidated while the response is copied: not cached */
+    idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &hit);
+    TEST_ASSERT(idx != -1 && hit);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    esp_amp_rpc_cache_invalidate(&s_cache, SRV_STATUS);
+    idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &hit);
+    TEST_ASSERT(idx != -1 && !hit);
+    s_in_copy = in_copy_invalidate;
+    esp_amp_host_critical_hook = in_copy_hook;
+    esp_amp_rpc_cache_fill(&s_cache, idx, &rsp, sizeof(rsp), 0);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 1, 0) == -1);
+
+    /* req destroyed while its entry is filled by the rsp path holding it */
+    idx = esp_amp_rpc_cache_acquire(&s_cache, SRV_STATUS, &param, sizeof(param), 0, &hit);
+    TEST_ASSERT(idx != -1 && !hit);
+    esp_amp_rpc_cache_hold(&s_cache, idx);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    TEST_ASSERT(s_cache.entries[idx].state == CACHE_FILLING);
+    esp_amp_rpc_cache_fill(&s_cache, idx, &rsp, sizeof(rsp), 0);
+    esp_amp_rpc_cache_release(&s_cache, idx);
+    TEST_ASSERT(s_cache.entries[idx].refs == 0);
+    TEST_ASSERT(cached_rsp(SRV_STATUS, 1, 0) == 10);
+    return 0;
+}
+
+int main(void)
+{
+    int ret = test_hit_and_ttl() || test_invalidate() || test_eviction() || test_too_large() || test_hash_collision()
+              || test_fill_concurrent();
+
+    printf("rpc cache test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
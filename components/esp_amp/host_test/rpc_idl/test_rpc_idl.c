@@ -0,0 +1,183 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_amp_rpc_service_priv.h"
+#include "test_rpc.h"
+#include "test_utils.h"
+
+#define TEST_BUF_SIZE 64
+
+/*
+ * loopback rpc client and server, requests are dispatched in place to services defined at link time.
+ * Params of both directions follow a packet header, as in the rpmsg buffer, so they are only 4-byte aligned
+ */
+static union {
+    uint64_t align;
+    uint8_t buf[sizeof(esp_amp_rpc_pkt_t) + TEST_BUF_SIZE];
+} s_rsp;
+static uint8_t *const s_rsp_buf = s_rsp.buf + sizeof(esp_amp_rpc_pkt_t);
+static int s_reset_cnt;
+
+static esp_amp_rpc_service_func_t test_find_service(uint16_t service_id)
+{
+    int idx = esp_amp_rpc_service_static_find(service_id);
+    return idx == -1 ? NULL : esp_amp_rpc_service_static_get(idx)->handler;
+}
+
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id, void *params_in, uint16_t params_in_len)
+{
+    esp_amp_rpc_pkt_t *pkt = calloc(1, sizeof(esp_amp_rpc_pkt_t) + params_in_len);
+    if (pkt == NULL) {
+        return NULL;
+    }
+    pkt->service_id = service_id;
+    pkt->params_len = params_in_len;
+    if (params_in != NULL) {
+        memcpy(pkt->params, params_in, params_in_len);
+    }
+    return pkt;
+}
+
+void *esp_amp_rpc_client_get_request_params(esp_amp_rpc_req_handle_t req)
+{
+    return ((esp_amp_rpc_pkt_t *)req)->params;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_execute_request(esp_amp_rpc_req_handle_t req, void **params_out, int *params_out_len, uint32_t timeout_ms)
+{
+    esp_amp_rpc_pkt_t *pkt = (esp_amp_rpc_pkt_t *)req;
+    esp_amp_rpc_service_func_t service = test_find_service(pkt->service_id);
+    uint16_t len = TEST_BUF_SIZE;
+
+    if (service == NULL) {
+        return ESP_AMP_RPC_STATUS_NO_SERVICE;
+    }
+    if (service(pkt->params, pkt->params_len, s_rsp_buf, &len) != 0) {
+        return ESP_AMP_RPC_STATUS_EXEC_FAILED;
+    }
+    *params_out = s_rsp_buf;
+    *params_out_len = len;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+void esp_amp_rpc_client_destroy_request(esp_amp_rpc_req_handle_t req)
+{
+    free(req);
+}
+
+/* handlers implemented by application */
+esp_amp_rpc_status_t test_add_handler(int32_t a, uint8_t scale, int64_t b, int64_t *sum)
+{
+    *sum = (int64_t)a * scale + b;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t test_checksum_handler(const uint8_t data[16], uint8_t digest[4], bool *ok)
+{
+    memset(digest, 0, 4);
+    for (int i = 0; i < 16; i++) {
+        digest[i % 4] ^= data[i];
+    }
+    *ok = true;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t test_reset_handler(void)
+{
+    s_reset_cnt++;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static int test_layout(void)
+{
+    /* fields are ordered by alignment, no padding between them */
+    TEST_ASSERT(sizeof(test_add_in_t) == 16);
+    TEST_ASSERT(offsetof(test_add_in_t, b) == 0 && offsetof(test_add_in_t, a) == 8 && offsetof(test_add_in_t, scale) == 12);
+    TEST_ASSERT(sizeof(test_checksum_out_t) == 5);
+    TEST_ASSERT(TEST_RPC_ADD == 1 && TEST_RPC_CHECKSUM == 2 && TEST_RPC_RESET == 7);
+    return 0;
+}
+
+static int test_call(void)
+{
+    int64_t sum = 0;
+    uint8_t data[16];
+    uint8_t digest[4] = { 0 };
+    bool ok = false;
+
+    /* skeletons are registered at link time */
+    TEST_ASSERT(esp_amp_rpc_service_static_init() == 3);
+    TEST_ASSERT(test_find_service(TEST_RPC_ADD) != NULL && test_find_service(TEST_RPC_CHECKSUM) != NULL && test_find_service(TEST_RPC_RESET) != NULL);
+    TEST_ASSERT(test_find_service(TEST_RPC_RESET + 1) == NULL);
+
+    /* 8-byte fields at 4-byte aligned params, both in request and response */
+    TEST_ASSERT(((uintptr_t)s_rsp_buf & 7) != 0);
+
+    TEST_ASSERT(test_add(-3, 5, 1LL << 40, &sum, 100) == ESP_AMP_RPC_STATUS_OK);
+    TEST_ASSERT(sum == (1LL << 40) - 15);
+    TEST_ASSERT(test_add(1, 1, 1, NULL, 100) == ESP_AMP_RPC_STATUS_OK);
+
+    for (int i = 0; i < 16; i++) {
+        data[i] = (uint8_t)(1 << (i / 4));
+    }
+    TEST_ASSERT(test_checksum(data, digest, &ok, 100) == ESP_AMP_RPC_STATUS_OK);
+    TEST_ASSERT(ok && digest[0] == 0xf && digest[1] == 0xf && digest[2] == 0xf && digest[3] == 0xf);
+
+    TEST_ASSERT(test_reset(100) == ESP_AMP_RPC_STATUS_OK && s_reset_cnt == 1);
+    return 0;
+}
+
+static int test_validate(void)
+{
+    test_add_out_t out;
+    uint16_t len = TEST_BUF_SIZE;
+
+    /* request of wrong length is rejected by server skeleton */
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_create_request(TEST_RPC_ADD, NULL, sizeof(test_add_in_t) - 1);
+    TEST_ASSERT(req != NULL);
+    void *params_out;
+    int params_out_len;
+    TEST_ASSERT(esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 100) == ESP_AMP_RPC_STATUS_EXEC_FAILED);
+    esp_amp_rpc_client_destroy_request(req);
+
+    /* output buffer too small */
+    req = test_add_create(1, 2, 3);
+    len = sizeof(test_add_out_t) - 1;
+    TEST_ASSERT(test_find_service(TEST_RPC_ADD)(esp_amp_rpc_client_get_request_params(req), sizeof(test_add_in_t), s_rsp_buf, &len) == ESP_AMP_RPC_STATUS_BAD_PACKET);
+
+    /* notification has no response buffer */
+    len = 0;
+    TEST_ASSERT(test_find_service(TEST_RPC_ADD)(esp_amp_rpc_client_get_request_params(req), sizeof(test_add_in_t), NULL, &len) == ESP_AMP_RPC_STATUS_BAD_PACKET);
+    esp_amp_rpc_client_destroy_request(req);
+
+    /* response of wrong length is rejected by client stub */
+    TEST_ASSERT(test_add_decode(s_rsp_buf, sizeof(test_add_out_t) + 1, &out) == ESP_AMP_RPC_STATUS_BAD_PACKET);
+    int64_t sum = -42;
+    memcpy(s_rsp_buf, &sum, sizeof(sum));
+    TEST_ASSERT(test_add_decode(s_rsp_buf, sizeof(test_add_out_t), &out) == ESP_AMP_RPC_STATUS_OK && out.sum == -42);
+
+    /* identical parameters give identical request bytes, padding included */
+    esp_amp_rpc_req_handle_t req2 = test_add_create(1, 2, 3);
+    req = test_add_create(1, 2, 3);
+    TEST_ASSERT(memcmp(esp_amp_rpc_client_get_request_params(req), esp_amp_rpc_client_get_request_params(req2), sizeof(test_add_in_t)) == 0);
+    esp_amp_rpc_client_destroy_request(req);
+    esp_amp_rpc_client_destroy_request(req2);
+    return 0;
+}
+
+int main(void)
+{
+    int ret = test_layout() || test_call() || test_validate();
+
+    printf("rpc idl test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
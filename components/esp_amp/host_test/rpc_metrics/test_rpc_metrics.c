@@ -0,0 +1,128 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_amp_rpc_metrics_priv.h"
+#include "test_utils.h"
+
+static esp_amp_rpc_metrics_tbl_t s_tbl;
+
+static int test_calls(void)
+{
+    esp_amp_rpc_metrics_t metrics;
+
+    esp_amp_rpc_metrics_reset(&s_tbl);
+    TEST_ASSERT(esp_amp_rpc_metrics_get(&s_tbl, 1, &metrics) == -1);
+
+    esp_amp_rpc_metrics_add_call(&s_tbl, 1, ESP_AMP_RPC_STATUS_OK);
+    esp_amp_rpc_metrics_add_call(&s_tbl, 1, ESP_AMP_RPC_STATUS_OK);
+    esp_amp_rpc_metrics_add_call(&s_tbl, 1, ESP_AMP_RPC_STATUS_TIMEOUT);
+    esp_amp_rpc_metrics_add_call(&s_tbl, 2, ESP_AMP_RPC_STATUS_EXEC_FAILED);
+    /* status out of range is counted as internal error */
+    esp_amp_rpc_metrics_add_call(&s_tbl, 2, (esp_amp_rpc_status_t)0x1234);
+
+    TEST_ASSERT(esp_amp_rpc_metrics_get(&s_tbl, 1, &metrics) == 0);
+    TEST_ASSERT(metrics.service_id == 1);
+    TEST_ASSERT(metrics.calls == 3);
+    TEST_ASSERT(metrics.status[ESP_AMP_RPC_STATUS_OK] == 2);
+    TEST_ASSERT(metrics.status[ESP_AMP_RPC_STATUS_TIMEOUT] == 1);
+    TEST_ASSERT(metrics.time[ESP_AMP_RPC_METRICS_LATENCY].count == 0);
+
+    TEST_ASSERT(esp_amp_rpc_metrics_get(&s_tbl, 2, &metrics) == 0);
+    TEST_ASSERT(metrics.calls == 2);
+    TEST_ASSERT(metrics.status[ESP_AMP_RPC_STATUS_EXEC_FAILED] == 1);
+    TEST_ASSERT(metrics.status[ESP_AMP_RPC_STATUS_FAILED] == 1);
+
+    /* services are listed in the order they are first seen */
+    TEST_ASSERT(esp_amp_rpc_metrics_get_by_index(&s_tbl, 0, &metrics) == 0 && metrics.service_id == 1);
+    TEST_ASSERT(esp_amp_rpc_metrics_get_by_index(&s_tbl, 1, &metrics) == 0 && metrics.service_id == 2);
+    TEST_ASSERT(esp_amp_rpc_metrics_get_by_index(&s_tbl, 2, &metrics) == -1);
+    return 0;
+}
+
+static int test_times(void)
+{
+    esp_amp_rpc_metrics_t metrics;
+
+    esp_amp_rpc_metrics_reset(&s_tbl);
+
+    /* 90 fast samples and 10 slow ones */
+    for (int i = 0; i < 90; i++) {
+        esp_amp_rpc_metrics_add_time(&s_tbl, 7, ESP_AMP_RPC_METRICS_EXEC, 100);
+    }
+    for (int i = 0; i < 10; i++) {
+        esp_amp_rpc_metrics_add_time(&s_tbl, 7, ESP_AMP_RPC_METRICS_EXEC, 5000);
+    }
+    esp_amp_rpc_metrics_add_time(&s_tbl, 7, ESP_AMP_RPC_METRICS_QUEUE, 0);
+    esp_amp_rpc_metrics_add_time(&s_tbl, 7, ESP_AMP_RPC_METRICS_LATENCY, UINT32_MAX);
+
+    TEST_ASSERT(esp_amp_rpc_metrics_get(&s_tbl, 7, &metrics) == 0);
+    TEST_ASSERT(metrics.calls == 0);
+
+    const esp_amp_rpc_hist_t *exec = &metrics.time[ESP_AMP_RPC_METRICS_EXEC];
+    TEST_ASSERT(exec->count == 100);
+    TEST_ASSERT(exec->max_us == 5000);
+    TEST_ASSERT(exec->total_us == 90 * 100 + 10 * 5000);
+    /* 100us is in [64, 128), 5000us in [4096, 8192) */
+    TEST_ASSERT(exec->bucket[7] == 90);
+    TEST_ASSERT(exec->bucket[13] == 10);
+    TEST_ASSERT(esp_amp_rpc_metrics_percentile(exec, 50) == 127);
+    TEST_ASSERT(esp_amp_rpc_metrics_percentile(exec, 90) == 127);
+    TEST_ASSERT(esp_amp_rpc_metrics_percentile(exec, 91) == 5000);
+    TEST_ASSERT(esp_amp_rpc_metrics_percentile(exec, 100) == 5000);
+
+    const esp_amp_rpc_hist_t *queue = &metrics.time[ESP_AMP_RPC_METRICS_QUEUE];
+    TEST_ASSERT(queue->count == 1 && queue->bucket[0] == 1);
+    TEST_ASSERT(esp_amp_rpc_metrics_percentile(queue, 99) == 0);
+
+    /* huge sample goes to the last bucket */
+    const esp_amp_rpc_hist_t *latency = &metrics.time[ESP_AMP_RPC_METRICS_LATENCY];
+    TEST_ASSERT(latency->bucket[ESP_AMP_RPC_METRICS_BUCKET_NUM - 1] == 1);
+    TEST_ASSERT(esp_amp_rpc_metrics_percentile(latency, 50) == UINT32_MAX);
+
+    /* percentile 0 */
+    TEST_ASSERT(esp_amp_rpc_metrics_percentile(exec, 0) == 0);
+    return 0;
+}
+
+static int test_full(void)
+{
+    esp_amp_rpc_metrics_t metrics;
+
+    esp_amp_rpc_metrics_reset(&s_tbl);
+    for (int i = 0; i < CONFIG_ESP_AMP_RPC_METRICS_SERVICE_NUM; i++) {
+        esp_amp_rpc_metrics_add_call(&s_tbl, 100 + i, ESP_AMP_RPC_STATUS_OK);
+    }
+
+    /* table is full, new services are only counted as dropped */
+    esp_amp_rpc_metrics_add_call(&s_tbl, 200, ESP_AMP_RPC_STATUS_OK);
+    esp_amp_rpc_metrics_add_time(&s_tbl, 200, ESP_AMP_RPC_METRICS_EXEC, 10);
+    TEST_ASSERT(s_tbl.dropped == 2);
+    TEST_ASSERT(esp_amp_rpc_metrics_get(&s_tbl, 200, &metrics) == -1);
+
+    /* tracked services are still updated */
+    esp_amp_rpc_metrics_add_call(&s_tbl, 100, ESP_AMP_RPC_STATUS_OK);
+    TEST_ASSERT(esp_amp_rpc_metrics_get(&s_tbl, 100, &metrics) == 0 && metrics.calls == 2);
+
+    /* reset forgets all services */
+    esp_amp_rpc_metrics_reset(&s_tbl);
+    TEST_ASSERT(s_tbl.dropped == 0);
+    TEST_ASSERT(esp_amp_rpc_metrics_get(&s_tbl, 100, &metrics) == -1);
+    esp_amp_rpc_metrics_add_call(&s_tbl, 200, ESP_AMP_RPC_STATUS_OK);
+    TEST_ASSERT(esp_amp_rpc_metrics_get(&s_tbl, 200, &metrics) == 0 && metrics.calls == 1);
+    return 0;
+}
+
+int main(void)
+{
+    int ret = test_calls() || test_times() || test_full();
+
+    printf("rpc metrics test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
@@ -0,0 +1,70 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "esp_amp_rpc_pending_priv.h"
+#include "test_utils.h"
+
+static esp_amp_rpc_pending_tbl_t s_tbl;
+
+static int test_alloc_release(void)
+{
+    uint16_t ids[ESP_AMP_RPC_MAX_PENDING_REQ];
+
+    esp_amp_rpc_pending_tbl_init(&s_tbl);
+
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        ids[i] = esp_amp_rpc_pending_tbl_alloc(&s_tbl);
+        TEST_ASSERT(ids[i] != ESP_AMP_RPC_INVALID_REQ_ID && ids[i] <= ESP_AMP_RPC_REQ_ID_MAX);
+        TEST_ASSERT(esp_amp_rpc_pending_tbl_find(&s_tbl, ids[i]) == ids[i] % ESP_AMP_RPC_MAX_PENDING_REQ);
+        for (int j = 0; j < i; j++) {
+            TEST_ASSERT(ids[i] % ESP_AMP_RPC_MAX_PENDING_REQ != ids[j] % ESP_AMP_RPC_MAX_PENDING_REQ);
+        }
+    }
+
+    /* full */
+    TEST_ASSERT(esp_amp_rpc_pending_tbl_alloc(&s_tbl) == ESP_AMP_RPC_INVALID_REQ_ID);
+    TEST_ASSERT(esp_amp_rpc_pending_tbl_find(&s_tbl, ESP_AMP_RPC_INVALID_REQ_ID) == -1);
+
+    /* release in any order */
+    TEST_ASSERT(esp_amp_rpc_pending_tbl_release(&s_tbl, ids[3]) == ids[3] % ESP_AMP_RPC_MAX_PENDING_REQ);
+    TEST_ASSERT(esp_amp_rpc_pending_tbl_release(&s_tbl, ids[3]) == -1);
+    TEST_ASSERT(esp_amp_rpc_pending_tbl_find(&s_tbl, ids[3]) == -1);
+
+    /* the slot is reused with a new generation, the old id stays invalid */
+    uint16_t id = esp_amp_rpc_pending_tbl_alloc(&s_tbl);
+    TEST_ASSERT(id != ids[3] && id % ESP_AMP_RPC_MAX_PENDING_REQ == ids[3] % ESP_AMP_RPC_MAX_PENDING_REQ);
+    TEST_ASSERT(esp_amp_rpc_pending_tbl_find(&s_tbl, ids[3]) == -1);
+    TEST_ASSERT(esp_amp_rpc_pending_tbl_release(&s_tbl, ids[3]) == -1);
+    TEST_ASSERT(esp_amp_rpc_pending_tbl_find(&s_tbl, id) != -1);
+    return 0;
+}
+
+static int test_generation_wrap(void)
+{
+    uint16_t last = ESP_AMP_RPC_INVALID_REQ_ID;
+
+    esp_amp_rpc_pending_tbl_init(&s_tbl);
+
+    /* the same slot is reused again and again, ids must stay valid across wrap around */
+    for (int i = 0; i < 3 * (ESP_AMP_RPC_REQ_ID_MAX / ESP_AMP_RPC_MAX_PENDING_REQ); i++) {
+        uint16_t id = esp_amp_rpc_pending_tbl_alloc(&s_tbl);
+        TEST_ASSERT(id != ESP_AMP_RPC_INVALID_REQ_ID && id != last && id <= ESP_AMP_RPC_REQ_ID_MAX);
+        TEST_ASSERT(esp_amp_rpc_pending_tbl_release(&s_tbl, id) != -1);
+        last = id;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int ret = test_alloc_release() || test_generation_wrap();
+
+    printf("rpc pending table test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
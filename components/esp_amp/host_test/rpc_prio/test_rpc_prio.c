@@ -0,0 +1,132 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "esp_amp_rpc_prio_priv.h"
+#include "test_utils.h"
+
+#define TEST_CAP        (8)
+
+static esp_amp_rpc_prio_q_t s_q;
+static esp_amp_rpc_prio_link_t s_links[TEST_CAP];
+static int s_items[TEST_CAP]; /* request stored by user in the slot taken */
+
+static int push(int item, uint8_t prio, uint32_t now)
+{
+    int slot = esp_amp_rpc_prio_q_push(&s_q, prio, now);
+    if (slot != -1) {
+        s_items[slot] = item;
+    }
+    return slot;
+}
+
+static int pop(uint32_t now)
+{
+    int slot = esp_amp_rpc_prio_q_pop(&s_q, now);
+    return slot == -1 ? -1 : s_items[slot];
+}
+
+static int test_order(void)
+{
+    esp_amp_rpc_prio_q_init(&s_q, s_links, TEST_CAP, 0);
+    TEST_ASSERT(pop(0) == -1);
+
+    /* burst of bulk requests, then an urgent one */
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT(push(i, ESP_AMP_RPC_PRIORITY_NORMAL, 0) != -1);
+    }
+    TEST_ASSERT(push(100, ESP_AMP_RPC_PRIORITY_MAX, 0) != -1);
+    TEST_ASSERT(push(50, 1, 0) != -1);
+    /* clamped to the highest level, queued behind the other urgent one */
+    TEST_ASSERT(push(101, 200, 0) != -1);
+
+    TEST_ASSERT(pop(1000) == 100);
+    TEST_ASSERT(pop(1000) == 101);
+    TEST_ASSERT(pop(1000) == 50);
+    /* without aging, same level keeps arrival order */
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT(pop(1000) == i);
+    }
+    TEST_ASSERT(pop(1000) == -1);
+    TEST_ASSERT(s_q.num == 0);
+    return 0;
+}
+
+static int test_full(void)
+{
+    esp_amp_rpc_prio_q_init(&s_q, s_links, TEST_CAP, 0);
+
+    for (int i = 0; i < TEST_CAP; i++) {
+        TEST_ASSERT(push(i, i % ESP_AMP_RPC_PRIORITY_NUM, 0) != -1);
+    }
+    TEST_ASSERT(esp_amp_rpc_prio_q_is_full(&s_q));
+    TEST_ASSERT(push(TEST_CAP, 0, 0) == -1);
+
+    /* slot popped is reused */
+    TEST_ASSERT(pop(0) == ESP_AMP_RPC_PRIORITY_MAX);
+    TEST_ASSERT(push(TEST_CAP, ESP_AMP_RPC_PRIORITY_MAX, 0) != -1);
+    TEST_ASSERT(pop(0) == 2 * ESP_AMP_RPC_PRIORITY_NUM - 1);
+    TEST_ASSERT(pop(0) == TEST_CAP);
+
+    int num = 0;
+    while (pop(0) != -1) {
+        num++;
+    }
+    TEST_ASSERT(num == TEST_CAP - 2);
+    return 0;
+}
+
+static int test_aging(void)
+{
+    /* promoted by one level every 10 time units */
+    esp_amp_rpc_prio_q_init(&s_q, s_links, TEST_CAP, 10);
+
+    TEST_ASSERT(push(0, ESP_AMP_RPC_PRIORITY_NORMAL, 0) != -1);
+    TEST_ASSERT(push(1, 1, 5) != -1);
+    TEST_ASSERT(push(2, ESP_AMP_RPC_PRIORITY_MAX, 9) != -1);
+
+    /* fresh urgent one goes first */
+    TEST_ASSERT(pop(9) == 2);
+
+    /* at 20, request 0 is promoted to 2 and request 1 to 2, the older one wins */
+    TEST_ASSERT(push(3, 1, 20) != -1);
+    TEST_ASSERT(pop(20) == 0);
+    TEST_ASSERT(pop(20) == 1);
+    TEST_ASSERT(pop(20) == 3);
+
+    /* request of lowest level waiting long enough overtakes a stream of urgent ones */
+    TEST_ASSERT(push(10, ESP_AMP_RPC_PRIORITY_NORMAL, 100) != -1);
+    uint32_t now = 100;
+    int overtaken = -1;
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT(push(20 + i, ESP_AMP_RPC_PRIORITY_MAX, now) != -1);
+        now += 10;
+        if (pop(now) == 10) {
+            overtaken = i;
+            break;
+        }
+    }
+    TEST_ASSERT(overtaken != -1 && overtaken <= ESP_AMP_RPC_PRIORITY_MAX);
+
+    /* time counter wraps while waiting */
+    esp_amp_rpc_prio_q_init(&s_q, s_links, TEST_CAP, 10);
+    TEST_ASSERT(push(0, ESP_AMP_RPC_PRIORITY_NORMAL, UINT32_MAX - 50) != -1);
+    TEST_ASSERT(push(1, ESP_AMP_RPC_PRIORITY_MAX, 0) != -1);
+    TEST_ASSERT(pop(0) == 0);
+    TEST_ASSERT(pop(0) == 1);
+    return 0;
+}
+
+int main(void)
+{
+    int ret = test_order() || test_full() || test_aging();
+
+    printf("rpc prio test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
@@ -0,0 +1,84 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "esp_amp_rpc_service_priv.h"
+#include "test_utils.h"
+
+#if TEST_SPARSE_IDS
+#define SRV_ID_A 40
+#define SRV_ID_B 7
+#define SRV_ID_C 1000
+#define SRV_ID_D 12
+#else
+#define SRV_ID_A 5
+#define SRV_ID_B 3
+#define SRV_ID_C 6
+#define SRV_ID_D 4
+#endif
+
+static esp_amp_rpc_status_t srv_a(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static esp_amp_rpc_status_t srv_b(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static esp_amp_rpc_status_t srv_c(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+/* defined out of id order, the same handler may serve two ids */
+ESP_AMP_RPC_SERVICE_DEFINE(SRV_ID_A, srv_a);
+ESP_AMP_RPC_SERVICE_DEFINE(SRV_ID_B, srv_b);
+ESP_AMP_RPC_SERVICE_DEFINE(SRV_ID_C, srv_c);
+ESP_AMP_RPC_SERVICE_DEFINE(SRV_ID_D, srv_a);
+
+static int test_lookup(void)
+{
+    TEST_ASSERT(esp_amp_rpc_service_static_init() == 4);
+    /* init again does not change anything */
+    TEST_ASSERT(esp_amp_rpc_service_static_init() == 4);
+
+    /* sorted by id */
+    for (int i = 1; i < 4; i++) {
+        TEST_ASSERT(esp_amp_rpc_service_static_get(i - 1)->id < esp_amp_rpc_service_static_get(i)->id);
+    }
+
+    int idx = esp_amp_rpc_service_static_find(SRV_ID_A);
+    TEST_ASSERT(idx != -1 && esp_amp_rpc_service_static_get(idx)->handler == srv_a);
+    idx = esp_amp_rpc_service_static_find(SRV_ID_B);
+    TEST_ASSERT(idx == 0 && esp_amp_rpc_service_static_get(idx)->handler == srv_b);
+    idx = esp_amp_rpc_service_static_find(SRV_ID_C);
+    TEST_ASSERT(idx == 3 && esp_amp_rpc_service_static_get(idx)->handler == srv_c);
+    idx = esp_amp_rpc_service_static_find(SRV_ID_D);
+    TEST_ASSERT(idx != -1 && esp_amp_rpc_service_static_get(idx)->handler == srv_a);
+
+    /* out of range and holes */
+    TEST_ASSERT(esp_amp_rpc_service_static_find(SRV_ID_B - 1) == -1);
+    TEST_ASSERT(esp_amp_rpc_service_static_find(SRV_ID_C + 1) == -1);
+    TEST_ASSERT(esp_amp_rpc_service_static_find(-1) == -1);
+#if TEST_SPARSE_IDS
+    TEST_ASSERT(esp_amp_rpc_service_static_find(8) == -1);
+    TEST_ASSERT(esp_amp_rpc_service_static_find(41) == -1);
+#endif
+    return 0;
+}
+
+int main(void)
+{
+    if (test_lookup() != 0) {
+        return 1;
+    }
+    printf("rpc service tests passed\n");
+    return 0;
+}
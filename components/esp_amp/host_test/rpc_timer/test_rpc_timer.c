@@ -0,0 +1,141 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_amp_rpc_timer_priv.h"
+#include "test_utils.h"
+
+static esp_amp_rpc_timer_t s_timer;
+
+static int test_order(void)
+{
+    /* deadlines out of order, slot i expires at deadlines[i] */
+    static const uint32_t deadlines[ESP_AMP_RPC_MAX_PENDING_REQ] = { 50, 10, 70, 30, 20, 80, 60, 40 };
+
+    esp_amp_rpc_timer_init(&s_timer);
+    TEST_ASSERT(esp_amp_rpc_timer_is_empty(&s_timer));
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 1000) == -1);
+
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        esp_amp_rpc_timer_arm(&s_timer, i, deadlines[i]);
+    }
+    TEST_ASSERT(!esp_amp_rpc_timer_is_empty(&s_timer));
+
+    /* nothing expires before the earliest deadline */
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 9) == -1);
+
+    /* deadline itself counts as expired */
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 10) == 1);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 10) == -1);
+
+    /* only expired slots are popped, earliest first */
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 45) == 4);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 45) == 3);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 45) == 7);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 45) == -1);
+
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 100) == 0);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 100) == 6);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 100) == 2);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 100) == 5);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 100) == -1);
+    TEST_ASSERT(esp_amp_rpc_timer_is_empty(&s_timer));
+    return 0;
+}
+
+static int test_rearm_disarm(void)
+{
+    esp_amp_rpc_timer_init(&s_timer);
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        esp_amp_rpc_timer_arm(&s_timer, i, 100 + i * 10);
+    }
+
+    /* completed reqs leave the heap, disarming twice has no effect */
+    esp_amp_rpc_timer_disarm(&s_timer, 0);
+    esp_amp_rpc_timer_disarm(&s_timer, 0);
+    esp_amp_rpc_timer_disarm(&s_timer, 5);
+
+    /* restarted req moves to its new deadline, both later and earlier */
+    esp_amp_rpc_timer_arm(&s_timer, 1, 500);
+    esp_amp_rpc_timer_arm(&s_timer, 7, 50);
+
+    static const int expected[] = { 7, 2, 3, 4, 6, 1 };
+    for (int i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 1000) == expected[i]);
+    }
+    TEST_ASSERT(esp_amp_rpc_timer_is_empty(&s_timer));
+    return 0;
+}
+
+static int test_wrap_around(void)
+{
+    esp_amp_rpc_timer_init(&s_timer);
+
+    /* ms counter wraps between the two deadlines */
+    esp_amp_rpc_timer_arm(&s_timer, 0, 0x10);
+    esp_amp_rpc_timer_arm(&s_timer, 1, UINT32_MAX - 0x10);
+
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, UINT32_MAX - 0x20) == -1);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, UINT32_MAX) == 1);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, UINT32_MAX) == -1);
+    TEST_ASSERT(esp_amp_rpc_timer_pop_expired(&s_timer, 0x10) == 0);
+    return 0;
+}
+
+static int test_random(void)
+{
+    uint32_t deadline[ESP_AMP_RPC_MAX_PENDING_REQ];
+    bool armed[ESP_AMP_RPC_MAX_PENDING_REQ] = { 0 };
+
+    esp_amp_rpc_timer_init(&s_timer);
+    srand(1);
+
+    /* random arm / disarm / expire, checked against a plain scan */
+    for (int round = 0; round < 10000; round++) {
+        int slot = rand() % ESP_AMP_RPC_MAX_PENDING_REQ;
+        switch (rand() % 3) {
+        case 0:
+            deadline[slot] = rand() % 1000;
+            armed[slot] = true;
+            esp_amp_rpc_timer_arm(&s_timer, slot, deadline[slot]);
+            break;
+        case 1:
+            armed[slot] = false;
+            esp_amp_rpc_timer_disarm(&s_timer, slot);
+            break;
+        default: {
+            uint32_t now = rand() % 1000;
+            int earliest = -1;
+            for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+                if (armed[i] && deadline[i] <= now && (earliest == -1 || deadline[i] < deadline[earliest])) {
+                    earliest = i;
+                }
+            }
+            int popped = esp_amp_rpc_timer_pop_expired(&s_timer, now);
+            if (earliest == -1) {
+                TEST_ASSERT(popped == -1);
+            } else {
+                /* ties may pop any of the slots sharing the deadline */
+                TEST_ASSERT(popped != -1 && armed[popped] && deadline[popped] == deadline[earliest]);
+                armed[popped] = false;
+            }
+            break;
+        }
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int ret = test_order() || test_rearm_disarm() || test_wrap_around() || test_random();
+
+    printf("rpc timer test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
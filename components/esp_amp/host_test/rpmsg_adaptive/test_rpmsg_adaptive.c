@@ -0,0 +1,171 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Main-core rpmsg device in adaptive receive mode, sub-core sends with notify enabled. The emulated software
+ * interrupt delivers the doorbell, so the device switches from interrupt mode to polling mode and back for real.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "esp_amp_sys_info.h"
+#include "esp_amp_rpmsg.h"
+#include "port_host.h"
+#include "test_utils.h"
+
+#define TEST_SYSINFO_ID         (0x100)
+#define TEST_EPT_ADDR           (1)
+#define TEST_QUEUE_LEN          (16)
+#define TEST_INTR_BUDGET        (4)
+#define TEST_POLL_BUDGET        (3)
+
+static esp_amp_rpmsg_dev_t s_main_dev;
+static esp_amp_rpmsg_dev_t s_sub_dev;
+static esp_amp_rpmsg_ept_t s_main_ept;
+static esp_amp_rpmsg_ept_t s_sub_ept;
+static uint32_t s_next_seq;
+static uint32_t s_rx_seq;
+static int s_rx_cnt;
+static int s_sched_cnt;
+
+static int test_main_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    uint32_t seq = *(uint32_t*)msg_data;
+    if (seq == s_rx_seq) {
+        s_rx_seq++;
+    }
+    s_rx_cnt++;
+    esp_amp_rpmsg_destroy(&s_main_dev, msg_data);
+    return 0;
+}
+
+static int test_sched_cb(void* sched_arg)
+{
+    s_sched_cnt++;
+    return 0;
+}
+
+static int test_sub_send(int num)
+{
+    for (int i = 0; i < num; i++) {
+        uint32_t seq = s_next_seq++;
+        if (esp_amp_rpmsg_send(&s_sub_dev, &s_sub_ept, TEST_EPT_ADDR, &seq, sizeof(seq)) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void test_sub_send_one(void)
+{
+    test_sub_send(1);
+}
+
+static bool test_doorbell_armed(void)
+{
+    return !s_main_dev.rx_queue->conf->notify_disabled;
+}
+
+static int test_interrupt_mode(void)
+{
+    /* light load is fully handled in the interrupt */
+    TEST_ASSERT(test_sub_send(TEST_INTR_BUDGET - 1) == 0);
+    TEST_ASSERT(esp_amp_host_sw_intr_pending(SW_INTR_RESERVED_ID_VQUEUE));
+    TEST_ASSERT(esp_amp_host_sw_intr_dispatch() == 1);
+    TEST_ASSERT(s_rx_cnt == TEST_INTR_BUDGET - 1 && s_rx_seq == s_next_seq);
+    TEST_ASSERT(!s_main_dev.adaptive.polling && s_sched_cnt == 0);
+    TEST_ASSERT(test_doorbell_armed());
+    return 0;
+}
+
+static int test_switch_to_polling(void)
+{
+    int rx_cnt = s_rx_cnt;
+
+    /* a burst exhausts the interrupt budget, the doorbell is masked and the poller is scheduled */
+    TEST_ASSERT(test_sub_send(TEST_INTR_BUDGET + 2 * TEST_POLL_BUDGET + 1) == 0);
+    TEST_ASSERT(esp_amp_host_sw_intr_dispatch() == 1);
+    TEST_ASSERT(s_rx_cnt - rx_cnt == TEST_INTR_BUDGET);
+    TEST_ASSERT(s_main_dev.adaptive.polling && s_sched_cnt == 1);
+    TEST_ASSERT(!test_doorbell_armed());
+
+    /* the other core doesn't ring the masked doorbell */
+    TEST_ASSERT(test_sub_send(1) == 0);
+    TEST_ASSERT(!esp_amp_host_sw_intr_pending(SW_INTR_RESERVED_ID_VQUEUE));
+
+    /* 2 * poll_budget + 2 pending: two full batches, then a short one switches back */
+    TEST_ASSERT(esp_amp_rpmsg_adaptive_poll(&s_main_dev) == 0);
+    TEST_ASSERT(esp_amp_rpmsg_adaptive_poll(&s_main_dev) == 0);
+    TEST_ASSERT(esp_amp_rpmsg_adaptive_poll(&s_main_dev) == -1);
+    TEST_ASSERT(s_rx_seq == s_next_seq);
+    TEST_ASSERT(!s_main_dev.adaptive.polling && test_doorbell_armed());
+    TEST_ASSERT(esp_amp_rpmsg_adaptive_poll(&s_main_dev) == -1);
+
+    /* doorbell works again */
+    TEST_ASSERT(test_sub_send(1) == 0);
+    TEST_ASSERT(esp_amp_host_sw_intr_dispatch() == 1);
+    TEST_ASSERT(s_rx_seq == s_next_seq && !s_main_dev.adaptive.polling && s_sched_cnt == 1);
+    return 0;
+}
+
+static int test_rearm_race(void)
+{
+    /* exactly intr_budget rpmsg: the interrupt drains the rx queue but still hands over to the poller */
+    TEST_ASSERT(test_sub_send(TEST_INTR_BUDGET) == 0);
+    TEST_ASSERT(esp_amp_host_sw_intr_dispatch() == 1);
+    TEST_ASSERT(s_main_dev.adaptive.polling && s_sched_cnt == 2);
+    TEST_ASSERT(s_rx_seq == s_next_seq);
+
+    /* the sub-core sends right before the doorbell is re-armed and sees it still masked */
+    esp_amp_host_critical_hook = test_sub_send_one;
+    TEST_ASSERT(esp_amp_rpmsg_adaptive_poll(&s_main_dev) == 0);
+    TEST_ASSERT(esp_amp_host_critical_hook == NULL);
+    TEST_ASSERT(!esp_amp_host_sw_intr_pending(SW_INTR_RESERVED_ID_VQUEUE));
+
+    /* the recheck keeps the device in polling mode instead of stranding the rpmsg until the next doorbell */
+    TEST_ASSERT(s_main_dev.adaptive.polling && !test_doorbell_armed());
+    TEST_ASSERT(s_rx_seq == s_next_seq - 1);
+    TEST_ASSERT(esp_amp_rpmsg_adaptive_poll(&s_main_dev) == -1);
+    TEST_ASSERT(s_rx_seq == s_next_seq);
+    TEST_ASSERT(!s_main_dev.adaptive.polling && test_doorbell_armed());
+
+    /* sent right after the doorbell is re-armed: rings it */
+    TEST_ASSERT(test_sub_send(TEST_INTR_BUDGET + 1) == 0);
+    TEST_ASSERT(esp_amp_host_sw_intr_dispatch() == 1);
+    TEST_ASSERT(s_main_dev.adaptive.polling && s_sched_cnt == 3);
+    TEST_ASSERT(esp_amp_rpmsg_adaptive_poll(&s_main_dev) == -1);
+    TEST_ASSERT(test_sub_send(1) == 0);
+    TEST_ASSERT(esp_amp_host_sw_intr_pending(SW_INTR_RESERVED_ID_VQUEUE));
+    TEST_ASSERT(esp_amp_host_sw_intr_dispatch() == 1);
+    TEST_ASSERT(s_rx_seq == s_next_seq && !s_main_dev.adaptive.polling);
+
+    /* nothing lost or reordered across all switches */
+    TEST_ASSERT(s_rx_cnt == (int)s_next_seq);
+    return 0;
+}
+
+int main(void)
+{
+    static esp_amp_queue_t main_vqueue[2];
+    static esp_amp_queue_t sub_vqueue[2];
+
+    if (esp_amp_sys_info_init() != 0 ||
+            esp_amp_rpmsg_main_init_by_id(&s_main_dev, main_vqueue, TEST_QUEUE_LEN, 64, false, false, TEST_SYSINFO_ID) != 0 ||
+            esp_amp_rpmsg_sub_init_by_id(&s_sub_dev, sub_vqueue, true, true, TEST_SYSINFO_ID) != 0 ||
+            esp_amp_rpmsg_intr_enable(&s_main_dev) != 0 ||
+            esp_amp_rpmsg_adaptive_enable(&s_main_dev, TEST_INTR_BUDGET, TEST_POLL_BUDGET, test_sched_cb, NULL) != 0) {
+        fprintf(stderr, "failed to init rpmsg devices\n");
+        return 1;
+    }
+    esp_amp_rpmsg_create_endpoint(&s_main_dev, TEST_EPT_ADDR, test_main_rx_cb, NULL, &s_main_ept);
+    esp_amp_rpmsg_create_endpoint(&s_sub_dev, TEST_EPT_ADDR, NULL, NULL, &s_sub_ept);
+
+    int ret = test_interrupt_mode() || test_switch_to_polling() || test_rearm_race();
+
+    printf("rpmsg adaptive test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
@@ -0,0 +1,149 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Two lanes in polling mode: sub-core queues a burst on the bulk lane, then control rpmsg on lane 0. Main-core must
+ * dispatch every control rpmsg before the bulk ones still waiting, including control sent while the burst is drained.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "esp_amp_sys_info.h"
+#include "esp_amp_rpmsg.h"
+#include "test_utils.h"
+
+#define TEST_SYSINFO_ID         (0x100)
+#define TEST_CTRL_ADDR          (1)
+#define TEST_BULK_ADDR          (2)
+#define TEST_CTRL_LANE          (0)
+#define TEST_BULK_LANE          (1)
+#define TEST_CTRL_QUEUE_LEN     (4)
+#define TEST_BULK_QUEUE_LEN     (8)
+#define TEST_LOG_LEN            (32)
+
+/* tags of dispatched rpmsg: control ones are 'A' + seq, bulk ones 'a' + seq */
+#define TEST_CTRL_TAG(seq)      (uint8_t)('A' + (seq))
+#define TEST_BULK_TAG(seq)      (uint8_t)('a' + (seq))
+
+static esp_amp_rpmsg_dev_t s_main_dev;
+static esp_amp_rpmsg_dev_t s_sub_dev;
+static esp_amp_rpmsg_ept_t s_main_ctrl_ept;
+static esp_amp_rpmsg_ept_t s_main_bulk_ept;
+static esp_amp_rpmsg_ept_t s_sub_ctrl_ept;
+static esp_amp_rpmsg_ept_t s_sub_bulk_ept;
+
+static uint8_t s_log[TEST_LOG_LEN];
+static int s_log_num;
+static int s_rx_bad;
+static uint8_t s_send_on_rx; /* bulk tag which makes sub-core send one more control rpmsg, 0 if none */
+static uint8_t s_ctrl_seq;
+
+static int test_sub_send(esp_amp_rpmsg_ept_t* ept, uint16_t dst_addr, uint8_t tag)
+{
+    return esp_amp_rpmsg_send(&s_sub_dev, ept, dst_addr, &tag, sizeof(tag));
+}
+
+static int test_main_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    uint8_t tag = *(uint8_t*)msg_data;
+    if (data_len != 1 || s_log_num == TEST_LOG_LEN) {
+        s_rx_bad++;
+    } else {
+        s_log[s_log_num++] = tag;
+    }
+    esp_amp_rpmsg_destroy(&s_main_dev, msg_data);
+
+    /* sub-core acts while main-core is in the middle of the burst */
+    if (s_send_on_rx != 0 && tag == s_send_on_rx) {
+        s_send_on_rx = 0;
+        if (test_sub_send(&s_sub_ctrl_ept, TEST_CTRL_ADDR, TEST_CTRL_TAG(s_ctrl_seq++)) != 0) {
+            s_rx_bad++;
+        }
+    }
+    return 0;
+}
+
+static void test_main_drain(void)
+{
+    s_log_num = 0;
+    while (esp_amp_rpmsg_poll(&s_main_dev) == 0) {
+    }
+}
+
+static int test_lane_order(void)
+{
+    /* bulk burst first, then control */
+    s_ctrl_seq = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT(test_sub_send(&s_sub_bulk_ept, TEST_BULK_ADDR, TEST_BULK_TAG(i)) == 0);
+    }
+    TEST_ASSERT(test_sub_send(&s_sub_ctrl_ept, TEST_CTRL_ADDR, TEST_CTRL_TAG(s_ctrl_seq++)) == 0);
+    TEST_ASSERT(test_sub_send(&s_sub_ctrl_ept, TEST_CTRL_ADDR, TEST_CTRL_TAG(s_ctrl_seq++)) == 0);
+
+    /* control arriving while the burst is drained overtakes the rest of it */
+    s_send_on_rx = TEST_BULK_TAG(1);
+    test_main_drain();
+    const uint8_t expected[] = { 'A', 'B', 'a', 'b', 'C', 'c', 'd' };
+    TEST_ASSERT(s_rx_bad == 0 && s_log_num == sizeof(expected));
+    for (int i = 0; i < s_log_num; i++) {
+        TEST_ASSERT(s_log[i] == expected[i]);
+    }
+    return 0;
+}
+
+static int test_saturated_bulk_lane(void)
+{
+    /* bulk lane full: no more bulk buffer, control lane is not affected */
+    s_ctrl_seq = 0;
+    for (uint8_t i = 0; i < TEST_BULK_QUEUE_LEN; i++) {
+        TEST_ASSERT(test_sub_send(&s_sub_bulk_ept, TEST_BULK_ADDR, TEST_BULK_TAG(i)) == 0);
+    }
+    TEST_ASSERT(esp_amp_rpmsg_create_message_by_ept(&s_sub_dev, &s_sub_bulk_ept, 1, ESP_AMP_RPMSG_DATA_DEFAULT) == NULL);
+    for (uint8_t i = 0; i < TEST_CTRL_QUEUE_LEN; i++) {
+        TEST_ASSERT(test_sub_send(&s_sub_ctrl_ept, TEST_CTRL_ADDR, TEST_CTRL_TAG(s_ctrl_seq++)) == 0);
+    }
+
+    test_main_drain();
+    TEST_ASSERT(s_rx_bad == 0 && s_log_num == TEST_CTRL_QUEUE_LEN + TEST_BULK_QUEUE_LEN);
+    for (int i = 0; i < TEST_CTRL_QUEUE_LEN; i++) {
+        TEST_ASSERT(s_log[i] == TEST_CTRL_TAG(i));
+    }
+    for (int i = 0; i < TEST_BULK_QUEUE_LEN; i++) {
+        TEST_ASSERT(s_log[TEST_CTRL_QUEUE_LEN + i] == TEST_BULK_TAG(i));
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static esp_amp_queue_t main_vqueue[4];
+    static esp_amp_queue_t sub_vqueue[4];
+    const esp_amp_rpmsg_lane_conf_t lane_conf[] = {
+        [TEST_CTRL_LANE] = { .queue_len = TEST_CTRL_QUEUE_LEN, .queue_item_size = 32 },
+        [TEST_BULK_LANE] = { .queue_len = TEST_BULK_QUEUE_LEN, .queue_item_size = 64 },
+    };
+
+    if (esp_amp_sys_info_init() != 0 ||
+            esp_amp_rpmsg_main_init_with_lanes(&s_main_dev, main_vqueue, lane_conf, 2, false, true, TEST_SYSINFO_ID) != 0 ||
+            esp_amp_rpmsg_sub_init_with_lanes(&s_sub_dev, sub_vqueue, 2, false, true, TEST_SYSINFO_ID) != 0) {
+        fprintf(stderr, "failed to init rpmsg devices\n");
+        return 1;
+    }
+    esp_amp_rpmsg_create_endpoint(&s_main_dev, TEST_CTRL_ADDR, test_main_rx_cb, NULL, &s_main_ctrl_ept);
+    esp_amp_rpmsg_create_endpoint(&s_main_dev, TEST_BULK_ADDR, test_main_rx_cb, NULL, &s_main_bulk_ept);
+    esp_amp_rpmsg_create_endpoint(&s_sub_dev, TEST_CTRL_ADDR, NULL, NULL, &s_sub_ctrl_ept);
+    esp_amp_rpmsg_create_endpoint(&s_sub_dev, TEST_BULK_ADDR, NULL, NULL, &s_sub_bulk_ept);
+    if (esp_amp_rpmsg_endpoint_set_lane(&s_sub_dev, &s_sub_bulk_ept, TEST_BULK_LANE) != 0) {
+        fprintf(stderr, "failed to bind bulk lane\n");
+        return 1;
+    }
+
+    int ret = test_lane_order() || test_saturated_bulk_lane();
+
+    printf("rpmsg lane test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
@@ -0,0 +1,146 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Main-core and sub-core rpmsg devices in one process. Sub-core runs with its clock skewed,
+ * clock sync must find the skew and latency must be measured in spite of it.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_amp_sys_info.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_latency.h"
+#include "port_host.h"
+#include "test_utils.h"
+
+#define TEST_SYSINFO_ID         (0x100)
+#define TEST_EPT_ADDR           (1)
+#define TEST_SUB_SKEW_US        (5000000)
+#define TEST_OFFSET_ERROR_US    (1000)
+#define TEST_MSG_NUM            (10)
+#define TEST_MSG_DELAY_US       (3000)
+
+static esp_amp_rpmsg_dev_t s_main_dev;
+static esp_amp_rpmsg_dev_t s_sub_dev;
+static int s_sub_rx_cnt;
+
+static int test_sub_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    s_sub_rx_cnt++;
+    esp_amp_rpmsg_destroy(&s_sub_dev, msg_data);
+    return 0;
+}
+
+static void test_poll_sub(void)
+{
+    esp_amp_host_time_skew_us = TEST_SUB_SKEW_US;
+    while (esp_amp_rpmsg_poll(&s_sub_dev) == 0) {
+    }
+    esp_amp_host_time_skew_us = 0;
+}
+
+static void test_poll_main(void)
+{
+    while (esp_amp_rpmsg_poll(&s_main_dev) == 0) {
+    }
+}
+
+static int test_histogram(void)
+{
+    esp_amp_rpmsg_latency_t latency = { 0 };
+
+    TEST_ASSERT(esp_amp_rpmsg_latency_percentile(&latency, 50) == 0);
+
+    /* 90 samples in [8, 16) us, 10 samples in [512, 1024) us */
+    latency.count = 100;
+    latency.bucket[4] = 90;
+    latency.bucket[10] = 10;
+    latency.max_us = 700;
+    TEST_ASSERT(esp_amp_rpmsg_latency_percentile(&latency, 50) == 15);
+    TEST_ASSERT(esp_amp_rpmsg_latency_percentile(&latency, 90) == 15);
+    TEST_ASSERT(esp_amp_rpmsg_latency_percentile(&latency, 91) == 700);
+    TEST_ASSERT(esp_amp_rpmsg_latency_percentile(&latency, 100) == 700);
+
+    esp_amp_rpmsg_latency_reset(&latency);
+    TEST_ASSERT(latency.count == 0 && latency.bucket[4] == 0 && latency.max_us == 0);
+    return 0;
+}
+
+static int test_clock_sync(void)
+{
+    int32_t offset;
+
+    TEST_ASSERT(esp_amp_rpmsg_clock_get_offset(&s_main_dev, &offset) == -1);
+    TEST_ASSERT(esp_amp_rpmsg_clock_sync(&s_main_dev, 8) == 0);
+    for (int i = 0; i < 16; i++) {
+        test_poll_sub();
+        test_poll_main();
+    }
+    test_poll_sub();
+
+    TEST_ASSERT(esp_amp_rpmsg_clock_get_offset(&s_main_dev, &offset) == 0);
+    printf("main-core offset %d us\n", (int)offset);
+    TEST_ASSERT(abs(offset - TEST_SUB_SKEW_US) < TEST_OFFSET_ERROR_US);
+    TEST_ASSERT(esp_amp_rpmsg_clock_get_offset(&s_sub_dev, &offset) == 0);
+    TEST_ASSERT(abs(offset + TEST_SUB_SKEW_US) < TEST_OFFSET_ERROR_US);
+    return 0;
+}
+
+static int test_latency(esp_amp_rpmsg_ept_t* main_ept, esp_amp_rpmsg_ept_t* sub_ept)
+{
+    static esp_amp_rpmsg_latency_t latency;
+    uint32_t data = 0;
+
+    TEST_ASSERT(esp_amp_rpmsg_endpoint_set_latency(&s_sub_dev, sub_ept, &latency) == 0);
+
+    /* every message waits in the queue before the sub-core polls */
+    for (int i = 0; i < TEST_MSG_NUM; i++) {
+        TEST_ASSERT(esp_amp_rpmsg_send(&s_main_dev, main_ept, TEST_EPT_ADDR, &data, sizeof(data)) == 0);
+        usleep(TEST_MSG_DELAY_US);
+        test_poll_sub();
+    }
+
+    uint32_t p50 = esp_amp_rpmsg_latency_percentile(&latency, 50);
+    uint32_t p99 = esp_amp_rpmsg_latency_percentile(&latency, 99);
+    printf("latency p50 %u us, p99 %u us, max %u us\n", (unsigned)p50, (unsigned)p99, (unsigned)latency.max_us);
+    TEST_ASSERT(s_sub_rx_cnt == TEST_MSG_NUM);
+    TEST_ASSERT(latency.count == TEST_MSG_NUM);
+    TEST_ASSERT(p50 >= TEST_MSG_DELAY_US - TEST_OFFSET_ERROR_US && p50 <= p99 && p99 <= latency.max_us);
+    TEST_ASSERT(latency.max_us < 1000000);
+
+    TEST_ASSERT(esp_amp_rpmsg_endpoint_set_latency(&s_sub_dev, sub_ept, NULL) == 0);
+    TEST_ASSERT(esp_amp_rpmsg_send(&s_main_dev, main_ept, TEST_EPT_ADDR, &data, sizeof(data)) == 0);
+    test_poll_sub();
+    TEST_ASSERT(latency.count == TEST_MSG_NUM);
+    return 0;
+}
+
+int main(void)
+{
+    static esp_amp_queue_t main_vqueue[2];
+    static esp_amp_queue_t sub_vqueue[2];
+    static esp_amp_rpmsg_ept_t main_ept;
+    static esp_amp_rpmsg_ept_t sub_ept;
+
+    if (esp_amp_sys_info_init() != 0 ||
+            esp_amp_rpmsg_main_init_by_id(&s_main_dev, main_vqueue, 4, 64, false, true, TEST_SYSINFO_ID) != 0 ||
+            esp_amp_rpmsg_sub_init_by_id(&s_sub_dev, sub_vqueue, false, true, TEST_SYSINFO_ID) != 0) {
+        fprintf(stderr, "failed to init rpmsg devices\n");
+        return 1;
+    }
+    esp_amp_rpmsg_create_endpoint(&s_main_dev, TEST_EPT_ADDR, NULL, NULL, &main_ept);
+    esp_amp_rpmsg_create_endpoint(&s_sub_dev, TEST_EPT_ADDR, test_sub_rx_cb, NULL, &sub_ept);
+
+    int ret = test_histogram() || test_clock_sync() || test_latency(&main_ept, &sub_ept);
+
+    printf("rpmsg latency test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
@@ -0,0 +1,181 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Built with CONFIG_ESP_AMP_RPMSG_BUF_REFCNT. Sub-core fills the whole queue, main-core shares every received buffer
+ * between its endpoint callback and one more consumer, then both drop their references out of order.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_amp_sys_info.h"
+#include "esp_amp_rpmsg.h"
+#include "test_utils.h"
+
+#define TEST_SYSINFO_ID         (0x100)
+#define TEST_EPT_ADDR           (1)
+#define TEST_QUEUE_LEN          (8)
+#define TEST_ROUND_NUM          (6)
+
+#if !CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+#error "test must be built with CONFIG_ESP_AMP_RPMSG_BUF_REFCNT"
+#endif
+
+static esp_amp_rpmsg_dev_t s_main_dev;
+static esp_amp_rpmsg_dev_t s_sub_dev;
+static esp_amp_rpmsg_ept_t s_main_ept;
+static esp_amp_rpmsg_ept_t s_sub_ept;
+
+static void* s_rx_buf[TEST_QUEUE_LEN];
+static int s_rx_num;
+static uint32_t s_rx_seq;
+static int s_rx_bad;
+static void* s_tx_buf[TEST_QUEUE_LEN];
+static uint32_t s_tx_seq;
+
+static int test_main_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    if (data_len != sizeof(uint32_t) || *(uint32_t*)msg_data != s_rx_seq || s_rx_num == TEST_QUEUE_LEN) {
+        s_rx_bad++;
+    }
+    s_rx_seq++;
+
+    // keep the reference of the callback, take one more for another consumer
+    if (esp_amp_rpmsg_buf_ref(&s_main_dev, msg_data) != 0) {
+        s_rx_bad++;
+    }
+    s_rx_buf[s_rx_num++] = msg_data;
+    return 0;
+}
+
+static bool test_is_tx_buf(void* buf)
+{
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        if (s_tx_buf[i] == buf) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* virtqueue indexes are free running, their distance is the number of buffers owned by the other side */
+static int test_check_index(uint16_t rx_held, uint16_t tx_allocated)
+{
+    esp_amp_queue_t* rx_queue = s_main_dev.rx_queue;
+    esp_amp_queue_t* tx_queue = s_sub_dev.tx_queue;
+
+    TEST_ASSERT((uint16_t)(rx_queue->free_index - rx_queue->used_index) == rx_held);
+    TEST_ASSERT((uint16_t)(tx_queue->free_index - tx_queue->used_index) == tx_allocated);
+    TEST_ASSERT(tx_queue->used_index == rx_queue->free_index);
+    return 0;
+}
+
+static int test_round(const int order_a[], const int order_b[])
+{
+    /* sub-core fills the queue */
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        TEST_ASSERT(test_is_tx_buf(s_tx_buf[i]));
+        *(uint32_t*)s_tx_buf[i] = s_tx_seq++;
+        TEST_ASSERT(esp_amp_rpmsg_send_nocopy(&s_sub_dev, &s_sub_ept, TEST_EPT_ADDR, s_tx_buf[i], sizeof(uint32_t)) == 0);
+    }
+    TEST_ASSERT(esp_amp_rpmsg_create_message(&s_sub_dev, sizeof(uint32_t), ESP_AMP_RPMSG_DATA_DEFAULT) == NULL);
+
+    s_rx_num = 0;
+    while (esp_amp_rpmsg_poll(&s_main_dev) == 0) {
+    }
+    TEST_ASSERT(s_rx_num == TEST_QUEUE_LEN && s_rx_bad == 0);
+    TEST_ASSERT(test_check_index(TEST_QUEUE_LEN, 0) == 0);
+
+    /* first consumer drops all its references, the callback still holds every buffer */
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        TEST_ASSERT(esp_amp_rpmsg_buf_unref(&s_main_dev, s_rx_buf[order_a[i]]) == 0);
+    }
+    TEST_ASSERT(esp_amp_rpmsg_create_message(&s_sub_dev, sizeof(uint32_t), ESP_AMP_RPMSG_DATA_DEFAULT) == NULL);
+    TEST_ASSERT(test_check_index(TEST_QUEUE_LEN, 0) == 0);
+
+    /* every last reference gives exactly one buffer back, whatever slot it was received in */
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        void* rx_buf = s_rx_buf[order_b[i]];
+        TEST_ASSERT(esp_amp_rpmsg_buf_unref(&s_main_dev, rx_buf) == 0);
+        void* tx_buf = esp_amp_rpmsg_create_message(&s_sub_dev, sizeof(uint32_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+        TEST_ASSERT(tx_buf == rx_buf);
+        TEST_ASSERT(esp_amp_rpmsg_create_message(&s_sub_dev, sizeof(uint32_t), ESP_AMP_RPMSG_DATA_DEFAULT) == NULL);
+        TEST_ASSERT(test_check_index(TEST_QUEUE_LEN - 1 - i, i + 1) == 0);
+        s_rx_buf[order_b[i]] = NULL;
+        s_tx_buf[i] = tx_buf;
+    }
+
+    /* the sender got back the same set of buffers, each once */
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        for (int j = i + 1; j < TEST_QUEUE_LEN; j++) {
+            TEST_ASSERT(s_tx_buf[i] != s_tx_buf[j]);
+        }
+    }
+    return 0;
+}
+
+static void test_shuffle(int order[], unsigned int seed)
+{
+    srand(seed);
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        order[i] = i;
+    }
+    for (int i = TEST_QUEUE_LEN - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+}
+
+static int test_out_of_order_release(void)
+{
+    int forward[TEST_QUEUE_LEN];
+    int reverse[TEST_QUEUE_LEN];
+    int shuffled[TEST_QUEUE_LEN];
+
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        forward[i] = i;
+        reverse[i] = TEST_QUEUE_LEN - 1 - i;
+    }
+
+    /* take all buffers once to know the set of buffers of the queue */
+    for (int i = 0; i < TEST_QUEUE_LEN; i++) {
+        s_tx_buf[i] = esp_amp_rpmsg_create_message(&s_sub_dev, sizeof(uint32_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+        TEST_ASSERT(s_tx_buf[i] != NULL);
+    }
+
+    /* several rounds so that both flip counters wrap with buffers out of their original slots */
+    TEST_ASSERT(test_round(forward, reverse) == 0);
+    for (int round = 1; round < TEST_ROUND_NUM; round++) {
+        test_shuffle(shuffled, round);
+        TEST_ASSERT(test_round(round % 2 ? reverse : shuffled, shuffled) == 0);
+    }
+    TEST_ASSERT(s_rx_seq == TEST_ROUND_NUM * TEST_QUEUE_LEN);
+    return 0;
+}
+
+int main(void)
+{
+    static esp_amp_queue_t main_vqueue[2];
+    static esp_amp_queue_t sub_vqueue[2];
+
+    if (esp_amp_sys_info_init() != 0 ||
+            esp_amp_rpmsg_main_init_by_id(&s_main_dev, main_vqueue, TEST_QUEUE_LEN, 64, false, true, TEST_SYSINFO_ID) != 0 ||
+            esp_amp_rpmsg_sub_init_by_id(&s_sub_dev, sub_vqueue, false, true, TEST_SYSINFO_ID) != 0) {
+        fprintf(stderr, "failed to init rpmsg devices\n");
+        return 1;
+    }
+    esp_amp_rpmsg_create_endpoint(&s_main_dev, TEST_EPT_ADDR, test_main_rx_cb, NULL, &s_main_ept);
+    esp_amp_rpmsg_create_endpoint(&s_sub_dev, TEST_EPT_ADDR, NULL, NULL, &s_sub_ept);
+
+    int ret = test_out_of_order_release();
+
+    printf("rpmsg refcnt test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
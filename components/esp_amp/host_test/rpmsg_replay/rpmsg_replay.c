@@ -0,0 +1,358 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Replay a trace dumped by esp_amp_rpmsg_trace_dump() through the queue/rpmsg code on host.
+ *
+ * Both cores are simulated by two rpmsg devices in polling mode. Every recorded message is sent
+ * again in the recorded direction, on the recorded lane, with the recorded size and captured payload,
+ * at the recorded time (scaled by speed factor). Throughput and send-to-receive latency are reported,
+ * and compared with optional thresholds to catch regressions.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_amp_sys_info.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_trace.h"
+
+#define REPLAY_SYSINFO_ID       (0x100)
+#define REPLAY_EPT_NUM_MAX      (64)
+
+#define REPLAY_EXIT_OK          (0)
+#define REPLAY_EXIT_ERROR       (1)
+#define REPLAY_EXIT_REGRESSION  (2)
+
+typedef struct replay_inflight_t {
+    uint32_t record_idx;
+    uint64_t send_ns;
+} replay_inflight_t;
+
+typedef struct replay_side_t {
+    esp_amp_rpmsg_dev_t dev;
+    esp_amp_queue_t vqueue[2 * ESP_AMP_RPMSG_LANE_NUM_MAX];
+    esp_amp_rpmsg_ept_t epts[REPLAY_EPT_NUM_MAX];
+    int ept_num;
+    /* messages sent towards this side, per lane in virtqueue order */
+    replay_inflight_t* inflight[ESP_AMP_RPMSG_LANE_NUM_MAX];
+    uint16_t inflight_len[ESP_AMP_RPMSG_LANE_NUM_MAX];
+    uint32_t inflight_head[ESP_AMP_RPMSG_LANE_NUM_MAX];
+    uint32_t inflight_tail[ESP_AMP_RPMSG_LANE_NUM_MAX];
+} replay_side_t;
+
+typedef struct replay_ctx_t {
+    esp_amp_rpmsg_trace_file_head_t head;
+    uint8_t* records;
+    replay_side_t side[2];          /* [0]: main-core, [1]: sub-core */
+    uint64_t msg_num;
+    uint64_t byte_num;
+    uint64_t stall_num;             /* sender found no free buffer and had to wait for receiver */
+    uint64_t error_num;
+    uint64_t latency_sum_ns;
+    uint64_t latency_max_ns;
+} replay_ctx_t;
+
+static replay_ctx_t s_ctx;
+
+static uint64_t replay_get_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static const esp_amp_rpmsg_trace_record_t* replay_get_record(uint32_t idx)
+{
+    return (const esp_amp_rpmsg_trace_record_t*)(s_ctx.records + (size_t)idx * s_ctx.head.record_size);
+}
+
+static const uint8_t* replay_get_payload(const esp_amp_rpmsg_trace_record_t* record)
+{
+    return (const uint8_t*)record + sizeof(esp_amp_rpmsg_trace_record_t);
+}
+
+static int replay_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    replay_side_t* side = (replay_side_t*)rx_cb_data;
+    esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)((uint8_t*)msg_data - offsetof(esp_amp_rpmsg_t, msg_data));
+    uint8_t lane = ESP_AMP_RPMSG_DATA_GET_LANE(rpmsg->msg_head.data_flags);
+    uint64_t now = replay_get_time_ns();
+
+    if (side->inflight_head[lane] == side->inflight_tail[lane]) {
+        fprintf(stderr, "unexpected message from 0x%x on lane %d\n", src_addr, lane);
+        s_ctx.error_num++;
+        esp_amp_rpmsg_destroy(&side->dev, msg_data);
+        return 0;
+    }
+
+    replay_inflight_t* inflight = &side->inflight[lane][side->inflight_head[lane]++ % side->inflight_len[lane]];
+    const esp_amp_rpmsg_trace_record_t* record = replay_get_record(inflight->record_idx);
+
+    if (data_len != record->data_len || src_addr != record->src_addr || rpmsg->msg_head.dst_addr != record->dst_addr ||
+            memcmp(msg_data, replay_get_payload(record), record->payload_len) != 0) {
+        fprintf(stderr, "record %u: message mismatch\n", inflight->record_idx);
+        s_ctx.error_num++;
+    }
+
+    uint64_t latency = now - inflight->send_ns;
+    s_ctx.latency_sum_ns += latency;
+    if (latency > s_ctx.latency_max_ns) {
+        s_ctx.latency_max_ns = latency;
+    }
+    s_ctx.msg_num++;
+    s_ctx.byte_num += data_len;
+
+    esp_amp_rpmsg_destroy(&side->dev, msg_data);
+    return 0;
+}
+
+static esp_amp_rpmsg_ept_t* replay_get_ept(replay_side_t* side, uint16_t addr)
+{
+    for (int i = 0; i < side->ept_num; i++) {
+        if (side->epts[i].addr == addr) {
+            return &side->epts[i];
+        }
+    }
+
+    if (side->ept_num == REPLAY_EPT_NUM_MAX) {
+        return NULL;
+    }
+    esp_amp_rpmsg_ept_t* ept = &side->epts[side->ept_num];
+    if (esp_amp_rpmsg_create_endpoint(&side->dev, addr, replay_rx_cb, (void*)side, ept) == NULL) {
+        return NULL;
+    }
+    side->ept_num++;
+    return ept;
+}
+
+static void replay_poll_all(void)
+{
+    bool busy = true;
+    while (busy) {
+        busy = false;
+        for (int i = 0; i < 2; i++) {
+            if (esp_amp_rpmsg_poll(&s_ctx.side[i].dev) == 0) {
+                busy = true;
+            }
+        }
+    }
+}
+
+static int replay_load(const char* path)
+{
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    esp_amp_rpmsg_trace_file_head_t* head = &s_ctx.head;
+    if (fread(head, sizeof(*head), 1, fp) != 1 || head->magic != ESP_AMP_RPMSG_TRACE_MAGIC ||
+            head->version != ESP_AMP_RPMSG_TRACE_VERSION || head->record_size < sizeof(esp_amp_rpmsg_trace_record_t) ||
+            head->lane_num == 0 || head->lane_num > ESP_AMP_RPMSG_LANE_NUM_MAX) {
+        fprintf(stderr, "%s: not a valid rpmsg trace\n", path);
+        fclose(fp);
+        return -1;
+    }
+
+    s_ctx.records = malloc((size_t)head->record_num * head->record_size + 1);
+    if (s_ctx.records == NULL || fread(s_ctx.records, head->record_size, head->record_num, fp) != head->record_num) {
+        fprintf(stderr, "%s: truncated trace\n", path);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+static int replay_setup(void)
+{
+    esp_amp_rpmsg_lane_conf_t lane_conf[ESP_AMP_RPMSG_LANE_NUM_MAX];
+    for (uint8_t lane = 0; lane < s_ctx.head.lane_num; lane++) {
+        lane_conf[lane].queue_len = s_ctx.head.queue_len[lane];
+        lane_conf[lane].queue_item_size = s_ctx.head.queue_item_size[lane];
+    }
+
+    if (esp_amp_sys_info_init() != 0 ||
+            esp_amp_rpmsg_main_init_with_lanes(&s_ctx.side[0].dev, s_ctx.side[0].vqueue, lane_conf, s_ctx.head.lane_num, false, true, REPLAY_SYSINFO_ID) != 0 ||
+            esp_amp_rpmsg_sub_init_with_lanes(&s_ctx.side[1].dev, s_ctx.side[1].vqueue, s_ctx.head.lane_num, false, true, REPLAY_SYSINFO_ID) != 0) {
+        fprintf(stderr, "failed to init rpmsg devices\n");
+        return -1;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        replay_side_t* side = &s_ctx.side[i];
+        for (uint8_t lane = 0; lane < s_ctx.head.lane_num; lane++) {
+            // in-flight messages of one lane never exceed its queue length
+            side->inflight_len[lane] = side->vqueue[2 * lane + 1].size;
+            side->inflight[lane] = calloc(side->inflight_len[lane], sizeof(replay_inflight_t));
+            if (side->inflight[lane] == NULL) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int replay_send(uint32_t idx, replay_side_t* from, replay_side_t* to)
+{
+    const esp_amp_rpmsg_trace_record_t* record = replay_get_record(idx);
+    uint8_t lane = ESP_AMP_RPMSG_DATA_GET_LANE(record->data_flags);
+    esp_amp_rpmsg_ept_t* src_ept = replay_get_ept(from, record->src_addr);
+
+    if (lane >= s_ctx.head.lane_num || src_ept == NULL || replay_get_ept(to, record->dst_addr) == NULL ||
+            record->data_len > esp_amp_rpmsg_get_lane_max_size(&from->dev, lane)) {
+        fprintf(stderr, "record %u: can't be replayed\n", idx);
+        return -1;
+    }
+
+    esp_amp_rpmsg_endpoint_set_lane(&from->dev, src_ept, lane);
+
+    void* data = esp_amp_rpmsg_create_message_by_ept(&from->dev, src_ept, record->data_len, record->data_flags & ~ESP_AMP_RPMSG_DATA_LANE_MASK);
+    if (data == NULL) {
+        // receiver hasn't given buffers back yet
+        s_ctx.stall_num++;
+        replay_poll_all();
+        data = esp_amp_rpmsg_create_message_by_ept(&from->dev, src_ept, record->data_len, record->data_flags & ~ESP_AMP_RPMSG_DATA_LANE_MASK);
+        if (data == NULL) {
+            fprintf(stderr, "record %u: no buffer available\n", idx);
+            return -1;
+        }
+    }
+
+    memset(data, 0, record->data_len);
+    memcpy(data, replay_get_payload(record), record->payload_len);
+
+    replay_inflight_t* inflight = &to->inflight[lane][to->inflight_tail[lane]++ % to->inflight_len[lane]];
+    inflight->record_idx = idx;
+    inflight->send_ns = replay_get_time_ns();
+
+    if (esp_amp_rpmsg_send_nocopy(&from->dev, src_ept, record->dst_addr, data, record->data_len) != 0) {
+        to->inflight_tail[lane]--;
+        fprintf(stderr, "record %u: failed to send\n", idx);
+        return -1;
+    }
+    return 0;
+}
+
+static void replay_run(double speed)
+{
+    // records of the traced core: TX goes from this core to the other, RX the opposite
+    replay_side_t* local = s_ctx.head.main_core ? &s_ctx.side[0] : &s_ctx.side[1];
+    replay_side_t* remote = s_ctx.head.main_core ? &s_ctx.side[1] : &s_ctx.side[0];
+    uint64_t start_ns = replay_get_time_ns();
+    uint64_t offset_us = 0;
+
+    for (uint32_t i = 0; i < s_ctx.head.record_num; i++) {
+        const esp_amp_rpmsg_trace_record_t* record = replay_get_record(i);
+
+        if (i > 0) {
+            // timestamp wraps around, accumulate the difference
+            offset_us += (uint32_t)(record->timestamp_us - replay_get_record(i - 1)->timestamp_us);
+        }
+        if (speed > 0) {
+            uint64_t due_ns = start_ns + (uint64_t)(offset_us * 1000 / speed);
+            while (replay_get_time_ns() < due_ns) {
+                replay_poll_all();
+            }
+        }
+
+        bool tx = (record->dir == ESP_AMP_RPMSG_TRACE_DIR_TX);
+        if (replay_send(i, tx ? local : remote, tx ? remote : local) != 0) {
+            s_ctx.error_num++;
+        }
+        replay_poll_all();
+    }
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, "usage: %s [-s speed] [-r repeat] [-L max_avg_latency_ns] [-T min_msgs_per_sec] trace.bin\n"
+            "  -s  replay speed relative to the recorded timing, 0 to replay as fast as possible (default 1)\n"
+            "  -r  number of times to replay the trace (default 1)\n"
+            "  -L  fail if average send-to-receive latency exceeds this value\n"
+            "  -T  fail if throughput is lower than this value\n", prog);
+}
+
+int main(int argc, char* argv[])
+{
+    double speed = 1;
+    int repeat = 1;
+    double max_latency_ns = 0;
+    double min_throughput = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:r:L:T:h")) != -1) {
+        switch (opt) {
+        case 's':
+            speed = atof(optarg);
+            break;
+        case 'r':
+            repeat = atoi(optarg);
+            break;
+        case 'L':
+            max_latency_ns = atof(optarg);
+            break;
+        case 'T':
+            min_throughput = atof(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return REPLAY_EXIT_ERROR;
+        }
+    }
+    if (optind != argc - 1 || speed < 0 || repeat < 1) {
+        usage(argv[0]);
+        return REPLAY_EXIT_ERROR;
+    }
+
+    if (replay_load(argv[optind]) != 0 || replay_setup() != 0) {
+        return REPLAY_EXIT_ERROR;
+    }
+
+    printf("trace: %u records (%u dropped before dump), %d lanes, recorded by %s\n", s_ctx.head.record_num,
+           s_ctx.head.dropped, s_ctx.head.lane_num, s_ctx.head.main_core ? "main-core" : "sub-core");
+
+    uint64_t start_ns = replay_get_time_ns();
+    for (int i = 0; i < repeat; i++) {
+        replay_run(speed);
+    }
+    replay_poll_all();
+    uint64_t elapsed_ns = replay_get_time_ns() - start_ns;
+
+    uint64_t expected = (uint64_t)s_ctx.head.record_num * repeat;
+    if (s_ctx.msg_num != expected) {
+        fprintf(stderr, "%llu of %llu messages received\n", (unsigned long long)s_ctx.msg_num, (unsigned long long)expected);
+        s_ctx.error_num++;
+    }
+
+    double elapsed_s = elapsed_ns / 1e9;
+    double throughput = elapsed_s > 0 ? s_ctx.msg_num / elapsed_s : 0;
+    double latency_avg_ns = s_ctx.msg_num > 0 ? (double)s_ctx.latency_sum_ns / s_ctx.msg_num : 0;
+
+    printf("replayed: %llu messages, %llu bytes in %.3f ms\n", (unsigned long long)s_ctx.msg_num,
+           (unsigned long long)s_ctx.byte_num, elapsed_ns / 1e6);
+    printf("throughput: %.0f msgs/s, %.1f KB/s\n", throughput, elapsed_s > 0 ? s_ctx.byte_num / elapsed_s / 1024 : 0);
+    printf("latency: avg %.0f ns, max %llu ns\n", latency_avg_ns, (unsigned long long)s_ctx.latency_max_ns);
+    printf("stalls: %llu, errors: %llu\n", (unsigned long long)s_ctx.stall_num, (unsigned long long)s_ctx.error_num);
+
+    if (s_ctx.error_num != 0) {
+        return REPLAY_EXIT_ERROR;
+    }
+    if ((max_latency_ns > 0 && latency_avg_ns > max_latency_ns) || (min_throughput > 0 && throughput < min_throughput)) {
+        fprintf(stderr, "performance regression detected\n");
+        return REPLAY_EXIT_REGRESSION;
+    }
+    return REPLAY_EXIT_OK;
+}
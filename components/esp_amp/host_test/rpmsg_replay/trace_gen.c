@@ -0,0 +1,115 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Record a synthetic trace with the rpmsg traffic recorder on host, used to test the replayer.
+ * Main-core sends small control messages on lane 0 and bulk data on lane 1, sub-core answers
+ * every control message. Only the main-core device is traced, like on target.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_amp_sys_info.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_trace.h"
+
+#define GEN_SYSINFO_ID          (0x100)
+#define GEN_ROUND_NUM           (64)
+#define GEN_EPT_CTRL            (1)
+#define GEN_EPT_BULK            (2)
+
+static esp_amp_rpmsg_dev_t s_main_dev;
+static esp_amp_rpmsg_dev_t s_sub_dev;
+
+static int gen_main_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    esp_amp_rpmsg_destroy(&s_main_dev, msg_data);
+    return 0;
+}
+
+static int gen_sub_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    esp_amp_rpmsg_ept_t* ept = (esp_amp_rpmsg_ept_t*)rx_cb_data;
+    if (ept->addr == GEN_EPT_CTRL) {
+        uint32_t ack = *(uint32_t*)msg_data + 1;
+        esp_amp_rpmsg_send(&s_sub_dev, ept, src_addr, &ack, sizeof(ack));
+    }
+    esp_amp_rpmsg_destroy(&s_sub_dev, msg_data);
+    return 0;
+}
+
+static int gen_write_cb(const void* data, uint16_t len, void* write_arg)
+{
+    return fwrite(data, len, 1, (FILE*)write_arg) == 1 ? 0 : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    static esp_amp_queue_t main_vqueue[4];
+    static esp_amp_queue_t sub_vqueue[4];
+    static esp_amp_rpmsg_ept_t main_ept[2];
+    static esp_amp_rpmsg_ept_t sub_ept[2];
+    const esp_amp_rpmsg_lane_conf_t lane_conf[2] = {
+        { .queue_len = 4, .queue_item_size = 32 },
+        { .queue_len = 8, .queue_item_size = 256 },
+    };
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s trace.bin\n", argv[0]);
+        return 1;
+    }
+
+    if (esp_amp_sys_info_init() != 0 ||
+            esp_amp_rpmsg_main_init_with_lanes(&s_main_dev, main_vqueue, lane_conf, 2, false, true, GEN_SYSINFO_ID) != 0 ||
+            esp_amp_rpmsg_sub_init_with_lanes(&s_sub_dev, sub_vqueue, 2, false, true, GEN_SYSINFO_ID) != 0) {
+        fprintf(stderr, "failed to init rpmsg devices\n");
+        return 1;
+    }
+
+    esp_amp_rpmsg_create_endpoint(&s_main_dev, GEN_EPT_CTRL, gen_main_rx_cb, NULL, &main_ept[0]);
+    esp_amp_rpmsg_create_endpoint(&s_main_dev, GEN_EPT_BULK, gen_main_rx_cb, NULL, &main_ept[1]);
+    esp_amp_rpmsg_create_endpoint(&s_sub_dev, GEN_EPT_CTRL, gen_sub_rx_cb, &sub_ept[0], &sub_ept[0]);
+    esp_amp_rpmsg_create_endpoint(&s_sub_dev, GEN_EPT_BULK, gen_sub_rx_cb, &sub_ept[1], &sub_ept[1]);
+    esp_amp_rpmsg_endpoint_set_lane(&s_main_dev, &main_ept[1], 1);
+
+    esp_amp_rpmsg_trace_start(&s_main_dev);
+
+    uint8_t bulk[200];
+    for (uint32_t round = 0; round < GEN_ROUND_NUM; round++) {
+        if (esp_amp_rpmsg_send(&s_main_dev, &main_ept[0], GEN_EPT_CTRL, &round, sizeof(round)) != 0) {
+            fprintf(stderr, "failed to send control message\n");
+            return 1;
+        }
+        for (int i = 0; i < 3; i++) {
+            memset(bulk, (uint8_t)(round + i), sizeof(bulk));
+            if (esp_amp_rpmsg_send(&s_main_dev, &main_ept[1], GEN_EPT_BULK, bulk, 40 * (i + 1) + round % 7) != 0) {
+                fprintf(stderr, "failed to send bulk message\n");
+                return 1;
+            }
+        }
+
+        while (esp_amp_rpmsg_poll(&s_sub_dev) == 0) {
+        }
+        while (esp_amp_rpmsg_poll(&s_main_dev) == 0) {
+        }
+        usleep(200);
+    }
+
+    esp_amp_rpmsg_trace_stop();
+
+    FILE* fp = fopen(argv[1], "wb");
+    if (fp == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    int ret = esp_amp_rpmsg_trace_dump(gen_write_cb, fp);
+    fclose(fp);
+
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+ * Two chips talking rpmsg over the serial transport. Each side writes encoded frames to
+ * one end of a socketpair, which stands in for a UART, and feeds what it reads from it.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_serial.h"
+#include "test_utils.h"
+
+#define TEST_EPT_ECHO           (1)
+#define TEST_EPT_SINK           (2)
+#define TEST_PUMP_ROUND         (16)
+
+typedef struct test_node_t {
+    int fd;
+    int corrupt_at;                 /* flip one written byte at this offset, -1 to disable */
+    int written;
+    uint8_t* capture;               /* keep written bytes here instead of writing them to the link, NULL to disable */
+    int capture_len;
+    esp_amp_rpmsg_dev_t dev;
+    esp_amp_rpmsg_serial_t serial;
+    esp_amp_rpmsg_ept_t ept;
+    uint8_t last_rx[ESP_AMP_RPMSG_SERIAL_ITEM_SIZE];
+    uint16_t last_rx_len;
+    int rx_cnt;
+} test_node_t;
+
+static test_node_t s_node[2];
+
+static int test_write_cb(const void* data, uint16_t len, void* write_arg)
+{
+    test_node_t* node = (test_node_t*)write_arg;
+    uint8_t buf[ESP_AMP_RPMSG_SERIAL_ITEM_SIZE * 2 + 8];
+
+    memcpy(buf, data, len);
+    if (node->corrupt_at >= node->written && node->corrupt_at < node->written + len) {
+        buf[node->corrupt_at - node->written] ^= 0x01;
+        node->corrupt_at = -1;
+    }
+    node->written += len;
+
+    if (node->capture != NULL) {
+        memcpy(node->capture + node->capture_len, buf, len);
+        node->capture_len += len;
+        return 0;
+    }
+    return write(node->fd, buf, len) == len ? 0 : -1;
+}
+
+/* echo endpoint on node 1 sends every message back to its source */
+static int test_echo_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    test_node_t* node = (test_node_t*)rx_cb_data;
+    void* reply = esp_amp_rpmsg_create_message(&node->dev, data_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+
+    node->rx_cnt++;
+    if (reply != NULL) {
+        memcpy(reply, msg_data, data_len);
+        esp_amp_rpmsg_send_nocopy(&node->dev, &node->ept, src_addr, reply, data_len);
+    }
+    esp_amp_rpmsg_destroy(&node->dev, msg_data);
+    return 0;
+}
+
+static int test_sink_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    test_node_t* node = (test_node_t*)rx_cb_data;
+
+    memcpy(node->last_rx, msg_data, data_len);
+    node->last_rx_len = data_len;
+    node->rx_cnt++;
+    esp_amp_rpmsg_destroy(&node->dev, msg_data);
+    return 0;
+}
+
+/* move bytes between both nodes until the link is idle */
+static void test_pump(void)
+{
+    uint8_t buf[64];
+
+    for (int round = 0; round < TEST_PUMP_ROUND; round++) {
+        for (int i = 0; i < 2; i++) {
+            esp_amp_rpmsg_serial_flush(&s_node[i].serial);
+        }
+        for (int i = 0; i < 2; i++) {
+            ssize_t len;
+            while ((len = read(s_node[i].fd, buf, sizeof(buf))) > 0) {
+                esp_amp_rpmsg_serial_feed(&s_node[i].serial, buf, len);
+                esp_amp_rpmsg_poll(&s_node[i].dev);
+            }
+            while (esp_amp_rpmsg_poll(&s_node[i].dev) == 0) {
+            }
+        }
+    }
+}
+
+static int test_send(uint16_t len, uint8_t seed)
+{
+    test_node_t* node = &s_node[0];
+    uint8_t* data = esp_amp_rpmsg_create_message(&node->dev, len, ESP_AMP_RPMSG_DATA_DEFAULT);
+
+    if (data == NULL) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        /* make sure frame delimiter and escape bytes appear in payload */
+        data[i] = (i % 3 == 0) ? 0x7E : (i % 3 == 1) ? 0x7D : (uint8_t)(seed + i);
+    }
+    return esp_amp_rpmsg_send_nocopy(&node->dev, &node->ept, TEST_EPT_ECHO, data, len);
+}
+
+static int test_check_echo(uint16_t len, uint8_t seed)
+{
+    test_node_t* node = &s_node[0];
+
+    if (node->last_rx_len != len) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t expect = (i % 3 == 0) ? 0x7E : (i % 3 == 1) ? 0x7D : (uint8_t)(seed + i);
+        if (node->last_rx[i] != expect) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int test_echo(void)
+{
+    const uint16_t max_len = ESP_AMP_RPMSG_SERIAL_ITEM_SIZE - sizeof(esp_amp_rpmsg_head_t);
+    const uint16_t sizes[] = { 1, 2, 3, 16, 31, 32, 33, 64, max_len };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        int rx_cnt = s_node[0].rx_cnt;
+        TEST_ASSERT(test_send(sizes[i], i) == 0);
+        test_pump();
+        TEST_ASSERT(s_node[0].rx_cnt == rx_cnt + 1);
+        TEST_ASSERT(test_check_echo(sizes[i], i) == 0);
+    }
+
+    /* burst filling all TX buffers before the link is flushed */
+    int rx_cnt = s_node[0].rx_cnt;
+    for (int i = 0; i < ESP_AMP_RPMSG_SERIAL_TX_BUF_NUM; i++) {
+        TEST_ASSERT(test_send(24, i) == 0);
+    }
+    TEST_ASSERT(esp_amp_rpmsg_create_message(&s_node[0].dev, 24, ESP_AMP_RPMSG_DATA_DEFAULT) == NULL);
+    test_pump();
+    TEST_ASSERT(s_node[0].rx_cnt == rx_cnt + ESP_AMP_RPMSG_SERIAL_TX_BUF_NUM);
+
+    TEST_ASSERT(s_node[0].serial.rx_error == 0 && s_node[1].serial.rx_error == 0);
+    return 0;
+}
+
+static int test_corrupted_frame(void)
+{
+    int rx_cnt = s_node[1].rx_cnt;
+
+    /* flip a payload byte of the next frame, it must be dropped and the next frame still decoded */
+    s_node[0].corrupt_at = s_node[0].written + 12;
+    TEST_ASSERT(test_send(20, 0x55) == 0);
+    test_pump();
+    TEST_ASSERT(s_node[1].rx_cnt == rx_cnt);
+    TEST_ASSERT(s_node[1].serial.rx_error == 1);
+
+    TEST_ASSERT(test_send(20, 0x66) == 0);
+    test_pump();
+    TEST_ASSERT(s_node[1].rx_cnt == rx_cnt + 1);
+    TEST_ASSERT(test_check_echo(20, 0x66) == 0);
+
+    /* garbage between frames is discarded on resync */
+    const uint8_t garbage[] = { 0x11, 0x22, 0x7D, 0x7E, 0x33 };
+    TEST_ASSERT(write(s_node[0].fd, garbage, sizeof(garbage)) == sizeof(garbage));
+    TEST_ASSERT(test_send(8, 0x77) == 0);
+    test_pump();
+    TEST_ASSERT(s_node[1].rx_cnt == rx_cnt + 2);
+    TEST_ASSERT(test_check_echo(8, 0x77) == 0);
+    return 0;
+}
+
+/* same CRC-16/CCITT-FALSE as the transport, to forge frames which pass the CRC check */
+static uint16_t test_crc16(uint16_t crc, const uint8_t* data, int len)
+{
+    for (int i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static int test_put_escaped(uint8_t* out, uint8_t byte)
+{
+    if (byte == 0x7E || byte == 0x7D) {
+        out[0] = 0x7D;
+        out[1] = byte ^ 0x20;
+        return 2;
+    }
+    out[0] = byte;
+    return 1;
+}
+
+static int test_format_mismatch(void)
+{
+    uint8_t wire[ESP_AMP_RPMSG_SERIAL_ITEM_SIZE * 2 + 8];
+    uint8_t frame[ESP_AMP_RPMSG_SERIAL_ITEM_SIZE + 3];
+    int frame_len = 0;
+    int rx_cnt = s_node[1].rx_cnt;
+    int rx_error = s_node[1].serial.rx_error;
+
+    /* capture one encoded frame and decode it by hand */
+    s_node[0].capture = wire;
+    s_node[0].capture_len = 0;
+    TEST_ASSERT(test_send(20, 0x44) == 0);
+    TEST_ASSERT(esp_amp_rpmsg_serial_flush(&s_node[0].serial) == 1);
+    s_node[0].capture = NULL;
+    TEST_ASSERT(wire[0] == 0x7E && wire[s_node[0].capture_len - 1] == 0x7E);
+    for (int i = 1; i < s_node[0].capture_len - 1; i++) {
+        frame[frame_len++] = (wire[i] == 0x7D) ? (wire[++i] ^ 0x20) : wire[i];
+    }
+    TEST_ASSERT(frame_len == 1 + (int)sizeof(esp_amp_rpmsg_head_t) + 20 + 2);
+    TEST_ASSERT((frame[0] & 0x0F) == 1);
+#if CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+    TEST_ASSERT(frame[0] & (1 << 4));
+#else
+    TEST_ASSERT(!(frame[0] & (1 << 4)));
+#endif
+
+    /* the untouched frame is accepted */
+    TEST_ASSERT(write(s_node[0].fd, wire, s_node[0].capture_len) == s_node[0].capture_len);
+    test_pump();
+    TEST_ASSERT(s_node[1].rx_cnt == rx_cnt + 1);
+    TEST_ASSERT(test_check_echo(20, 0x44) == 0);
+
+    /* a peer with another header layout or version sends intact frames, they are dropped without touching rpmsg */
+    const uint8_t flip[] = { 1 << 4, 1 << 5, 1 << 6, 0x02 };
+    for (size_t i = 0; i < sizeof(flip) / sizeof(flip[0]); i++) {
+        int len = 0;
+        frame[0] ^= flip[i];
+        uint16_t crc = test_crc16(0xFFFF, frame, frame_len - 2);
+        frame[0] ^= flip[i];
+
+        wire[len++] = 0x7E;
+        len += test_put_escaped(&wire[len], frame[0] ^ flip[i]);
+        for (int j = 1; j < frame_len - 2; j++) {
+            len += test_put_escaped(&wire[len], frame[j]);
+        }
+        len += test_put_escaped(&wire[len], crc & 0xFF);
+        len += test_put_escaped(&wire[len], crc >> 8);
+        wire[len++] = 0x7E;
+        TEST_ASSERT(write(s_node[0].fd, wire, len) == len);
+        test_pump();
+        TEST_ASSERT(s_node[1].serial.rx_format_error == i + 1);
+    }
+    TEST_ASSERT(s_node[1].rx_cnt == rx_cnt + 1);
+    TEST_ASSERT(s_node[1].serial.rx_error == rx_error);
+
+    /* the link keeps working */
+    TEST_ASSERT(test_send(8, 0x88) == 0);
+    test_pump();
+    TEST_ASSERT(s_node[1].rx_cnt == rx_cnt + 2);
+    TEST_ASSERT(test_check_echo(8, 0x88) == 0);
+    return 0;
+}
+
+static int test_oversize(void)
+{
+    const uint16_t max_len = ESP_AMP_RPMSG_SERIAL_ITEM_SIZE - sizeof(esp_amp_rpmsg_head_t);
+
+    TEST_ASSERT(esp_amp_rpmsg_create_message(&s_node[0].dev, max_len + 1, ESP_AMP_RPMSG_DATA_DEFAULT) == NULL);
+    return 0;
+}
+
+int main(void)
+{
+    int sv[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        test_node_t* node = &s_node[i];
+        node->fd = sv[i];
+        node->corrupt_at = -1;
+        fcntl(node->fd, F_SETFL, fcntl(node->fd, F_GETFL) | O_NONBLOCK);
+        if (esp_amp_rpmsg_serial_init(&node->serial, &node->dev, test_write_cb, node, NULL, NULL) != 0 ||
+                esp_amp_rpmsg_create_endpoint(&node->dev, (i == 0) ? TEST_EPT_SINK : TEST_EPT_ECHO,
+                                              (i == 0) ? test_sink_cb : test_echo_cb, node, &node->ept) == NULL) {
+            fprintf(stderr, "failed to init node %d\n", i);
+            return 1;
+        }
+    }
+
+    int ret = test_echo() || test_corrupted_frame() || test_format_mismatch() || test_oversize();
+
+    close(sv[0]);
+    close(sv[1]);
+    printf("rpmsg serial test %s\n", ret ? "FAILED" : "PASSED");
+    return ret;
+}
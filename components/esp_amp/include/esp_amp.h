@@ -11,7 +11,13 @@
 #include "esp_amp_event.h"
 #include "esp_amp_queue.h"
 #include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_trace.h"
+#include "esp_amp_rpmsg_serial.h"
+#include "esp_amp_rpmsg_latency.h"
+#include "esp_amp_stream.h"
+#include "esp_amp_pubsub.h"
 #include "esp_amp_rpc.h"
+#include "esp_amp_rpc_metrics.h"
 
 #include "esp_amp_env.h"
 #include "esp_amp_platform.h"
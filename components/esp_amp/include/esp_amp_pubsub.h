@@ -0,0 +1,140 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "sdkconfig.h"
+#include "esp_amp_rpmsg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* received publish message, opaque to subscribers */
+typedef struct esp_amp_pubsub_msg_t esp_amp_pubsub_msg_t;
+
+/**
+ * Subscriber callback, invoked in the context of the rpmsg endpoint callback (ISR context if rpmsg interrupt is enabled)
+ * with the broker critical section held, so only ISR-safe APIs can be called inside, whatever the context.
+ * `data` points into the received rpmsg buffer (zero-copy) and stays valid until `esp_amp_pubsub_msg_release()` is called on `msg`.
+ * Every subscriber MUST release `msg` exactly once, either inside the callback or later from any context.
+ */
+typedef void (*esp_amp_pubsub_cb_t)(esp_amp_pubsub_msg_t* msg, uint32_t topic_id, void* data, uint16_t data_len, void* cb_arg);
+
+typedef struct esp_amp_pubsub_sub_t {
+    uint32_t topic_id;
+    esp_amp_pubsub_cb_t cb;
+    void* cb_arg;
+    volatile bool rejected;             /* set when the other core has no room left for the topic, nothing is delivered */
+    struct esp_amp_pubsub_sub_t* next;
+} esp_amp_pubsub_sub_t;
+
+typedef struct esp_amp_pubsub_t {
+    esp_amp_rpmsg_dev_t* rpmsg_dev;
+    esp_amp_rpmsg_ept_t ept;                                            /* broker endpoint, same address on both cores */
+    esp_amp_pubsub_sub_t* sub_list;                                     /* local subscribers */
+    uint32_t remote_topics[CONFIG_ESP_AMP_PUBSUB_REMOTE_TOPIC_NUM];     /* topics with at least one subscriber on the other core */
+    uint16_t remote_topic_num;
+} esp_amp_pubsub_t;
+
+/**
+ * Get the topic id of a topic name (32-bit FNV-1a hash)
+ * @param topic             topic name, null-terminated string
+ *
+ * @retval topic id
+ *
+ * @note Compute topic id once and reuse it, instead of hashing the name on every publish.
+ */
+uint32_t esp_amp_pubsub_topic_id(const char* topic);
+
+/**
+ * Initialize the pub/sub broker on this core
+ * @param pubsub            broker context, should be allocated in advance, either statically or dynamically
+ * @param rpmsg_dev         rpmsg context
+ * @param ept_addr          broker endpoint address, MUST be the same on both cores
+ *
+ * @retval 0                successfully initialize the broker
+ * @retval -1               invalid argument, or endpoint with `ept_addr` already exists
+ *
+ * @note The broker asks the peer to announce its subscriptions during initialization, so either core can start first.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_pubsub_init(esp_amp_pubsub_t* pubsub, esp_amp_rpmsg_dev_t* rpmsg_dev, uint16_t ept_addr);
+
+/**
+ * Subscribe to a topic published by the other core
+ * @param pubsub            broker context
+ * @param sub               subscriber context, should be allocated in advance and kept valid until unsubscribed
+ * @param topic_id          topic id returned by `esp_amp_pubsub_topic_id()`
+ * @param cb                callback invoked for every message published on this topic
+ * @param cb_arg            argument passed to `cb`
+ *
+ * @retval 0                successfully subscribe
+ * @retval -1               invalid argument, or failed to announce the subscription to the other core
+ *
+ * @note Only the first local subscriber of a topic is announced to the other core.
+ * @note If the other core already tracks CONFIG_ESP_AMP_PUBSUB_REMOTE_TOPIC_NUM topics, it replies with a rejection later on:
+ *       an error is logged and `sub->rejected` is set for all subscribers of the topic. Unsubscribe them and retry after
+ *       the other core frees a topic.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_pubsub_subscribe(esp_amp_pubsub_t* pubsub, esp_amp_pubsub_sub_t* sub, uint32_t topic_id, esp_amp_pubsub_cb_t cb, void* cb_arg);
+
+/**
+ * Unsubscribe from a topic
+ * @param pubsub            broker context
+ * @param sub               subscriber context passed to `esp_amp_pubsub_subscribe()`
+ *
+ * @retval 0                successfully unsubscribe
+ * @retval -1               subscriber not found
+ *
+ * @note Messages already delivered to `sub` still need to be released.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_pubsub_unsubscribe(esp_amp_pubsub_t* pubsub, esp_amp_pubsub_sub_t* sub);
+
+/**
+ * Publish a message to a topic
+ * @param pubsub            broker context
+ * @param topic_id          topic id returned by `esp_amp_pubsub_topic_id()`
+ * @param data              data to publish
+ * @param data_len          size of data in bytes
+ *
+ * @retval 1                nobody on the other core subscribes to the topic, message is dropped locally
+ * @retval 0                successfully send the message to the other core
+ * @retval -1               message is too large, or no rpmsg buffer is available at present
+ *
+ * @note This API can be called in interrupt context.
+ */
+int esp_amp_pubsub_publish(esp_amp_pubsub_t* pubsub, uint32_t topic_id, const void* data, uint16_t data_len);
+
+/**
+ * Check whether the other core subscribes to a topic
+ * @param pubsub            broker context
+ * @param topic_id          topic id
+ *
+ * @retval true             at least one subscriber on the other core
+ * @retval false            no subscriber on the other core
+ *
+ * @note Useful to skip producing data nobody is interested in.
+ */
+bool esp_amp_pubsub_has_remote_subscriber(esp_amp_pubsub_t* pubsub, uint32_t topic_id);
+
+/**
+ * Release a message delivered to a subscriber
+ * @param pubsub            broker context
+ * @param msg               message handle passed to the subscriber callback
+ *
+ * @note The rpmsg buffer is given back to the other core after all subscribers release it.
+ * @note This API can be called in interrupt context.
+ */
+void esp_amp_pubsub_msg_release(esp_amp_pubsub_t* pubsub, esp_amp_pubsub_msg_t* msg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -36,8 +36,17 @@ typedef struct esp_amp_queue_t {
     void* priv_data;
     uint16_t free_flip_counter;
     uint16_t used_flip_counter;
+    struct esp_amp_queue_conf_t* conf;          /* virtqueue config in shared memory */
 } esp_amp_queue_t;
 
+/*
+ * Transport operations used by rpmsg, implemented by shared memory virtqueue (esp_amp_queue_xxx_try) by default.
+ * Other transport backends implement the same semantics on their own channels:
+ *  - q_tx_alloc: get a free TX buffer of at least `size` bytes, return 0 and set `buffer`, or non-zero if none is free
+ *  - q_tx: hand over a buffer from q_tx_alloc to the transport, return 0 on success. Called in critical section, MUST NOT block
+ *  - q_rx: get the next received buffer, return 0 and set `buffer` and `size`, or non-zero if nothing received
+ *  - q_rx_free: give back a buffer from q_rx, in any order
+ */
 typedef struct esp_amp_queue_ops_t {
     int (*q_tx)(esp_amp_queue_t* queue, void* buffer, uint16_t size);
     int (*q_tx_alloc)(esp_amp_queue_t *queue, void** buffer, uint16_t size);
@@ -50,6 +59,7 @@ typedef struct esp_amp_queue_conf_t {
     uint16_t max_queue_item_size;
     uint8_t* queue_buffer;
     esp_amp_queue_desc_t* queue_desc;
+    volatile uint32_t notify_disabled;          /* set by `remote-core` to stop `master-core` from sending notification */
 } esp_amp_queue_conf_t;
 
 /**
@@ -98,6 +108,9 @@ int esp_amp_queue_alloc_try(esp_amp_queue_t *queue, void** buffer, uint16_t size
  * @retval ESP_OK                   successfully free the data buffer
  * @retval ESP_ERR_NOT_SUPPORTED    failed to free, expected to be called only on `remote-core`
  * @retval ESP_ERR_NOT_ALLOWED      failed to free, free before receive!
+ * @retval ESP_ERR_INVALID_ARG      failed to free, buffer doesn't belong to this virtqueue
+ *
+ * @note Received buffers can be freed in any order.
  */
 int esp_amp_queue_free_try(esp_amp_queue_t *queue, void* buffer);
 
@@ -168,6 +181,38 @@ int esp_amp_queue_sub_init(esp_amp_queue_t* queue, esp_amp_queue_cb_t cb_func, v
  */
 int esp_amp_queue_intr_enable(esp_amp_queue_t* queue);
 
+/**
+ * Ask `master-core` not to send notification after sending data (must be called on `remote-core`)
+ * @param queue                     virtqueue handler
+ *
+ * @retval ESP_OK                   successfully disable the notification
+ * @retval ESP_ERR_NOT_SUPPORTED    failed to disable, expected to be called only on `remote-core`
+ *
+ * @note Useful when `remote-core` keeps receiving data by polling, so that the interrupt is not triggered for every data buffer
+ */
+int esp_amp_queue_notify_disable(esp_amp_queue_t* queue);
+
+/**
+ * Ask `master-core` to send notification after sending data again (must be called on `remote-core`)
+ * @param queue                     virtqueue handler
+ *
+ * @retval ESP_OK                   successfully enable the notification
+ * @retval ESP_ERR_NOT_SUPPORTED    failed to enable, expected to be called only on `remote-core`
+ *
+ * @note Data sent before `master-core` observes the change doesn't trigger notification. Always check with
+ *       `esp_amp_queue_recv_available()` after enabling the notification to avoid missing data.
+ */
+int esp_amp_queue_notify_enable(esp_amp_queue_t* queue);
+
+/**
+ * Check whether there is data buffer available to receive without receiving it (must be called on `remote-core`)
+ * @param queue                 virtqueue handler
+ *
+ * @retval true                 at least one data buffer can be received by `esp_amp_queue_recv_try()`
+ * @retval false                no data buffer to receive, or not called on `remote-core`
+ */
+bool esp_amp_queue_recv_available(esp_amp_queue_t* queue);
+
 #define ESP_AMP_QUEUE_AVAILABLE_MASK(bit)                       (uint16_t)((uint16_t)(bit) << 7)
 #define ESP_AMP_QUEUE_USED_MASK(bit)                            (uint16_t)((uint16_t)(bit) << 15)
 #define ESP_AMP_QUEUE_FLAG_IS_USED(flipCounter, flag)           (((ESP_AMP_QUEUE_AVAILABLE_MASK(1) & (flag)) != ESP_AMP_QUEUE_AVAILABLE_MASK((flipCounter))) && ((ESP_AMP_QUEUE_USED_MASK(1) & (flag)) != ESP_AMP_QUEUE_USED_MASK((flipCounter))))
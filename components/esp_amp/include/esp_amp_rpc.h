@@ -16,6 +16,25 @@ extern "C" {
 
 #define ESP_AMP_RPC_MAX_PENDING_REQ CONFIG_ESP_AMP_RPC_MAX_PENDING_REQ
 
+/* req_id of one-way notification, never allocated to a pending request */
+#define ESP_AMP_RPC_NOTIFY_REQ_ID (0)
+
+#define ESP_AMP_RPC_BATCH_MAX_REQ CONFIG_ESP_AMP_RPC_BATCH_MAX_REQ
+
+/* service_id of batch request, whose params carry sub-requests in esp_amp_rpc_pkt_t format, each padded to 4 bytes */
+#define ESP_AMP_RPC_BATCH_SERVICE_ID (0xFFFF)
+
+/* service_id of cancel message, whose req_id is the request to cancel. No response is sent */
+#define ESP_AMP_RPC_CANCEL_SERVICE_ID (0xFFFE)
+
+/* service_id of cache invalidation sent by server as notification, whose params carry the uint16_t service id to drop */
+#define ESP_AMP_RPC_INVALIDATE_SERVICE_ID (0xFFFD)
+
+/* priority of rpc request, a larger value is more urgent. Server treats values above ESP_AMP_RPC_PRIORITY_MAX as it */
+#define ESP_AMP_RPC_PRIORITY_NUM CONFIG_ESP_AMP_RPC_PRIORITY_NUM
+#define ESP_AMP_RPC_PRIORITY_NORMAL (0)
+#define ESP_AMP_RPC_PRIORITY_MAX (ESP_AMP_RPC_PRIORITY_NUM - 1)
+
 /**
  * esp amp rpc status code
  *
@@ -32,17 +51,28 @@ typedef enum {
     ESP_AMP_RPC_STATUS_TIMEOUT, /* timer time out */
     ESP_AMP_RPC_STATUS_NO_MEM, /* memory allocation failed */
     ESP_AMP_RPC_STATUS_BAD_PACKET,
+    ESP_AMP_RPC_STATUS_STREAM, /* chunk of streaming response, more to follow */
+    ESP_AMP_RPC_STATUS_CANCELLED, /* request cancelled by client */
 } esp_amp_rpc_status_t;
 
 /* rpc request handle exposed to user app */
 typedef void *esp_amp_rpc_req_handle_t;
 
+/**
+ * rpc client and server instance handles
+ * APIs without handle operate on the default instance created by esp_amp_rpc_client_init() and esp_amp_rpc_server_init()
+ */
+typedef struct esp_amp_rpc_client_t *esp_amp_rpc_client_handle_t;
+typedef struct esp_amp_rpc_server_t *esp_amp_rpc_server_handle_t;
+
 /* rpc packet for both request & response */
 typedef struct {
     uint16_t req_id;
     uint16_t service_id;
-    uint16_t status;
+    uint8_t status;
+    uint8_t priority; /* request only: scheduling priority on server, ESP_AMP_RPC_PRIORITY_NORMAL by default */
     uint16_t params_len;
+    uint32_t timeout_ms; /* request only: remaining time client waits for response when sent, 0 means no deadline */
     uint8_t params[0];
 } esp_amp_rpc_pkt_t;
 
@@ -58,18 +88,65 @@ typedef struct {
  */
 typedef esp_amp_rpc_status_t (* esp_amp_rpc_service_func_t)(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len);
 
+/* one request of a run of batched requests to the same service */
+typedef struct {
+    void *params_in;
+    void *params_out; /* pre-allocated by rpc server */
+    uint16_t params_in_len;
+    uint16_t params_out_len; /* capacity of params_out on entry, length of output parameters on return */
+    esp_amp_rpc_status_t status; /* ESP_AMP_RPC_STATUS_OK on entry, set by handler if the request fails */
+} esp_amp_rpc_batch_item_t;
+
+/**
+ * batch-aware rpc service, optional
+ * invoked by rpc server with consecutive requests of a batch to the same service, instead of the service handler
+ *
+ * @param[inout] items requests to execute
+ * @param[in] num number of requests
+ */
+typedef void (* esp_amp_rpc_service_batch_func_t)(esp_amp_rpc_batch_item_t *items, int num);
+
 typedef int esp_amp_rpc_service_id_t;
 typedef struct {
     esp_amp_rpc_service_id_t id;
     esp_amp_rpc_service_func_t handler;
+    esp_amp_rpc_service_batch_func_t batch_handler; /* NULL if not batch-aware */
 } esp_amp_rpc_service_t;
 
+#define ESP_AMP_RPC_SERVICE_CONCAT_(a, b) a##b
+#define ESP_AMP_RPC_SERVICE_CONCAT(a, b) ESP_AMP_RPC_SERVICE_CONCAT_(a, b)
+
+/**
+ * Define an rpc service at link time
+ * Entries are collected into a table by the linker and dispatched in O(1) when service ids are contiguous,
+ * without calling esp_amp_rpc_server_add_service() or reserving CONFIG_ESP_AMP_RPC_SERVICE_TABLE_LEN entries.
+ * Services defined at link time cannot be replaced by esp_amp_rpc_server_add_service().
+ *
+ * @param srv_id service id
+ * @param srv_func service handler of type esp_amp_rpc_service_func_t
+ *
+ * @note Object file containing the definition must be linked. If nothing else in the file is referenced,
+ *       link the component with WHOLE_ARCHIVE.
+ */
+#define ESP_AMP_RPC_SERVICE_DEFINE(srv_id, srv_func) \
+    static esp_amp_rpc_service_t ESP_AMP_RPC_SERVICE_CONCAT(esp_amp_rpc_service_##srv_func##_, __LINE__) \
+    __attribute__((used, section(".esp_amp_rpc_service." #srv_func), aligned(__alignof__(esp_amp_rpc_service_t)))) = { \
+        .id = (srv_id), \
+        .handler = (srv_func), \
+    }
+
 /**
  * rpc client cb
  * callback when client receives response or the request is timeout
  */
 typedef void (* esp_amp_rpc_req_cb_t)(esp_amp_rpc_status_t status, void *params_out, uint16_t params_out_len);
 
+/**
+ * rpc client async cb
+ * callback when client receives response or the request is timeout, with user context
+ */
+typedef void (* esp_amp_rpc_req_async_cb_t)(esp_amp_rpc_status_t status, void *params_out, uint16_t params_out_len, void *ctx);
+
 #if !IS_ENV_BM
 
 /**
@@ -112,13 +189,100 @@ esp_amp_rpc_status_t esp_amp_rpc_client_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uin
  * sent by RPC client. Transport buffer is also allocated to construct RPC packet
  *
  * @param[in] service_id service id of rpc requests to be executed by server
- * @param[in] params_in input parameters of the rpc request
+ * @param[in] params_in input parameters of the rpc request, NULL to fill them later via esp_amp_rpc_client_get_request_params()
  * @param[in] params_in_len length of the input parameters of the rpc request
  * @retval NULL failed to create the RPC request
  * @retval others handle of the RPC request
  */
 esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id, void *params_in, uint16_t params_in_len);
 
+/**
+ * Send a one-way RPC notification
+ * Service is executed by server without response, and no pending request is taken on client.
+ * Service handler is invoked with params_out NULL and *params_out_len 0
+ *
+ * @param[in] service_id service id of rpc notification to be executed by server
+ * @param[in] params_in input parameters of the rpc notification
+ * @param[in] params_in_len length of the input parameters of the rpc notification
+ * @retval ESP_AMP_RPC_STATUS_OK successfully send out the notification
+ * @retval ESP_AMP_RPC_STATUS_NO_MEM no free rpmsg buffer
+ * @retval ESP_AMP_RPC_STATUS_FAILED failed to send out the notification
+ *
+ * @note Delivery and execution are not confirmed. Use RPC request if the result matters
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_notify(uint16_t service_id, void *params_in, uint16_t params_in_len);
+
+/**
+ * Send a one-way RPC notification with the given priority, e.g. an emergency stop which must not wait behind bulk
+ * requests queued on server. Arguments are the same as esp_amp_rpc_client_notify()
+ *
+ * @param[in] priority scheduling priority on server, from ESP_AMP_RPC_PRIORITY_NORMAL to ESP_AMP_RPC_PRIORITY_MAX
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_notify_with_priority(uint16_t service_id, uint8_t priority, void *params_in, uint16_t params_in_len);
+
+/**
+ * Create an RPC batch request
+ * Several small requests are packed into one transport buffer by esp_amp_rpc_client_batch_add(), executed by server
+ * in one pass, and answered by one combined response. Execute it as a normal RPC request, then iterate sub-responses
+ * by esp_amp_rpc_batch_next()
+ *
+ * @retval NULL failed to create the RPC batch request
+ * @retval others handle of the RPC request
+ */
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_batch(void);
+
+/**
+ * Append a request to the created RPC batch request
+ * Sub-response of the n-th request appended carries req_id n
+ *
+ * @param[in] req handle of the created RPC batch request
+ * @param[in] service_id service id of the request
+ * @param[in] params_in input parameters of the request
+ * @param[in] params_in_len length of the input parameters of the request
+ * @retval ESP_AMP_RPC_STATUS_OK successfully append the request
+ * @retval ESP_AMP_RPC_STATUS_INVALID_ARG req is not a batch request created and not executed yet
+ * @retval ESP_AMP_RPC_STATUS_NO_MEM batch is full, execute it and start a new one
+ *
+ * @note Each sub-response takes at most 1/n of the response buffer when n requests are batched
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_batch_add(esp_amp_rpc_req_handle_t req, uint16_t service_id, void *params_in, uint16_t params_in_len);
+
+/**
+ * Iterate sub-responses of a batch response
+ *
+ * @param[in] params_out output parameters of the RPC batch request
+ * @param[in] params_out_len length of output parameters of the RPC batch request
+ * @param[in] prev sub-response returned by previous call, NULL to get the first one
+ * @retval NULL no more sub-response
+ * @retval others sub-response, whose req_id is the index of the request in batch
+ */
+esp_amp_rpc_pkt_t *esp_amp_rpc_batch_next(void *params_out, int params_out_len, esp_amp_rpc_pkt_t *prev);
+
+/**
+ * Get the input parameter buffer of the created RPC request
+ * Parameters can be written directly into the transport buffer before the request is executed
+ *
+ * @param[in] req handle of the created RPC request
+ * @retval NULL invalid request
+ * @retval others input parameter buffer of params_in_len bytes
+ */
+void *esp_amp_rpc_client_get_request_params(esp_amp_rpc_req_handle_t req);
+
+/**
+ * Set the priority of the created RPC request
+ * Server executes queued requests of higher priority first. Requests of the same priority are executed in arrival
+ * order, and a request waiting longer than CONFIG_ESP_AMP_RPC_PRIORITY_AGING_MS is promoted by one level, so that
+ * requests of low priority are delayed but never starved
+ *
+ * @param[in] req handle of the created RPC request, not executed yet
+ * @param[in] priority scheduling priority on server, from ESP_AMP_RPC_PRIORITY_NORMAL to ESP_AMP_RPC_PRIORITY_MAX
+ * @retval ESP_AMP_RPC_STATUS_OK successfully set the priority
+ * @retval ESP_AMP_RPC_STATUS_INVALID_ARG invalid request
+ *
+ * @note Priority only orders requests waiting on server. A request being executed is never preempted
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_set_priority(esp_amp_rpc_req_handle_t req, uint8_t priority);
+
 #if !IS_ENV_BM
 
 /**
@@ -130,13 +294,86 @@ esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id,
  * @param[in] timeout_ms maximum waiting time (in millisecond) before timeout. -1 means waiting forever
  * @retval ESP_AMP_RPC_STATUS_OK successfully send out the request
  * @retval ESP_AMP_RPC_STATUS_FAILED failed to send out the request (QUEUE_FULL)
+ * @retval ESP_AMP_RPC_STATUS_STREAM service streams its response, which needs esp_amp_rpc_client_execute_async().
+ *                                   params_out holds the first chunk, the rest of the stream is dropped
+ *
+ * @note Calling task is woken up by task notification at index CONFIG_ESP_AMP_RPC_CLIENT_NOTIFY_INDEX, and any
+ *       notification value pending at this index is cleared. The calling task MUST NOT use this index for other
+ *       purposes. Index 0 is used by xTaskNotify()/ulTaskNotifyTake(), set CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES
+ *       to 2 or more so that RPC client defaults to index 1.
  */
 esp_amp_rpc_status_t esp_amp_rpc_client_execute_request(esp_amp_rpc_req_handle_t req, void **params_out, int *params_out_len, uint32_t timeout_ms);
 
+/**
+ * Execute the created RPC request without blocking
+ * Callback is invoked in rpc client's receiving task, then the request is destroyed by rpc client.
+ * Response parameters are only valid inside the callback. Chunks of streaming response are delivered to the callback
+ * with status ESP_AMP_RPC_STATUS_STREAM before the final response, each chunk restarts the timeout
+ *
+ * @param[in] req handle of the created RPC request
+ * @param[in] cb callback handler for the RPC request
+ * @param[in] ctx user context passed to cb
+ * @param[in] timeout_ms maximum waiting time (in millisecond) before timeout. -1 means waiting forever
+ * @retval ESP_AMP_RPC_STATUS_OK successfully send out the request
+ * @retval ESP_AMP_RPC_STATUS_INVALID_ARG invalid req or cb
+ *
+ * @note DO NOT call esp_amp_rpc_client_destroy_request() on the request once this API succeeds
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_execute_async(esp_amp_rpc_req_handle_t req, esp_amp_rpc_req_async_cb_t cb, void *ctx, uint32_t timeout_ms);
+
+/**
+ * Send out the created RPC request without blocking
+ * Result is obtained later by esp_amp_rpc_client_poll_request()
+ *
+ * @param[in] req handle of the created RPC request
+ * @param[in] timeout_ms maximum waiting time (in millisecond) before timeout. -1 means waiting forever
+ * @retval ESP_AMP_RPC_STATUS_OK successfully send out the request
+ * @retval ESP_AMP_RPC_STATUS_INVALID_ARG invalid req
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_submit_request(esp_amp_rpc_req_handle_t req, uint32_t timeout_ms);
+
+/**
+ * Poll the result of a submitted RPC request
+ *
+ * @param[in] req handle of the submitted RPC request
+ * @param[out] params_out output parameters of the RPC request, valid until the request is destroyed
+ * @param[out] params_out_len length of the parameters of the rpc request
+ * @retval ESP_AMP_RPC_STATUS_PENDING response not received yet, poll again later
+ * @retval ESP_AMP_RPC_STATUS_TIMEOUT no response within timeout
+ * @retval others status of the RPC response
+ *
+ * @note Destroy the request by esp_amp_rpc_client_destroy_request() once the result other than ESP_AMP_RPC_STATUS_PENDING is returned
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_poll_request(esp_amp_rpc_req_handle_t req, void **params_out, int *params_out_len);
+
+#if CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM
+
+/**
+ * Mark a service idempotent, and serve its repeated requests from rpc client's response cache
+ * A request is served from cache if an OK response to the same service id and params, received within ttl_ms, is
+ * cached. Nothing is sent to server then, and the request completes at once: esp_amp_rpc_client_execute_request()
+ * does not block, and callback of esp_amp_rpc_client_execute_async() is invoked in the calling task.
+ * Server drops cached responses of a service by esp_amp_rpc_server_invalidate()
+ *
+ * @param[in] service_id identifier of the service
+ * @param[in] ttl_ms time (in millisecond) a response stays valid. 0 stops caching and drops cached responses
+ * @retval ESP_AMP_RPC_STATUS_OK successfully configure the cache
+ * @retval ESP_AMP_RPC_STATUS_INVALID_ARG invalid client or reserved service id
+ * @retval ESP_AMP_RPC_STATUS_NO_MEM already CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM services are cached
+ *
+ * @note Requests created with params_in set to NULL and filled by esp_amp_rpc_client_get_request_params() are never
+ * served from cache. Params and response larger than CONFIG_ESP_AMP_RPC_CLIENT_CACHE_DATA_LEN in total are not cached
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_set_cache(uint16_t service_id, uint32_t ttl_ms);
+
+#endif /* CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM */
+
 #else
 
 /**
  * Execute the created RPC request
+ * Chunks of streaming response are delivered to cb with status ESP_AMP_RPC_STATUS_STREAM before the final response,
+ * each chunk restarts the timeout
  *
  * @param[in] req handle of the created RPC request
  * @param[in] cb callback handler for the RPC request
@@ -148,6 +385,22 @@ esp_amp_rpc_status_t esp_amp_rpc_client_execute_request_with_cb(esp_amp_rpc_req_
 
 #endif /* IS_ENV_BM */
 
+/**
+ * Cancel the RPC request sent out and not completed yet
+ * Response to the request is dropped, and server is asked to drop the request if it is not executed yet.
+ * Server also drops requests not executed before their timeout, so cancellation is only needed to give up earlier
+ *
+ * A task blocked in esp_amp_rpc_client_execute_request() on the request returns ESP_AMP_RPC_STATUS_CANCELLED, and so
+ * does esp_amp_rpc_client_poll_request(). Callback of the request is invoked with ESP_AMP_RPC_STATUS_CANCELLED before
+ * this API returns, then the request is destroyed by rpc client
+ *
+ * @param[in] req handle of the RPC request sent out
+ * @retval ESP_AMP_RPC_STATUS_OK request is cancelled
+ * @retval ESP_AMP_RPC_STATUS_INVALID_ARG request is not sent out, or already completed
+ * @retval ESP_AMP_RPC_STATUS_NO_MEM request is cancelled, but server is not told since no buffer is available
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_cancel_request(esp_amp_rpc_req_handle_t req);
+
 /**
  * Destroy the RPC request
  * Pending request and transport buffer are released
@@ -170,6 +423,9 @@ esp_amp_rpc_status_t esp_amp_rpc_client_run(void);
 /**
  * Complete the timeout request by triggering timeout cb & remove from pending list
  * This API can only be used in baremetal environment
+ *
+ * @note Cost is proportional to the number of expired requests, and time is read at most once per call,
+ * thus it is cheap to call from the idle loop
  */
 void esp_amp_rpc_client_complete_timeout_request(void);
 
@@ -191,6 +447,64 @@ esp_amp_rpc_status_t esp_amp_rpc_client_stop(void);
  */
 esp_amp_rpc_status_t esp_amp_rpc_client_deinit(void);
 
+/**
+ * Instance APIs of rpc client
+ * Up to CONFIG_ESP_AMP_RPC_CLIENT_INSTANCE_NUM clients, including the default one, can run on different endpoints or
+ * rpmsg devices, each with its own pending requests. Requests created on an instance are executed, polled, cancelled
+ * and destroyed by the APIs above, which take the request handle only
+ */
+
+#if !IS_ENV_BM
+
+/**
+ * Create an rpc client instance, arguments are the same as esp_amp_rpc_client_init()
+ *
+ * @retval NULL failed to create the client, or no free instance
+ * @retval others handle of the client, to be started by esp_amp_rpc_client_inst_run()
+ */
+esp_amp_rpc_client_handle_t esp_amp_rpc_client_inst_create(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr, int task_priority, int stack_size);
+
+/* same as esp_amp_rpc_client_run(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_run(esp_amp_rpc_client_handle_t client);
+
+/* same as esp_amp_rpc_client_stop(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_stop(esp_amp_rpc_client_handle_t client);
+
+#if CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM
+/* same as esp_amp_rpc_client_set_cache(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_set_cache(esp_amp_rpc_client_handle_t client, uint16_t service_id, uint32_t ttl_ms);
+#endif /* CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM */
+
+#else
+
+/**
+ * Create an rpc client instance, arguments are the same as esp_amp_rpc_client_init()
+ *
+ * @retval NULL failed to create the client, or no free instance
+ * @retval others handle of the client
+ */
+esp_amp_rpc_client_handle_t esp_amp_rpc_client_inst_create(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr);
+
+/* same as esp_amp_rpc_client_complete_timeout_request(), on the given instance */
+void esp_amp_rpc_client_inst_complete_timeout_request(esp_amp_rpc_client_handle_t client);
+
+#endif /* !IS_ENV_BM */
+
+/* same as esp_amp_rpc_client_deinit(), the instance is stopped and released */
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_delete(esp_amp_rpc_client_handle_t client);
+
+/* same as esp_amp_rpc_client_create_request(), on the given instance */
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_inst_create_request(esp_amp_rpc_client_handle_t client, uint16_t service_id, void *params_in, uint16_t params_in_len);
+
+/* same as esp_amp_rpc_client_create_batch(), on the given instance */
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_inst_create_batch(esp_amp_rpc_client_handle_t client);
+
+/* same as esp_amp_rpc_client_notify(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_notify(esp_amp_rpc_client_handle_t client, uint16_t service_id, void *params_in, uint16_t params_in_len);
+
+/* same as esp_amp_rpc_client_notify_with_priority(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_notify_with_priority(esp_amp_rpc_client_handle_t client, uint16_t service_id, uint8_t priority, void *params_in, uint16_t params_in_len);
+
 #if !IS_ENV_BM
 
 /**
@@ -234,6 +548,81 @@ esp_amp_rpc_status_t esp_amp_rpc_server_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uin
  */
 esp_amp_rpc_status_t esp_amp_rpc_server_add_service(esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_func_t srv_func);
 
+/**
+ * Send a chunk of streaming response from a service handler
+ * The chunk is delivered to client with status ESP_AMP_RPC_STATUS_STREAM. Response returned by the service handler
+ * terminates the stream. Only requests executed with callback receive chunks, blocking or polled requests fail with
+ * ESP_AMP_RPC_STATUS_STREAM on the first chunk
+ *
+ * @param[in] params_out params_out passed to the running service handler, identifying the request
+ * @param[in] data chunk data, can point to params_out
+ * @param[in] data_len length of chunk data
+ * @retval ESP_AMP_RPC_STATUS_OK successfully send the chunk
+ * @retval ESP_AMP_RPC_STATUS_INVALID_ARG chunk larger than rpmsg buffer, params_out not of the running handler, or
+ *                                        called while a batch is executing
+ * @retval ESP_AMP_RPC_STATUS_NO_MEM no free rpmsg buffer, try again later
+ *
+ * @note This API MUST be called inside service handler
+ */
+esp_amp_rpc_status_t esp_amp_rpc_server_stream_send(void *params_out, const void *data, uint16_t data_len);
+
+/**
+ * Set batch-aware handler of a service
+ * Consecutive requests to the service in a batch are executed together by batch_func, while single requests are still
+ * executed by the service handler. Replacing the service handler by esp_amp_rpc_server_add_service() clears batch_func
+ *
+ * @param[in] srv_id identifier of a service already added or defined at link time
+ * @param[in] batch_func batch-aware handler, NULL to execute batched requests one by one
+ * @retval ESP_AMP_RPC_STATUS_OK successfully set the handler
+ * @retval ESP_AMP_RPC_STATUS_NO_SERVICE service not found
+ */
+esp_amp_rpc_status_t esp_amp_rpc_server_set_batch_handler(esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_batch_func_t batch_func);
+
+/**
+ * Tell rpc client to drop cached responses of a service
+ * Call this API when the data served by an idempotent service changes, so that rpc client stops serving the old
+ * response from its cache (see esp_amp_rpc_client_set_cache()). Client without cache ignores the message
+ *
+ * @param[in] srv_id identifier of the service
+ * @retval ESP_AMP_RPC_STATUS_OK successfully send out the invalidation
+ * @retval ESP_AMP_RPC_STATUS_NO_MEM no free rpmsg buffer, try again later
+ * @retval ESP_AMP_RPC_STATUS_FAILED server is not initialized, or failed to send out the invalidation
+ */
+esp_amp_rpc_status_t esp_amp_rpc_server_invalidate(esp_amp_rpc_service_id_t srv_id);
+
+#if !IS_ENV_BM
+
+/**
+ * Configure how a service is scheduled on rpc server's worker tasks
+ * Number of worker tasks is specified by Kconfig macro CONFIG_ESP_AMP_RPC_SERVER_WORKER_NUM.
+ * By default, a service is not reentrant (max_concurrency = 1) and has no order key
+ *
+ * @param[in] srv_id identifier of a service already added
+ * @param[in] max_concurrency maximum number of workers executing this service in parallel. 0 means unlimited
+ * @param[in] order_key requests to services sharing the same non-zero order key are executed one by one in arrival order
+ * @retval ESP_AMP_RPC_STATUS_OK successfully configure the service
+ * @retval ESP_AMP_RPC_STATUS_NO_SERVICE service not found
+ * @retval ESP_AMP_RPC_STATUS_FAILED service has requests in progress
+ *
+ * @note Configure services before rpc server starts to receive requests
+ */
+esp_amp_rpc_status_t esp_amp_rpc_server_config_service(esp_amp_rpc_service_id_t srv_id, uint8_t max_concurrency, uint8_t order_key);
+
+#elif CONFIG_ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+
+/**
+ * Execute requests waiting in rpc server's run queue
+ * With CONFIG_ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN larger than 0, requests received by esp_amp_rpmsg_poll() or rpmsg
+ * interrupt are only queued, and their service handlers run in this API instead. Call it from the main loop.
+ * Requests expired or cancelled while queued are dropped without response
+ *
+ * @param[in] budget maximum number of requests to execute in this call. 0 means until the run queue is empty
+ * @return number of requests left in the run queue
+ */
+int esp_amp_rpc_server_process(uint16_t budget);
+
+#endif /* !IS_ENV_BM */
+
 
 /**
  * Create an rpc server task and start to process incoming RPC requests
@@ -262,6 +651,64 @@ esp_amp_rpc_status_t esp_amp_rpc_server_stop(void);
  */
 esp_amp_rpc_status_t esp_amp_rpc_server_deinit(void);
 
+/**
+ * Instance APIs of rpc server
+ * Up to CONFIG_ESP_AMP_RPC_SERVER_INSTANCE_NUM servers, including the default one, can run on different endpoints or
+ * rpmsg devices, each with its own service table. Services defined at link time are served by every instance.
+ * esp_amp_rpc_server_stream_send() finds the instance executing the calling handler by itself
+ */
+
+#if !IS_ENV_BM
+
+/**
+ * Create an rpc server instance
+ * Arguments other than worker_num are the same as esp_amp_rpc_server_init()
+ *
+ * @param[in] worker_num number of worker tasks, from 1 to CONFIG_ESP_AMP_RPC_SERVER_WORKER_NUM. 0 means
+ *                       CONFIG_ESP_AMP_RPC_SERVER_WORKER_NUM
+ * @retval NULL failed to create the server, or no free instance
+ * @retval others handle of the server, to be started by esp_amp_rpc_server_inst_run()
+ */
+esp_amp_rpc_server_handle_t esp_amp_rpc_server_inst_create(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr, int task_priority, int stack_size, int worker_num);
+
+/* same as esp_amp_rpc_server_config_service(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_config_service(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id, uint8_t max_concurrency, uint8_t order_key);
+
+/* same as esp_amp_rpc_server_run(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_run(esp_amp_rpc_server_handle_t server);
+
+/* same as esp_amp_rpc_server_stop(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_stop(esp_amp_rpc_server_handle_t server);
+
+#else
+
+/**
+ * Create an rpc server instance, arguments are the same as esp_amp_rpc_server_init()
+ *
+ * @retval NULL failed to create the server, or no free instance
+ * @retval others handle of the server
+ */
+esp_amp_rpc_server_handle_t esp_amp_rpc_server_inst_create(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr);
+
+#if CONFIG_ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+/* same as esp_amp_rpc_server_process(), on the given instance */
+int esp_amp_rpc_server_inst_process(esp_amp_rpc_server_handle_t server, uint16_t budget);
+#endif /* CONFIG_ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN */
+
+#endif /* !IS_ENV_BM */
+
+/* same as esp_amp_rpc_server_deinit(), the instance is stopped and released */
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_delete(esp_amp_rpc_server_handle_t server);
+
+/* same as esp_amp_rpc_server_add_service(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_add_service(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_func_t srv_func);
+
+/* same as esp_amp_rpc_server_set_batch_handler(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_set_batch_handler(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_batch_func_t batch_func);
+
+/* same as esp_amp_rpc_server_invalidate(), on the given instance */
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_invalidate(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,92 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "sdkconfig.h"
+#include "esp_amp_rpc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_AMP_RPC_METRICS_BUCKET_NUM      (16)
+#define ESP_AMP_RPC_METRICS_STATUS_NUM      (ESP_AMP_RPC_STATUS_CANCELLED + 1)
+
+/* time histogram with power-of-2 buckets */
+typedef struct {
+    uint32_t count;                                         /* number of samples */
+    uint32_t max_us;                                        /* largest sample */
+    uint64_t total_us;                                      /* sum of samples, for average */
+    uint32_t bucket[ESP_AMP_RPC_METRICS_BUCKET_NUM];        /* [0]: 0us, [i]: [2^(i-1), 2^i) us, last bucket also counts all larger samples */
+} esp_amp_rpc_hist_t;
+
+typedef enum {
+    ESP_AMP_RPC_METRICS_QUEUE = 0,  /* client: app_req_q until sent. server: rx_q and waiting for its turn until executed */
+    ESP_AMP_RPC_METRICS_EXEC,       /* server: service handler. not collected by client */
+    ESP_AMP_RPC_METRICS_LATENCY,    /* client: from execute to response. server: from receiving request to sending response */
+    ESP_AMP_RPC_METRICS_TIME_NUM,
+} esp_amp_rpc_metrics_time_t;
+
+/* metrics of one service on one side */
+typedef struct {
+    uint16_t service_id;
+    uint32_t calls;                                         /* completed calls, sum of status[] */
+    uint32_t status[ESP_AMP_RPC_METRICS_STATUS_NUM];        /* completed calls by esp_amp_rpc_status_t */
+    esp_amp_rpc_hist_t time[ESP_AMP_RPC_METRICS_TIME_NUM];  /* indexed by esp_amp_rpc_metrics_time_t */
+} esp_amp_rpc_metrics_t;
+
+#if CONFIG_ESP_AMP_RPC_METRICS
+/**
+ * Get metrics of a service collected by rpc client, summed over all client instances
+ * @param service_id        service id. A batch is accounted as a whole under ESP_AMP_RPC_BATCH_SERVICE_ID
+ * @param metrics           snapshot of metrics
+ *
+ * @retval ESP_AMP_RPC_STATUS_OK           success
+ * @retval ESP_AMP_RPC_STATUS_NO_SERVICE   service never called, or not tracked since the table is full
+ * @retval ESP_AMP_RPC_STATUS_INVALID_ARG  metrics is NULL
+ *
+ * @note Client records end-to-end latency of responses only. Timeout and cancelled calls are counted in status[].
+ *       Notifications are not collected by client.
+ */
+esp_amp_rpc_status_t esp_amp_rpc_client_metrics_get(uint16_t service_id, esp_amp_rpc_metrics_t *metrics);
+
+/**
+ * Get metrics of a service collected by rpc server, summed over all server instances
+ * Arguments and return values are the same as esp_amp_rpc_client_metrics_get()
+ *
+ * @note Requests dropped by server since their deadline passed or client cancelled them are counted as
+ *       ESP_AMP_RPC_STATUS_TIMEOUT and ESP_AMP_RPC_STATUS_CANCELLED. Bare-metal server executes a request as soon as
+ *       it is polled, its queueing time is not collected.
+ */
+esp_amp_rpc_status_t esp_amp_rpc_server_metrics_get(uint16_t service_id, esp_amp_rpc_metrics_t *metrics);
+
+/* clear metrics of all services of rpc client */
+void esp_amp_rpc_client_metrics_reset(void);
+
+/* clear metrics of all services of rpc server */
+void esp_amp_rpc_server_metrics_reset(void);
+
+/* log metrics of all services of rpc client, one line per service */
+void esp_amp_rpc_client_metrics_dump(void);
+
+/* log metrics of all services of rpc server, one line per service */
+void esp_amp_rpc_server_metrics_dump(void);
+
+/**
+ * Estimate a percentile of a time histogram
+ * @param hist              time histogram
+ * @param percent           percentile, 1 ~ 100
+ *
+ * @retval upper bound of the bucket holding the percentile in microseconds, never larger than `max_us`. 0 if no sample
+ */
+uint32_t esp_amp_rpc_metrics_percentile(const esp_amp_rpc_hist_t *hist, uint8_t percent);
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
+
+#ifdef __cplusplus
+}
+#endif
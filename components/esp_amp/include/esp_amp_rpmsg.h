@@ -8,6 +8,7 @@
 
 #include "stdint.h"
 #include "stdbool.h"
+#include "sdkconfig.h"
 #include "esp_amp_queue.h"
 #include "esp_amp_sw_intr.h"
 #include "esp_amp_sys_info.h"
@@ -19,12 +20,27 @@ extern "C" {
 #define ESP_AMP_RPMSG_DATA_DEFAULT      (uint16_t)(0x0)
 
 #define ESP_AMP_RPMSG_RESERVED_EPT_SYS_PRT      (uint16_t)(UINT16_MAX)
+#define ESP_AMP_RPMSG_RESERVED_EPT_CLOCK_SYNC   (uint16_t)(UINT16_MAX - 1)
+
+/* lane (priority) index is carried in the upper bits of rpmsg data_flags, lane 0 has the highest priority */
+#define ESP_AMP_RPMSG_LANE_NUM_MAX              (4)
+#define ESP_AMP_RPMSG_DATA_LANE_SHIFT           (14)
+#define ESP_AMP_RPMSG_DATA_LANE_MASK            (uint16_t)(0xC000)
+#define ESP_AMP_RPMSG_DATA_GET_LANE(flags)      (uint8_t)(((flags) & ESP_AMP_RPMSG_DATA_LANE_MASK) >> ESP_AMP_RPMSG_DATA_LANE_SHIFT)
+#define ESP_AMP_RPMSG_DATA_SET_LANE(flags, lane) (uint16_t)(((flags) & ~ESP_AMP_RPMSG_DATA_LANE_MASK) | (((uint16_t)(lane) << ESP_AMP_RPMSG_DATA_LANE_SHIFT) & ESP_AMP_RPMSG_DATA_LANE_MASK))
 
 typedef struct esp_amp_rpmsg_head_t {
     uint16_t src_addr;                  /* source endpoint address */
     uint16_t dst_addr;                  /* destination endpoint address */
     uint16_t data_len;                  /* length of rpmsg data */
     uint16_t data_flags;                /* msg_data field property flags*/
+#if CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+    uint16_t refcnt;                    /* number of references held by receiver, see esp_amp_rpmsg_buf_ref() */
+    uint16_t reserved;
+#endif
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+    uint32_t send_ts;                   /* sender time in microseconds when the rpmsg is sent */
+#endif
 } esp_amp_rpmsg_head_t;
 
 typedef struct esp_amp_rpmsg_t {
@@ -39,13 +55,51 @@ typedef struct esp_amp_rpmsg_ept_t {
     void* rx_cb_data;                       /* ISR callback data */
     struct esp_amp_rpmsg_ept_t* next_ept;    /* Pointer to the next endpoint*/
     uint16_t addr;                          /* endpoint address */
+    uint8_t lane;                           /* lane used when sending from this endpoint */
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+    struct esp_amp_rpmsg_latency_t* latency;    /* one-way latency histogram, NULL if not collected */
+#endif
 } esp_amp_rpmsg_ept_t;
 
+typedef struct esp_amp_rpmsg_lane_conf_t {
+    uint16_t queue_len;                     /* length of TX/RX virtqueue of this lane */
+    uint16_t queue_item_size;               /* maximum size of one rpmsg(including header) on this lane */
+} esp_amp_rpmsg_lane_conf_t;
+
+/**
+ * Invoked in ISR context when the rpmsg device switches from interrupt mode to polling mode under load.
+ * The poller (task, main loop, etc.) should be woken up here and call `esp_amp_rpmsg_adaptive_poll()`.
+ * Return 1 if a higher priority task is woken, otherwise return 0.
+ */
+typedef int (*esp_amp_rpmsg_sched_cb_t)(void* sched_arg);
+
+typedef struct esp_amp_rpmsg_adaptive_t {
+    esp_amp_rpmsg_sched_cb_t sched_cb;      /* NULL if adaptive mode is disabled */
+    void* sched_arg;                        /* argument passed to sched_cb */
+    uint16_t intr_budget;                   /* max number of rpmsg processed in ISR before switching to polling mode */
+    uint16_t poll_budget;                   /* max number of rpmsg processed by one esp_amp_rpmsg_adaptive_poll() call */
+    volatile bool polling;                  /* whether the device is in polling mode */
+} esp_amp_rpmsg_adaptive_t;
+
+typedef struct esp_amp_rpmsg_clock_t {
+    int32_t offset_us;                      /* clock of the other side minus local clock */
+    int32_t best_offset_us;                 /* offset measured by the fastest round trip of ongoing sync */
+    uint32_t best_rtt_us;                   /* fastest round trip of ongoing sync */
+    volatile bool synced;                   /* whether offset_us is valid */
+    volatile bool syncing;                  /* whether this side is running a sync */
+} esp_amp_rpmsg_clock_t;
+
 typedef struct esp_amp_rpmsg_dev_t {
-    esp_amp_queue_t* rx_queue;
-    esp_amp_queue_t* tx_queue;
+    esp_amp_queue_t* rx_queue;              /* RX virtqueue of lane 0 */
+    esp_amp_queue_t* tx_queue;              /* TX virtqueue of lane 0 */
     esp_amp_rpmsg_ept_t* ept_list;
-    esp_amp_queue_ops_t queue_ops;
+    esp_amp_queue_ops_t queue_ops;          /* transport operations, shared memory virtqueue by default */
+    esp_amp_queue_t* lane_queues;           /* virtqueue pairs of all lanes, [2 * lane] is TX, [2 * lane + 1] is RX */
+    uint8_t lane_num;                       /* number of lanes */
+    esp_amp_rpmsg_adaptive_t adaptive;      /* adaptive interrupt/polling receive mode */
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+    esp_amp_rpmsg_clock_t clock;            /* cross-core clock offset used to convert timestamps */
+#endif
 } esp_amp_rpmsg_dev_t;
 
 /* RPMsg Endpoint Management API */
@@ -109,6 +163,21 @@ esp_amp_rpmsg_ept_t* esp_amp_rpmsg_rebind_endpoint(esp_amp_rpmsg_dev_t* rpmsg_de
  */
 esp_amp_rpmsg_ept_t* esp_amp_rpmsg_search_endpoint(esp_amp_rpmsg_dev_t* rpmsg_device, uint16_t ept_addr);
 
+/**
+ * Bind an endpoint to a specific lane
+ * @param rpmsg_device      rpmsg context
+ * @param ept               pointer to endpoint context
+ * @param lane              lane index, lower index means higher priority
+ *
+ * @retval 0                successfully bind the endpoint to the lane
+ * @retval -1               invalid endpoint or lane index exceeds the number of lanes of this rpmsg device
+ *
+ * @note Endpoints are bound to lane 0 when created. Messages sent by `esp_amp_rpmsg_send()` and buffers created by
+ *       `esp_amp_rpmsg_create_message_by_ept()` use the lane of the endpoint.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_rpmsg_endpoint_set_lane(esp_amp_rpmsg_dev_t* rpmsg_device, esp_amp_rpmsg_ept_t* ept, uint8_t lane);
+
 
 /**
  * Poll the next available rpmsg and execute corresponding callback function if necessary
@@ -119,6 +188,7 @@ esp_amp_rpmsg_ept_t* esp_amp_rpmsg_search_endpoint(esp_amp_rpmsg_dev_t* rpmsg_de
  * @retval 0                successfully polled and processed one rpmsg, maybe still available rpmsg left, should poll again
  *
  * @note Should only be called when using polling mechanism.
+ * @note Lanes are scanned from lane 0 on every call, so rpmsg on a higher priority lane is always processed first.
  */
 int esp_amp_rpmsg_poll(esp_amp_rpmsg_dev_t* rpmsg_dev);
 
@@ -160,6 +230,21 @@ void* esp_amp_rpmsg_create_message(esp_amp_rpmsg_dev_t* rpmsg_dev, uint32_t nbyt
  */
 int esp_amp_rpmsg_send_nocopy(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept, uint16_t dst_addr, void* data, uint16_t data_len);
 
+/**
+ * Create and return a rpmsg buffer on the lane bound to the given endpoint
+ * @param rpmsg_dev         rpmsg context
+ * @param ept               pointer to endpoint context which will send this rpmsg
+ * @param nbytes            number of maximum bytes which you want to send with rpmsg
+ * @param flags             currently reserved, should always set to ESP_AMP_RPMSG_DATA_DEFAULT
+ *
+ * @retval NULL             no available buffer to use / message size is larger than the maximum settings of the lane
+ * @retval void* ptr        successfully get the pointer to the data buffer for read/write (should be subsequently sent with nocopy version API)
+ *
+ * @note Same as `esp_amp_rpmsg_create_message()` except the lane of `ept` is used instead of lane 0.
+ * @note This API can be called in interrupt context.
+ */
+void* esp_amp_rpmsg_create_message_by_ept(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept, uint32_t nbytes, uint16_t flags);
+
 /**
  * Sending the data to the other side with copy
  *
@@ -188,6 +273,18 @@ int esp_amp_rpmsg_send(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept,
  */
 uint16_t esp_amp_rpmsg_get_max_size(esp_amp_rpmsg_dev_t* rpmsg_dev);
 
+/**
+ * Get the maximum settings of data size which one rpmsg can send at most on a specific lane
+ * @param rpmsg_dev         rpmsg context
+ * @param lane              lane index
+ *
+ * @retval 0                lane index exceeds the number of lanes of this rpmsg device
+ * @retval size             maximum data size one rpmsg can send on this lane
+ *
+ * @note This API can be used in interrupt context
+ */
+uint16_t esp_amp_rpmsg_get_lane_max_size(esp_amp_rpmsg_dev_t* rpmsg_dev, uint8_t lane);
+
 /**
  * Destroy(free) the rpmsg buffer after use
  *
@@ -204,6 +301,39 @@ uint16_t esp_amp_rpmsg_get_max_size(esp_amp_rpmsg_dev_t* rpmsg_dev);
  */
 int esp_amp_rpmsg_destroy(esp_amp_rpmsg_dev_t* rpmsg_dev, void* msg_data);
 
+#if CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+/**
+ * Take one more reference of a received rpmsg buffer
+ * @param rpmsg_dev         rpmsg context
+ * @param msg_data          pointer to the received rpmsg buffer
+ *
+ * @retval 0                successfully take the reference
+ * @retval -1               too many references
+ *
+ * @note The endpoint callback owns one reference of the received buffer. Take one more reference for each extra
+ *       consumer (e.g. task) the buffer is handed to, and let every consumer call `esp_amp_rpmsg_buf_unref()`.
+ * @note Only call it while holding a reference. Once the last reference is dropped, the buffer is given back and the
+ *       other core can reuse it at any time, so its reference counter means nothing anymore.
+ * @note This API can be used in interrupt context
+ */
+int esp_amp_rpmsg_buf_ref(esp_amp_rpmsg_dev_t* rpmsg_dev, void* msg_data);
+
+/**
+ * Drop one reference of a received rpmsg buffer, destroy the buffer when the last reference is dropped
+ * @param rpmsg_dev         rpmsg context
+ * @param msg_data          pointer to the received rpmsg buffer
+ *
+ * @retval 0                successfully drop the reference
+ * @retval -1               fatal error happens internally
+ *
+ * @note Consumers may drop their references in any order.
+ * @note Every reference MUST be dropped exactly once. Dropping more references than taken (e.g. double unref) is
+ *       undefined behavior: the buffer may already be reused by the other core and carry a new reference counter.
+ * @note This API can be used in interrupt context
+ */
+int esp_amp_rpmsg_buf_unref(esp_amp_rpmsg_dev_t* rpmsg_dev, void* msg_data);
+#endif
+
 /**
  * Initialize the rpmsg framework on main-core
  * @param rpmsg_dev         rpmsg context, should be allocated in advance, either statically or dynamically
@@ -264,6 +394,57 @@ int esp_amp_rpmsg_sub_init_by_id(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t
  */
 int esp_amp_rpmsg_sub_init(esp_amp_rpmsg_dev_t* rpmsg_dev, bool notify, bool poll);
 
+/**
+ * Initialize the rpmsg framework with multiple prioritized lanes on main-core
+ * @param rpmsg_dev         rpmsg context, should be allocated in advance, either statically or dynamically
+ * @param rpmsg_vqueue      virtqueue array with at least `2 * lane_num` entries
+ * @param lane_conf         queue length and item size of each lane, lane 0 has the highest priority
+ * @param lane_num          number of lanes, from 1 to ESP_AMP_RPMSG_LANE_NUM_MAX
+ * @param notify            whether to notify the other side after sending the data (send software interrupt)
+ * @param poll              whether to use the polling mechanism on this specific core, if set to false, then `esp_amp_rpmsg_intr_enable()` MUST be called later
+ * @param sysinfo_id        sysinfo id of shared memory allocated for rpmsg queue buffer
+ *
+ * @retval 0                successfully initialize the rpmsg framework
+ * @retval -1               failed to initialize
+ *
+ * @note Each lane owns a dedicated TX/RX virtqueue pair, so a saturated lane never exhausts the buffers of other lanes.
+ * @note this api MUST be called before any other rpmsg APIs on maincore
+ */
+int esp_amp_rpmsg_main_init_with_lanes(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t rpmsg_vqueue[], const esp_amp_rpmsg_lane_conf_t lane_conf[], uint8_t lane_num, bool notify, bool poll, esp_amp_sys_info_id_t sysinfo_id);
+
+/**
+ * Initialize the rpmsg framework with multiple prioritized lanes on sub-core
+ * @param rpmsg_dev         rpmsg context, should be allocated in advance, either statically or dynamically
+ * @param rpmsg_vqueue      virtqueue array with at least `2 * lane_num` entries
+ * @param lane_num          number of lanes, MUST be the same as the one passed to `esp_amp_rpmsg_main_init_with_lanes()`
+ * @param notify            whether to notify the other side after sending the data (send software interrupt)
+ * @param poll              whether to use the polling mechanism on this specific core, if set to false, then `esp_amp_rpmsg_intr_enable()` MUST be called later
+ * @param sysinfo_id        sysinfo id of shared memory allocated for rpmsg queue buffer
+ *
+ * @retval 0                successfully initialize the rpmsg framework
+ * @retval -1               failed to initialize, or `lane_num` doesn't match the shared memory layout created by main-core
+ *
+ * @note this api MUST be called before any other rpmsg APIs on subcore
+ */
+int esp_amp_rpmsg_sub_init_with_lanes(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t rpmsg_vqueue[], uint8_t lane_num, bool notify, bool poll, esp_amp_sys_info_id_t sysinfo_id);
+
+/**
+ * Initialize the rpmsg framework on a transport backend other than shared memory virtqueue
+ * @param rpmsg_dev         rpmsg context, should be allocated in advance, either statically or dynamically
+ * @param channels          channels prepared by the transport backend, with at least `2 * lane_num` entries. TX channel of
+ *                          lane `i` is `channels[2 * i]`, RX channel is `channels[2 * i + 1]`. Backend can keep its context
+ *                          in `priv_data`, and MUST set `max_item_size` of TX channels
+ * @param lane_num          number of lanes
+ * @param ops               transport operations invoked on the channels, see `esp_amp_queue_ops_t`
+ *
+ * @retval 0                successfully initialize the rpmsg framework
+ * @retval -1               invalid argument
+ *
+ * @note Endpoints, rpmsg APIs and upper layers (e.g. RPC) work unchanged on any transport. Received rpmsg are dispatched
+ *       by `esp_amp_rpmsg_poll()`. Interrupt mode and adaptive mode are only available on shared memory virtqueue.
+ */
+int esp_amp_rpmsg_init_with_transport(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t channels[], uint8_t lane_num, const esp_amp_queue_ops_t* ops);
+
 /**
  * Enable the rpmsg framework software interrupt handler, MUST be called when poll is set to false when initializing the rpmsg framework
  * @param rpmsg_dev         rpmsg context
@@ -273,6 +454,37 @@ int esp_amp_rpmsg_sub_init(esp_amp_rpmsg_dev_t* rpmsg_dev, bool notify, bool pol
  */
 int esp_amp_rpmsg_intr_enable(esp_amp_rpmsg_dev_t* rpmsg_dev);
 
+/**
+ * Enable the adaptive interrupt/polling receive mode
+ * @param rpmsg_dev         rpmsg context, initialized with `poll` set to false
+ * @param intr_budget       max number of rpmsg processed in one interrupt, set to 0 to use CONFIG_ESP_AMP_RPMSG_ADAPTIVE_INTR_BUDGET
+ * @param poll_budget       max number of rpmsg processed by one `esp_amp_rpmsg_adaptive_poll()` call, set to 0 to use CONFIG_ESP_AMP_RPMSG_ADAPTIVE_POLL_BUDGET
+ * @param sched_cb          callback invoked in ISR context to wake up the poller when switching to polling mode
+ * @param sched_arg         argument passed to `sched_cb`
+ *
+ * @retval 0                successfully enable the adaptive mode
+ * @retval -1               `sched_cb` is NULL or the rpmsg device is initialized in polling mode
+ *
+ * @note The device starts in interrupt mode. Once `intr_budget` rpmsg are processed in one interrupt, the doorbell from
+ *       the other core is masked and `sched_cb` is invoked. The poller then calls `esp_amp_rpmsg_adaptive_poll()` until it
+ *       returns -1, which means no more rpmsg is pending and the doorbell is re-armed.
+ * @note The other core MUST be initialized with `notify` set to true.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_rpmsg_adaptive_enable(esp_amp_rpmsg_dev_t* rpmsg_dev, uint16_t intr_budget, uint16_t poll_budget, esp_amp_rpmsg_sched_cb_t sched_cb, void* sched_arg);
+
+/**
+ * Process a batch of rpmsg in polling mode of the adaptive receive mode
+ * @param rpmsg_dev         rpmsg context
+ *
+ * @retval 0                processed a full batch, more rpmsg may be pending, should call again
+ * @retval -1               no more rpmsg to process, the device is back to interrupt mode
+ *
+ * @note Endpoint callbacks are invoked in the context of the caller instead of ISR context.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_rpmsg_adaptive_poll(esp_amp_rpmsg_dev_t* rpmsg_dev);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,81 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "sdkconfig.h"
+#include "esp_amp_rpmsg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_AMP_RPMSG_LATENCY_BUCKET_NUM    (16)
+
+/* one-way latency histogram with power-of-2 buckets */
+typedef struct esp_amp_rpmsg_latency_t {
+    uint32_t count;                                         /* number of samples */
+    uint32_t max_us;                                        /* largest sample */
+    uint32_t bucket[ESP_AMP_RPMSG_LATENCY_BUCKET_NUM];      /* [0]: 0us, [i]: [2^(i-1), 2^i) us, last bucket also counts all larger samples */
+} esp_amp_rpmsg_latency_t;
+
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+/**
+ * Measure the clock offset to the other side of an rpmsg device
+ * @param rpmsg_dev         rpmsg context
+ * @param rounds            number of probe round trips, the offset measured by the fastest one is used
+ *
+ * @retval 0                probe is sent, the sync completes while rpmsg is received on both sides
+ * @retval -1               invalid argument, or no rpmsg buffer available
+ *
+ * @note Both sides update their offset when the sync completes, check with `esp_amp_rpmsg_clock_get_offset()`.
+ *       Call again to start over if a probe is lost, or to compensate clock drift. The previous offset stays valid meanwhile.
+ */
+int esp_amp_rpmsg_clock_sync(esp_amp_rpmsg_dev_t* rpmsg_dev, uint8_t rounds);
+
+/**
+ * Get the clock offset measured by `esp_amp_rpmsg_clock_sync()`
+ * @param rpmsg_dev         rpmsg context
+ * @param offset_us         clock of the other side minus local clock, in microseconds
+ *
+ * @retval 0                offset is available
+ * @retval -1               clock is never synced
+ */
+int esp_amp_rpmsg_clock_get_offset(esp_amp_rpmsg_dev_t* rpmsg_dev, int32_t* offset_us);
+
+/**
+ * Collect one-way latency of rpmsg received by an endpoint
+ * @param rpmsg_dev         rpmsg context
+ * @param ept               endpoint
+ * @param latency           histogram to accumulate latency, reset here. Set to NULL to stop collecting
+ *
+ * @retval 0                success
+ * @retval -1               invalid argument
+ *
+ * @note Latency is measured from `esp_amp_rpmsg_send_nocopy()` on the sender to dispatch on the receiver, including
+ *       the time spent in the queue and waiting for the interrupt. Samples are taken only after the clock is synced.
+ */
+int esp_amp_rpmsg_endpoint_set_latency(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept, esp_amp_rpmsg_latency_t* latency);
+
+/**
+ * Clear all samples of a latency histogram
+ */
+void esp_amp_rpmsg_latency_reset(esp_amp_rpmsg_latency_t* latency);
+
+/**
+ * Estimate a percentile of a latency histogram
+ * @param latency           latency histogram
+ * @param percent           percentile, 1 ~ 100
+ *
+ * @retval upper bound of the bucket holding the percentile in microseconds, never larger than `max_us`. 0 if no sample
+ */
+uint32_t esp_amp_rpmsg_latency_percentile(const esp_amp_rpmsg_latency_t* latency, uint8_t percent);
+#endif /* CONFIG_ESP_AMP_RPMSG_TIMESTAMP */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,107 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+#include "sdkconfig.h"
+#include "esp_amp_rpmsg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_AMP_RPMSG_SERIAL_ITEM_SIZE      CONFIG_ESP_AMP_RPMSG_SERIAL_ITEM_SIZE
+#define ESP_AMP_RPMSG_SERIAL_TX_BUF_NUM     CONFIG_ESP_AMP_RPMSG_SERIAL_TX_BUF_NUM
+#define ESP_AMP_RPMSG_SERIAL_RX_BUF_NUM     CONFIG_ESP_AMP_RPMSG_SERIAL_RX_BUF_NUM
+
+/**
+ * Write encoded bytes to the link (UART, SPI, etc.), invoked by `esp_amp_rpmsg_serial_flush()`.
+ * Blocking is allowed. Return 0 if all bytes are written, other values to drop the current frame.
+ */
+typedef int (*esp_amp_rpmsg_serial_write_cb_t)(const void* data, uint16_t len, void* write_arg);
+
+/**
+ * Invoked in the context of rpmsg sender (may be ISR) when a frame is queued for transmission,
+ * should wake up the task calling `esp_amp_rpmsg_serial_flush()`.
+ * Return 1 if a higher priority task is woken, otherwise return 0.
+ */
+typedef int (*esp_amp_rpmsg_serial_tx_notify_cb_t)(void* notify_arg);
+
+typedef struct esp_amp_rpmsg_serial_t {
+    esp_amp_queue_t channels[2];                                    /* TX/RX channel handed to rpmsg device, single lane */
+    esp_amp_rpmsg_serial_write_cb_t write_cb;
+    void* write_arg;
+    esp_amp_rpmsg_serial_tx_notify_cb_t tx_notify_cb;
+    void* tx_notify_arg;
+    uint32_t tx_free_mask;                                          /* bit set if TX buffer is free */
+    uint32_t tx_head;                                               /* number of frames written to the link */
+    uint32_t tx_tail;                                               /* number of frames queued */
+    uint8_t tx_fifo[ESP_AMP_RPMSG_SERIAL_TX_BUF_NUM];               /* TX buffers waiting to be written */
+    uint32_t rx_free_mask;                                          /* bit set if RX buffer is free */
+    uint32_t rx_head;                                               /* number of frames handed to rpmsg */
+    uint32_t rx_tail;                                               /* number of frames decoded */
+    uint8_t rx_fifo[ESP_AMP_RPMSG_SERIAL_RX_BUF_NUM];               /* RX buffers waiting to be received by rpmsg */
+    int8_t rx_cur;                                                  /* RX buffer of the frame being decoded, -1 if none */
+    bool rx_escape;
+    bool rx_discard;                                                /* discard bytes until next frame delimiter */
+    bool rx_has_format;                                             /* format byte of the current frame is received */
+    uint8_t rx_format;
+    uint16_t rx_len;
+    uint32_t rx_error;                                              /* number of frames dropped: bad CRC, too large or no buffer */
+    uint32_t rx_format_error;                                       /* number of intact frames dropped: peer uses another header layout */
+    uint32_t tx_buf[ESP_AMP_RPMSG_SERIAL_TX_BUF_NUM][(ESP_AMP_RPMSG_SERIAL_ITEM_SIZE + 3) / 4];
+    uint32_t rx_buf[ESP_AMP_RPMSG_SERIAL_RX_BUF_NUM][(ESP_AMP_RPMSG_SERIAL_ITEM_SIZE + 2 + 3) / 4];   /* frame and CRC */
+} esp_amp_rpmsg_serial_t;
+
+/**
+ * Initialize an rpmsg device on a byte link to another chip
+ * @param serial            serial transport context, should be allocated in advance and kept valid while rpmsg device is used
+ * @param rpmsg_dev         rpmsg context to initialize
+ * @param write_cb          callback to write encoded bytes to the link
+ * @param write_arg         argument passed to `write_cb`
+ * @param tx_notify_cb      callback invoked when a frame is queued, set to NULL if `esp_amp_rpmsg_serial_flush()` is polled
+ * @param tx_notify_arg     argument passed to `tx_notify_cb`
+ *
+ * @retval 0                successfully initialize
+ * @retval -1               invalid argument
+ *
+ * @note Both chips MUST use the same CONFIG_ESP_AMP_RPMSG_SERIAL_ITEM_SIZE and rpmsg header layout. The header is sent as is,
+ *       its layout depends on CONFIG_ESP_AMP_RPMSG_BUF_REFCNT, CONFIG_ESP_AMP_RPMSG_TIMESTAMP and byte order. Each frame
+ *       carries a format byte describing them, frames with another layout are dropped and counted in `rx_format_error`.
+ */
+int esp_amp_rpmsg_serial_init(esp_amp_rpmsg_serial_t* serial, esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_serial_write_cb_t write_cb, void* write_arg,
+                              esp_amp_rpmsg_serial_tx_notify_cb_t tx_notify_cb, void* tx_notify_arg);
+
+/**
+ * Feed bytes read from the link
+ * @param serial            serial transport context
+ * @param data              bytes read from the link
+ * @param len               number of bytes
+ *
+ * @retval number of complete frames decoded, call `esp_amp_rpmsg_poll()` to dispatch them to endpoints
+ *
+ * @note Corrupted frames are dropped silently and counted in `rx_error`, frames with another header layout in `rx_format_error`. Decoding resynchronizes on the next frame delimiter.
+ * @note This API MUST be called from one task only.
+ */
+int esp_amp_rpmsg_serial_feed(esp_amp_rpmsg_serial_t* serial, const void* data, size_t len);
+
+/**
+ * Write all queued frames to the link
+ * @param serial            serial transport context
+ *
+ * @retval >=0              number of frames written
+ * @retval -1               `write_cb` failed, the frame being written is dropped
+ *
+ * @note This API MUST be called from one task only, and MUST NOT be called in interrupt context.
+ */
+int esp_amp_rpmsg_serial_flush(esp_amp_rpmsg_serial_t* serial);
+
+#ifdef __cplusplus
+}
+#endif
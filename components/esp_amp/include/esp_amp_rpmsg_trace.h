@@ -0,0 +1,89 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "sdkconfig.h"
+#include "esp_amp_rpmsg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* dump format, all fields are little-endian */
+#define ESP_AMP_RPMSG_TRACE_MAGIC           (0x43525441) /* "ATRC" */
+#define ESP_AMP_RPMSG_TRACE_VERSION         (1)
+
+#define ESP_AMP_RPMSG_TRACE_DIR_TX          (0)
+#define ESP_AMP_RPMSG_TRACE_DIR_RX          (1)
+
+/* dump file header, followed by `record_num` records of `record_size` bytes each, oldest first */
+typedef struct esp_amp_rpmsg_trace_file_head_t {
+    uint32_t magic;                                         /* ESP_AMP_RPMSG_TRACE_MAGIC */
+    uint16_t version;                                       /* ESP_AMP_RPMSG_TRACE_VERSION */
+    uint16_t record_size;                                   /* size of one record in bytes, including captured payload */
+    uint32_t record_num;                                    /* number of records in this dump */
+    uint32_t dropped;                                       /* number of older records overwritten before dump */
+    uint8_t main_core;                                      /* 1 if recorded by main-core, 0 if recorded by sub-core */
+    uint8_t lane_num;                                       /* lane number of the traced rpmsg device */
+    uint16_t payload_max;                                   /* maximum payload bytes captured per record */
+    uint16_t queue_len[ESP_AMP_RPMSG_LANE_NUM_MAX];         /* TX queue length of each lane */
+    uint16_t queue_item_size[ESP_AMP_RPMSG_LANE_NUM_MAX];   /* TX queue item size of each lane */
+} esp_amp_rpmsg_trace_file_head_t;
+
+/* one record in dump, followed by `payload_max` bytes (rounded up to word) of captured payload */
+typedef struct esp_amp_rpmsg_trace_record_t {
+    uint32_t timestamp_us;                                  /* esp_amp_platform_get_time_us() of the recording core */
+    uint16_t src_addr;
+    uint16_t dst_addr;
+    uint16_t data_len;
+    uint16_t data_flags;                                    /* lane is carried in data_flags */
+    uint8_t dir;                                            /* ESP_AMP_RPMSG_TRACE_DIR_TX or ESP_AMP_RPMSG_TRACE_DIR_RX */
+    uint8_t reserved;
+    uint16_t payload_len;                                   /* number of valid payload bytes */
+} esp_amp_rpmsg_trace_record_t;
+
+/**
+ * Write callback used to output trace dump
+ * Return 0 on success, other values to abort the dump
+ */
+typedef int (*esp_amp_rpmsg_trace_write_cb_t)(const void* data, uint16_t len, void* write_arg);
+
+#if CONFIG_ESP_AMP_RPMSG_TRACE
+/**
+ * Start recording the traffic of an rpmsg device
+ * @param rpmsg_dev         rpmsg device to trace, only one device can be traced at a time
+ *
+ * @retval 0                successfully start recording
+ * @retval -1               invalid argument
+ *
+ * @note Previous records are cleared. Messages sent by `esp_amp_rpmsg_send_nocopy()` (and `esp_amp_rpmsg_send()`)
+ *       are recorded as TX, messages received by `esp_amp_rpmsg_poll()` (including interrupt mode) are recorded as RX.
+ */
+int esp_amp_rpmsg_trace_start(esp_amp_rpmsg_dev_t* rpmsg_dev);
+
+/**
+ * Stop recording, records are kept until next `esp_amp_rpmsg_trace_start()`
+ */
+void esp_amp_rpmsg_trace_stop(void);
+
+/**
+ * Dump records in the format described by `esp_amp_rpmsg_trace_file_head_t`
+ * @param write_cb          callback to output the dump, e.g. write to uart or file
+ * @param write_arg         argument passed to `write_cb`
+ *
+ * @retval 0                successfully dump
+ * @retval -1               recording is not stopped or never started, or `write_cb` failed
+ *
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_rpmsg_trace_dump(esp_amp_rpmsg_trace_write_cb_t write_cb, void* write_arg);
+#endif /* CONFIG_ESP_AMP_RPMSG_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,133 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "stddef.h"
+#include "sdkconfig.h"
+#include "esp_amp_rpmsg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_AMP_STREAM_EVENT_READABLE       (1 << 0)    /* new data can be read */
+#define ESP_AMP_STREAM_EVENT_WRITABLE       (1 << 1)    /* peer consumed data, window is open again */
+#define ESP_AMP_STREAM_EVENT_CLOSED         (1 << 2)    /* peer closed the stream or protocol error */
+
+struct esp_amp_stream_t;
+
+/**
+ * Invoked in the context of the rpmsg endpoint callback (ISR context if rpmsg interrupt is enabled)
+ * when the state of the stream changes. Return 1 if a higher priority task is woken, otherwise return 0.
+ */
+typedef int (*esp_amp_stream_notify_cb_t)(struct esp_amp_stream_t* stream, uint32_t events, void* notify_arg);
+
+typedef enum {
+    ESP_AMP_STREAM_STATE_CLOSED = 0,
+    ESP_AMP_STREAM_STATE_OPEN,
+    ESP_AMP_STREAM_STATE_PEER_CLOSED,
+} esp_amp_stream_state_t;
+
+typedef struct esp_amp_stream_t {
+    esp_amp_rpmsg_dev_t* rpmsg_dev;
+    esp_amp_rpmsg_ept_t ept;                /* local endpoint */
+    uint16_t remote_addr;                   /* endpoint address of the peer stream */
+    volatile esp_amp_stream_state_t state;
+    esp_amp_stream_notify_cb_t notify_cb;
+    void* notify_arg;
+
+    /* TX */
+    void* tx_buf;                           /* rpmsg buffer coalescing written data, not sent yet */
+    uint16_t tx_len;                        /* bytes of data in tx_buf */
+    uint16_t tx_max;                        /* capacity of tx_buf */
+    uint16_t tx_seq;                        /* sequence number of the next data frame */
+    volatile uint16_t tx_acked;             /* number of data frames consumed by peer */
+
+    /* RX */
+    void* rx_frames[CONFIG_ESP_AMP_STREAM_WINDOW_SIZE];        /* received data frames, kept in place (zero-copy) */
+    uint16_t rx_frame_len[CONFIG_ESP_AMP_STREAM_WINDOW_SIZE];  /* bytes of data in each frame */
+    uint16_t rx_offset;                     /* bytes already read from the oldest frame */
+    volatile uint16_t rx_head;              /* number of data frames consumed */
+    volatile uint16_t rx_tail;              /* number of data frames received */
+    uint16_t rx_acked;                      /* number of consumed data frames reported to peer */
+} esp_amp_stream_t;
+
+/**
+ * Open a byte stream between a local endpoint and a remote endpoint
+ * @param stream            stream context, should be allocated in advance, either statically or dynamically
+ * @param rpmsg_dev         rpmsg context
+ * @param local_addr        address of the local endpoint created for this stream
+ * @param remote_addr       address of the endpoint of the peer stream on the other core
+ * @param notify_cb         callback invoked when the stream becomes readable/writable/closed, set to NULL if not required
+ * @param notify_arg        argument passed to `notify_cb`
+ *
+ * @retval 0                successfully open the stream
+ * @retval -1               invalid argument, or endpoint with `local_addr` already exists
+ *
+ * @note Both cores MUST open the stream with swapped `local_addr` and `remote_addr`.
+ * @note The lane of the stream can be changed with `esp_amp_rpmsg_endpoint_set_lane()` on `stream->ept` before writing.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_stream_open(esp_amp_stream_t* stream, esp_amp_rpmsg_dev_t* rpmsg_dev, uint16_t local_addr, uint16_t remote_addr, esp_amp_stream_notify_cb_t notify_cb, void* notify_arg);
+
+/**
+ * Write data into the stream without blocking
+ * @param stream            stream context
+ * @param data              data to write
+ * @param len               size of data in bytes
+ *
+ * @retval >=0              number of bytes accepted, can be less than `len` when the window or rpmsg buffers are exhausted
+ * @retval -1               stream is not open or fatal error happens in rpmsg framework
+ *
+ * @note Small writes are coalesced into one rpmsg. A frame is sent once it is full, or when `esp_amp_stream_flush()` is called.
+ * @note When less than `len` bytes are accepted, retry after `ESP_AMP_STREAM_EVENT_WRITABLE` is notified.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_stream_write(esp_amp_stream_t* stream, const void* data, size_t len);
+
+/**
+ * Send the data coalesced by `esp_amp_stream_write()` so far
+ * @param stream            stream context
+ *
+ * @retval 0                nothing is left unsent
+ * @retval -1               window is full, retry after `ESP_AMP_STREAM_EVENT_WRITABLE` is notified
+ *
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_stream_flush(esp_amp_stream_t* stream);
+
+/**
+ * Read data from the stream without blocking
+ * @param stream            stream context
+ * @param buf               buffer to store the data
+ * @param len               size of buffer in bytes
+ *
+ * @retval >0               number of bytes read, can be less than `len` (partial read)
+ * @retval 0                no data available at present
+ * @retval -1               stream is closed and all data has been read
+ *
+ * @note Data frames are freed and acknowledged to the peer as soon as they are completely read.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_stream_read(esp_amp_stream_t* stream, void* buf, size_t len);
+
+/**
+ * Flush pending data, notify the peer and close the stream
+ * @param stream            stream context
+ *
+ * @retval 0                successfully close the stream
+ * @retval -1               pending data or close notification can't be sent at present, retry later
+ *
+ * @note Unread data is dropped.
+ * @note This API MUST NOT be called in interrupt context.
+ */
+int esp_amp_stream_close(esp_amp_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
@@ -51,6 +51,14 @@ void esp_amp_platform_delay_us(uint32_t time);
 uint32_t esp_amp_platform_get_time_ms(void);
 
 
+/**
+ * Get current time in microseconds, derived from cpu cycle
+ *
+ * @retval current time in microseconds, wraps around every ~71 minutes
+ */
+uint32_t esp_amp_platform_get_time_us(void);
+
+
 /**
  * Disable all interrupts on local core
  *
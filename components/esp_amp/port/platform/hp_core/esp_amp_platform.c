@@ -25,6 +25,11 @@ uint32_t esp_amp_platform_get_time_ms(void)
     return esp_amp_arch_get_cpu_cycle() / (esp_rom_get_cpu_ticks_per_us() * 1000);
 }
 
+uint32_t esp_amp_platform_get_time_us(void)
+{
+    return esp_amp_arch_get_cpu_cycle() / esp_rom_get_cpu_ticks_per_us();
+}
+
 void esp_amp_platform_intr_enable(void)
 {
     esp_amp_arch_intr_enable();
@@ -33,6 +33,12 @@ uint32_t esp_amp_platform_get_time_ms(void)
     return (uint32_t)(cpu_cycle_u64 / (LP_CORE_CPU_FREQ_HZ / 1000));
 }
 
+uint32_t esp_amp_platform_get_time_us(void)
+{
+    uint64_t cpu_cycle_u64 = esp_amp_arch_get_cpu_cycle();
+    return (uint32_t)(cpu_cycle_u64 / (LP_CORE_CPU_FREQ_HZ / 1000000));
+}
+
 void esp_amp_platform_intr_enable(void)
 {
     ulp_lp_core_intr_enable();
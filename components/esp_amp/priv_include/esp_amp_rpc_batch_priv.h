@@ -0,0 +1,49 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "esp_amp_rpc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Batch encoding shared by freertos and baremetal rpc client and server
+ * Params of a batch request (service_id ESP_AMP_RPC_BATCH_SERVICE_ID) are a sequence of sub-requests, each an
+ * esp_amp_rpc_pkt_t header followed by its params and padded to 4 bytes. Combined response uses the same layout.
+ */
+
+#define ESP_AMP_RPC_BATCH_ALIGN(len) (((len) + 3) & ~3)
+
+typedef struct {
+    /* return service of n consecutive sub-requests starting at idx once it is allowed to run, NULL if not found */
+    const esp_amp_rpc_service_t *(*acquire)(void *arg, uint16_t service_id, int idx, int num);
+    /* called after sub-requests taken by acquire() are executed */
+    void (*release)(void *arg, int idx, int num);
+    void *arg;
+} esp_amp_rpc_batch_ops_t;
+
+/* return number of sub-requests, -1 if batch is malformed or has more than ESP_AMP_RPC_BATCH_MAX_REQ sub-requests */
+int esp_amp_rpc_batch_count(const void *params, uint32_t params_len);
+
+/* append a sub-request to batch pkt whose params can hold capacity bytes, return its index or -1 if batch is full */
+int esp_amp_rpc_batch_append(esp_amp_rpc_pkt_t *batch, uint32_t capacity, uint16_t service_id, const void *params, uint16_t params_len);
+
+/**
+ * execute sub-requests and write combined response to params_out
+ * runs of consecutive sub-requests to the same service are passed to its batch handler if any
+ *
+ * @retval >=0 length of combined response
+ * @retval -1 batch is malformed, or params_out cannot hold a header per sub-request, nothing is executed
+ */
+int esp_amp_rpc_batch_execute(void *params_in, uint32_t params_in_len, void *params_out, uint32_t params_out_cap, const esp_amp_rpc_batch_ops_t *ops);
+
+#ifdef __cplusplus
+}
+#endif
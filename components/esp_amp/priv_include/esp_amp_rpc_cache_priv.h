@@ -0,0 +1,90 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM
+
+#define ESP_AMP_RPC_CACHE_NUM           CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM
+#define ESP_AMP_RPC_CACHE_DATA_LEN      CONFIG_ESP_AMP_RPC_CLIENT_CACHE_DATA_LEN
+
+typedef enum {
+    CACHE_FREE,
+    CACHE_FILLING,  /* params stored, waiting for the response of the req holding it */
+    CACHE_VALID,    /* response stored, served until expire_ms */
+    CACHE_STALE,    /* invalidated or expired, released once no req holds it */
+} esp_amp_rpc_cache_state_t;
+
+typedef struct {
+    uint16_t service_id;
+    uint32_t ttl_ms; /* 0 if policy slot is free */
+} esp_amp_rpc_cache_policy_t;
+
+typedef struct {
+    uint8_t state; /* esp_amp_rpc_cache_state_t */
+    uint8_t refs; /* reqs holding the entry, data is not overwritten while held */
+    uint16_t service_id;
+    uint16_t params_len;
+    uint16_t rsp_len;
+    uint32_t hash; /* of params */
+    uint32_t expire_ms;
+    uint32_t used; /* lru stamp */
+    uint8_t data[ESP_AMP_RPC_CACHE_DATA_LEN]; /* params followed by response */
+} esp_amp_rpc_cache_entry_t;
+
+/**
+ * Response cache of idempotent services used by freertos rpc client
+ * A request to a cacheable service acquires an entry keyed by service id and params. On hit, the response is served
+ * from the entry. On miss, the entry is filled with the response when it arrives, and served to later requests until
+ * its ttl expires or the server invalidates the service. Entries are held by requests until destroyed, so that
+ * responses can be returned without copy. Entries are looked up and held in esp_amp_env critical section, while params
+ * and responses are compared and copied outside of it, so that the section stays short in the rpmsg isr
+ */
+typedef struct {
+    esp_amp_rpc_cache_policy_t policy[ESP_AMP_RPC_CACHE_NUM];
+    esp_amp_rpc_cache_entry_t entries[ESP_AMP_RPC_CACHE_NUM];
+    uint32_t clock; /* source of lru stamps */
+} esp_amp_rpc_cache_t;
+
+void esp_amp_rpc_cache_init(esp_amp_rpc_cache_t *cache);
+
+/* make service cacheable for ttl_ms, 0 to disable. return 0 on success, -1 if no free policy slot */
+int esp_amp_rpc_cache_config(esp_amp_rpc_cache_t *cache, uint16_t service_id, uint32_t ttl_ms);
+
+/**
+ * acquire entry of a request, return its index or -1 if request is not cached
+ * *hit tells whether the entry holds a valid response, or is taken to store the response to come
+ */
+int esp_amp_rpc_cache_acquire(esp_amp_rpc_cache_t *cache, uint16_t service_id, const void *params, uint16_t params_len, uint32_t now_ms, bool *hit);
+
+/* store response in an entry acquired on miss. response too large or invalidated in the meantime is not cached */
+void esp_amp_rpc_cache_fill(esp_amp_rpc_cache_t *cache, int idx, const void *rsp, uint16_t rsp_len, uint32_t now_ms);
+
+/* response of an entry acquired on hit, valid until the entry is released */
+const void *esp_amp_rpc_cache_get_rsp(esp_amp_rpc_cache_t *cache, int idx, uint16_t *rsp_len);
+
+/* take one more hold on an entry already held, e.g. to fill it after its req may be destroyed */
+void esp_amp_rpc_cache_hold(esp_amp_rpc_cache_t *cache, int idx);
+
+/* drop the hold of a request on the entry */
+void esp_amp_rpc_cache_release(esp_amp_rpc_cache_t *cache, int idx);
+
+/* drop cached responses of a service, responses in flight are not cached either */
+void esp_amp_rpc_cache_invalidate(esp_amp_rpc_cache_t *cache, uint16_t service_id);
+
+#endif /* CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM */
+
+#ifdef __cplusplus
+}
+#endif
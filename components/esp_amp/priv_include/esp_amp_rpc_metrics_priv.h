@@ -0,0 +1,58 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "sdkconfig.h"
+#include "esp_amp_platform.h"
+#include "esp_amp_rpc_metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_ESP_AMP_RPC_METRICS
+/* metrics of one side, shared by all instances on the core */
+typedef struct {
+    int num;                                                /* number of services tracked */
+    uint32_t dropped;                                       /* samples of services not tracked */
+    esp_amp_rpc_metrics_t services[CONFIG_ESP_AMP_RPC_METRICS_SERVICE_NUM];
+} esp_amp_rpc_metrics_tbl_t;
+
+/* add a time sample to the histogram of service, can be called in interrupt context */
+void esp_amp_rpc_metrics_add_time(esp_amp_rpc_metrics_tbl_t *tbl, uint16_t service_id, esp_amp_rpc_metrics_time_t which, uint32_t us);
+
+/* count a completed call of service, can be called in interrupt context */
+void esp_amp_rpc_metrics_add_call(esp_amp_rpc_metrics_tbl_t *tbl, uint16_t service_id, esp_amp_rpc_status_t status);
+
+/* take a snapshot of metrics of service, return 0 on success, -1 if service is not tracked */
+int esp_amp_rpc_metrics_get(esp_amp_rpc_metrics_tbl_t *tbl, uint16_t service_id, esp_amp_rpc_metrics_t *metrics);
+
+/* take a snapshot of the idx-th service tracked, return 0 on success, -1 if idx is out of range */
+int esp_amp_rpc_metrics_get_by_index(esp_amp_rpc_metrics_tbl_t *tbl, int idx, esp_amp_rpc_metrics_t *metrics);
+
+/* forget all services */
+void esp_amp_rpc_metrics_reset(esp_amp_rpc_metrics_tbl_t *tbl);
+
+#if ESP_PLATFORM
+/* log metrics of all services in tbl */
+void esp_amp_rpc_metrics_dump(esp_amp_rpc_metrics_tbl_t *tbl, const char *tag);
+#endif /* ESP_PLATFORM */
+
+#define ESP_AMP_RPC_METRICS_NOW() esp_amp_platform_get_time_us()
+#define ESP_AMP_RPC_METRICS_TIME(tbl, service_id, which, us) esp_amp_rpc_metrics_add_time(tbl, service_id, which, us)
+#define ESP_AMP_RPC_METRICS_CALL(tbl, service_id, status) esp_amp_rpc_metrics_add_call(tbl, service_id, status)
+#else
+/* compiled out, arguments are still evaluated so that timestamps taken for metrics do not trigger warnings */
+#define ESP_AMP_RPC_METRICS_NOW() (0)
+#define ESP_AMP_RPC_METRICS_TIME(tbl, service_id, which, us) ((void)(service_id), (void)(us))
+#define ESP_AMP_RPC_METRICS_CALL(tbl, service_id, status) ((void)(service_id), (void)(status))
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
+
+#ifdef __cplusplus
+}
+#endif
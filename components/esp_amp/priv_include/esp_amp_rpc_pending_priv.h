@@ -0,0 +1,47 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "esp_amp_rpc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_AMP_RPC_INVALID_REQ_ID      (0)
+/* req id is (generation * ESP_AMP_RPC_MAX_PENDING_REQ + slot), generation starts from 1 so that 0 is never used,
+ * and is left to one-way notification (ESP_AMP_RPC_NOTIFY_REQ_ID) */
+#define ESP_AMP_RPC_REQ_ID_MAX          (0x7FFF)
+
+/**
+ * Pending request table shared by freertos and baremetal rpc client
+ * Request id locates its slot directly (slot = req_id % ESP_AMP_RPC_MAX_PENDING_REQ), and the generation carried
+ * in the upper part of the id tells a late response of a completed request apart from the current owner of the slot.
+ * Every operation is O(1) and protected by esp_amp_env critical section, thus can be called in interrupt context.
+ */
+typedef struct {
+    uint16_t req_id[ESP_AMP_RPC_MAX_PENDING_REQ];       /* req id owning the slot, ESP_AMP_RPC_INVALID_REQ_ID if free */
+    uint16_t generation[ESP_AMP_RPC_MAX_PENDING_REQ];   /* generation used by the last owner of the slot */
+    uint16_t free_slots[ESP_AMP_RPC_MAX_PENDING_REQ];   /* stack of free slots */
+    uint16_t free_num;
+} esp_amp_rpc_pending_tbl_t;
+
+void esp_amp_rpc_pending_tbl_init(esp_amp_rpc_pending_tbl_t *tbl);
+
+/* take a free slot, return its new req id or ESP_AMP_RPC_INVALID_REQ_ID if table is full */
+uint16_t esp_amp_rpc_pending_tbl_alloc(esp_amp_rpc_pending_tbl_t *tbl);
+
+/* return slot of a pending req id, -1 if req id is not pending (never allocated, released or stale) */
+int esp_amp_rpc_pending_tbl_find(esp_amp_rpc_pending_tbl_t *tbl, uint16_t req_id);
+
+/* release the slot of a pending req id, return its slot or -1 if req id is not pending */
+int esp_amp_rpc_pending_tbl_release(esp_amp_rpc_pending_tbl_t *tbl, uint16_t req_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "esp_amp_rpc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_AMP_RPC_PRIO_NONE           (0xFFFF)
+
+/* per-slot bookkeeping of priority queue, storage provided by user of the queue */
+typedef struct {
+    uint16_t next; /* next slot of the same level, or next free slot */
+    uint8_t prio;
+    uint32_t enq_time; /* arrival time, in the unit of aging */
+} esp_amp_rpc_prio_link_t;
+
+/**
+ * Priority queue of received requests used by rpc server
+ * Each priority level is a FIFO of slots, so requests of the same priority keep their arrival order, and pop costs
+ * O(ESP_AMP_RPC_PRIORITY_NUM). The queue only hands out slot numbers, user stores the request in its own array
+ * indexed by slot. A request waiting for every `aging` time units is promoted by one level when it is compared, up to
+ * the highest level, where the oldest request wins. Thus low priority requests wait for at most
+ * (ESP_AMP_RPC_PRIORITY_NUM - 1) * aging plus the backlog of the highest level.
+ * Not thread-safe, user protects the queue.
+ */
+typedef struct {
+    esp_amp_rpc_prio_link_t *links; /* cap entries */
+    uint16_t cap;
+    uint16_t num;
+    uint16_t free; /* first free slot */
+    uint16_t head[ESP_AMP_RPC_PRIORITY_NUM]; /* oldest slot of each level */
+    uint16_t tail[ESP_AMP_RPC_PRIORITY_NUM];
+    uint32_t aging; /* 0 disables aging */
+} esp_amp_rpc_prio_q_t;
+
+void esp_amp_rpc_prio_q_init(esp_amp_rpc_prio_q_t *q, esp_amp_rpc_prio_link_t *links, uint16_t cap, uint32_t aging);
+
+/* take a slot for a request of prio arriving at enq_time, prio above the highest level is clamped. -1 if full */
+int esp_amp_rpc_prio_q_push(esp_amp_rpc_prio_q_t *q, uint8_t prio, uint32_t enq_time);
+
+/* release and return the slot of the most urgent request at now, -1 if empty. slot is reused by next push */
+int esp_amp_rpc_prio_q_pop(esp_amp_rpc_prio_q_t *q, uint32_t now);
+
+static inline bool esp_amp_rpc_prio_q_is_full(esp_amp_rpc_prio_q_t *q)
+{
+    return q->num == q->cap;
+}
+
+#ifdef __cplusplus
+}
+#endif
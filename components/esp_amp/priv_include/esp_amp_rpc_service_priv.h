@@ -0,0 +1,34 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "esp_amp_rpc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Link-time service table shared by freertos and baremetal rpc server
+ * Entries defined by ESP_AMP_RPC_SERVICE_DEFINE() are collected by the linker between
+ * _esp_amp_rpc_service_start and _esp_amp_rpc_service_end, in no particular order. The table is sorted
+ * by service id in place once, then looked up by direct index if ids are contiguous, or by binary search.
+ */
+
+/* sort the table, return number of link-time services. Safe to call more than once */
+int esp_amp_rpc_service_static_init(void);
+
+/* return index of service id in the table, -1 if not defined at link time */
+int esp_amp_rpc_service_static_find(esp_amp_rpc_service_id_t srv_id);
+
+/* return service at index returned by esp_amp_rpc_service_static_find() */
+esp_amp_rpc_service_t *esp_amp_rpc_service_static_get(int idx);
+
+#ifdef __cplusplus
+}
+#endif
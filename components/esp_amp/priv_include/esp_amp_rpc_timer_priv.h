@@ -0,0 +1,53 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "esp_amp_rpc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_AMP_RPC_TIMER_IDLE          (0xFFFF)
+/* deadlines are compared by signed difference, so they must stay within this distance from now */
+#define ESP_AMP_RPC_TIMER_MAX_MS        (0x7FFFFFFF)
+
+/**
+ * Deadline heap of pending requests used by baremetal rpc client
+ * Each pending slot owns at most one deadline. Slots are kept in a binary min-heap ordered by deadline, so that
+ * the earliest one is checked in O(1), and arming, disarming or expiring a slot costs O(log n).
+ * Every operation is protected by esp_amp_env critical section.
+ */
+typedef struct {
+    uint32_t deadline[ESP_AMP_RPC_MAX_PENDING_REQ]; /* deadline of slot in ms */
+    uint16_t pos[ESP_AMP_RPC_MAX_PENDING_REQ];      /* heap position of slot, ESP_AMP_RPC_TIMER_IDLE if not armed */
+    uint16_t heap[ESP_AMP_RPC_MAX_PENDING_REQ];     /* armed slots, earliest deadline first */
+    uint16_t num;
+} esp_amp_rpc_timer_t;
+
+void esp_amp_rpc_timer_init(esp_amp_rpc_timer_t *timer);
+
+/* arm slot to expire at deadline_ms, an armed slot is moved to the new deadline */
+void esp_amp_rpc_timer_arm(esp_amp_rpc_timer_t *timer, uint16_t slot, uint32_t deadline_ms);
+
+/* disarm slot, no effect if slot is not armed */
+void esp_amp_rpc_timer_disarm(esp_amp_rpc_timer_t *timer, uint16_t slot);
+
+/* true if no slot is armed. a single 16-bit load, no lock needed */
+static inline bool esp_amp_rpc_timer_is_empty(esp_amp_rpc_timer_t *timer)
+{
+    return timer->num == 0;
+}
+
+/* disarm and return the earliest slot whose deadline is not later than now_ms, -1 if none */
+int esp_amp_rpc_timer_pop_expired(esp_amp_rpc_timer_t *timer, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,27 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_latency.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+/* handle an rpmsg sent to ESP_AMP_RPMSG_RESERVED_EPT_CLOCK_SYNC and free it, can be called in interrupt context */
+void esp_amp_rpmsg_clock_sync_handler(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_t* rpmsg, uint32_t recv_ts);
+
+/* add one sample to `latency` if the clock of `rpmsg_dev` is synced, can be called in interrupt context */
+void esp_amp_rpmsg_latency_record(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_latency_t* latency, uint32_t send_ts, uint32_t recv_ts);
+#endif /* CONFIG_ESP_AMP_RPMSG_TIMESTAMP */
+
+#ifdef __cplusplus
+}
+#endif
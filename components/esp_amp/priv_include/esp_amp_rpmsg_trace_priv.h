@@ -0,0 +1,24 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#pragma once
+
+#include "stdint.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_ESP_AMP_RPMSG_TRACE
+/* record one rpmsg if `rpmsg_dev` is being traced, can be called in interrupt context */
+void esp_amp_rpmsg_trace_record(esp_amp_rpmsg_dev_t* rpmsg_dev, uint8_t dir, const esp_amp_rpmsg_t* rpmsg);
+#endif /* CONFIG_ESP_AMP_RPMSG_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,3 +1,5 @@
+include(${CMAKE_CURRENT_LIST_DIR}/cmake/rpc_idl.cmake)
+
 function(esp_amp_add_subcore_project subcore_app_name subcore_project_dir)
 
     set(options EMBED PARTITION)
@@ -0,0 +1,477 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Generate typed rpc client stubs and server skeletons from an IDL file.
+#
+#   // calc.idl
+#   option max_params_len = 120;
+#
+#   service add = 1 {
+#       in int32 a;
+#       in int32 b;
+#       out int32 sum;
+#   };
+#
+# Outputs <name>_rpc.h, <name>_rpc_client.c and <name>_rpc_server.c, where <name> is the IDL file name
+# without extension. Parameters are laid out in natural alignment, ordered by alignment to avoid padding.
+# Rpc params follow the 12-byte packet header and are only 4-byte aligned in the rpmsg buffer, so structs
+# holding 8-byte types would be misaligned there. Generated code copies them through locals instead of
+# casting the buffer. Server skeletons are defined at link time by ESP_AMP_RPC_SERVICE_DEFINE().
+
+import argparse
+import os
+import re
+import sys
+
+TYPES = {
+    "bool": ("bool", 1),
+    "int8": ("int8_t", 1),
+    "uint8": ("uint8_t", 1),
+    "int16": ("int16_t", 2),
+    "uint16": ("uint16_t", 2),
+    "int32": ("int32_t", 4),
+    "uint32": ("uint32_t", 4),
+    "float": ("float", 4),
+    "int64": ("int64_t", 8),
+    "uint64": ("uint64_t", 8),
+    "double": ("double", 8),
+}
+
+TOKEN_RE = re.compile(r"\s*(?:(//[^\n]*|#[^\n]*|/\*.*?\*/)|([A-Za-z_]\w*|\d+|[{}\[\];=]))", re.S)
+IDENT_RE = re.compile(r"[A-Za-z_]\w*$")
+
+
+class IdlError(Exception):
+    pass
+
+
+class Field:
+    def __init__(self, direction, type_name, name, count):
+        self.direction = direction
+        self.ctype, self.align = TYPES[type_name]
+        self.name = name
+        self.count = count          # 0 for scalar
+
+    def size(self):
+        return self.align * max(self.count, 1)
+
+
+class Service:
+    def __init__(self, name, srv_id):
+        self.name = name
+        self.id = srv_id
+        self.fields = []
+
+    def params(self, direction):
+        return [f for f in self.fields if f.direction == direction]
+
+    def layout(self, direction):
+        # stable sort by alignment, larger first, so structs carry no padding between fields
+        return sorted(self.params(direction), key=lambda f: -f.align)
+
+    def size(self, direction):
+        return sum(f.size() for f in self.params(direction))
+
+
+def tokenize(text):
+    tokens = []
+    pos = 0
+    while pos < len(text):
+        m = TOKEN_RE.match(text, pos)
+        if not m:
+            if text[pos:].strip() == "":
+                break
+            line = text.count("\n", 0, pos) + 1
+            raise IdlError(f"line {line}: unexpected character '{text[pos:].lstrip()[0]}'")
+        if m.group(2):
+            tokens.append((m.group(2), text.count("\n", 0, m.start(2)) + 1))
+        pos = m.end()
+    return tokens
+
+
+class Parser:
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+
+    def peek(self):
+        return self.tokens[self.pos][0] if self.pos < len(self.tokens) else None
+
+    def next(self, expect=None):
+        if self.pos >= len(self.tokens):
+            raise IdlError("unexpected end of file")
+        tok, line = self.tokens[self.pos]
+        self.pos += 1
+        if expect is not None and tok != expect:
+            raise IdlError(f"line {line}: expected '{expect}', got '{tok}'")
+        return tok
+
+    def ident(self):
+        line = self.tokens[self.pos][1] if self.pos < len(self.tokens) else 0
+        tok = self.next()
+        if not IDENT_RE.match(tok):
+            raise IdlError(f"line {line}: expected identifier, got '{tok}'")
+        return tok
+
+    def number(self):
+        line = self.tokens[self.pos][1] if self.pos < len(self.tokens) else 0
+        tok = self.next()
+        if not tok.isdigit():
+            raise IdlError(f"line {line}: expected number, got '{tok}'")
+        return int(tok)
+
+    def parse(self):
+        options = {}
+        services = []
+        next_id = 0
+        while self.peek() is not None:
+            kw = self.ident()
+            if kw == "option":
+                key = self.ident()
+                self.next("=")
+                options[key] = self.number()
+                self.next(";")
+            elif kw == "service":
+                name = self.ident()
+                if self.peek() == "=":
+                    self.next()
+                    next_id = self.number()
+                srv = Service(name, next_id)
+                next_id += 1
+                self.next("{")
+                while self.peek() != "}":
+                    direction = self.ident()
+                    if direction not in ("in", "out"):
+                        raise IdlError(f"service {name}: expected 'in' or 'out', got '{direction}'")
+                    type_name = self.ident()
+                    if type_name not in TYPES:
+                        raise IdlError(f"service {name}: unknown type '{type_name}'")
+                    field = self.ident()
+                    count = 0
+                    if self.peek() == "[":
+                        self.next()
+                        count = self.number()
+                        if count == 0:
+                            raise IdlError(f"service {name}: zero-length array '{field}'")
+                        self.next("]")
+                    self.next(";")
+                    srv.fields.append(Field(direction, type_name, field, count))
+                self.next("}")
+                if self.peek() == ";":
+                    self.next()
+                services.append(srv)
+            else:
+                raise IdlError(f"unexpected keyword '{kw}'")
+        return options, services
+
+
+# service ids taken by the rpc layer itself, see esp_amp_rpc.h
+RESERVED_IDS = {
+    0xfffd: "cache invalidation",
+    0xfffe: "cancel",
+    0xffff: "batch",
+}
+
+
+def check(services, options):
+    for key in options:
+        if key != "max_params_len":
+            raise IdlError(f"unknown option '{key}'")
+    ids = {}
+    names = set()
+    for srv in services:
+        if srv.name in names:
+            raise IdlError(f"duplicate service '{srv.name}'")
+        names.add(srv.name)
+        if srv.id > 0xffff:
+            raise IdlError(f"service {srv.name}: id {srv.id} exceeds 65535")
+        if srv.id in RESERVED_IDS:
+            raise IdlError(f"service {srv.name}: id {srv.id:#06x} is reserved for {RESERVED_IDS[srv.id]}")
+        if srv.id in ids:
+            raise IdlError(f"service {srv.name}: id {srv.id} already used by {ids[srv.id]}")
+        ids[srv.id] = srv.name
+        fields = set()
+        for f in srv.fields:
+            if f.name in fields or f.name == "timeout_ms":
+                raise IdlError(f"service {srv.name}: duplicate parameter '{f.name}'")
+            fields.add(f.name)
+        for direction in ("in", "out"):
+            if srv.size(direction) > 0xffff:
+                raise IdlError(f"service {srv.name}: {direction} parameters exceed 65535 bytes")
+
+
+def in_arg(f):
+    if f.count:
+        return f"const {f.ctype} {f.name}[{f.count}]"
+    return f"{f.ctype} {f.name}"
+
+
+def out_arg(f):
+    if f.count:
+        return f"{f.ctype} {f.name}[{f.count}]"
+    return f"{f.ctype} *{f.name}"
+
+
+def arg_list(args):
+    return ", ".join(args) if args else "void"
+
+
+class Generator:
+    def __init__(self, name, options, services):
+        self.name = name
+        self.upper = name.upper()
+        self.options = options
+        self.services = services
+
+    def struct_name(self, srv, direction):
+        return f"{self.name}_{srv.name}_{direction}_t"
+
+    def srv_id(self, srv):
+        return f"{self.upper}_RPC_{srv.name.upper()}"
+
+    def create_proto(self, srv):
+        args = [in_arg(f) for f in srv.params("in")]
+        return f"esp_amp_rpc_req_handle_t {self.name}_{srv.name}_create({arg_list(args)})"
+
+    def decode_proto(self, srv):
+        return (f"esp_amp_rpc_status_t {self.name}_{srv.name}_decode(const void *params_out, int params_out_len, "
+                f"{self.struct_name(srv, 'out')} *out)")
+
+    def call_proto(self, srv):
+        args = [in_arg(f) for f in srv.params("in")] + [out_arg(f) for f in srv.params("out")] + ["uint32_t timeout_ms"]
+        return f"esp_amp_rpc_status_t {self.name}_{srv.name}({', '.join(args)})"
+
+    def handler_proto(self, srv):
+        args = [in_arg(f) for f in srv.params("in")] + [out_arg(f) for f in srv.params("out")]
+        return f"esp_amp_rpc_status_t {self.name}_{srv.name}_handler({arg_list(args)})"
+
+    def header(self):
+        o = []
+        o.append(f"/* Generated by rpc_idl_gen.py from {self.name}.idl, do not edit */\n")
+        o.append("#pragma once\n")
+        o.append("#include <stdbool.h>")
+        o.append("#include <stdint.h>")
+        o.append('#include "esp_amp_rpc.h"\n')
+        o.append("#ifdef __cplusplus")
+        o.append('extern "C" {')
+        o.append("#endif\n")
+
+        o.append("typedef enum {")
+        for srv in self.services:
+            o.append(f"    {self.srv_id(srv)} = {srv.id},")
+        o.append(f"}} {self.name}_rpc_service_id_t;\n")
+
+        max_len = self.options.get("max_params_len")
+        if max_len is not None:
+            o.append(f"#define {self.upper}_RPC_MAX_PARAMS_LEN {max_len}\n")
+
+        for srv in self.services:
+            for direction in ("in", "out"):
+                fields = srv.layout(direction)
+                if not fields:
+                    continue
+                st = self.struct_name(srv, direction)
+                o.append("typedef struct {")
+                for f in fields:
+                    suffix = f"[{f.count}]" if f.count else ""
+                    o.append(f"    {f.ctype} {f.name}{suffix};")
+                o.append(f"}} {st};")
+                if max_len is not None:
+                    o.append(f"_Static_assert(sizeof({st}) <= {self.upper}_RPC_MAX_PARAMS_LEN, "
+                             f"\"{st} exceeds max_params_len\");")
+                o.append("")
+
+        o.append("/* client stubs */\n")
+        for srv in self.services:
+            o.append("/**")
+            o.append(f" * Create {srv.name} request, parameters are copied into the transport buffer")
+            o.append(" * Execute it with esp_amp_rpc_client APIs and release it by esp_amp_rpc_client_destroy_request()")
+            o.append(" */")
+            o.append(self.create_proto(srv) + ";\n")
+            if srv.params("out"):
+                o.append("/**")
+                o.append(f" * Validate response of {srv.name} request and copy it to output parameters")
+                o.append(" */")
+                o.append(self.decode_proto(srv) + ";\n")
+        o.append("#if !IS_ENV_BM\n")
+        for srv in self.services:
+            o.append("/**")
+            o.append(f" * Execute {srv.name} request and wait for the response. Output pointers may be NULL")
+            o.append(" */")
+            o.append(self.call_proto(srv) + ";\n")
+        o.append("#endif /* !IS_ENV_BM */\n")
+
+        o.append("/**")
+        o.append(f" * Server skeletons, handlers are implemented by application. Services of {self.name}.idl are defined at link")
+        o.append(f" * time by ESP_AMP_RPC_SERVICE_DEFINE() in {self.name}_rpc_server.c, which is kept by the linker through")
+        o.append(f" * {self.name}_rpc_server_include() (esp_amp_rpc_idl_generate() with SERVER option)")
+        o.append(" */")
+        for srv in self.services:
+            o.append(self.handler_proto(srv) + ";")
+        o.append(f"void {self.name}_rpc_server_include(void);\n")
+
+        o.append("#ifdef __cplusplus")
+        o.append("}")
+        o.append("#endif")
+        return "\n".join(o) + "\n"
+
+    def client(self):
+        o = []
+        o.append(f"/* Generated by rpc_idl_gen.py from {self.name}.idl, do not edit */\n")
+        o.append("#include <stddef.h>")
+        o.append("#include <string.h>")
+        o.append(f'#include "{self.name}_rpc.h"\n')
+        for srv in self.services:
+            fields = srv.params("in")
+            o.append(self.create_proto(srv))
+            o.append("{")
+            if fields:
+                st = self.struct_name(srv, "in")
+                o.append(f"    {st} in;\n")
+                o.append("    /* padding is zeroed too, identical parameters give identical bytes (response cache key) */")
+                o.append("    memset(&in, 0, sizeof(in));")
+                for f in fields:
+                    if f.count:
+                        o.append(f"    memcpy(in.{f.name}, {f.name}, sizeof(in.{f.name}));")
+                    else:
+                        o.append(f"    in.{f.name} = {f.name};")
+                o.append(f"    return esp_amp_rpc_client_create_request({self.srv_id(srv)}, &in, sizeof(in));")
+            else:
+                o.append(f"    return esp_amp_rpc_client_create_request({self.srv_id(srv)}, NULL, 0);")
+            o.append("}\n")
+
+            if srv.params("out"):
+                st = self.struct_name(srv, "out")
+                o.append(self.decode_proto(srv))
+                o.append("{")
+                o.append(f"    if (params_out == NULL || params_out_len != sizeof({st})) {{")
+                o.append("        return ESP_AMP_RPC_STATUS_BAD_PACKET;")
+                o.append("    }")
+                o.append(f"    memcpy(out, params_out, sizeof({st}));")
+                o.append("    return ESP_AMP_RPC_STATUS_OK;")
+                o.append("}\n")
+
+        o.append("#if !IS_ENV_BM\n")
+        for srv in self.services:
+            outs = srv.params("out")
+            call_args = ", ".join(f.name for f in srv.params("in"))
+            o.append(self.call_proto(srv))
+            o.append("{")
+            o.append(f"    esp_amp_rpc_req_handle_t req = {self.name}_{srv.name}_create({call_args});")
+            o.append("    if (req == NULL) {")
+            o.append("        return ESP_AMP_RPC_STATUS_NO_MEM;")
+            o.append("    }\n")
+            o.append("    void *params_out = NULL;")
+            o.append("    int params_out_len = 0;")
+            o.append("    esp_amp_rpc_status_t status = esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, timeout_ms);")
+            if outs:
+                st = self.struct_name(srv, "out")
+                o.append(f"    {st} out;")
+                o.append("    if (status == ESP_AMP_RPC_STATUS_OK) {")
+                o.append(f"        status = {self.name}_{srv.name}_decode(params_out, params_out_len, &out);")
+                o.append("    }")
+                o.append("    if (status == ESP_AMP_RPC_STATUS_OK) {")
+                for f in outs:
+                    o.append(f"        if ({f.name} != NULL) {{")
+                    if f.count:
+                        o.append(f"            memcpy({f.name}, out.{f.name}, sizeof(out.{f.name}));")
+                    else:
+                        o.append(f"            *{f.name} = out.{f.name};")
+                    o.append("        }")
+                o.append("    }")
+            o.append("    esp_amp_rpc_client_destroy_request(req);")
+            o.append("    return status;")
+            o.append("}\n")
+        o.append("#endif /* !IS_ENV_BM */")
+        return "\n".join(o) + "\n"
+
+    def server(self):
+        o = []
+        o.append(f"/* Generated by rpc_idl_gen.py from {self.name}.idl, do not edit */\n")
+        o.append("#include <stddef.h>")
+        o.append("#include <string.h>")
+        o.append(f'#include "{self.name}_rpc.h"\n')
+        for srv in self.services:
+            ins = srv.params("in")
+            outs = srv.params("out")
+            o.append(f"static esp_amp_rpc_status_t {self.name}_{srv.name}_shim(void *params_in, uint16_t params_in_len, "
+                     "void *params_out, uint16_t *params_out_len)")
+            o.append("{")
+            if ins:
+                o.append(f"    {self.struct_name(srv, 'in')} in;")
+            if outs:
+                o.append(f"    {self.struct_name(srv, 'out')} out;")
+            if ins or outs:
+                o.append("")
+            in_size = "sizeof(in)" if ins else "0"
+            cond = f"params_in_len != {in_size}"
+            if outs:
+                # params_out is NULL for a notification, which has no response to fill
+                cond += " || params_out == NULL || *params_out_len < sizeof(out)"
+            o.append(f"    if ({cond}) {{")
+            o.append("        return ESP_AMP_RPC_STATUS_BAD_PACKET;")
+            o.append("    }")
+            if ins:
+                o.append("    memcpy(&in, params_in, sizeof(in));")
+            if outs:
+                o.append("    memset(&out, 0, sizeof(out));")
+            args = [f"in.{f.name}" for f in ins]
+            args += [f"out.{f.name}" if f.count else f"&out.{f.name}" for f in outs]
+            o.append(f"    esp_amp_rpc_status_t ret = {self.name}_{srv.name}_handler({', '.join(args)});")
+            if outs:
+                o.append("    memcpy(params_out, &out, sizeof(out));")
+                o.append("    *params_out_len = sizeof(out);")
+            else:
+                o.append("    *params_out_len = 0;")
+            o.append("    return ret;")
+            o.append("}")
+            o.append(f"ESP_AMP_RPC_SERVICE_DEFINE({self.srv_id(srv)}, {self.name}_{srv.name}_shim);\n")
+
+        o.append("/* referenced by the linker (-u), so that the service definitions above are linked */")
+        o.append(f"void {self.name}_rpc_server_include(void)")
+        o.append("{")
+        o.append("}")
+        return "\n".join(o) + "\n"
+
+
+def write_if_changed(path, content):
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == content:
+                return
+    with open(path, "w") as f:
+        f.write(content)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate esp-amp rpc client stubs and server skeletons from an IDL file.")
+    parser.add_argument("idl_file", help="Path to the IDL file.")
+    parser.add_argument("--output_dir", default=".", help="Directory of generated files.")
+    parser.add_argument("--name", help="Prefix of generated files and symbols, IDL file name by default.")
+    args = parser.parse_args()
+
+    name = args.name or os.path.splitext(os.path.basename(args.idl_file))[0]
+    if not IDENT_RE.match(name):
+        print(f"{args.idl_file}: invalid name '{name}', use --name", file=sys.stderr)
+        sys.exit(1)
+
+    try:
+        with open(args.idl_file) as f:
+            options, services = Parser(tokenize(f.read())).parse()
+        check(services, options)
+    except IdlError as e:
+        print(f"{args.idl_file}: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    gen = Generator(name, options, services)
+    os.makedirs(args.output_dir, exist_ok=True)
+    write_if_changed(os.path.join(args.output_dir, f"{name}_rpc.h"), gen.header())
+    write_if_changed(os.path.join(args.output_dir, f"{name}_rpc_client.c"), gen.client())
+    write_if_changed(os.path.join(args.output_dir, f"{name}_rpc_server.c"), gen.server())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,314 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "string.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_pubsub.h"
+#include "esp_amp_log.h"
+
+#define PUBSUB_FNV_OFFSET_BASIS     (2166136261UL)
+#define PUBSUB_FNV_PRIME            (16777619UL)
+
+typedef enum {
+    PUBSUB_FRAME_PUBLISH = 0,
+    PUBSUB_FRAME_SUBSCRIBE,
+    PUBSUB_FRAME_UNSUBSCRIBE,
+    PUBSUB_FRAME_SYNC,              /* ask the peer to announce all its subscriptions */
+    PUBSUB_FRAME_REJECT,            /* SUBSCRIBE refused, remote topic table is full */
+} pubsub_frame_type_t;
+
+/*
+ * With CONFIG_ESP_AMP_RPMSG_BUF_REFCNT, messages are counted by esp_amp_rpmsg_buf_ref()/unref() in the rpmsg header,
+ * so a subscriber can share the buffer with other users of that API. The option is off by default and changes the
+ * rpmsg header on both cores, so pubsub can't depend on it and falls back to its own count otherwise.
+ */
+struct esp_amp_pubsub_msg_t {
+    uint8_t type;                   /* pubsub_frame_type_t */
+    uint8_t reserved;
+    uint16_t refcnt;                /* used by receiver only, without CONFIG_ESP_AMP_RPMSG_BUF_REFCNT: references not yet released */
+    uint32_t topic_id;
+    uint8_t data[0];
+};
+
+static const DRAM_ATTR char TAG[] = "pubsub";
+
+uint32_t esp_amp_pubsub_topic_id(const char* topic)
+{
+    uint32_t hash = PUBSUB_FNV_OFFSET_BASIS;
+    for (const uint8_t* c = (const uint8_t*)topic; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= PUBSUB_FNV_PRIME;
+    }
+    return hash;
+}
+
+static esp_amp_pubsub_sub_t* IRAM_ATTR __esp_amp_pubsub_find_local_sub(esp_amp_pubsub_t* pubsub, uint32_t topic_id, esp_amp_pubsub_sub_t* until)
+{
+    for (esp_amp_pubsub_sub_t* sub = pubsub->sub_list; sub != until; sub = sub->next) {
+        if (sub->topic_id == topic_id) {
+            return sub;
+        }
+    }
+    return NULL;
+}
+
+static void IRAM_ATTR __esp_amp_pubsub_set_rejected(esp_amp_pubsub_t* pubsub, uint32_t topic_id, bool rejected)
+{
+    for (esp_amp_pubsub_sub_t* sub = pubsub->sub_list; sub != NULL; sub = sub->next) {
+        if (sub->topic_id == topic_id) {
+            sub->rejected = rejected;
+        }
+    }
+}
+
+static int IRAM_ATTR __esp_amp_pubsub_find_remote_topic(esp_amp_pubsub_t* pubsub, uint32_t topic_id)
+{
+    for (uint16_t i = 0; i < pubsub->remote_topic_num; i++) {
+        if (pubsub->remote_topics[i] == topic_id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int IRAM_ATTR __esp_amp_pubsub_send_ctrl(esp_amp_pubsub_t* pubsub, uint8_t type, uint32_t topic_id)
+{
+    esp_amp_pubsub_msg_t* frame = (esp_amp_pubsub_msg_t*)esp_amp_rpmsg_create_message_by_ept(pubsub->rpmsg_dev, &pubsub->ept, sizeof(esp_amp_pubsub_msg_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (frame == NULL) {
+        return -1;
+    }
+    frame->type = type;
+    frame->reserved = 0;
+    frame->refcnt = 0;
+    frame->topic_id = topic_id;
+    return esp_amp_rpmsg_send_nocopy(pubsub->rpmsg_dev, &pubsub->ept, pubsub->ept.addr, frame, sizeof(esp_amp_pubsub_msg_t));
+}
+
+static void IRAM_ATTR __esp_amp_pubsub_msg_ref(esp_amp_pubsub_t* pubsub, esp_amp_pubsub_msg_t* msg)
+{
+#if CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+    esp_amp_rpmsg_buf_ref(pubsub->rpmsg_dev, msg);
+#else
+    esp_amp_env_enter_critical();
+    msg->refcnt++;
+    esp_amp_env_exit_critical();
+#endif
+}
+
+static void IRAM_ATTR __esp_amp_pubsub_deliver(esp_amp_pubsub_t* pubsub, esp_amp_pubsub_msg_t* msg, uint16_t data_len)
+{
+    // the broker holds one reference during delivery, so a subscriber releasing early can't free it under the others
+#if !CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+    msg->refcnt = 1;
+#endif
+
+    // sub_list can't change under the walk, callbacks already run as if in ISR context
+    esp_amp_env_enter_critical();
+
+    for (esp_amp_pubsub_sub_t* sub = pubsub->sub_list; sub != NULL; sub = sub->next) {
+        if (sub->topic_id == msg->topic_id) {
+            __esp_amp_pubsub_msg_ref(pubsub, msg);
+            sub->cb(msg, msg->topic_id, (void*)msg->data, data_len, sub->cb_arg);
+        }
+    }
+
+    esp_amp_env_exit_critical();
+
+    // destroyed here if subscribers left after the peer published, or all of them released in the callback
+    esp_amp_pubsub_msg_release(pubsub, msg);
+}
+
+static int IRAM_ATTR __esp_amp_pubsub_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    esp_amp_pubsub_t* pubsub = (esp_amp_pubsub_t*)rx_cb_data;
+    esp_amp_pubsub_msg_t* msg = (esp_amp_pubsub_msg_t*)msg_data;
+
+    if (data_len < sizeof(esp_amp_pubsub_msg_t)) {
+        esp_amp_rpmsg_destroy(pubsub->rpmsg_dev, msg_data);
+        return 0;
+    }
+
+    if (msg->type == PUBSUB_FRAME_PUBLISH) {
+        // subscribers own the buffer from now on
+        __esp_amp_pubsub_deliver(pubsub, msg, data_len - sizeof(esp_amp_pubsub_msg_t));
+        return 0;
+    }
+
+    esp_amp_env_enter_critical();
+
+    switch (msg->type) {
+    case PUBSUB_FRAME_SUBSCRIBE:
+        if (__esp_amp_pubsub_find_remote_topic(pubsub, msg->topic_id) >= 0) {
+            break;
+        }
+        if (pubsub->remote_topic_num < CONFIG_ESP_AMP_PUBSUB_REMOTE_TOPIC_NUM) {
+            pubsub->remote_topics[pubsub->remote_topic_num++] = msg->topic_id;
+        } else {
+            ESP_AMP_DRAM_LOGW(TAG, "remote topic table full, reject topic 0x%08lx", (unsigned long)msg->topic_id);
+            __esp_amp_pubsub_send_ctrl(pubsub, PUBSUB_FRAME_REJECT, msg->topic_id);
+        }
+        break;
+    case PUBSUB_FRAME_REJECT:
+        // only the first subscriber announced the topic, but none of them will receive anything
+        if (__esp_amp_pubsub_find_local_sub(pubsub, msg->topic_id, NULL) != NULL) {
+            ESP_AMP_DRAM_LOGE(TAG, "topic 0x%08lx rejected by peer, remote topic table full", (unsigned long)msg->topic_id);
+            __esp_amp_pubsub_set_rejected(pubsub, msg->topic_id, true);
+        }
+        break;
+    case PUBSUB_FRAME_UNSUBSCRIBE: {
+        int idx = __esp_amp_pubsub_find_remote_topic(pubsub, msg->topic_id);
+        if (idx >= 0) {
+            pubsub->remote_topics[idx] = pubsub->remote_topics[--pubsub->remote_topic_num];
+        }
+        break;
+    }
+    case PUBSUB_FRAME_SYNC:
+        // peer (re)started, announce every local topic once
+        for (esp_amp_pubsub_sub_t* sub = pubsub->sub_list; sub != NULL; sub = sub->next) {
+            if (__esp_amp_pubsub_find_local_sub(pubsub, sub->topic_id, sub) == NULL) {
+                __esp_amp_pubsub_set_rejected(pubsub, sub->topic_id, false);
+                __esp_amp_pubsub_send_ctrl(pubsub, PUBSUB_FRAME_SUBSCRIBE, sub->topic_id);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    esp_amp_env_exit_critical();
+
+    esp_amp_rpmsg_destroy(pubsub->rpmsg_dev, msg_data);
+    return 0;
+}
+
+int esp_amp_pubsub_init(esp_amp_pubsub_t* pubsub, esp_amp_rpmsg_dev_t* rpmsg_dev, uint16_t ept_addr)
+{
+    if (pubsub == NULL || rpmsg_dev == NULL) {
+        return -1;
+    }
+
+    memset(pubsub, 0, sizeof(esp_amp_pubsub_t));
+    pubsub->rpmsg_dev = rpmsg_dev;
+
+    if (esp_amp_rpmsg_create_endpoint(rpmsg_dev, ept_addr, __esp_amp_pubsub_rx_cb, (void*)pubsub, &pubsub->ept) == NULL) {
+        return -1;
+    }
+
+    // if the peer is not ready yet, its own SYNC will trigger our announcements later
+    __esp_amp_pubsub_send_ctrl(pubsub, PUBSUB_FRAME_SYNC, 0);
+    return 0;
+}
+
+int esp_amp_pubsub_subscribe(esp_amp_pubsub_t* pubsub, esp_amp_pubsub_sub_t* sub, uint32_t topic_id, esp_amp_pubsub_cb_t cb, void* cb_arg)
+{
+    if (sub == NULL || cb == NULL) {
+        return -1;
+    }
+
+    sub->topic_id = topic_id;
+    sub->cb = cb;
+    sub->cb_arg = cb_arg;
+
+    esp_amp_env_enter_critical();
+
+    esp_amp_pubsub_sub_t* peer_sub = __esp_amp_pubsub_find_local_sub(pubsub, topic_id, NULL);
+    bool first = (peer_sub == NULL);
+    sub->rejected = first ? false : peer_sub->rejected;
+    sub->next = pubsub->sub_list;
+    pubsub->sub_list = sub;
+
+    esp_amp_env_exit_critical();
+
+    if (first && __esp_amp_pubsub_send_ctrl(pubsub, PUBSUB_FRAME_SUBSCRIBE, topic_id) != 0) {
+        esp_amp_pubsub_unsubscribe(pubsub, sub);
+        return -1;
+    }
+
+    return 0;
+}
+
+int esp_amp_pubsub_unsubscribe(esp_amp_pubsub_t* pubsub, esp_amp_pubsub_sub_t* sub)
+{
+    esp_amp_env_enter_critical();
+
+    esp_amp_pubsub_sub_t** prev = &pubsub->sub_list;
+    while (*prev != NULL && *prev != sub) {
+        prev = &(*prev)->next;
+    }
+
+    if (*prev == NULL) {
+        esp_amp_env_exit_critical();
+        return -1;
+    }
+    *prev = sub->next;
+    sub->next = NULL;
+    bool last = (__esp_amp_pubsub_find_local_sub(pubsub, sub->topic_id, NULL) == NULL);
+
+    esp_amp_env_exit_critical();
+
+    if (last) {
+        // best effort, messages still published by the peer are dropped on arrival
+        __esp_amp_pubsub_send_ctrl(pubsub, PUBSUB_FRAME_UNSUBSCRIBE, sub->topic_id);
+    }
+
+    return 0;
+}
+
+bool esp_amp_pubsub_has_remote_subscriber(esp_amp_pubsub_t* pubsub, uint32_t topic_id)
+{
+    esp_amp_env_enter_critical();
+
+    bool found = __esp_amp_pubsub_find_remote_topic(pubsub, topic_id) >= 0;
+
+    esp_amp_env_exit_critical();
+
+    return found;
+}
+
+int esp_amp_pubsub_publish(esp_amp_pubsub_t* pubsub, uint32_t topic_id, const void* data, uint16_t data_len)
+{
+    if (!esp_amp_pubsub_has_remote_subscriber(pubsub, topic_id)) {
+        // nobody cares, don't cross the core boundary
+        return 1;
+    }
+
+    uint32_t frame_len = sizeof(esp_amp_pubsub_msg_t) + data_len;
+    esp_amp_pubsub_msg_t* frame = (esp_amp_pubsub_msg_t*)esp_amp_rpmsg_create_message_by_ept(pubsub->rpmsg_dev, &pubsub->ept, frame_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (frame == NULL) {
+        return -1;
+    }
+
+    frame->type = PUBSUB_FRAME_PUBLISH;
+    frame->reserved = 0;
+    frame->refcnt = 0;
+    frame->topic_id = topic_id;
+    memcpy(frame->data, data, data_len);
+
+    return esp_amp_rpmsg_send_nocopy(pubsub->rpmsg_dev, &pubsub->ept, pubsub->ept.addr, frame, frame_len);
+}
+
+void IRAM_ATTR esp_amp_pubsub_msg_release(esp_amp_pubsub_t* pubsub, esp_amp_pubsub_msg_t* msg)
+{
+#if CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+    esp_amp_rpmsg_buf_unref(pubsub->rpmsg_dev, msg);
+#else
+    esp_amp_env_enter_critical();
+
+    bool last = (--msg->refcnt == 0);
+
+    esp_amp_env_exit_critical();
+
+    if (last) {
+        esp_amp_rpmsg_destroy(pubsub->rpmsg_dev, msg);
+    }
+#endif
+}
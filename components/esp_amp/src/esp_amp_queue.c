@@ -54,7 +54,9 @@ int IRAM_ATTR esp_amp_queue_send_try(esp_amp_queue_t *queue, void* data, uint16_
     }
 
     // notify the opposite side if necessary
-    if (queue->notify_fc != NULL) {
+    esp_amp_platform_memory_barrier();
+    // make sure the slot is published before checking whether the opposite side is polling
+    if (queue->notify_fc != NULL && !queue->conf->notify_disabled) {
         return queue->notify_fc(queue->priv_data);
     }
 
@@ -137,6 +139,17 @@ int IRAM_ATTR esp_amp_queue_free_try(esp_amp_queue_t *queue, void* buffer)
         return ESP_ERR_NOT_ALLOWED;
     }
 
+    /*
+        Buffers can be freed in a different order than received: the freed buffer address is written into the next
+        used slot, so the slot doesn't need to hold the buffer it carried when received. Only make sure the buffer
+        really comes from this queue, otherwise `master-core` would later alloc a foreign buffer.
+    */
+    uint8_t* queue_buffer = queue->conf->queue_buffer;
+    uint32_t offset = (uint32_t)((uint8_t*)buffer - queue_buffer);
+    if ((uint8_t*)buffer < queue_buffer || offset >= (uint32_t)queue->size * queue->max_item_size || offset % queue->max_item_size != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     uint16_t q_idx = queue->used_index & (queue->size - 1);
     uint16_t flags = queue->desc[q_idx].flags;
     esp_amp_platform_memory_barrier();
@@ -163,12 +176,51 @@ int IRAM_ATTR esp_amp_queue_free_try(esp_amp_queue_t *queue, void* buffer)
     return ESP_OK;
 }
 
+int IRAM_ATTR esp_amp_queue_notify_disable(esp_amp_queue_t* queue)
+{
+    if (queue->master) {
+        // can only be called on `remote-core`
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    queue->conf->notify_disabled = 1;
+    esp_amp_platform_memory_barrier();
+    return ESP_OK;
+}
+
+int IRAM_ATTR esp_amp_queue_notify_enable(esp_amp_queue_t* queue)
+{
+    if (queue->master) {
+        // can only be called on `remote-core`
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    queue->conf->notify_disabled = 0;
+    esp_amp_platform_memory_barrier();
+    // make sure the flag is visible before the caller checks the queue again
+    return ESP_OK;
+}
+
+bool IRAM_ATTR esp_amp_queue_recv_available(esp_amp_queue_t* queue)
+{
+    if (queue->master) {
+        // can only be called on `remote-core`
+        return false;
+    }
+
+    uint16_t q_idx = queue->free_index & (queue->size - 1);
+    uint16_t flags = queue->desc[q_idx].flags;
+    esp_amp_platform_memory_barrier();
+    return ESP_AMP_QUEUE_FLAG_IS_AVAILABLE(queue->free_flip_counter, flags);
+}
+
 int esp_amp_queue_init_buffer(esp_amp_queue_conf_t* queue_conf, uint16_t queue_len, uint16_t queue_item_size, esp_amp_queue_desc_t* queue_desc, void* queue_buffer)
 {
     queue_conf->queue_size = queue_len;
     queue_conf->max_queue_item_size = queue_item_size;
     queue_conf->queue_desc = queue_desc;
     queue_conf->queue_buffer = queue_buffer;
+    queue_conf->notify_disabled = 0;
     uint8_t* _queue_buffer = (uint8_t*)queue_buffer;
     for (uint16_t desc_idx = 0; desc_idx < queue_conf->queue_size; desc_idx++) {
         queue_conf->queue_desc[desc_idx].addr = (uint32_t)_queue_buffer;
@@ -188,6 +240,7 @@ int esp_amp_queue_create(esp_amp_queue_t* queue, esp_amp_queue_conf_t* queue_con
     queue->free_index = 0;
     queue->used_index = 0;
     queue->max_item_size = queue_conf->max_queue_item_size;
+    queue->conf = queue_conf;
     if (is_master) {
         /* master can only send message */
         queue->notify_fc = cb_func;
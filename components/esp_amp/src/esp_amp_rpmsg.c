@@ -5,6 +5,7 @@
 */
 
 
+#include "sdkconfig.h"
 #include "esp_attr.h"
 
 #include "esp_amp_env.h"
@@ -13,6 +14,8 @@
 #include "esp_amp_platform.h"
 #include "esp_amp_sys_info.h"
 #include "esp_amp_sw_intr.h"
+#include "esp_amp_rpmsg_trace_priv.h"
+#include "esp_amp_rpmsg_latency_priv.h"
 
 
 static void __esp_amp_rpmsg_extend_endpoint_list(esp_amp_rpmsg_ept_t** ept_head, esp_amp_rpmsg_ept_t* new_ept)
@@ -73,6 +76,10 @@ esp_amp_rpmsg_ept_t* esp_amp_rpmsg_create_endpoint(esp_amp_rpmsg_dev_t* rpmsg_de
     }
 
     ept_ctx->addr = ept_addr;
+    ept_ctx->lane = 0;
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+    ept_ctx->latency = NULL;
+#endif
     ept_ctx->rx_cb = ept_rx_cb;
     ept_ctx->rx_cb_data = ept_rx_cb_data;
     __esp_amp_rpmsg_extend_endpoint_list(&(rpmsg_device->ept_list), ept_ctx);
@@ -137,18 +144,52 @@ esp_amp_rpmsg_ept_t* esp_amp_rpmsg_rebind_endpoint(esp_amp_rpmsg_dev_t* rpmsg_de
     return ept_ptr;
 }
 
+int esp_amp_rpmsg_endpoint_set_lane(esp_amp_rpmsg_dev_t* rpmsg_device, esp_amp_rpmsg_ept_t* ept, uint8_t lane)
+{
+    if (ept == NULL || lane >= rpmsg_device->lane_num) {
+        return -1;
+    }
+
+    esp_amp_env_enter_critical();
+
+    ept->lane = lane;
+
+    esp_amp_env_exit_critical();
+
+    return 0;
+}
+
 static int IRAM_ATTR __esp_amp_rpmsg_dispatcher(esp_amp_rpmsg_t* rpmsg, esp_amp_rpmsg_dev_t* rpmsg_dev)
 {
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+    uint32_t recv_ts = esp_amp_platform_get_time_us();
+    if (rpmsg->msg_head.dst_addr == ESP_AMP_RPMSG_RESERVED_EPT_CLOCK_SYNC) {
+        esp_amp_rpmsg_clock_sync_handler(rpmsg_dev, rpmsg, recv_ts);
+        return 0;
+    }
+#endif
+
     esp_amp_rpmsg_ept_t* ept = __esp_amp_rpmsg_search_endpoint(rpmsg_dev, rpmsg->msg_head.dst_addr);
     if (ept == NULL) {
-        // can't find endpoint, ignore and return
-        return -1;
+        // can't find endpoint, nobody else can free the buffer, drop it
+        esp_amp_rpmsg_destroy(rpmsg_dev, (void*)(rpmsg->msg_data));
+        return 0;
     }
 
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+    if (ept->latency != NULL) {
+        esp_amp_rpmsg_latency_record(rpmsg_dev, ept->latency, rpmsg->msg_head.send_ts, recv_ts);
+    }
+#endif
+
     if (ept->rx_cb == NULL) {
         // endpoint has no callback function, nothing to do
         return 0;
     }
+#if CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+    // the endpoint callback owns the first reference
+    rpmsg->msg_head.refcnt = 1;
+#endif
     ept->rx_cb((void*)(rpmsg->msg_data), rpmsg->msg_head.data_len, rpmsg->msg_head.src_addr, ept->rx_cb_data);
     return 0;
 }
@@ -157,23 +198,126 @@ int IRAM_ATTR esp_amp_rpmsg_poll(esp_amp_rpmsg_dev_t* rpmsg_dev)
 {
     esp_amp_rpmsg_t* rpmsg;
     uint16_t rpmsg_size;
-    if (rpmsg_dev->queue_ops.q_rx(rpmsg_dev->rx_queue, (void**)(&rpmsg), &rpmsg_size) != 0) {
-        // nothing to receive
-        return -1;
+    // always restart from lane 0, so that a busy low priority lane can delay a high priority rpmsg by at most one callback
+    for (uint8_t lane = 0; lane < rpmsg_dev->lane_num; lane++) {
+        if (rpmsg_dev->queue_ops.q_rx(&rpmsg_dev->lane_queues[2 * lane + 1], (void**)(&rpmsg), &rpmsg_size) == 0) {
+#if CONFIG_ESP_AMP_RPMSG_TRACE
+            esp_amp_rpmsg_trace_record(rpmsg_dev, ESP_AMP_RPMSG_TRACE_DIR_RX, rpmsg);
+#endif
+            return __esp_amp_rpmsg_dispatcher(rpmsg, rpmsg_dev);
+        }
     }
 
-    return __esp_amp_rpmsg_dispatcher(rpmsg, rpmsg_dev);
+    // nothing to receive
+    return -1;
+}
+
+static void IRAM_ATTR __esp_amp_rpmsg_rx_notify_set(esp_amp_rpmsg_dev_t* rpmsg_dev, bool enable)
+{
+    for (uint8_t lane = 0; lane < rpmsg_dev->lane_num; lane++) {
+        if (enable) {
+            esp_amp_queue_notify_enable(&rpmsg_dev->lane_queues[2 * lane + 1]);
+        } else {
+            esp_amp_queue_notify_disable(&rpmsg_dev->lane_queues[2 * lane + 1]);
+        }
+    }
+}
+
+static bool IRAM_ATTR __esp_amp_rpmsg_rx_available(esp_amp_rpmsg_dev_t* rpmsg_dev)
+{
+    for (uint8_t lane = 0; lane < rpmsg_dev->lane_num; lane++) {
+        if (esp_amp_queue_recv_available(&rpmsg_dev->lane_queues[2 * lane + 1])) {
+            return true;
+        }
+    }
+    return false;
 }
 
 static int IRAM_ATTR __esp_amp_rpmsg_rx_callback(void* data)
 {
     esp_amp_rpmsg_dev_t* rpmsg_dev = (esp_amp_rpmsg_dev_t*) data;
-    while (esp_amp_rpmsg_poll(rpmsg_dev) == 0) {
-        // receive and process all avaialble vqueue item
+    esp_amp_rpmsg_adaptive_t* adaptive = &rpmsg_dev->adaptive;
+
+    if (adaptive->sched_cb == NULL) {
+        while (esp_amp_rpmsg_poll(rpmsg_dev) == 0) {
+            // receive and process all avaialble vqueue item
+        }
+        return 0;
+    }
+
+    if (adaptive->polling) {
+        // the poller owns the rx queues, interrupt comes from other users of the same software interrupt
+        return 0;
+    }
+
+    for (uint16_t i = 0; i < adaptive->intr_budget; i++) {
+        if (esp_amp_rpmsg_poll(rpmsg_dev) != 0) {
+            return 0;
+        }
     }
+
+    // budget exhausted in ISR: mask the doorbell and let the poller drain the rest in batches
+    __esp_amp_rpmsg_rx_notify_set(rpmsg_dev, false);
+    adaptive->polling = true;
+    return adaptive->sched_cb(adaptive->sched_arg);
+}
+
+int esp_amp_rpmsg_adaptive_enable(esp_amp_rpmsg_dev_t* rpmsg_dev, uint16_t intr_budget, uint16_t poll_budget, esp_amp_rpmsg_sched_cb_t sched_cb, void* sched_arg)
+{
+    if (sched_cb == NULL || rpmsg_dev->rx_queue->callback_fc == NULL) {
+        // adaptive mode relies on interrupt
+        return -1;
+    }
+
+    esp_amp_env_enter_critical();
+
+    rpmsg_dev->adaptive.intr_budget = intr_budget ? intr_budget : CONFIG_ESP_AMP_RPMSG_ADAPTIVE_INTR_BUDGET;
+    rpmsg_dev->adaptive.poll_budget = poll_budget ? poll_budget : CONFIG_ESP_AMP_RPMSG_ADAPTIVE_POLL_BUDGET;
+    rpmsg_dev->adaptive.sched_arg = sched_arg;
+    rpmsg_dev->adaptive.polling = false;
+    rpmsg_dev->adaptive.sched_cb = sched_cb;
+
+    esp_amp_env_exit_critical();
+
     return 0;
 }
 
+int esp_amp_rpmsg_adaptive_poll(esp_amp_rpmsg_dev_t* rpmsg_dev)
+{
+    esp_amp_rpmsg_adaptive_t* adaptive = &rpmsg_dev->adaptive;
+
+    if (!adaptive->polling) {
+        return -1;
+    }
+
+    uint16_t processed = 0;
+    while (processed < adaptive->poll_budget && esp_amp_rpmsg_poll(rpmsg_dev) == 0) {
+        processed++;
+    }
+
+    if (processed == adaptive->poll_budget) {
+        // batch used up, more rpmsg may be pending
+        return 0;
+    }
+
+    int ret = -1;
+
+    esp_amp_env_enter_critical();
+
+    // re-arm the doorbell, then check again for rpmsg sent before the other core saw the doorbell re-armed
+    __esp_amp_rpmsg_rx_notify_set(rpmsg_dev, true);
+    if (__esp_amp_rpmsg_rx_available(rpmsg_dev)) {
+        __esp_amp_rpmsg_rx_notify_set(rpmsg_dev, false);
+        ret = 0;
+    } else {
+        adaptive->polling = false;
+    }
+
+    esp_amp_env_exit_critical();
+
+    return ret;
+}
+
 static int IRAM_ATTR __esp_amp_rpmsg_tx_notify(void* data)
 {
     esp_amp_sw_intr_trigger(SW_INTR_RESERVED_ID_VQUEUE);
@@ -182,115 +326,186 @@ static int IRAM_ATTR __esp_amp_rpmsg_tx_notify(void* data)
 
 int esp_amp_rpmsg_intr_enable(esp_amp_rpmsg_dev_t* rpmsg_dev)
 {
+    /* all lanes share the same software interrupt, and its callback drains every lane */
     return esp_amp_queue_intr_enable(rpmsg_dev->rx_queue);
 }
 
-static void __esp_amp_rpmsg_dev_init(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t vqueue[])
+static void __esp_amp_rpmsg_dev_init(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t vqueue[], uint8_t lane_num)
 {
     rpmsg_dev->tx_queue = &vqueue[0];
     rpmsg_dev->rx_queue = &vqueue[1];
+    rpmsg_dev->lane_queues = vqueue;
+    rpmsg_dev->lane_num = lane_num;
     rpmsg_dev->ept_list = NULL;
+    rpmsg_dev->adaptive.sched_cb = NULL;
+    rpmsg_dev->adaptive.polling = false;
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+    rpmsg_dev->clock.synced = false;
+    rpmsg_dev->clock.syncing = false;
+#endif
     rpmsg_dev->queue_ops.q_tx = esp_amp_queue_send_try;
     rpmsg_dev->queue_ops.q_tx_alloc = esp_amp_queue_alloc_try;
     rpmsg_dev->queue_ops.q_rx = esp_amp_queue_recv_try;
     rpmsg_dev->queue_ops.q_rx_free = esp_amp_queue_free_try;
 }
 
+int esp_amp_rpmsg_init_with_transport(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t channels[], uint8_t lane_num, const esp_amp_queue_ops_t* ops)
+{
+    if (rpmsg_dev == NULL || channels == NULL || ops == NULL || lane_num == 0 || lane_num > ESP_AMP_RPMSG_LANE_NUM_MAX) {
+        return -1;
+    }
+    if (ops->q_tx == NULL || ops->q_tx_alloc == NULL || ops->q_rx == NULL || ops->q_rx_free == NULL) {
+        return -1;
+    }
+
+    __esp_amp_rpmsg_dev_init(rpmsg_dev, channels, lane_num);
+    rpmsg_dev->queue_ops = *ops;
+
+    return 0;
+}
+
 #if IS_MAIN_CORE
-int esp_amp_rpmsg_main_init_by_id(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t rpmsg_vqueue[], uint16_t queue_len, uint16_t queue_item_size, bool notify, bool poll, esp_amp_sys_info_id_t sysinfo_id)
+int esp_amp_rpmsg_main_init_with_lanes(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t rpmsg_vqueue[], const esp_amp_rpmsg_lane_conf_t lane_conf[], uint8_t lane_num, bool notify, bool poll, esp_amp_sys_info_id_t sysinfo_id)
 {
-    // force to ceil the queue length to power of 2
-    uint16_t aligned_queue_len = get_power_len(queue_len);
-    // force to align the queue item size with word boundary
-    uint16_t aligned_queue_item_size = get_aligned_size(queue_item_size);
+    uint16_t aligned_queue_len[ESP_AMP_RPMSG_LANE_NUM_MAX];
+    uint16_t aligned_queue_item_size[ESP_AMP_RPMSG_LANE_NUM_MAX];
+
+    if (lane_num == 0 || lane_num > ESP_AMP_RPMSG_LANE_NUM_MAX) {
+        return -1;
+    }
+
+    size_t queue_shm_size = 0;
+    for (uint8_t lane = 0; lane < lane_num; lane++) {
+        // force to ceil the queue length to power of 2
+        aligned_queue_len[lane] = get_power_len(lane_conf[lane].queue_len);
+        // force to align the queue item size with word boundary
+        aligned_queue_item_size[lane] = get_aligned_size(lane_conf[lane].queue_item_size);
+
+        if (aligned_queue_len[lane] == 0 || aligned_queue_item_size[lane] == 0) {
+            return -1;
+        }
+        queue_shm_size += 2 * (sizeof(esp_amp_queue_conf_t) + sizeof(esp_amp_queue_desc_t) * aligned_queue_len[lane] + aligned_queue_item_size[lane] * aligned_queue_len[lane]);
+    }
 
-    if (aligned_queue_len == 0 || aligned_queue_item_size == 0) {
+    if (queue_shm_size > UINT16_MAX) {
         return -1;
     }
 
     esp_amp_queue_cb_t tx_notify = notify ? __esp_amp_rpmsg_tx_notify : NULL;
     esp_amp_queue_cb_t rx_callback = poll ? NULL : __esp_amp_rpmsg_rx_callback;
 
-    size_t queue_shm_size = 2 * (sizeof(esp_amp_queue_conf_t) + sizeof(esp_amp_queue_desc_t) * aligned_queue_len + aligned_queue_item_size * aligned_queue_len);
-    // alloc fixed-size buffer for TX/RX Virtqueue
+    // alloc fixed-size buffer for TX/RX Virtqueue of all lanes
     uint8_t* vq_buffer = (uint8_t*)(esp_amp_sys_info_alloc(sysinfo_id, queue_shm_size));
     if (vq_buffer == NULL) {
         // reserve memory not enough or corresponding sys_info already occupied
         return -1;
     }
 
-    esp_amp_queue_conf_t* vq_tx_confg = (esp_amp_queue_conf_t*)(vq_buffer);
-    vq_buffer += sizeof(esp_amp_queue_conf_t);
-    esp_amp_queue_conf_t* vq_rx_confg = (esp_amp_queue_conf_t*)(vq_buffer);
-    vq_buffer += sizeof(esp_amp_queue_conf_t);
-    esp_amp_queue_desc_t* vq_tx_desc = (esp_amp_queue_desc_t*)(vq_buffer);
-    vq_buffer += sizeof(esp_amp_queue_desc_t) * aligned_queue_len;
-    esp_amp_queue_desc_t* vq_rx_desc = (esp_amp_queue_desc_t*)(vq_buffer);
-    vq_buffer += sizeof(esp_amp_queue_desc_t) * aligned_queue_len;
-    void* vq_tx_data_buffer = (void*)(vq_buffer);
-    vq_buffer += aligned_queue_item_size * aligned_queue_len;
-    void* vq_rx_data_buffer = (void*)(vq_buffer);
+    /*
+     * shared memory layout: TX/RX config of all lanes, then TX/RX descriptors of all lanes, then TX/RX data buffers of all lanes.
+     * With a single lane this is identical to the original layout: tx_conf, rx_conf, tx_desc, rx_desc, tx_buffer, rx_buffer
+     */
+    esp_amp_queue_conf_t* vq_confg = (esp_amp_queue_conf_t*)(vq_buffer);
+    vq_buffer += 2 * lane_num * sizeof(esp_amp_queue_conf_t);
+    esp_amp_queue_desc_t* vq_desc[2 * ESP_AMP_RPMSG_LANE_NUM_MAX];
+    for (uint8_t i = 0; i < 2 * lane_num; i++) {
+        vq_desc[i] = (esp_amp_queue_desc_t*)(vq_buffer);
+        vq_buffer += sizeof(esp_amp_queue_desc_t) * aligned_queue_len[i / 2];
+    }
+    for (uint8_t i = 0; i < 2 * lane_num; i++) {
+        // initialize the queue config
+        esp_amp_queue_init_buffer(&vq_confg[i], aligned_queue_len[i / 2], aligned_queue_item_size[i / 2], vq_desc[i], (void*)(vq_buffer));
+        vq_buffer += aligned_queue_item_size[i / 2] * aligned_queue_len[i / 2];
+    }
 
-    // initialize the queue config
-    esp_amp_queue_init_buffer(vq_tx_confg, aligned_queue_len, aligned_queue_item_size, vq_tx_desc, vq_tx_data_buffer);
-    esp_amp_queue_init_buffer(vq_rx_confg, aligned_queue_len, aligned_queue_item_size, vq_rx_desc, vq_rx_data_buffer);
-    // initialize the local queue structure
-    esp_amp_queue_create(&rpmsg_vqueue[0], vq_tx_confg, tx_notify, (void*)(rpmsg_dev), true);
-    esp_amp_queue_create(&rpmsg_vqueue[1], vq_rx_confg, rx_callback, (void*)(rpmsg_dev), false);
+    for (uint8_t lane = 0; lane < lane_num; lane++) {
+        // initialize the local queue structure
+        esp_amp_queue_create(&rpmsg_vqueue[2 * lane], &vq_confg[2 * lane], tx_notify, (void*)(rpmsg_dev), true);
+        esp_amp_queue_create(&rpmsg_vqueue[2 * lane + 1], &vq_confg[2 * lane + 1], rx_callback, (void*)(rpmsg_dev), false);
+    }
 
-    __esp_amp_rpmsg_dev_init(rpmsg_dev, rpmsg_vqueue);
+    __esp_amp_rpmsg_dev_init(rpmsg_dev, rpmsg_vqueue, lane_num);
 
     return 0;
 }
 
+int esp_amp_rpmsg_main_init_by_id(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t rpmsg_vqueue[], uint16_t queue_len, uint16_t queue_item_size, bool notify, bool poll, esp_amp_sys_info_id_t sysinfo_id)
+{
+    esp_amp_rpmsg_lane_conf_t lane_conf = {
+        .queue_len = queue_len,
+        .queue_item_size = queue_item_size,
+    };
+    return esp_amp_rpmsg_main_init_with_lanes(rpmsg_dev, rpmsg_vqueue, &lane_conf, 1, notify, poll, sysinfo_id);
+}
+
 int esp_amp_rpmsg_main_init(esp_amp_rpmsg_dev_t* rpmsg_dev, uint16_t queue_len, uint16_t queue_item_size, bool notify, bool poll)
 {
     static esp_amp_queue_t vqueue[2];
     return esp_amp_rpmsg_main_init_by_id(rpmsg_dev, vqueue, queue_len, queue_item_size, notify, poll, SYS_INFO_RESERVED_ID_VQUEUE);
 }
-#else
-int esp_amp_rpmsg_sub_init_by_id(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t rpmsg_vqueue[], bool notify, bool poll, esp_amp_sys_info_id_t sysinfo_id)
+#endif /* IS_MAIN_CORE */
+
+/* sub-core init only reads the shared memory, keep it available on main-core as well for host tools running both sides */
+int esp_amp_rpmsg_sub_init_with_lanes(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t rpmsg_vqueue[], uint8_t lane_num, bool notify, bool poll, esp_amp_sys_info_id_t sysinfo_id)
 {
     uint16_t queue_shm_size;
     uint8_t* vq_buffer = esp_amp_sys_info_get(sysinfo_id, &queue_shm_size);
 
-    if (vq_buffer == NULL) {
+    if (vq_buffer == NULL || lane_num == 0 || lane_num > ESP_AMP_RPMSG_LANE_NUM_MAX) {
+        return -1;
+    }
+
+    if (queue_shm_size < 2 * lane_num * sizeof(esp_amp_queue_conf_t)) {
+        return -1;
+    }
+
+    esp_amp_queue_conf_t* vq_confg = (esp_amp_queue_conf_t*)(vq_buffer);
+
+    // make sure main-core created the same number of lanes
+    size_t expected_shm_size = 0;
+    for (uint8_t i = 0; i < 2 * lane_num; i++) {
+        expected_shm_size += sizeof(esp_amp_queue_conf_t) + (sizeof(esp_amp_queue_desc_t) + vq_confg[i].max_queue_item_size) * vq_confg[i].queue_size;
+    }
+    if (expected_shm_size != queue_shm_size) {
         return -1;
     }
 
     esp_amp_queue_cb_t tx_notify = notify ? __esp_amp_rpmsg_tx_notify : NULL;
     esp_amp_queue_cb_t rx_callback = poll ? NULL : __esp_amp_rpmsg_rx_callback;
 
-    // Note: the configuration is different from the queue_main_init, since the main TX is sub RX; main RX is sub TX;
-    esp_amp_queue_conf_t* vq_tx_confg = (esp_amp_queue_conf_t*)(vq_buffer + sizeof(esp_amp_queue_conf_t));
-    esp_amp_queue_conf_t* vq_rx_confg = (esp_amp_queue_conf_t*)(vq_buffer);
-    // initialize the local queue structure
-    esp_amp_queue_create(&rpmsg_vqueue[0], vq_tx_confg, tx_notify, (void*)(rpmsg_dev), true);
-    esp_amp_queue_create(&rpmsg_vqueue[1], vq_rx_confg, rx_callback, (void*)(rpmsg_dev), false);
+    for (uint8_t lane = 0; lane < lane_num; lane++) {
+        // Note: the configuration is different from the queue_main_init, since the main TX is sub RX; main RX is sub TX;
+        esp_amp_queue_create(&rpmsg_vqueue[2 * lane], &vq_confg[2 * lane + 1], tx_notify, (void*)(rpmsg_dev), true);
+        esp_amp_queue_create(&rpmsg_vqueue[2 * lane + 1], &vq_confg[2 * lane], rx_callback, (void*)(rpmsg_dev), false);
+    }
 
-    __esp_amp_rpmsg_dev_init(rpmsg_dev, rpmsg_vqueue);
+    __esp_amp_rpmsg_dev_init(rpmsg_dev, rpmsg_vqueue, lane_num);
 
     return 0;
 }
 
+int esp_amp_rpmsg_sub_init_by_id(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_queue_t rpmsg_vqueue[], bool notify, bool poll, esp_amp_sys_info_id_t sysinfo_id)
+{
+    return esp_amp_rpmsg_sub_init_with_lanes(rpmsg_dev, rpmsg_vqueue, 1, notify, poll, sysinfo_id);
+}
+
 int esp_amp_rpmsg_sub_init(esp_amp_rpmsg_dev_t* rpmsg_dev, bool notify, bool poll)
 {
     static esp_amp_queue_t vqueue[2];
     return esp_amp_rpmsg_sub_init_by_id(rpmsg_dev, vqueue, notify, poll, SYS_INFO_RESERVED_ID_VQUEUE);
 }
-#endif
 
-void* esp_amp_rpmsg_create_message(esp_amp_rpmsg_dev_t* rpmsg_dev, uint32_t nbytes, uint16_t flags)
+static void* __esp_amp_rpmsg_create_message(esp_amp_rpmsg_dev_t* rpmsg_dev, uint8_t lane, uint32_t nbytes, uint16_t flags)
 {
     uint32_t rpmsg_size = nbytes + offsetof(esp_amp_rpmsg_t, msg_data);
     esp_amp_rpmsg_t* rpmsg;
-    if (rpmsg_size >= (uint32_t)(1) << 16) {
+    if (rpmsg_size >= (uint32_t)(1) << 16 || lane >= rpmsg_dev->lane_num) {
         return NULL;
     }
 
     esp_amp_env_enter_critical();
 
-    int ret = rpmsg_dev->queue_ops.q_tx_alloc(rpmsg_dev->tx_queue, (void**)(&rpmsg), rpmsg_size);
+    int ret = rpmsg_dev->queue_ops.q_tx_alloc(&rpmsg_dev->lane_queues[2 * lane], (void**)(&rpmsg), rpmsg_size);
 
     esp_amp_env_exit_critical();
 
@@ -298,12 +513,22 @@ void* esp_amp_rpmsg_create_message(esp_amp_rpmsg_dev_t* rpmsg_dev, uint32_t nbyt
         return NULL;
     }
 
-    rpmsg->msg_head.data_flags = flags;
+    rpmsg->msg_head.data_flags = ESP_AMP_RPMSG_DATA_SET_LANE(flags, lane);
     rpmsg->msg_head.data_len = nbytes;
 
     return (void*)((uint8_t*)(rpmsg) + offsetof(esp_amp_rpmsg_t, msg_data));
 }
 
+void* esp_amp_rpmsg_create_message(esp_amp_rpmsg_dev_t* rpmsg_dev, uint32_t nbytes, uint16_t flags)
+{
+    return __esp_amp_rpmsg_create_message(rpmsg_dev, 0, nbytes, flags);
+}
+
+void* esp_amp_rpmsg_create_message_by_ept(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept, uint32_t nbytes, uint16_t flags)
+{
+    return __esp_amp_rpmsg_create_message(rpmsg_dev, ept->lane, nbytes, flags);
+}
+
 int esp_amp_rpmsg_send(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept, uint16_t dst_addr, void* data, uint16_t data_len)
 {
 
@@ -311,7 +536,7 @@ int esp_amp_rpmsg_send(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept,
         return -1;
     }
 
-    void* buffer = esp_amp_rpmsg_create_message(rpmsg_dev, data_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    void* buffer = esp_amp_rpmsg_create_message_by_ept(rpmsg_dev, ept, data_len, ESP_AMP_RPMSG_DATA_DEFAULT);
 
     if (buffer == NULL) {
         return -1;
@@ -327,13 +552,30 @@ int esp_amp_rpmsg_send(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept,
 int esp_amp_rpmsg_send_nocopy(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept, uint16_t dst_addr, void* data, uint16_t data_len)
 {
     esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)((uint8_t*)(data) - offsetof(esp_amp_rpmsg_t, msg_data));
+    // the buffer must go back through the lane it was allocated from
+    uint8_t lane = ESP_AMP_RPMSG_DATA_GET_LANE(rpmsg->msg_head.data_flags);
+    if (lane >= rpmsg_dev->lane_num) {
+        return -1;
+    }
+    esp_amp_queue_t* tx_queue = &rpmsg_dev->lane_queues[2 * lane];
+
     rpmsg->msg_head.data_len = data_len;
     rpmsg->msg_head.dst_addr = dst_addr;
     rpmsg->msg_head.src_addr = ept->addr;
 
     esp_amp_env_enter_critical();
 
-    int ret = rpmsg_dev->queue_ops.q_tx(rpmsg_dev->tx_queue, rpmsg, rpmsg_dev->tx_queue->max_item_size);
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+    rpmsg->msg_head.send_ts = esp_amp_platform_get_time_us();
+#endif
+    int ret = rpmsg_dev->queue_ops.q_tx(tx_queue, rpmsg, tx_queue->max_item_size);
+
+#if CONFIG_ESP_AMP_RPMSG_TRACE
+    if (ret == 0) {
+        // this core can't reuse the buffer before leaving critical section
+        esp_amp_rpmsg_trace_record(rpmsg_dev, ESP_AMP_RPMSG_TRACE_DIR_TX, rpmsg);
+    }
+#endif
 
     esp_amp_env_exit_critical();
 
@@ -343,17 +585,74 @@ int esp_amp_rpmsg_send_nocopy(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_
 int esp_amp_rpmsg_destroy(esp_amp_rpmsg_dev_t* rpmsg_dev, void* msg_data)
 {
     esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)((uint8_t*)(msg_data) - offsetof(esp_amp_rpmsg_t, msg_data));
+    // lane index is set by the sender, which is the same as the local RX lane
+    uint8_t lane = ESP_AMP_RPMSG_DATA_GET_LANE(rpmsg->msg_head.data_flags);
+    if (lane >= rpmsg_dev->lane_num) {
+        return -1;
+    }
 
     esp_amp_env_enter_critical();
 
-    int ret = rpmsg_dev->queue_ops.q_rx_free(rpmsg_dev->rx_queue, rpmsg);
+    int ret = rpmsg_dev->queue_ops.q_rx_free(&rpmsg_dev->lane_queues[2 * lane + 1], rpmsg);
+
+    esp_amp_env_exit_critical();
+
+    return ret;
+}
+
+#if CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+int IRAM_ATTR esp_amp_rpmsg_buf_ref(esp_amp_rpmsg_dev_t* rpmsg_dev, void* msg_data)
+{
+    esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)((uint8_t*)(msg_data) - offsetof(esp_amp_rpmsg_t, msg_data));
+    int ret = -1;
+
+    esp_amp_env_enter_critical();
+
+    if (rpmsg->msg_head.refcnt != 0 && rpmsg->msg_head.refcnt != UINT16_MAX) {
+        rpmsg->msg_head.refcnt++;
+        ret = 0;
+    }
 
     esp_amp_env_exit_critical();
 
     return ret;
 }
 
+int IRAM_ATTR esp_amp_rpmsg_buf_unref(esp_amp_rpmsg_dev_t* rpmsg_dev, void* msg_data)
+{
+    esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)((uint8_t*)(msg_data) - offsetof(esp_amp_rpmsg_t, msg_data));
+    uint16_t refcnt;
+
+    esp_amp_env_enter_critical();
+
+    refcnt = rpmsg->msg_head.refcnt;
+    if (refcnt != 0) {
+        rpmsg->msg_head.refcnt = refcnt - 1;
+    }
+
+    esp_amp_env_exit_critical();
+
+    if (refcnt == 0) {
+        // over-release caught only if the buffer isn't reused yet, undefined behavior in general
+        return -1;
+    }
+    if (refcnt == 1) {
+        // last reference, give the buffer back to the other core
+        return esp_amp_rpmsg_destroy(rpmsg_dev, msg_data);
+    }
+    return 0;
+}
+#endif
+
 uint16_t IRAM_ATTR esp_amp_rpmsg_get_max_size(esp_amp_rpmsg_dev_t* rpmsg_dev)
 {
     return (uint16_t)(rpmsg_dev->tx_queue->max_item_size - offsetof(esp_amp_rpmsg_t, msg_data));
 }
+
+uint16_t IRAM_ATTR esp_amp_rpmsg_get_lane_max_size(esp_amp_rpmsg_dev_t* rpmsg_dev, uint8_t lane)
+{
+    if (lane >= rpmsg_dev->lane_num) {
+        return 0;
+    }
+    return (uint16_t)(rpmsg_dev->lane_queues[2 * lane].max_item_size - offsetof(esp_amp_rpmsg_t, msg_data));
+}
@@ -0,0 +1,213 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "string.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_latency.h"
+#include "esp_amp_rpmsg_latency_priv.h"
+
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+
+/*
+    Clock sync, NTP-like exchange between initiator (A) and responder (B):
+    PROBE   A -> B: t0 = send_ts of the probe
+    REPLY   B -> A: ts_a = t0, ts_b = t1 (receive time of the probe), t2 = send_ts of the reply
+    A receives the reply at t3: rtt = (t3 - t0) - (t2 - t1), offset = ((t1 - t0) + (t2 - t3)) / 2
+    RESULT  A -> B: ts_a = offset of the fastest round trip, after the last round
+*/
+#define CLOCK_SYNC_PROBE            (0)
+#define CLOCK_SYNC_REPLY            (1)
+#define CLOCK_SYNC_RESULT           (2)
+
+typedef struct clock_sync_msg_t {
+    uint8_t type;
+    uint8_t rounds;                 /* rounds left after this one */
+    uint16_t reserved;
+    uint32_t ts_a;
+    uint32_t ts_b;
+} clock_sync_msg_t;
+
+static int IRAM_ATTR __esp_amp_rpmsg_clock_sync_send(esp_amp_rpmsg_dev_t* rpmsg_dev, uint8_t type, uint8_t rounds, uint32_t ts_a, uint32_t ts_b)
+{
+    // only the address of the endpoint is used by send
+    esp_amp_rpmsg_ept_t ept = {
+        .addr = ESP_AMP_RPMSG_RESERVED_EPT_CLOCK_SYNC,
+    };
+    clock_sync_msg_t* msg = (clock_sync_msg_t*)esp_amp_rpmsg_create_message(rpmsg_dev, sizeof(clock_sync_msg_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (msg == NULL) {
+        return -1;
+    }
+
+    msg->type = type;
+    msg->rounds = rounds;
+    msg->reserved = 0;
+    msg->ts_a = ts_a;
+    msg->ts_b = ts_b;
+    esp_amp_rpmsg_send_nocopy(rpmsg_dev, &ept, ESP_AMP_RPMSG_RESERVED_EPT_CLOCK_SYNC, msg, sizeof(clock_sync_msg_t));
+    return 0;
+}
+
+int esp_amp_rpmsg_clock_sync(esp_amp_rpmsg_dev_t* rpmsg_dev, uint8_t rounds)
+{
+    if (rpmsg_dev == NULL || rounds == 0) {
+        return -1;
+    }
+
+    esp_amp_env_enter_critical();
+    rpmsg_dev->clock.best_rtt_us = UINT32_MAX;
+    rpmsg_dev->clock.syncing = true;
+    esp_amp_env_exit_critical();
+
+    if (__esp_amp_rpmsg_clock_sync_send(rpmsg_dev, CLOCK_SYNC_PROBE, rounds - 1, 0, 0) != 0) {
+        rpmsg_dev->clock.syncing = false;
+        return -1;
+    }
+    return 0;
+}
+
+int esp_amp_rpmsg_clock_get_offset(esp_amp_rpmsg_dev_t* rpmsg_dev, int32_t* offset_us)
+{
+    if (rpmsg_dev == NULL || offset_us == NULL || !rpmsg_dev->clock.synced) {
+        return -1;
+    }
+
+    *offset_us = rpmsg_dev->clock.offset_us;
+    return 0;
+}
+
+void IRAM_ATTR esp_amp_rpmsg_clock_sync_handler(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_t* rpmsg, uint32_t recv_ts)
+{
+    esp_amp_rpmsg_clock_t* clock = &rpmsg_dev->clock;
+    clock_sync_msg_t msg;
+
+    if (rpmsg->msg_head.data_len != sizeof(clock_sync_msg_t)) {
+        esp_amp_rpmsg_destroy(rpmsg_dev, rpmsg->msg_data);
+        return;
+    }
+
+    // copy out and give the buffer back before replying, so that a single-buffer queue still works
+    memcpy(&msg, rpmsg->msg_data, sizeof(clock_sync_msg_t));
+    uint32_t send_ts = rpmsg->msg_head.send_ts;
+    esp_amp_rpmsg_destroy(rpmsg_dev, rpmsg->msg_data);
+
+    switch (msg.type) {
+    case CLOCK_SYNC_PROBE:
+        __esp_amp_rpmsg_clock_sync_send(rpmsg_dev, CLOCK_SYNC_REPLY, msg.rounds, send_ts, recv_ts);
+        break;
+    case CLOCK_SYNC_REPLY: {
+        if (!clock->syncing) {
+            break;
+        }
+        uint32_t rtt = (recv_ts - msg.ts_a) - (send_ts - msg.ts_b);
+        int32_t offset = ((int32_t)(msg.ts_b - msg.ts_a) + (int32_t)(send_ts - recv_ts)) / 2;
+        if (rtt < clock->best_rtt_us) {
+            clock->best_rtt_us = rtt;
+            clock->best_offset_us = offset;
+        }
+        if (msg.rounds > 0) {
+            __esp_amp_rpmsg_clock_sync_send(rpmsg_dev, CLOCK_SYNC_PROBE, msg.rounds - 1, 0, 0);
+            break;
+        }
+        clock->offset_us = clock->best_offset_us;
+        clock->synced = true;
+        clock->syncing = false;
+        __esp_amp_rpmsg_clock_sync_send(rpmsg_dev, CLOCK_SYNC_RESULT, 0, (uint32_t)clock->best_offset_us, 0);
+        break;
+    }
+    case CLOCK_SYNC_RESULT:
+        // offset measured by the other side is local clock minus its clock
+        clock->offset_us = -(int32_t)msg.ts_a;
+        clock->synced = true;
+        break;
+    default:
+        break;
+    }
+}
+
+int esp_amp_rpmsg_endpoint_set_latency(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_ept_t* ept, esp_amp_rpmsg_latency_t* latency)
+{
+    if (rpmsg_dev == NULL || ept == NULL) {
+        return -1;
+    }
+
+    esp_amp_env_enter_critical();
+
+    if (latency != NULL) {
+        memset(latency, 0, sizeof(esp_amp_rpmsg_latency_t));
+    }
+    ept->latency = latency;
+
+    esp_amp_env_exit_critical();
+
+    return 0;
+}
+
+void esp_amp_rpmsg_latency_reset(esp_amp_rpmsg_latency_t* latency)
+{
+    esp_amp_env_enter_critical();
+    memset(latency, 0, sizeof(esp_amp_rpmsg_latency_t));
+    esp_amp_env_exit_critical();
+}
+
+void IRAM_ATTR esp_amp_rpmsg_latency_record(esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_latency_t* latency, uint32_t send_ts, uint32_t recv_ts)
+{
+    if (!rpmsg_dev->clock.synced) {
+        return;
+    }
+
+    // convert send time to local clock, a negative result means the offset is off by a few microseconds
+    int32_t delta = (int32_t)(recv_ts - send_ts + (uint32_t)rpmsg_dev->clock.offset_us);
+    uint32_t sample = (delta > 0) ? (uint32_t)delta : 0;
+    uint8_t idx = (sample == 0) ? 0 : (32 - __builtin_clz(sample));
+    if (idx >= ESP_AMP_RPMSG_LATENCY_BUCKET_NUM) {
+        idx = ESP_AMP_RPMSG_LATENCY_BUCKET_NUM - 1;
+    }
+
+    esp_amp_env_enter_critical();
+
+    latency->count++;
+    latency->bucket[idx]++;
+    if (sample > latency->max_us) {
+        latency->max_us = sample;
+    }
+
+    esp_amp_env_exit_critical();
+}
+
+uint32_t esp_amp_rpmsg_latency_percentile(const esp_amp_rpmsg_latency_t* latency, uint8_t percent)
+{
+    esp_amp_rpmsg_latency_t snapshot;
+
+    esp_amp_env_enter_critical();
+    memcpy(&snapshot, latency, sizeof(esp_amp_rpmsg_latency_t));
+    esp_amp_env_exit_critical();
+
+    if (snapshot.count == 0 || percent == 0) {
+        return 0;
+    }
+    if (percent > 100) {
+        percent = 100;
+    }
+
+    // rank of the percentile sample, rounded up
+    uint32_t rank = (uint32_t)(((uint64_t)snapshot.count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < ESP_AMP_RPMSG_LATENCY_BUCKET_NUM - 1; i++) {
+        seen += snapshot.bucket[i];
+        if (seen >= rank) {
+            uint32_t upper = (i == 0) ? 0 : ((1UL << i) - 1);
+            return (upper < snapshot.max_us) ? upper : snapshot.max_us;
+        }
+    }
+    return snapshot.max_us;
+}
+
+#endif /* CONFIG_ESP_AMP_RPMSG_TIMESTAMP */
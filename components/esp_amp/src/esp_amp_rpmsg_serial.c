@@ -0,0 +1,370 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "string.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_serial.h"
+
+/*
+    Frame format on the link (HDLC-like byte stuffing):
+    FLAG | escaped(format, rpmsg header + data, CRC16 little-endian) | FLAG
+
+    The rpmsg header is copied as is, so its layout depends on build options and byte order.
+    The format byte describes this layout, frames from a peer built differently are dropped.
+    CRC covers the format byte.
+*/
+#define SERIAL_FLAG                 (0x7E)
+#define SERIAL_ESC                  (0x7D)
+#define SERIAL_ESC_XOR              (0x20)
+#define SERIAL_CRC_SIZE             (2)
+#define SERIAL_CHUNK_SIZE           (32)
+
+#define SERIAL_FORMAT_VERSION       (1)
+#define SERIAL_FORMAT_VERSION_MASK  (0x0F)
+#define SERIAL_FORMAT_REFCNT        (1 << 4)    /* rpmsg header has reference count */
+#define SERIAL_FORMAT_TIMESTAMP     (1 << 5)    /* rpmsg header has timestamp */
+#define SERIAL_FORMAT_BIG_ENDIAN    (1 << 6)    /* rpmsg header fields are big-endian */
+
+#if CONFIG_ESP_AMP_RPMSG_BUF_REFCNT
+#define SERIAL_FORMAT_REFCNT_BIT    SERIAL_FORMAT_REFCNT
+#else
+#define SERIAL_FORMAT_REFCNT_BIT    (0)
+#endif
+
+#if CONFIG_ESP_AMP_RPMSG_TIMESTAMP
+#define SERIAL_FORMAT_TIMESTAMP_BIT SERIAL_FORMAT_TIMESTAMP
+#else
+#define SERIAL_FORMAT_TIMESTAMP_BIT (0)
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define SERIAL_FORMAT_ENDIAN_BIT    SERIAL_FORMAT_BIG_ENDIAN
+#else
+#define SERIAL_FORMAT_ENDIAN_BIT    (0)
+#endif
+
+#define SERIAL_FORMAT               (SERIAL_FORMAT_VERSION | SERIAL_FORMAT_REFCNT_BIT | SERIAL_FORMAT_TIMESTAMP_BIT | SERIAL_FORMAT_ENDIAN_BIT)
+
+#define SERIAL_TX_BUF_NUM           ESP_AMP_RPMSG_SERIAL_TX_BUF_NUM
+#define SERIAL_RX_BUF_NUM           ESP_AMP_RPMSG_SERIAL_RX_BUF_NUM
+#define SERIAL_ITEM_SIZE            ESP_AMP_RPMSG_SERIAL_ITEM_SIZE
+
+typedef struct serial_encoder_t {
+    esp_amp_rpmsg_serial_t* serial;
+    uint8_t chunk[SERIAL_CHUNK_SIZE];
+    uint16_t len;
+    int ret;
+} serial_encoder_t;
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t __esp_amp_rpmsg_serial_crc16(uint16_t crc, const uint8_t* data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static int __esp_amp_rpmsg_serial_alloc_buf(uint32_t* free_mask)
+{
+    int idx = -1;
+
+    esp_amp_env_enter_critical();
+
+    if (*free_mask != 0) {
+        idx = __builtin_ctz(*free_mask);
+        *free_mask &= ~(1UL << idx);
+    }
+
+    esp_amp_env_exit_critical();
+
+    return idx;
+}
+
+static void __esp_amp_rpmsg_serial_free_buf(uint32_t* free_mask, int idx)
+{
+    esp_amp_env_enter_critical();
+    *free_mask |= (1UL << idx);
+    esp_amp_env_exit_critical();
+}
+
+static int IRAM_ATTR __esp_amp_rpmsg_serial_tx_alloc(esp_amp_queue_t* queue, void** buffer, uint16_t size)
+{
+    esp_amp_rpmsg_serial_t* serial = (esp_amp_rpmsg_serial_t*)queue->priv_data;
+
+    *buffer = NULL;
+    if (size > SERIAL_ITEM_SIZE) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int idx = __esp_amp_rpmsg_serial_alloc_buf(&serial->tx_free_mask);
+    if (idx < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    *buffer = serial->tx_buf[idx];
+    return ESP_OK;
+}
+
+static int IRAM_ATTR __esp_amp_rpmsg_serial_tx(esp_amp_queue_t* queue, void* buffer, uint16_t size)
+{
+    esp_amp_rpmsg_serial_t* serial = (esp_amp_rpmsg_serial_t*)queue->priv_data;
+    esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)buffer;
+    uint32_t idx = ((uint8_t*)buffer - (uint8_t*)serial->tx_buf) / sizeof(serial->tx_buf[0]);
+
+    if (idx >= SERIAL_TX_BUF_NUM || offsetof(esp_amp_rpmsg_t, msg_data) + rpmsg->msg_head.data_len > SERIAL_ITEM_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // called in critical section by rpmsg, only queue the frame here
+    esp_amp_env_enter_critical();
+    serial->tx_fifo[serial->tx_tail % SERIAL_TX_BUF_NUM] = idx;
+    serial->tx_tail++;
+    esp_amp_env_exit_critical();
+
+    if (serial->tx_notify_cb != NULL) {
+        return serial->tx_notify_cb(serial->tx_notify_arg);
+    }
+    return ESP_OK;
+}
+
+static int IRAM_ATTR __esp_amp_rpmsg_serial_rx(esp_amp_queue_t* queue, void** buffer, uint16_t* size)
+{
+    esp_amp_rpmsg_serial_t* serial = (esp_amp_rpmsg_serial_t*)queue->priv_data;
+    int ret = ESP_ERR_NOT_FOUND;
+
+    *buffer = NULL;
+    *size = 0;
+
+    esp_amp_env_enter_critical();
+
+    if (serial->rx_head != serial->rx_tail) {
+        uint8_t idx = serial->rx_fifo[serial->rx_head % SERIAL_RX_BUF_NUM];
+        esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)serial->rx_buf[idx];
+        *buffer = rpmsg;
+        *size = offsetof(esp_amp_rpmsg_t, msg_data) + rpmsg->msg_head.data_len;
+        serial->rx_head++;
+        ret = ESP_OK;
+    }
+
+    esp_amp_env_exit_critical();
+
+    return ret;
+}
+
+static int IRAM_ATTR __esp_amp_rpmsg_serial_rx_free(esp_amp_queue_t* queue, void* buffer)
+{
+    esp_amp_rpmsg_serial_t* serial = (esp_amp_rpmsg_serial_t*)queue->priv_data;
+    uint32_t idx = ((uint8_t*)buffer - (uint8_t*)serial->rx_buf) / sizeof(serial->rx_buf[0]);
+
+    if (idx >= SERIAL_RX_BUF_NUM || (uint8_t*)buffer != (uint8_t*)serial->rx_buf[idx]) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    __esp_amp_rpmsg_serial_free_buf(&serial->rx_free_mask, idx);
+    return ESP_OK;
+}
+
+static const esp_amp_queue_ops_t s_serial_ops = {
+    .q_tx = __esp_amp_rpmsg_serial_tx,
+    .q_tx_alloc = __esp_amp_rpmsg_serial_tx_alloc,
+    .q_rx = __esp_amp_rpmsg_serial_rx,
+    .q_rx_free = __esp_amp_rpmsg_serial_rx_free,
+};
+
+int esp_amp_rpmsg_serial_init(esp_amp_rpmsg_serial_t* serial, esp_amp_rpmsg_dev_t* rpmsg_dev, esp_amp_rpmsg_serial_write_cb_t write_cb, void* write_arg,
+                              esp_amp_rpmsg_serial_tx_notify_cb_t tx_notify_cb, void* tx_notify_arg)
+{
+    if (serial == NULL || write_cb == NULL) {
+        return -1;
+    }
+
+    memset(serial, 0, sizeof(esp_amp_rpmsg_serial_t));
+    serial->write_cb = write_cb;
+    serial->write_arg = write_arg;
+    serial->tx_notify_cb = tx_notify_cb;
+    serial->tx_notify_arg = tx_notify_arg;
+    serial->tx_free_mask = (SERIAL_TX_BUF_NUM == 32) ? UINT32_MAX : (1UL << SERIAL_TX_BUF_NUM) - 1;
+    serial->rx_free_mask = (SERIAL_RX_BUF_NUM == 32) ? UINT32_MAX : (1UL << SERIAL_RX_BUF_NUM) - 1;
+    serial->rx_cur = -1;
+
+    for (int i = 0; i < 2; i++) {
+        serial->channels[i].size = (i == 0) ? SERIAL_TX_BUF_NUM : SERIAL_RX_BUF_NUM;
+        serial->channels[i].max_item_size = SERIAL_ITEM_SIZE;
+        serial->channels[i].master = (i == 0);
+        serial->channels[i].priv_data = serial;
+    }
+
+    return esp_amp_rpmsg_init_with_transport(rpmsg_dev, serial->channels, 1, &s_serial_ops);
+}
+
+static void __esp_amp_rpmsg_serial_rx_frame_end(esp_amp_rpmsg_serial_t* serial)
+{
+    uint8_t* frame = (uint8_t*)serial->rx_buf[serial->rx_cur];
+    esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)frame;
+
+    if (serial->rx_len < sizeof(esp_amp_rpmsg_head_t) + SERIAL_CRC_SIZE) {
+        serial->rx_error++;
+        return;
+    }
+
+    uint16_t len = serial->rx_len - SERIAL_CRC_SIZE;
+    uint16_t crc = frame[len] | (frame[len + 1] << 8);
+    if (crc != __esp_amp_rpmsg_serial_crc16(__esp_amp_rpmsg_serial_crc16(0xFFFF, &serial->rx_format, 1), frame, len)) {
+        serial->rx_error++;
+        return;
+    }
+
+    // intact frame, but the header layout can't be trusted
+    if (serial->rx_format != SERIAL_FORMAT) {
+        serial->rx_format_error++;
+        return;
+    }
+
+    if (offsetof(esp_amp_rpmsg_t, msg_data) + rpmsg->msg_head.data_len != len ||
+            ESP_AMP_RPMSG_DATA_GET_LANE(rpmsg->msg_head.data_flags) != 0) {
+        serial->rx_error++;
+        return;
+    }
+
+    esp_amp_env_enter_critical();
+    serial->rx_fifo[serial->rx_tail % SERIAL_RX_BUF_NUM] = serial->rx_cur;
+    serial->rx_tail++;
+    esp_amp_env_exit_critical();
+
+    serial->rx_cur = -1;
+}
+
+int esp_amp_rpmsg_serial_feed(esp_amp_rpmsg_serial_t* serial, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    int frame_num = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t byte = bytes[i];
+
+        if (byte == SERIAL_FLAG) {
+            if (serial->rx_cur >= 0 && serial->rx_has_format && !serial->rx_discard) {
+                __esp_amp_rpmsg_serial_rx_frame_end(serial);
+                frame_num += (serial->rx_cur < 0);
+            }
+            // a failed frame keeps its buffer for the next one
+            serial->rx_len = 0;
+            serial->rx_has_format = false;
+            serial->rx_escape = false;
+            serial->rx_discard = false;
+            continue;
+        }
+
+        if (serial->rx_discard) {
+            continue;
+        }
+
+        if (serial->rx_cur < 0) {
+            serial->rx_cur = __esp_amp_rpmsg_serial_alloc_buf(&serial->rx_free_mask);
+            if (serial->rx_cur < 0) {
+                // rpmsg doesn't consume fast enough
+                serial->rx_error++;
+                serial->rx_discard = true;
+                continue;
+            }
+        }
+
+        if (byte == SERIAL_ESC) {
+            serial->rx_escape = true;
+            continue;
+        }
+        if (serial->rx_escape) {
+            byte ^= SERIAL_ESC_XOR;
+            serial->rx_escape = false;
+        }
+
+        // format byte is kept apart, so that rpmsg header stays aligned in the buffer
+        if (!serial->rx_has_format) {
+            serial->rx_format = byte;
+            serial->rx_has_format = true;
+            continue;
+        }
+
+        if (serial->rx_len == SERIAL_ITEM_SIZE + SERIAL_CRC_SIZE) {
+            serial->rx_error++;
+            serial->rx_discard = true;
+            continue;
+        }
+        ((uint8_t*)serial->rx_buf[serial->rx_cur])[serial->rx_len++] = byte;
+    }
+
+    return frame_num;
+}
+
+static void __esp_amp_rpmsg_serial_put(serial_encoder_t* encoder, uint8_t byte, bool escape)
+{
+    if (escape && (byte == SERIAL_FLAG || byte == SERIAL_ESC)) {
+        __esp_amp_rpmsg_serial_put(encoder, SERIAL_ESC, false);
+        byte ^= SERIAL_ESC_XOR;
+    }
+
+    encoder->chunk[encoder->len++] = byte;
+    if (encoder->len == SERIAL_CHUNK_SIZE) {
+        if (encoder->ret == 0) {
+            encoder->ret = encoder->serial->write_cb(encoder->chunk, encoder->len, encoder->serial->write_arg);
+        }
+        encoder->len = 0;
+    }
+}
+
+int esp_amp_rpmsg_serial_flush(esp_amp_rpmsg_serial_t* serial)
+{
+    int frame_num = 0;
+    serial_encoder_t encoder = {
+        .serial = serial,
+    };
+
+    while (serial->tx_head != serial->tx_tail) {
+        // single writer, the frame stays at the head of fifo until written
+        uint8_t idx = serial->tx_fifo[serial->tx_head % SERIAL_TX_BUF_NUM];
+        esp_amp_rpmsg_t* rpmsg = (esp_amp_rpmsg_t*)serial->tx_buf[idx];
+        uint16_t len = offsetof(esp_amp_rpmsg_t, msg_data) + rpmsg->msg_head.data_len;
+        uint8_t format = SERIAL_FORMAT;
+        uint16_t crc = __esp_amp_rpmsg_serial_crc16(__esp_amp_rpmsg_serial_crc16(0xFFFF, &format, 1), (uint8_t*)rpmsg, len);
+
+        encoder.len = 0;
+        encoder.ret = 0;
+        __esp_amp_rpmsg_serial_put(&encoder, SERIAL_FLAG, false);
+        __esp_amp_rpmsg_serial_put(&encoder, format, true);
+        for (uint16_t i = 0; i < len; i++) {
+            __esp_amp_rpmsg_serial_put(&encoder, ((uint8_t*)rpmsg)[i], true);
+        }
+        __esp_amp_rpmsg_serial_put(&encoder, crc & 0xFF, true);
+        __esp_amp_rpmsg_serial_put(&encoder, crc >> 8, true);
+        __esp_amp_rpmsg_serial_put(&encoder, SERIAL_FLAG, false);
+        if (encoder.len > 0 && encoder.ret == 0) {
+            encoder.ret = serial->write_cb(encoder.chunk, encoder.len, serial->write_arg);
+        }
+
+        esp_amp_env_enter_critical();
+        serial->tx_head++;
+        esp_amp_env_exit_critical();
+        __esp_amp_rpmsg_serial_free_buf(&serial->tx_free_mask, idx);
+
+        if (encoder.ret != 0) {
+            return -1;
+        }
+        frame_num++;
+    }
+
+    return frame_num;
+}
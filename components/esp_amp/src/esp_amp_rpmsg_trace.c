@@ -0,0 +1,122 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "string.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_platform.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_rpmsg_trace.h"
+#include "esp_amp_rpmsg_trace_priv.h"
+
+#if CONFIG_ESP_AMP_RPMSG_TRACE
+
+#define TRACE_RECORD_NUM        CONFIG_ESP_AMP_RPMSG_TRACE_RECORD_NUM
+#define TRACE_PAYLOAD_LEN       CONFIG_ESP_AMP_RPMSG_TRACE_PAYLOAD_LEN
+/* keep every record word aligned in dump */
+#define TRACE_PAYLOAD_MAX       ((TRACE_PAYLOAD_LEN + 3) & ~3)
+
+typedef struct trace_slot_t {
+    esp_amp_rpmsg_trace_record_t record;
+    uint8_t payload[TRACE_PAYLOAD_MAX];
+} trace_slot_t;
+
+static esp_amp_rpmsg_dev_t* volatile s_trace_dev;           /* device being traced, NULL if stopped */
+static trace_slot_t s_trace_slots[TRACE_RECORD_NUM];
+static uint32_t s_trace_total;                              /* number of records taken since start */
+static esp_amp_rpmsg_trace_file_head_t s_trace_head;        /* lane_num is 0 if never started */
+
+int esp_amp_rpmsg_trace_start(esp_amp_rpmsg_dev_t* rpmsg_dev)
+{
+    if (rpmsg_dev == NULL) {
+        return -1;
+    }
+
+    esp_amp_env_enter_critical();
+
+    memset(&s_trace_head, 0, sizeof(s_trace_head));
+    s_trace_head.magic = ESP_AMP_RPMSG_TRACE_MAGIC;
+    s_trace_head.version = ESP_AMP_RPMSG_TRACE_VERSION;
+    s_trace_head.record_size = sizeof(trace_slot_t);
+#if IS_MAIN_CORE
+    s_trace_head.main_core = 1;
+#endif
+    s_trace_head.lane_num = rpmsg_dev->lane_num;
+    s_trace_head.payload_max = TRACE_PAYLOAD_LEN;
+    for (uint8_t lane = 0; lane < rpmsg_dev->lane_num; lane++) {
+        s_trace_head.queue_len[lane] = rpmsg_dev->lane_queues[2 * lane].size;
+        s_trace_head.queue_item_size[lane] = rpmsg_dev->lane_queues[2 * lane].max_item_size;
+    }
+
+    s_trace_total = 0;
+    s_trace_dev = rpmsg_dev;
+
+    esp_amp_env_exit_critical();
+
+    return 0;
+}
+
+void esp_amp_rpmsg_trace_stop(void)
+{
+    s_trace_dev = NULL;
+}
+
+void IRAM_ATTR esp_amp_rpmsg_trace_record(esp_amp_rpmsg_dev_t* rpmsg_dev, uint8_t dir, const esp_amp_rpmsg_t* rpmsg)
+{
+    if (rpmsg_dev != s_trace_dev) {
+        return;
+    }
+
+    esp_amp_env_enter_critical();
+
+    // overwrite the oldest record when full
+    trace_slot_t* slot = &s_trace_slots[s_trace_total % TRACE_RECORD_NUM];
+    uint16_t payload_len = TRACE_PAYLOAD_LEN;
+    if (payload_len > rpmsg->msg_head.data_len) {
+        payload_len = rpmsg->msg_head.data_len;
+    }
+
+    slot->record.timestamp_us = esp_amp_platform_get_time_us();
+    slot->record.src_addr = rpmsg->msg_head.src_addr;
+    slot->record.dst_addr = rpmsg->msg_head.dst_addr;
+    slot->record.data_len = rpmsg->msg_head.data_len;
+    slot->record.data_flags = rpmsg->msg_head.data_flags;
+    slot->record.dir = dir;
+    slot->record.reserved = 0;
+    slot->record.payload_len = payload_len;
+    memcpy(slot->payload, rpmsg->msg_data, payload_len);
+    s_trace_total++;
+
+    esp_amp_env_exit_critical();
+}
+
+int esp_amp_rpmsg_trace_dump(esp_amp_rpmsg_trace_write_cb_t write_cb, void* write_arg)
+{
+    if (write_cb == NULL || s_trace_dev != NULL || s_trace_head.lane_num == 0) {
+        return -1;
+    }
+
+    uint32_t record_num = s_trace_total < TRACE_RECORD_NUM ? s_trace_total : TRACE_RECORD_NUM;
+    s_trace_head.record_num = record_num;
+    s_trace_head.dropped = s_trace_total - record_num;
+
+    if (write_cb(&s_trace_head, sizeof(s_trace_head), write_arg) != 0) {
+        return -1;
+    }
+
+    for (uint32_t i = s_trace_total - record_num; i != s_trace_total; i++) {
+        if (write_cb(&s_trace_slots[i % TRACE_RECORD_NUM], sizeof(trace_slot_t), write_arg) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* CONFIG_ESP_AMP_RPMSG_TRACE */
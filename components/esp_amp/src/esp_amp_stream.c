@@ -0,0 +1,278 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "string.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_rpmsg.h"
+#include "esp_amp_stream.h"
+
+#define STREAM_WINDOW_SIZE          CONFIG_ESP_AMP_STREAM_WINDOW_SIZE
+/* acknowledge consumed frames in batches of half window, unless the receiver runs out of data */
+#define STREAM_ACK_THRESHOLD        ((STREAM_WINDOW_SIZE + 1) / 2)
+
+typedef enum {
+    STREAM_FRAME_DATA = 0,
+    STREAM_FRAME_ACK,
+    STREAM_FRAME_CLOSE,
+} stream_frame_type_t;
+
+typedef struct stream_frame_head_t {
+    uint8_t type;                   /* stream_frame_type_t */
+    uint8_t reserved;
+    uint16_t seq;                   /* DATA: sequence number of this frame; ACK: number of frames consumed */
+} stream_frame_head_t;
+
+static int IRAM_ATTR __esp_amp_stream_rx_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    esp_amp_stream_t* stream = (esp_amp_stream_t*)rx_cb_data;
+    stream_frame_head_t* head = (stream_frame_head_t*)msg_data;
+    uint32_t events = 0;
+    bool keep = false;
+
+    if (data_len < sizeof(stream_frame_head_t) || src_addr != stream->remote_addr) {
+        esp_amp_rpmsg_destroy(stream->rpmsg_dev, msg_data);
+        return 0;
+    }
+
+    switch (head->type) {
+    case STREAM_FRAME_DATA:
+        // frames are delivered in order, and peer never exceeds the window, so the rx ring can't overflow
+        if (stream->state == ESP_AMP_STREAM_STATE_OPEN && head->seq == stream->rx_tail &&
+                (uint16_t)(stream->rx_tail - stream->rx_head) < STREAM_WINDOW_SIZE) {
+            uint16_t idx = stream->rx_tail % STREAM_WINDOW_SIZE;
+            stream->rx_frames[idx] = msg_data;
+            stream->rx_frame_len[idx] = data_len - sizeof(stream_frame_head_t);
+            stream->rx_tail++;
+            keep = true;
+            events |= ESP_AMP_STREAM_EVENT_READABLE;
+        } else {
+            // out of sequence or window violation, the stream can't recover
+            stream->state = ESP_AMP_STREAM_STATE_PEER_CLOSED;
+            events |= ESP_AMP_STREAM_EVENT_CLOSED;
+        }
+        break;
+    case STREAM_FRAME_ACK:
+        stream->tx_acked = head->seq;
+        events |= ESP_AMP_STREAM_EVENT_WRITABLE;
+        break;
+    case STREAM_FRAME_CLOSE:
+        if (stream->state == ESP_AMP_STREAM_STATE_OPEN) {
+            stream->state = ESP_AMP_STREAM_STATE_PEER_CLOSED;
+        }
+        events |= ESP_AMP_STREAM_EVENT_CLOSED;
+        break;
+    default:
+        break;
+    }
+
+    if (!keep) {
+        esp_amp_rpmsg_destroy(stream->rpmsg_dev, msg_data);
+    }
+
+    if (events != 0 && stream->notify_cb != NULL) {
+        return stream->notify_cb(stream, events, stream->notify_arg);
+    }
+    return 0;
+}
+
+static int __esp_amp_stream_send_frame(esp_amp_stream_t* stream, void* frame, uint8_t type, uint16_t seq, uint16_t data_len)
+{
+    stream_frame_head_t* head = (stream_frame_head_t*)frame;
+    head->type = type;
+    head->reserved = 0;
+    head->seq = seq;
+    return esp_amp_rpmsg_send_nocopy(stream->rpmsg_dev, &stream->ept, stream->remote_addr, frame, sizeof(stream_frame_head_t) + data_len);
+}
+
+static int __esp_amp_stream_tx_alloc(esp_amp_stream_t* stream)
+{
+    uint16_t max_size = esp_amp_rpmsg_get_lane_max_size(stream->rpmsg_dev, stream->ept.lane);
+    if (max_size <= sizeof(stream_frame_head_t)) {
+        return -1;
+    }
+
+    stream->tx_buf = esp_amp_rpmsg_create_message_by_ept(stream->rpmsg_dev, &stream->ept, max_size, ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (stream->tx_buf == NULL) {
+        return -1;
+    }
+    stream->tx_len = 0;
+    stream->tx_max = max_size - sizeof(stream_frame_head_t);
+    return 0;
+}
+
+static int __esp_amp_stream_tx_send(esp_amp_stream_t* stream)
+{
+    if ((uint16_t)(stream->tx_seq - stream->tx_acked) >= STREAM_WINDOW_SIZE) {
+        // window is full, wait for ACK
+        return -1;
+    }
+
+    if (__esp_amp_stream_send_frame(stream, stream->tx_buf, STREAM_FRAME_DATA, stream->tx_seq, stream->tx_len) != 0) {
+        return -1;
+    }
+    stream->tx_seq++;
+    stream->tx_buf = NULL;
+    stream->tx_len = 0;
+    return 0;
+}
+
+static void __esp_amp_stream_rx_ack(esp_amp_stream_t* stream)
+{
+    uint16_t unacked = stream->rx_head - stream->rx_acked;
+    if (unacked == 0) {
+        return;
+    }
+    if (unacked < STREAM_ACK_THRESHOLD && stream->rx_head != stream->rx_tail) {
+        // keep batching while there is still data to read
+        return;
+    }
+
+    void* frame = esp_amp_rpmsg_create_message_by_ept(stream->rpmsg_dev, &stream->ept, sizeof(stream_frame_head_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (frame == NULL) {
+        // no buffer at present, retry on next read
+        return;
+    }
+    if (__esp_amp_stream_send_frame(stream, frame, STREAM_FRAME_ACK, stream->rx_head, 0) == 0) {
+        stream->rx_acked = stream->rx_head;
+    }
+}
+
+int esp_amp_stream_open(esp_amp_stream_t* stream, esp_amp_rpmsg_dev_t* rpmsg_dev, uint16_t local_addr, uint16_t remote_addr, esp_amp_stream_notify_cb_t notify_cb, void* notify_arg)
+{
+    if (stream == NULL || rpmsg_dev == NULL) {
+        return -1;
+    }
+
+    memset(stream, 0, sizeof(esp_amp_stream_t));
+    stream->rpmsg_dev = rpmsg_dev;
+    stream->remote_addr = remote_addr;
+    stream->notify_cb = notify_cb;
+    stream->notify_arg = notify_arg;
+    stream->state = ESP_AMP_STREAM_STATE_OPEN;
+
+    if (esp_amp_rpmsg_create_endpoint(rpmsg_dev, local_addr, __esp_amp_stream_rx_cb, (void*)stream, &stream->ept) == NULL) {
+        stream->state = ESP_AMP_STREAM_STATE_CLOSED;
+        return -1;
+    }
+
+    return 0;
+}
+
+int esp_amp_stream_write(esp_amp_stream_t* stream, const void* data, size_t len)
+{
+    if (stream->state != ESP_AMP_STREAM_STATE_OPEN) {
+        return -1;
+    }
+
+    size_t written = 0;
+    while (written < len) {
+        if (stream->tx_buf != NULL && stream->tx_len == stream->tx_max && __esp_amp_stream_tx_send(stream) != 0) {
+            break;
+        }
+        if (stream->tx_buf == NULL && __esp_amp_stream_tx_alloc(stream) != 0) {
+            break;
+        }
+
+        size_t n = len - written;
+        if (n > stream->tx_max - stream->tx_len) {
+            n = stream->tx_max - stream->tx_len;
+        }
+        memcpy((uint8_t*)stream->tx_buf + sizeof(stream_frame_head_t) + stream->tx_len, (const uint8_t*)data + written, n);
+        stream->tx_len += n;
+        written += n;
+    }
+
+    if (stream->tx_buf != NULL && stream->tx_len == stream->tx_max) {
+        // don't keep a full frame waiting for the next write
+        __esp_amp_stream_tx_send(stream);
+    }
+
+    return (int)written;
+}
+
+int esp_amp_stream_flush(esp_amp_stream_t* stream)
+{
+    if (stream->tx_buf == NULL || stream->tx_len == 0) {
+        return 0;
+    }
+    return __esp_amp_stream_tx_send(stream);
+}
+
+int esp_amp_stream_read(esp_amp_stream_t* stream, void* buf, size_t len)
+{
+    size_t nread = 0;
+
+    while (nread < len && stream->rx_head != stream->rx_tail) {
+        uint16_t idx = stream->rx_head % STREAM_WINDOW_SIZE;
+        uint8_t* frame_data = (uint8_t*)stream->rx_frames[idx] + sizeof(stream_frame_head_t);
+        size_t n = stream->rx_frame_len[idx] - stream->rx_offset;
+        if (n > len - nread) {
+            n = len - nread;
+        }
+        memcpy((uint8_t*)buf + nread, frame_data + stream->rx_offset, n);
+        stream->rx_offset += n;
+        nread += n;
+
+        if (stream->rx_offset == stream->rx_frame_len[idx]) {
+            // frame completely read, give the buffer back to the sender
+            esp_amp_rpmsg_destroy(stream->rpmsg_dev, stream->rx_frames[idx]);
+            stream->rx_offset = 0;
+
+            esp_amp_env_enter_critical();
+            stream->rx_head++;
+            esp_amp_env_exit_critical();
+        }
+    }
+
+    if (stream->state == ESP_AMP_STREAM_STATE_OPEN) {
+        __esp_amp_stream_rx_ack(stream);
+    } else if (nread == 0 && stream->rx_head == stream->rx_tail) {
+        return -1;
+    }
+
+    return (int)nread;
+}
+
+int esp_amp_stream_close(esp_amp_stream_t* stream)
+{
+    if (stream->state == ESP_AMP_STREAM_STATE_CLOSED) {
+        return 0;
+    }
+
+    if (stream->state == ESP_AMP_STREAM_STATE_OPEN) {
+        if (esp_amp_stream_flush(stream) != 0) {
+            return -1;
+        }
+        // reuse the allocated but empty frame if any
+        if (stream->tx_buf == NULL && __esp_amp_stream_tx_alloc(stream) != 0) {
+            return -1;
+        }
+        if (__esp_amp_stream_send_frame(stream, stream->tx_buf, STREAM_FRAME_CLOSE, stream->tx_seq, 0) != 0) {
+            return -1;
+        }
+        stream->tx_buf = NULL;
+    } else if (stream->tx_buf != NULL) {
+        // allocated buffer can only be given back by sending it, peer drops frames after close
+        __esp_amp_stream_send_frame(stream, stream->tx_buf, STREAM_FRAME_CLOSE, stream->tx_seq, 0);
+        stream->tx_buf = NULL;
+    }
+
+    esp_amp_rpmsg_delete_endpoint(stream->rpmsg_dev, stream->ept.addr);
+    stream->state = ESP_AMP_STREAM_STATE_CLOSED;
+
+    // drop unread frames
+    while (stream->rx_head != stream->rx_tail) {
+        esp_amp_rpmsg_destroy(stream->rpmsg_dev, stream->rx_frames[stream->rx_head % STREAM_WINDOW_SIZE]);
+        stream->rx_head++;
+    }
+
+    return 0;
+}
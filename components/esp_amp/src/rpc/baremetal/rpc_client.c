@@ -6,7 +6,6 @@
 
 #include "stdint.h"
 #include "stdbool.h"
-#include "limits.h"
 #include "string.h"
 #include "esp_attr.h"
 
@@ -14,16 +13,26 @@
 #include "esp_amp_rpmsg.h"
 #include "esp_amp_rpc.h"
 #include "esp_amp_log.h"
-
-#define ESP_AMP_RPC_INVALID_REQ_ID 0x0
+#include "esp_amp_rpc_pending_priv.h"
+#include "esp_amp_rpc_timer_priv.h"
+#include "esp_amp_rpc_batch_priv.h"
+#include "esp_amp_rpc_metrics_priv.h"
 
 static const DRAM_ATTR char TAG[] = "rpc_client";
 
+#define ESP_AMP_RPC_CLIENT_INSTANCE_NUM CONFIG_ESP_AMP_RPC_CLIENT_INSTANCE_NUM
+
+typedef struct esp_amp_rpc_client_t esp_amp_rpc_client_t;
+
 typedef struct {
+    esp_amp_rpc_client_t *client; /* instance owning the req */
     uint16_t req_id; /* req_id & status still needed since pkt can be freed somewhere asynchronously */
     uint16_t status; /* status can be updated by timer */
+    uint16_t service_id;
     uint32_t start_time;
+    uint32_t sent_us; /* for metrics */
     uint32_t timeout_ms;
+    bool sent; /* pkt is owned by server once sent */
     esp_amp_rpc_req_cb_t cb;
     esp_amp_rpc_pkt_t *pkt;
 } esp_amp_rpc_pending_req_t;
@@ -36,149 +45,170 @@ typedef struct {
 } esp_amp_rpc_resp_t;
 
 typedef struct {
-    esp_amp_rpc_pending_req_t *reqs[ESP_AMP_RPC_MAX_PENDING_REQ];
+    esp_amp_rpc_pending_tbl_t tbl; /* req id allocation and lookup */
+    esp_amp_rpc_pending_req_t reqs[ESP_AMP_RPC_MAX_PENDING_REQ]; /* indexed by slot of req id */
+    esp_amp_rpc_timer_t timer; /* deadlines of executed reqs, indexed by slot */
 } esp_amp_rpc_pending_list_t;
 
-typedef struct {
+struct esp_amp_rpc_client_t {
     uint16_t server_addr;
     uint16_t client_addr;
-    esp_amp_rpmsg_dev_t *rpmsg_dev;
+    esp_amp_rpmsg_dev_t *rpmsg_dev; /* NULL if instance is free */
     esp_amp_rpmsg_ept_t rpmsg_ept;
     esp_amp_rpc_pending_list_t pending_list;
-} esp_amp_rpc_client_t;
+};
+
+static esp_amp_rpc_client_t esp_amp_rpc_clients[ESP_AMP_RPC_CLIENT_INSTANCE_NUM];
+static esp_amp_rpc_client_t *esp_amp_rpc_client_default; /* instance of APIs without handle, created by esp_amp_rpc_client_init() */
 
-static esp_amp_rpc_client_t esp_amp_rpc_client;
-esp_amp_rpc_pending_req_t pending_reqs[ESP_AMP_RPC_MAX_PENDING_REQ];
+#if CONFIG_ESP_AMP_RPC_METRICS
+static esp_amp_rpc_metrics_tbl_t esp_amp_rpc_client_metrics; /* shared by all instances */
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
 
 static int esp_amp_rpc_client_poll(void *pkt_in_buf, uint16_t pkt_in_size, uint16_t src_addr, void* rx_cb_data);
 
-static int esp_amp_rpc_pending_list_push(esp_amp_rpc_pending_req_t *req)
+static esp_amp_rpc_pending_req_t *esp_amp_rpc_pending_list_push(esp_amp_rpc_client_t *client)
 {
-    int ret = -1;
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        if (esp_amp_rpc_client.pending_list.reqs[i] == NULL) {
-            /* copy the filled slot to the empty one */
-            esp_amp_rpc_client.pending_list.reqs[i] = req;
-            ret = 0;
-            break;
-        }
+    uint16_t req_id = esp_amp_rpc_pending_tbl_alloc(&client->pending_list.tbl);
+    if (req_id == ESP_AMP_RPC_INVALID_REQ_ID) {
+        return NULL;
     }
-    return ret;
+
+    esp_amp_rpc_pending_req_t *req = &client->pending_list.reqs[req_id % ESP_AMP_RPC_MAX_PENDING_REQ];
+    req->req_id = req_id;
+    return req;
 }
 
-static int esp_amp_rpc_pending_list_pop(uint32_t req_id, esp_amp_rpc_pending_req_t **req_out)
+static void esp_amp_rpc_pending_list_pop(esp_amp_rpc_pending_req_t *req)
 {
-    int ret = -1;
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        esp_amp_rpc_pending_req_t *req = esp_amp_rpc_client.pending_list.reqs[i];
-        if (req && req->req_id == req_id) {
-            /* copy to req_out */
-            if (req_out != NULL) {
-                *req_out = esp_amp_rpc_client.pending_list.reqs[i];
-            }
-            /* set to empty slot */
-            esp_amp_rpc_client.pending_list.reqs[i] = NULL;
-            ret = 0;
-            break;
-        }
+    int slot = esp_amp_rpc_pending_tbl_release(&req->client->pending_list.tbl, req->req_id);
+    if (slot != -1) {
+        esp_amp_rpc_timer_disarm(&req->client->pending_list.timer, slot);
     }
-    return ret;
+    req->req_id = ESP_AMP_RPC_INVALID_REQ_ID;
 }
 
-static int esp_amp_rpc_pending_list_peek(uint32_t req_id, esp_amp_rpc_pending_req_t **req_out)
+static esp_amp_rpc_pending_req_t *esp_amp_rpc_pending_list_peek(esp_amp_rpc_client_t *client, uint16_t req_id)
 {
-    int ret = -1;
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        esp_amp_rpc_pending_req_t *req = esp_amp_rpc_client.pending_list.reqs[i];
-        if (req && req->req_id == req_id) {
-            /* copy to req_out */
-            if (req_out != NULL) {
-                *req_out = esp_amp_rpc_client.pending_list.reqs[i];
-            }
-            ret = 0;
-            break;
-        }
+    int slot = esp_amp_rpc_pending_tbl_find(&client->pending_list.tbl, req_id);
+    if (slot == -1) {
+        return NULL;
     }
-    return ret;
+    return &client->pending_list.reqs[slot];
 }
 
-
-__attribute__((__unused__)) static void esp_amp_rpc_pending_list_dump(void)
+/* (re)start timeout of req from its start_time, req without deadline is never armed */
+static void esp_amp_rpc_pending_list_arm(esp_amp_rpc_pending_req_t *req)
 {
-    int list[ESP_AMP_RPC_MAX_PENDING_REQ];
-    ESP_AMP_LOGD(TAG, "=== pending list ===");
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        if (esp_amp_rpc_client.pending_list.reqs[i] == NULL) {
-            list[i] = 0;
-        } else {
-            list[i] = esp_amp_rpc_client.pending_list.reqs[i]->req_id;
-        }
+    if (req->timeout_ms == UINT32_MAX) {
+        return;
     }
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        ESP_AMP_LOGD(TAG, "%d\t%d", i, list[i]);
+    uint32_t timeout_ms = req->timeout_ms < ESP_AMP_RPC_TIMER_MAX_MS ? req->timeout_ms : ESP_AMP_RPC_TIMER_MAX_MS;
+    esp_amp_rpc_timer_arm(&req->client->pending_list.timer, req->req_id % ESP_AMP_RPC_MAX_PENDING_REQ, req->start_time + timeout_ms);
+}
+
+/* time left before req times out, counted from its start_time, as sent to server. 0 means no deadline */
+static uint32_t esp_amp_rpc_client_remaining_ms(esp_amp_rpc_pending_req_t *req)
+{
+    if (req->timeout_ms == UINT32_MAX) {
+        return 0;
     }
-    ESP_AMP_LOGD(TAG, "====================");
+    uint32_t elapsed = esp_amp_platform_get_time_ms() - req->start_time;
+    uint32_t remaining_ms = elapsed < req->timeout_ms ? req->timeout_ms - elapsed : 0;
+    return remaining_ms == 0 ? 1 : remaining_ms;
 }
 
-static uint16_t esp_amp_rpc_get_req_id(void)
+__attribute__((__unused__)) static void esp_amp_rpc_pending_list_dump(esp_amp_rpc_client_t *client)
 {
-    static uint16_t s_req_id = 0;
-    if (s_req_id++ == SHRT_MAX) { /* wrap around */
-        s_req_id = 1;
+    ESP_AMP_LOGD(TAG, "=== pending list ===");
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        uint16_t req_id = client->pending_list.tbl.req_id[i];
+        if (req_id != ESP_AMP_RPC_INVALID_REQ_ID) {
+            ESP_AMP_LOGD(TAG, "%d\t%d", i, req_id);
+        }
     }
-    return s_req_id;
+    ESP_AMP_LOGD(TAG, "====================");
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_client_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr)
+esp_amp_rpc_client_handle_t esp_amp_rpc_client_inst_create(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr)
 {
     if (rpmsg_dev == NULL) {
         ESP_AMP_LOGE(TAG, "Invalid rpmsg_dev");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        return NULL;
     }
 
-    esp_amp_rpc_client.rpmsg_dev = rpmsg_dev;
-    esp_amp_rpc_client.client_addr = client_addr;
-    esp_amp_rpc_client.server_addr = server_addr;
+    /* take a free instance */
+    esp_amp_rpc_client_t *client = NULL;
+    for (int i = 0; i < ESP_AMP_RPC_CLIENT_INSTANCE_NUM; i++) {
+        if (esp_amp_rpc_clients[i].rpmsg_dev == NULL) {
+            client = &esp_amp_rpc_clients[i];
+            break;
+        }
+    }
+    if (client == NULL) {
+        ESP_AMP_LOGE(TAG, "No free RPC client instance");
+        return NULL;
+    }
+
+    client->client_addr = client_addr;
+    client->server_addr = server_addr;
 
-    if (esp_amp_rpmsg_create_endpoint(esp_amp_rpc_client.rpmsg_dev, client_addr, esp_amp_rpc_client_poll, NULL, &esp_amp_rpc_client.rpmsg_ept) == NULL) {
+    esp_amp_rpc_pending_tbl_init(&client->pending_list.tbl);
+    esp_amp_rpc_timer_init(&client->pending_list.timer);
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        client->pending_list.reqs[i].client = client;
+        client->pending_list.reqs[i].req_id = ESP_AMP_RPC_INVALID_REQ_ID;
+    }
+
+    if (esp_amp_rpmsg_create_endpoint(rpmsg_dev, client_addr, esp_amp_rpc_client_poll, client, &client->rpmsg_ept) == NULL) {
         ESP_AMP_LOGE(TAG, "Failed to create ept");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        return NULL;
     }
+    client->rpmsg_dev = rpmsg_dev; /* marks the instance taken */
 
-    esp_amp_rpc_client.server_addr = server_addr;
-    return ESP_AMP_RPC_STATUS_OK;
+    return client;
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_client_deinit(void)
+esp_amp_rpc_status_t esp_amp_rpc_client_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr)
 {
-    return ESP_AMP_RPC_STATUS_OK;
+    esp_amp_rpc_client_default = esp_amp_rpc_client_inst_create(rpmsg_dev, client_addr, server_addr);
+    return esp_amp_rpc_client_default ? ESP_AMP_RPC_STATUS_OK : ESP_AMP_RPC_STATUS_FAILED;
 }
 
-esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id, void *params, uint16_t params_len)
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_delete(esp_amp_rpc_client_handle_t client)
 {
-
-    /* first, check if any space in pending list */
-    int avail_idx = ESP_AMP_RPC_MAX_PENDING_REQ;
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        if (pending_reqs[i].req_id == ESP_AMP_RPC_INVALID_REQ_ID) {
-            avail_idx = i;
-            break;
-        }
+    if (client != NULL && client->rpmsg_dev != NULL) {
+        esp_amp_rpmsg_delete_endpoint(client->rpmsg_dev, client->client_addr);
+        client->rpmsg_dev = NULL;
     }
+    return ESP_AMP_RPC_STATUS_OK;
+}
 
-    if (avail_idx == ESP_AMP_RPC_MAX_PENDING_REQ) {
-        ESP_AMP_LOGE(TAG, "No space for pending request");
+esp_amp_rpc_status_t esp_amp_rpc_client_deinit(void)
+{
+    esp_amp_rpc_status_t ret = esp_amp_rpc_client_inst_delete(esp_amp_rpc_client_default);
+    esp_amp_rpc_client_default = NULL;
+    return ret;
+}
+
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_inst_create_request(esp_amp_rpc_client_handle_t client, uint16_t service_id, void *params, uint16_t params_len)
+{
+    if (client == NULL || client->rpmsg_dev == NULL) {
+        ESP_AMP_LOGE(TAG, "Invalid client");
         return NULL;
     }
 
-    esp_amp_rpc_pending_req_t *pending_req = &pending_reqs[avail_idx];
-    if (esp_amp_rpc_pending_list_push(pending_req) == -1) {
+    /* first, check if any space in pending list */
+    esp_amp_rpc_pending_req_t *pending_req = esp_amp_rpc_pending_list_push(client);
+    if (pending_req == NULL) {
         ESP_AMP_LOGE(TAG, "No space in pending list");
-        pending_req->req_id = ESP_AMP_RPC_INVALID_REQ_ID;
         return NULL;
     }
 
-    pending_req->req_id = esp_amp_rpc_get_req_id();
+    pending_req->cb = NULL;
+    pending_req->service_id = service_id;
+    pending_req->timeout_ms = UINT32_MAX; /* not executed yet */
+    pending_req->sent = false;
     pending_req->start_time = esp_amp_platform_get_time_ms();
     pending_req->status = ESP_AMP_RPC_STATUS_PENDING;
 
@@ -186,20 +216,23 @@ esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id,
 
     /* second, alloc tx buffer only when pending list is not full */
     int pkt_out_size = params_len + sizeof(esp_amp_rpc_pkt_t);
-    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(esp_amp_rpc_client.rpmsg_dev, pkt_out_size, ESP_AMP_RPMSG_DATA_DEFAULT);
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(client->rpmsg_dev, pkt_out_size, ESP_AMP_RPMSG_DATA_DEFAULT);
     if (pkt_out == NULL) {
         ESP_AMP_LOGE(TAG, "No space for rpc pkt");
-        esp_amp_rpc_pending_list_pop(pending_req->req_id, NULL); /* pop out pending request */
-        pending_req->req_id = ESP_AMP_RPC_INVALID_REQ_ID;
+        esp_amp_rpc_pending_list_pop(pending_req); /* pop out pending request */
         return NULL;
     }
 
     /* third, create packet */
-    memcpy(pkt_out->params, params, params_len);
+    if (params != NULL) {
+        memcpy(pkt_out->params, params, params_len);
+    }
     pkt_out->params_len = params_len;
     pkt_out->req_id = pending_req->req_id;
     pkt_out->service_id = service_id;
     pkt_out->status = ESP_AMP_RPC_STATUS_PENDING;
+    pkt_out->priority = ESP_AMP_RPC_PRIORITY_NORMAL;
+    pkt_out->timeout_ms = 0; /* set when sent */
 
     /* attach pkt_out to pending req */
     pending_req->pkt = pkt_out;
@@ -210,50 +243,210 @@ esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id,
     return pending_req;
 }
 
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id, void *params, uint16_t params_len)
+{
+    return esp_amp_rpc_client_inst_create_request(esp_amp_rpc_client_default, service_id, params, params_len);
+}
+
 esp_amp_rpc_status_t esp_amp_rpc_client_execute_request_with_cb(esp_amp_rpc_req_handle_t req, esp_amp_rpc_req_cb_t cb, uint32_t timeout_ms)
 {
     esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
-    pending_req->cb = cb;
-    pending_req->timeout_ms = timeout_ms;
-
     /* finally, send out */
     if (!pending_req) {
         return ESP_AMP_RPC_STATUS_INVALID_ARG;
     }
 
-    esp_amp_rpmsg_send_nocopy(esp_amp_rpc_client.rpmsg_dev, &esp_amp_rpc_client.rpmsg_ept, esp_amp_rpc_client.server_addr,
+    esp_amp_rpc_client_t *client = pending_req->client;
+    pending_req->cb = cb;
+    pending_req->timeout_ms = timeout_ms;
+    pending_req->sent = true;
+    pending_req->sent_us = ESP_AMP_RPC_METRICS_NOW();
+    /* timeout counts from creation of the req, time spent before execution is deducted */
+    pending_req->pkt->timeout_ms = esp_amp_rpc_client_remaining_ms(pending_req);
+    esp_amp_rpc_pending_list_arm(pending_req);
+
+    esp_amp_rpmsg_send_nocopy(client->rpmsg_dev, &client->rpmsg_ept, client->server_addr,
                               pending_req->pkt, pending_req->pkt->params_len + sizeof(esp_amp_rpc_pkt_t));
     return ESP_AMP_RPC_STATUS_OK;
 }
 
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_inst_create_batch(esp_amp_rpc_client_handle_t client)
+{
+    if (client == NULL || client->rpmsg_dev == NULL) {
+        ESP_AMP_LOGE(TAG, "Invalid client");
+        return NULL;
+    }
+
+    /* take a whole transport buffer, sub-requests are appended in place */
+    uint16_t capacity = esp_amp_rpmsg_get_max_size(client->rpmsg_dev) - sizeof(esp_amp_rpc_pkt_t);
+    esp_amp_rpc_pending_req_t *pending_req = esp_amp_rpc_client_inst_create_request(client, ESP_AMP_RPC_BATCH_SERVICE_ID, NULL, capacity);
+    if (pending_req == NULL) {
+        return NULL;
+    }
+    pending_req->pkt->params_len = 0;
+    return pending_req;
+}
+
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_batch(void)
+{
+    return esp_amp_rpc_client_inst_create_batch(esp_amp_rpc_client_default);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_batch_add(esp_amp_rpc_req_handle_t req, uint16_t service_id, void *params, uint16_t params_len)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+
+    if (!pending_req || pending_req->pkt == NULL || pending_req->pkt->service_id != ESP_AMP_RPC_BATCH_SERVICE_ID) {
+        ESP_AMP_LOGE(TAG, "Invalid batch req");
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    uint16_t capacity = esp_amp_rpmsg_get_max_size(pending_req->client->rpmsg_dev) - sizeof(esp_amp_rpc_pkt_t);
+    if (esp_amp_rpc_batch_append(pending_req->pkt, capacity, service_id, params, params_len) == -1) {
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_notify_with_priority(esp_amp_rpc_client_handle_t client, uint16_t service_id, uint8_t priority, void *params, uint16_t params_len)
+{
+    if (client == NULL || client->rpmsg_dev == NULL) {
+        ESP_AMP_LOGE(TAG, "Invalid client");
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    /* no pending req, sent from caller's context */
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(client->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t) + params_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_out == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to alloc msg buf");
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+
+    if (params != NULL) {
+        memcpy(pkt_out->params, params, params_len);
+    }
+    pkt_out->params_len = params_len;
+    pkt_out->req_id = ESP_AMP_RPC_NOTIFY_REQ_ID;
+    pkt_out->service_id = service_id;
+    pkt_out->status = ESP_AMP_RPC_STATUS_PENDING;
+    pkt_out->priority = priority;
+    pkt_out->timeout_ms = 0;
+
+    if (esp_amp_rpmsg_send_nocopy(client->rpmsg_dev, &client->rpmsg_ept, client->server_addr,
+                                  pkt_out, sizeof(esp_amp_rpc_pkt_t) + params_len) != 0) {
+        ESP_AMP_LOGE(TAG, "Failed to send notification(%u)", service_id);
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_notify(esp_amp_rpc_client_handle_t client, uint16_t service_id, void *params, uint16_t params_len)
+{
+    return esp_amp_rpc_client_inst_notify_with_priority(client, service_id, ESP_AMP_RPC_PRIORITY_NORMAL, params, params_len);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_notify_with_priority(uint16_t service_id, uint8_t priority, void *params, uint16_t params_len)
+{
+    return esp_amp_rpc_client_inst_notify_with_priority(esp_amp_rpc_client_default, service_id, priority, params, params_len);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_notify(uint16_t service_id, void *params, uint16_t params_len)
+{
+    return esp_amp_rpc_client_inst_notify(esp_amp_rpc_client_default, service_id, params, params_len);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_cancel_request(esp_amp_rpc_req_handle_t req)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+
+    /* req completed or timeout is already moved out of pending list */
+    if (pending_req == NULL || pending_req->req_id == ESP_AMP_RPC_INVALID_REQ_ID || !pending_req->sent) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    /* header only, req_id tells server which req to drop */
+    esp_amp_rpc_client_t *client = pending_req->client;
+    esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_OK;
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(client->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_out == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to alloc msg buf");
+        ret = ESP_AMP_RPC_STATUS_NO_MEM;
+    } else {
+        pkt_out->req_id = pending_req->req_id;
+        pkt_out->service_id = ESP_AMP_RPC_CANCEL_SERVICE_ID;
+        pkt_out->status = ESP_AMP_RPC_STATUS_CANCELLED;
+        pkt_out->priority = ESP_AMP_RPC_PRIORITY_NORMAL;
+        pkt_out->params_len = 0;
+        pkt_out->timeout_ms = 0;
+        esp_amp_rpmsg_send_nocopy(client->rpmsg_dev, &client->rpmsg_ept, client->server_addr,
+                                  pkt_out, sizeof(esp_amp_rpc_pkt_t));
+    }
+
+    ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_client_metrics, pending_req->service_id, ESP_AMP_RPC_STATUS_CANCELLED);
+
+    /* late rsp finds no pending req and is dropped */
+    if (pending_req->cb) {
+        pending_req->cb(ESP_AMP_RPC_STATUS_CANCELLED, NULL, 0);
+    }
+    esp_amp_rpc_pending_list_pop(pending_req);
+    return ret;
+}
+
+void *esp_amp_rpc_client_get_request_params(esp_amp_rpc_req_handle_t req)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+    if (pending_req == NULL || pending_req->pkt == NULL) {
+        return NULL;
+    }
+    return pending_req->pkt->params;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_set_priority(esp_amp_rpc_req_handle_t req, uint8_t priority)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+    if (pending_req == NULL || pending_req->req_id == ESP_AMP_RPC_INVALID_REQ_ID || pending_req->pkt == NULL || pending_req->sent) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    pending_req->pkt->priority = priority;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
 void esp_amp_rpc_client_destroy_request(esp_amp_rpc_req_handle_t req)
 {
     esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
-    esp_amp_rpc_pending_list_pop(pending_req->req_id, NULL);
-    pending_req->req_id = ESP_AMP_RPC_INVALID_REQ_ID; /* set req_id to invalid */
+    esp_amp_rpc_pending_list_pop(pending_req); /* set req_id to invalid */
 }
 
-/* check pending list periodically and pop out the timeout requests */
-void esp_amp_rpc_client_complete_timeout_request(void)
+/* called periodically to pop out the timeout requests, only the expired ones are visited */
+void esp_amp_rpc_client_inst_complete_timeout_request(esp_amp_rpc_client_handle_t client)
 {
-    ESP_AMP_LOGD(TAG, "=== timeout request begin ===");
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        esp_amp_rpc_pending_req_t *pending_req = esp_amp_rpc_client.pending_list.reqs[i];
-        if (!pending_req || pending_req->req_id == ESP_AMP_RPC_INVALID_REQ_ID) {
-            continue;
-        }
-        ESP_AMP_LOGD(TAG, "req(%u): timeout=%lu, start=%lu, cur=%lu", pending_req->req_id, pending_req->timeout_ms, pending_req->start_time, esp_amp_platform_get_time_ms());
+    if (client == NULL || client->rpmsg_dev == NULL) {
+        return;
+    }
 
-        /* if timeout, remove this request from pending list */
-        if (esp_amp_platform_get_time_ms() - pending_req->start_time >= pending_req->timeout_ms) {
-            if (pending_req->cb) {
-                pending_req->cb(ESP_AMP_RPC_STATUS_TIMEOUT, NULL, 0);
-            }
-            esp_amp_rpc_pending_list_pop(pending_req->req_id, NULL);
-            pending_req->req_id = ESP_AMP_RPC_INVALID_REQ_ID;
+    /* nothing to expire, skip reading time */
+    if (esp_amp_rpc_timer_is_empty(&client->pending_list.timer)) {
+        return;
+    }
+
+    uint32_t cur_time = esp_amp_platform_get_time_ms();
+    int slot;
+    while ((slot = esp_amp_rpc_timer_pop_expired(&client->pending_list.timer, cur_time)) != -1) {
+        esp_amp_rpc_pending_req_t *pending_req = &client->pending_list.reqs[slot];
+        ESP_AMP_LOGD(TAG, "req(%u): timeout=%lu, start=%lu, cur=%lu", pending_req->req_id, pending_req->timeout_ms, pending_req->start_time, cur_time);
+
+        ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_client_metrics, pending_req->service_id, ESP_AMP_RPC_STATUS_TIMEOUT);
+        if (pending_req->cb) {
+            pending_req->cb(ESP_AMP_RPC_STATUS_TIMEOUT, NULL, 0);
         }
+        esp_amp_rpc_pending_list_pop(pending_req);
     }
-    ESP_AMP_LOGD(TAG, "=== timeout request end ===");
+}
+
+void esp_amp_rpc_client_complete_timeout_request(void)
+{
+    esp_amp_rpc_client_inst_complete_timeout_request(esp_amp_rpc_client_default);
 }
 
 /**
@@ -263,6 +456,7 @@ void esp_amp_rpc_client_complete_timeout_request(void)
 static int esp_amp_rpc_client_poll(void *pkt_in_buf, uint16_t pkt_in_size, uint16_t src_addr, void* rx_cb_data)
 {
     int ret = 0;
+    esp_amp_rpc_client_t *client = (esp_amp_rpc_client_t *)rx_cb_data;
     esp_amp_rpc_pending_req_t *pending_req;
     esp_amp_rpc_pkt_t *pkt_in;
 
@@ -274,24 +468,57 @@ static int esp_amp_rpc_client_poll(void *pkt_in_buf, uint16_t pkt_in_size, uint1
     if (ret != -1) {
         pkt_in = (esp_amp_rpc_pkt_t *)pkt_in_buf;
         /* find req from pending list and execute cb */
-        ret = esp_amp_rpc_pending_list_peek(pkt_in->req_id, &pending_req);
+        pending_req = esp_amp_rpc_pending_list_peek(client, pkt_in->req_id);
 
         /* rsp may belong to a timeout req already moved out of pending list */
-        if (ret == -1) {
+        if (pending_req == NULL) {
+            ret = -1;
             ESP_AMP_LOGD(TAG, "recv rsp for timeout req(%u)", pkt_in->req_id);
         } else {
             if (pending_req->cb) {
                 ESP_AMP_LOGD(TAG, "calling req(%u)'s cb %p", pkt_in->req_id, pending_req->cb);
                 pending_req->cb(pkt_in->status, pkt_in->params, pkt_in->params_len);
             }
+            /* stream chunk keeps req pending until the final rsp, and restarts its timeout */
+            if (pkt_in->status == ESP_AMP_RPC_STATUS_STREAM) {
+                pending_req->start_time = esp_amp_platform_get_time_ms();
+                esp_amp_rpc_pending_list_arm(pending_req);
+                ret = 1;
+            } else {
+                ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_client_metrics, pending_req->service_id, ESP_AMP_RPC_METRICS_LATENCY,
+                                         ESP_AMP_RPC_METRICS_NOW() - pending_req->sent_us);
+                ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_client_metrics, pending_req->service_id, pkt_in->status);
+            }
         }
     }
 
     /* release rx buf */
-    if (ret != -1) {
-        esp_amp_rpc_pending_list_pop(pkt_in->req_id, NULL);
-        pending_req->req_id = ESP_AMP_RPC_INVALID_REQ_ID;
+    if (ret == 0) {
+        esp_amp_rpc_pending_list_pop(pending_req);
     }
-    esp_amp_rpmsg_destroy(esp_amp_rpc_client.rpmsg_dev, pkt_in_buf);
-    return ret;
+    esp_amp_rpmsg_destroy(client->rpmsg_dev, pkt_in_buf);
+    return ret == -1 ? -1 : 0;
+}
+
+#if CONFIG_ESP_AMP_RPC_METRICS
+esp_amp_rpc_status_t esp_amp_rpc_client_metrics_get(uint16_t service_id, esp_amp_rpc_metrics_t *metrics)
+{
+    if (metrics == NULL) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+    if (esp_amp_rpc_metrics_get(&esp_amp_rpc_client_metrics, service_id, metrics) != 0) {
+        return ESP_AMP_RPC_STATUS_NO_SERVICE;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+void esp_amp_rpc_client_metrics_reset(void)
+{
+    esp_amp_rpc_metrics_reset(&esp_amp_rpc_client_metrics);
+}
+
+void esp_amp_rpc_client_metrics_dump(void)
+{
+    esp_amp_rpc_metrics_dump(&esp_amp_rpc_client_metrics, TAG);
 }
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
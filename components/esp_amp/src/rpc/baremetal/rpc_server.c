@@ -10,11 +10,25 @@
 #include "string.h"
 #include "esp_attr.h"
 
+#include "esp_amp_env.h"
+#include "esp_amp_platform.h"
 #include "esp_amp_rpc.h"
 #include "esp_amp_rpmsg.h"
 #include "esp_amp_log.h"
+#include "esp_amp_rpc_service_priv.h"
+#include "esp_amp_rpc_batch_priv.h"
+#include "esp_amp_rpc_metrics_priv.h"
+#include "esp_amp_rpc_prio_priv.h"
 
 #define ESP_AMP_RPC_SERVICE_TABLE_LEN CONFIG_ESP_AMP_RPC_SERVICE_TABLE_LEN
+#define ESP_AMP_RPC_SERVER_INSTANCE_NUM CONFIG_ESP_AMP_RPC_SERVER_INSTANCE_NUM
+#define ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN CONFIG_ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+
+#if ESP_AMP_RPC_PRIORITY_NUM > 1
+#define ESP_AMP_RPC_PRIORITY_AGING_MS CONFIG_ESP_AMP_RPC_PRIORITY_AGING_MS
+#else
+#define ESP_AMP_RPC_PRIORITY_AGING_MS 0
+#endif /* ESP_AMP_RPC_PRIORITY_NUM > 1 */
 
 static const DRAM_ATTR char TAG[] = "rpc_server";
 
@@ -23,43 +37,116 @@ typedef struct {
     esp_amp_rpc_service_t services[ESP_AMP_RPC_SERVICE_TABLE_LEN];
 } esp_amp_rpc_service_tbl_t;
 
+#if ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+typedef struct {
+    esp_amp_rpc_pkt_t *pkt; /* NULL if slot is free, or cancelled while queued */
+    uint32_t rx_ms; /* for deadline and aging, only set if pkt has a deadline or priority levels are enabled */
+    uint32_t rx_us; /* for metrics */
+} esp_amp_rpc_server_rx_t;
+
+/**
+ * received requests, filled by rpmsg callback and drained by esp_amp_rpc_server_process()
+ * executed by priority, and in arrival order if priority levels are disabled
+ */
 typedef struct {
+    esp_amp_rpc_prio_q_t q;
+    esp_amp_rpc_prio_link_t links[ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN];
+    esp_amp_rpc_server_rx_t rx[ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN]; /* indexed by slot of q */
+} esp_amp_rpc_server_run_q_t;
+#endif /* ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN */
+
+struct esp_amp_rpc_server_t {
     uint16_t server_addr;
     uint16_t client_addr;
-    esp_amp_rpmsg_dev_t *rpmsg_dev;
+    esp_amp_rpmsg_dev_t *rpmsg_dev; /* NULL if instance is free */
     esp_amp_rpmsg_ept_t rpmsg_ept;
     esp_amp_rpc_service_tbl_t service_tbl;
-} esp_amp_rpc_server_t;
+#if ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+    esp_amp_rpc_server_run_q_t run_q;
+#endif /* ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN */
+};
+
+typedef struct esp_amp_rpc_server_t esp_amp_rpc_server_t;
+
+/* request whose service handler is running, for stream_send */
+typedef struct {
+    esp_amp_rpc_server_t *server; /* NULL if no handler is running, or a batch is executing */
+    void *params_out;
+    uint16_t req_id;
+    uint16_t service_id;
+    uint8_t priority;
+} esp_amp_rpc_server_stream_t;
+
+static esp_amp_rpc_server_t esp_amp_rpc_servers[ESP_AMP_RPC_SERVER_INSTANCE_NUM];
+static esp_amp_rpc_server_t *esp_amp_rpc_server_default; /* instance of APIs without handle, created by esp_amp_rpc_server_init() */
+static esp_amp_rpc_server_stream_t esp_amp_rpc_server_stream;
 
-static esp_amp_rpc_server_t esp_amp_rpc_server;
+#if CONFIG_ESP_AMP_RPC_METRICS
+static esp_amp_rpc_metrics_tbl_t esp_amp_rpc_server_metrics; /* shared by all instances */
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
 
 static int esp_amp_rpc_server_poll(void *pkt_in_buf, uint16_t size, uint16_t src_addr, void* rx_cb_data);
 
-esp_amp_rpc_status_t esp_amp_rpc_server_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr)
+esp_amp_rpc_server_handle_t esp_amp_rpc_server_inst_create(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr)
 {
     if (!rpmsg_dev) {
         ESP_AMP_LOGE(TAG, "Invalid rpmsg_dev");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        return NULL;
+    }
+
+    /* take a free instance */
+    esp_amp_rpc_server_t *server = NULL;
+    for (int i = 0; i < ESP_AMP_RPC_SERVER_INSTANCE_NUM; i++) {
+        if (esp_amp_rpc_servers[i].rpmsg_dev == NULL) {
+            server = &esp_amp_rpc_servers[i];
+            break;
+        }
     }
-    esp_amp_rpc_server.rpmsg_dev = rpmsg_dev;
-    esp_amp_rpc_server.client_addr = client_addr;
-    esp_amp_rpc_server.server_addr = server_addr;
+    if (server == NULL) {
+        ESP_AMP_LOGE(TAG, "No free RPC server instance");
+        return NULL;
+    }
+
+    server->client_addr = client_addr;
+    server->server_addr = server_addr;
 
     /* init service_tbl*/
-    esp_amp_rpc_server.service_tbl.len = 0;
+    server->service_tbl.len = 0;
+    esp_amp_rpc_service_static_init();
+
+#if ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+    memset(server->run_q.rx, 0, sizeof(server->run_q.rx));
+    esp_amp_rpc_prio_q_init(&server->run_q.q, server->run_q.links, ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN, ESP_AMP_RPC_PRIORITY_AGING_MS);
+#endif /* ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN */
 
     /* register endpoint */
-    if (esp_amp_rpmsg_create_endpoint(esp_amp_rpc_server.rpmsg_dev, server_addr, esp_amp_rpc_server_poll, NULL, &esp_amp_rpc_server.rpmsg_ept) == NULL) {
+    if (esp_amp_rpmsg_create_endpoint(rpmsg_dev, server_addr, esp_amp_rpc_server_poll, server, &server->rpmsg_ept) == NULL) {
         ESP_AMP_LOGE(TAG, "Failed to create ept");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        return NULL;
     }
+    server->rpmsg_dev = rpmsg_dev; /* marks the instance taken */
 
-    return ESP_AMP_RPC_STATUS_OK;
+    return server;
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_server_add_service(esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_func_t srv_func)
+esp_amp_rpc_status_t esp_amp_rpc_server_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr)
 {
-    int next_idx = esp_amp_rpc_server.service_tbl.len;
+    esp_amp_rpc_server_default = esp_amp_rpc_server_inst_create(rpmsg_dev, client_addr, server_addr);
+    return esp_amp_rpc_server_default ? ESP_AMP_RPC_STATUS_OK : ESP_AMP_RPC_STATUS_FAILED;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_add_service(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_func_t srv_func)
+{
+    if (server == NULL || server->rpmsg_dev == NULL) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    if (esp_amp_rpc_service_static_find(srv_id) != -1) {
+        ESP_AMP_LOGE(TAG, "srv(%d) already defined at link time", srv_id);
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    int next_idx = server->service_tbl.len;
     if (next_idx == ESP_AMP_RPC_SERVICE_TABLE_LEN) {
         return ESP_AMP_RPC_STATUS_FAILED;
     }
@@ -70,56 +157,215 @@ esp_amp_rpc_status_t esp_amp_rpc_server_add_service(esp_amp_rpc_service_id_t srv
 
     /* duplicated id checking: if a previous handler has the same srv_id, replace it with the new one */
     for (int i = 0; i < next_idx; i++) {
-        if (esp_amp_rpc_server.service_tbl.services[i].id == srv_id) {
+        if (server->service_tbl.services[i].id == srv_id) {
             next_idx = i;
             break;
         }
     }
 
-    esp_amp_rpc_server.service_tbl.services[next_idx].handler = srv_func;
-    esp_amp_rpc_server.service_tbl.services[next_idx].id = srv_id;
+    server->service_tbl.services[next_idx].handler = srv_func;
+    server->service_tbl.services[next_idx].id = srv_id;
+    server->service_tbl.services[next_idx].batch_handler = NULL;
 
     /* if a new service is added to service table, increase the service table length */
-    if (next_idx == esp_amp_rpc_server.service_tbl.len) {
-        esp_amp_rpc_server.service_tbl.len++;
+    if (next_idx == server->service_tbl.len) {
+        server->service_tbl.len++;
     }
     ESP_AMP_LOGD(TAG, "added srv(%u, %p) to tbl[%d]", srv_id, srv_func, next_idx);
     return ESP_AMP_RPC_STATUS_OK;
 }
 
+esp_amp_rpc_status_t esp_amp_rpc_server_add_service(esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_func_t srv_func)
+{
+    return esp_amp_rpc_server_inst_add_service(esp_amp_rpc_server_default, srv_id, srv_func);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_stream_send(void *params_out, const void *data, uint16_t data_len)
+{
+    esp_amp_rpc_server_t *server = esp_amp_rpc_server_stream.server;
+    /* sub-requests of a batch share one rsp, they cannot stream */
+    if (server == NULL || params_out == NULL || esp_amp_rpc_server_stream.params_out != params_out ||
+            sizeof(esp_amp_rpc_pkt_t) + data_len > esp_amp_rpmsg_get_max_size(server->rpmsg_dev)) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    esp_amp_rpc_pkt_t *pkt_chunk = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(server->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t) + data_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_chunk == NULL) {
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+
+    pkt_chunk->req_id = esp_amp_rpc_server_stream.req_id;
+    pkt_chunk->service_id = esp_amp_rpc_server_stream.service_id;
+    pkt_chunk->status = ESP_AMP_RPC_STATUS_STREAM;
+    pkt_chunk->priority = esp_amp_rpc_server_stream.priority;
+    pkt_chunk->params_len = data_len;
+    pkt_chunk->timeout_ms = 0;
+    memcpy(pkt_chunk->params, data, data_len);
+
+    ESP_AMP_LOGD(TAG, "sending chunk(%u) of rsp(%u)", data_len, pkt_chunk->req_id);
+    esp_amp_rpmsg_send_nocopy(server->rpmsg_dev, &server->rpmsg_ept, server->client_addr,
+                              pkt_chunk, sizeof(esp_amp_rpc_pkt_t) + data_len);
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_delete(esp_amp_rpc_server_handle_t server)
+{
+    if (server != NULL && server->rpmsg_dev != NULL) {
+        esp_amp_rpmsg_delete_endpoint(server->rpmsg_dev, server->server_addr);
+#if ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+        /* no more requests after endpoint is deleted, release rx buffers still queued */
+        for (int i = 0; i < ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN; i++) {
+            if (server->run_q.rx[i].pkt != NULL) {
+                esp_amp_rpmsg_destroy(server->rpmsg_dev, server->run_q.rx[i].pkt);
+                server->run_q.rx[i].pkt = NULL;
+            }
+        }
+        esp_amp_rpc_prio_q_init(&server->run_q.q, server->run_q.links, ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN, ESP_AMP_RPC_PRIORITY_AGING_MS);
+#endif /* ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN */
+        server->rpmsg_dev = NULL;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
 
 esp_amp_rpc_status_t esp_amp_rpc_server_deinit(void)
 {
+    esp_amp_rpc_status_t ret = esp_amp_rpc_server_inst_delete(esp_amp_rpc_server_default);
+    esp_amp_rpc_server_default = NULL;
+    return ret;
+}
+
+static esp_amp_rpc_service_t *esp_amp_rpc_server_get_service(esp_amp_rpc_server_t *server, esp_amp_rpc_service_id_t srv_id)
+{
+    /* link-time services first, O(1) for contiguous ids */
+    int idx = esp_amp_rpc_service_static_find(srv_id);
+    if (idx != -1) {
+        return esp_amp_rpc_service_static_get(idx);
+    }
+
+    for (int i = 0; i < server->service_tbl.len; i++) {
+        if (server->service_tbl.services[i].id == srv_id) {
+            return &server->service_tbl.services[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_amp_rpc_service_func_t esp_amp_rpc_server_find_service(esp_amp_rpc_server_t *server, esp_amp_rpc_service_id_t srv_id)
+{
+    esp_amp_rpc_service_t *service = esp_amp_rpc_server_get_service(server, srv_id);
+    return service ? service->handler : NULL;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_set_batch_handler(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_batch_func_t batch_func)
+{
+    if (server == NULL || server->rpmsg_dev == NULL) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    esp_amp_rpc_service_t *service = esp_amp_rpc_server_get_service(server, srv_id);
+    if (service == NULL) {
+        return ESP_AMP_RPC_STATUS_NO_SERVICE;
+    }
+    service->batch_handler = batch_func;
     return ESP_AMP_RPC_STATUS_OK;
 }
 
+esp_amp_rpc_status_t esp_amp_rpc_server_set_batch_handler(esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_batch_func_t batch_func)
+{
+    return esp_amp_rpc_server_inst_set_batch_handler(esp_amp_rpc_server_default, srv_id, batch_func);
+}
 
-static int esp_amp_rpc_server_poll(void *pkt_in_buf, uint16_t size, uint16_t src_addr, void* rx_cb_data)
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_invalidate(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id)
+{
+    if (server == NULL || server->rpmsg_dev == NULL) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    /* notification to client, which drops cached responses of srv_id */
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(server->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t) + sizeof(uint16_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_out == NULL) {
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+
+    uint16_t service_id = srv_id;
+    pkt_out->req_id = ESP_AMP_RPC_NOTIFY_REQ_ID;
+    pkt_out->service_id = ESP_AMP_RPC_INVALIDATE_SERVICE_ID;
+    pkt_out->status = ESP_AMP_RPC_STATUS_OK;
+    pkt_out->priority = ESP_AMP_RPC_PRIORITY_NORMAL;
+    pkt_out->params_len = sizeof(uint16_t);
+    pkt_out->timeout_ms = 0;
+    memcpy(pkt_out->params, &service_id, sizeof(uint16_t));
+
+    ESP_AMP_LOGD(TAG, "invalidate cache of srv(%u)", service_id);
+    if (esp_amp_rpmsg_send_nocopy(server->rpmsg_dev, &server->rpmsg_ept, server->client_addr,
+                                  pkt_out, sizeof(esp_amp_rpc_pkt_t) + sizeof(uint16_t)) != 0) {
+        ESP_AMP_LOGE(TAG, "Failed to send invalidation(%u)", service_id);
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_invalidate(esp_amp_rpc_service_id_t srv_id)
+{
+    return esp_amp_rpc_server_inst_invalidate(esp_amp_rpc_server_default, srv_id);
+}
+
+/* sub-requests of a batch are executed right away, nothing to wait for */
+static const esp_amp_rpc_service_t *esp_amp_rpc_server_batch_acquire(void *arg, uint16_t service_id, int idx, int num)
+{
+    return esp_amp_rpc_server_get_service((esp_amp_rpc_server_t *)arg, service_id);
+}
+
+static void esp_amp_rpc_server_batch_release(void *arg, int idx, int num)
+{
+}
+
+static void esp_amp_rpc_server_handle_notify(esp_amp_rpc_server_t *server, esp_amp_rpc_pkt_t *pkt_in)
+{
+    uint16_t params_out_len = 0;
+    esp_amp_rpc_status_t status = ESP_AMP_RPC_STATUS_OK;
+    esp_amp_rpc_service_func_t service_handler = esp_amp_rpc_server_find_service(server, pkt_in->service_id);
+    uint32_t exec_us = ESP_AMP_RPC_METRICS_NOW();
+
+    if (service_handler == NULL) {
+        ESP_AMP_LOGE(TAG, "Invalid srv id notification(%u)", pkt_in->service_id);
+        status = ESP_AMP_RPC_STATUS_NO_SERVICE;
+    } else if (service_handler(pkt_in->params, pkt_in->params_len, NULL, &params_out_len) != 0) {
+        ESP_AMP_LOGE(TAG, "Failed to execute notification(%u)", pkt_in->service_id);
+        status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
+    }
+    ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_server_metrics, pkt_in->service_id, ESP_AMP_RPC_METRICS_EXEC, ESP_AMP_RPC_METRICS_NOW() - exec_us);
+    ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_server_metrics, pkt_in->service_id, status);
+
+    esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in);
+}
+
+
+/* execute a request and send back its response, rx buffer (pkt_in) is released */
+static void esp_amp_rpc_server_execute(esp_amp_rpc_server_t *server, esp_amp_rpc_pkt_t *pkt_in, uint32_t rx_us)
 {
     int ret = 0;
-    esp_amp_rpc_pkt_t *pkt_in;
     esp_amp_rpc_pkt_t *pkt_out;
-    uint32_t rpmsg_len = esp_amp_rpmsg_get_max_size(esp_amp_rpc_server.rpmsg_dev);
+    uint32_t rpmsg_len = esp_amp_rpmsg_get_max_size(server->rpmsg_dev);
 
-    if (size < sizeof(esp_amp_rpc_pkt_t)) {
-        ESP_AMP_LOGE(TAG, "Incomplete pkt in");
-        ret = -1;
+    /* one-way notification, no tx buffer is taken */
+    if (pkt_in->req_id == ESP_AMP_RPC_NOTIFY_REQ_ID) {
+        esp_amp_rpc_server_handle_notify(server, pkt_in);
+        return;
     }
 
     /* decode */
-    if (ret != -1) {
-        pkt_in = (esp_amp_rpc_pkt_t *)pkt_in_buf;
-        ESP_AMP_LOGD(TAG, "server(%u) recv req(pkt=%p, req_id=%u) from client(%u)", esp_amp_rpc_server.rpmsg_ept.addr,
-                     pkt_in, pkt_in->req_id, src_addr);
-        ESP_AMP_LOG_BUFFER_HEXDUMP(TAG, pkt_in, pkt_in->params_len + sizeof(esp_amp_rpc_pkt_t), ESP_AMP_LOG_DEBUG);
-
-        /* alloc tx_buf (pkt_out) */
-        pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(esp_amp_rpc_server.rpmsg_dev, rpmsg_len, ESP_AMP_RPMSG_DATA_DEFAULT);
-        if (pkt_out == NULL) {
-            ESP_AMP_LOGE(TAG, "Failed to alloc tx buf for pkt_out");
-            ret = -1;
-        }
-
+    ESP_AMP_LOGD(TAG, "server(%u) recv req(pkt=%p, req_id=%u) from client(%u)", server->rpmsg_ept.addr,
+                 pkt_in, pkt_in->req_id, server->client_addr);
+    ESP_AMP_LOG_BUFFER_HEXDUMP(TAG, pkt_in, pkt_in->params_len + sizeof(esp_amp_rpc_pkt_t), ESP_AMP_LOG_DEBUG);
+
+    /* alloc tx_buf (pkt_out) */
+    pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(server->rpmsg_dev, rpmsg_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_out == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to alloc tx buf for pkt_out");
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in);
+        ret = -1;
+    } else {
         /* copy from pkt_in to pkt_out */
         memcpy(pkt_out, pkt_in, sizeof(esp_amp_rpc_pkt_t));
         pkt_out->params_len = rpmsg_len;
@@ -130,23 +376,35 @@ static int esp_amp_rpc_server_poll(void *pkt_in_buf, uint16_t size, uint16_t src
     if (ret != -1) {
         ESP_AMP_LOGD(TAG, "Executing(req_id:%u, srv_id:%u, status:%u, param(%u):%p)", pkt_in->req_id, pkt_in->service_id, pkt_in->status, pkt_in->params_len, pkt_in->params);
         /* execute service */
-        for (int i = 0; i < esp_amp_rpc_server.service_tbl.len; i++) {
-            if (esp_amp_rpc_server.service_tbl.services[i].handler == NULL) {
-                continue;
-            }
-            if (esp_amp_rpc_server.service_tbl.services[i].id == pkt_in->service_id) {
-                int ret = esp_amp_rpc_server.service_tbl.services[i].handler(pkt_in->params, pkt_in->params_len, pkt_out->params, &pkt_out->params_len);
-                if (ret == 0) {
-                    pkt_out->status = ESP_AMP_RPC_STATUS_OK;
-                } else {
-                    pkt_out->status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
-                }
-                break;
+        esp_amp_rpc_service_func_t service_handler = esp_amp_rpc_server_find_service(server, pkt_in->service_id);
+        uint32_t exec_us = ESP_AMP_RPC_METRICS_NOW();
+        if (pkt_in->service_id == ESP_AMP_RPC_BATCH_SERVICE_ID) {
+            esp_amp_rpc_batch_ops_t ops = {
+                .acquire = esp_amp_rpc_server_batch_acquire,
+                .release = esp_amp_rpc_server_batch_release,
+                .arg = server,
+            };
+            int len = esp_amp_rpc_batch_execute(pkt_in->params, pkt_in->params_len, pkt_out->params, rpmsg_len - sizeof(esp_amp_rpc_pkt_t), &ops);
+            pkt_out->status = len == -1 ? ESP_AMP_RPC_STATUS_BAD_PACKET : ESP_AMP_RPC_STATUS_OK;
+            pkt_out->params_len = len == -1 ? 0 : len;
+        } else if (service_handler != NULL) {
+            esp_amp_rpc_server_stream.server = server;
+            esp_amp_rpc_server_stream.params_out = pkt_out->params;
+            esp_amp_rpc_server_stream.req_id = pkt_in->req_id;
+            esp_amp_rpc_server_stream.service_id = pkt_in->service_id;
+            esp_amp_rpc_server_stream.priority = pkt_in->priority;
+            if (service_handler(pkt_in->params, pkt_in->params_len, pkt_out->params, &pkt_out->params_len) == 0) {
+                pkt_out->status = ESP_AMP_RPC_STATUS_OK;
+            } else {
+                pkt_out->status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
             }
+            esp_amp_rpc_server_stream.server = NULL;
         }
+        ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_server_metrics, pkt_out->service_id, ESP_AMP_RPC_METRICS_EXEC, ESP_AMP_RPC_METRICS_NOW() - exec_us);
+        ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_server_metrics, pkt_out->service_id, pkt_out->status);
 
         /* release rx buffer (pkt_in) */
-        esp_amp_rpmsg_destroy(esp_amp_rpc_server.rpmsg_dev, pkt_in_buf);
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in);
 
         if (pkt_out->status == ESP_AMP_RPC_STATUS_OK) {
             ESP_AMP_LOGD(TAG, "Execd req(%u, %u)", pkt_out->req_id, pkt_out->service_id);
@@ -163,13 +421,168 @@ static int esp_amp_rpc_server_poll(void *pkt_in_buf, uint16_t size, uint16_t src
 
     /* as long as decode successfully, send back the result */
     if (ret != -1) {
-        ESP_AMP_LOGD(TAG, "server(%u) send rsp(pkt=%p, req_id=%u) to client(%u)", esp_amp_rpc_server.rpmsg_ept.addr,
-                     pkt_out, pkt_out->req_id, src_addr);
+        ESP_AMP_LOGD(TAG, "server(%u) send rsp(pkt=%p, req_id=%u) to client(%u)", server->rpmsg_ept.addr,
+                     pkt_out, pkt_out->req_id, server->client_addr);
         ESP_AMP_LOG_BUFFER_HEXDUMP(TAG, pkt_out, pkt_out->params_len + sizeof(esp_amp_rpc_pkt_t), ESP_AMP_LOG_DEBUG);
 
-        esp_amp_rpmsg_send_nocopy(esp_amp_rpc_server.rpmsg_dev, &esp_amp_rpc_server.rpmsg_ept, esp_amp_rpc_server.client_addr,
+        ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_server_metrics, pkt_out->service_id, ESP_AMP_RPC_METRICS_LATENCY, ESP_AMP_RPC_METRICS_NOW() - rx_us);
+        esp_amp_rpmsg_send_nocopy(server->rpmsg_dev, &server->rpmsg_ept, server->client_addr,
                                   pkt_out, pkt_out->params_len + sizeof(esp_amp_rpc_pkt_t));
     }
+}
+
+#if ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+/* drop the queued req named by a cancel message, it may have been executed already */
+static void esp_amp_rpc_server_cancel(esp_amp_rpc_server_t *server, uint16_t req_id)
+{
+    esp_amp_rpc_pkt_t *pkt = NULL;
+
+    esp_amp_env_enter_critical();
+    for (int i = 0; i < ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN; i++) {
+        esp_amp_rpc_server_rx_t *rx = &server->run_q.rx[i];
+        if (rx->pkt != NULL && rx->pkt->req_id == req_id) {
+            pkt = rx->pkt;
+            rx->pkt = NULL;
+            break;
+        }
+    }
+    esp_amp_env_exit_critical();
+
+    if (pkt != NULL) {
+        ESP_AMP_LOGD(TAG, "Drop cancelled req(%u, %u)", pkt->req_id, pkt->service_id);
+        ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_server_metrics, pkt->service_id, ESP_AMP_RPC_STATUS_CANCELLED);
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt);
+    }
+}
+
+static void esp_amp_rpc_server_enqueue(esp_amp_rpc_server_t *server, esp_amp_rpc_pkt_t *pkt_in, uint32_t rx_us)
+{
+    esp_amp_rpc_server_rx_t rx = {
+        .pkt = pkt_in,
+        .rx_ms = (pkt_in->timeout_ms != 0 || ESP_AMP_RPC_PRIORITY_NUM > 1) ? esp_amp_platform_get_time_ms() : 0,
+        .rx_us = rx_us,
+    };
+    bool queued = false;
+
+    esp_amp_env_enter_critical();
+    int slot = esp_amp_rpc_prio_q_push(&server->run_q.q, pkt_in->priority, rx.rx_ms);
+    if (slot != -1) {
+        server->run_q.rx[slot] = rx;
+        queued = true;
+    }
+    esp_amp_env_exit_critical();
+
+    /* same as a lost message, client times out */
+    if (!queued) {
+        ESP_AMP_LOGE(TAG, "Run queue full, drop req(%u, %u)", pkt_in->req_id, pkt_in->service_id);
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in);
+    }
+}
+#endif /* ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN */
+
+static int esp_amp_rpc_server_poll(void *pkt_in_buf, uint16_t size, uint16_t src_addr, void* rx_cb_data)
+{
+    esp_amp_rpc_server_t *server = (esp_amp_rpc_server_t *)rx_cb_data;
+    esp_amp_rpc_pkt_t *pkt_in = (esp_amp_rpc_pkt_t *)pkt_in_buf;
+    uint32_t rx_us = ESP_AMP_RPC_METRICS_NOW();
+
+    if (size < sizeof(esp_amp_rpc_pkt_t)) {
+        ESP_AMP_LOGE(TAG, "Incomplete pkt in");
+        return 0;
+    }
+
+#if ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+    /* handlers run in esp_amp_rpc_server_process(), only queue the request here */
+    if (pkt_in->service_id == ESP_AMP_RPC_CANCEL_SERVICE_ID) {
+        esp_amp_rpc_server_cancel(server, pkt_in->req_id);
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in_buf);
+    } else {
+        esp_amp_rpc_server_enqueue(server, pkt_in, rx_us);
+    }
+#else
+    /**
+     * request is executed as soon as it is polled, so it never expires here, and the req named by a cancel message
+     * has been executed already. Cancel message is consumed without response
+     */
+    if (pkt_in->service_id == ESP_AMP_RPC_CANCEL_SERVICE_ID) {
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in_buf);
+    } else {
+        esp_amp_rpc_server_execute(server, pkt_in, rx_us);
+    }
+#endif /* ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN */
 
     return 0;
 }
+
+#if ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+int esp_amp_rpc_server_inst_process(esp_amp_rpc_server_handle_t server, uint16_t budget)
+{
+    if (server == NULL || server->rpmsg_dev == NULL) {
+        return 0;
+    }
+
+    uint16_t executed = 0;
+    while (budget == 0 || executed < budget) {
+        esp_amp_rpc_server_rx_t rx;
+        uint32_t now_ms = ESP_AMP_RPC_PRIORITY_NUM > 1 ? esp_amp_platform_get_time_ms() : 0;
+
+        esp_amp_env_enter_critical();
+        int slot = esp_amp_rpc_prio_q_pop(&server->run_q.q, now_ms);
+        if (slot == -1) {
+            esp_amp_env_exit_critical();
+            break;
+        }
+        rx = server->run_q.rx[slot];
+        server->run_q.rx[slot].pkt = NULL;
+        esp_amp_env_exit_critical();
+
+        /* cancelled while queued, already released */
+        if (rx.pkt == NULL) {
+            continue;
+        }
+
+        /* nobody waits for the response of an expired req, drop it without taking budget */
+        if (rx.pkt->timeout_ms != 0 && esp_amp_platform_get_time_ms() - rx.rx_ms >= rx.pkt->timeout_ms) {
+            ESP_AMP_LOGD(TAG, "Drop expired req(%u, %u)", rx.pkt->req_id, rx.pkt->service_id);
+            ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_server_metrics, rx.pkt->service_id, ESP_AMP_RPC_STATUS_TIMEOUT);
+            esp_amp_rpmsg_destroy(server->rpmsg_dev, rx.pkt);
+            continue;
+        }
+
+        ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_server_metrics, rx.pkt->service_id, ESP_AMP_RPC_METRICS_QUEUE, ESP_AMP_RPC_METRICS_NOW() - rx.rx_us);
+        esp_amp_rpc_server_execute(server, rx.pkt, rx.rx_us);
+        executed++;
+    }
+
+    /* a single 16-bit load, no lock needed */
+    return server->run_q.q.num;
+}
+
+int esp_amp_rpc_server_process(uint16_t budget)
+{
+    return esp_amp_rpc_server_inst_process(esp_amp_rpc_server_default, budget);
+}
+#endif /* ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN */
+
+#if CONFIG_ESP_AMP_RPC_METRICS
+esp_amp_rpc_status_t esp_amp_rpc_server_metrics_get(uint16_t service_id, esp_amp_rpc_metrics_t *metrics)
+{
+    if (metrics == NULL) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+    if (esp_amp_rpc_metrics_get(&esp_amp_rpc_server_metrics, service_id, metrics) != 0) {
+        return ESP_AMP_RPC_STATUS_NO_SERVICE;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+void esp_amp_rpc_server_metrics_reset(void)
+{
+    esp_amp_rpc_metrics_reset(&esp_amp_rpc_server_metrics);
+}
+
+void esp_amp_rpc_server_metrics_dump(void)
+{
+    esp_amp_rpc_metrics_dump(&esp_amp_rpc_server_metrics, TAG);
+}
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
@@ -0,0 +1,148 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stddef.h"
+#include "string.h"
+#include "esp_amp_rpc_batch_priv.h"
+
+#define BATCH_HDR_SIZE sizeof(esp_amp_rpc_pkt_t)
+
+int esp_amp_rpc_batch_count(const void *params, uint32_t params_len)
+{
+    uint32_t offset = 0;
+    int num = 0;
+
+    while (offset < params_len) {
+        const esp_amp_rpc_pkt_t *sub = (const esp_amp_rpc_pkt_t *)((const uint8_t *)params + offset);
+        if (params_len - offset < BATCH_HDR_SIZE || params_len - offset - BATCH_HDR_SIZE < sub->params_len) {
+            return -1;
+        }
+        if (++num > ESP_AMP_RPC_BATCH_MAX_REQ) {
+            return -1;
+        }
+        offset += BATCH_HDR_SIZE + ESP_AMP_RPC_BATCH_ALIGN(sub->params_len);
+    }
+    return num;
+}
+
+int esp_amp_rpc_batch_append(esp_amp_rpc_pkt_t *batch, uint32_t capacity, uint16_t service_id, const void *params, uint16_t params_len)
+{
+    int num = esp_amp_rpc_batch_count(batch->params, batch->params_len);
+    uint32_t offset = ESP_AMP_RPC_BATCH_ALIGN(batch->params_len);
+
+    if (num < 0 || num == ESP_AMP_RPC_BATCH_MAX_REQ || offset + BATCH_HDR_SIZE + ESP_AMP_RPC_BATCH_ALIGN(params_len) > capacity) {
+        return -1;
+    }
+
+    esp_amp_rpc_pkt_t *sub = (esp_amp_rpc_pkt_t *)(batch->params + offset);
+    sub->req_id = num;
+    sub->service_id = service_id;
+    sub->status = ESP_AMP_RPC_STATUS_PENDING;
+    sub->priority = ESP_AMP_RPC_PRIORITY_NORMAL; /* whole batch is scheduled by the priority of its pkt */
+    sub->params_len = params_len;
+    sub->timeout_ms = 0; /* whole batch shares the deadline of its pkt */
+    if (params != NULL) {
+        memcpy(sub->params, params, params_len);
+    }
+    batch->params_len = offset + BATCH_HDR_SIZE + ESP_AMP_RPC_BATCH_ALIGN(params_len);
+    return num;
+}
+
+esp_amp_rpc_pkt_t *esp_amp_rpc_batch_next(void *params_out, int params_out_len, esp_amp_rpc_pkt_t *prev)
+{
+    uint32_t offset = 0;
+
+    if (params_out == NULL || params_out_len <= 0) {
+        return NULL;
+    }
+    if (prev != NULL) {
+        offset = (uint8_t *)prev - (uint8_t *)params_out + BATCH_HDR_SIZE + ESP_AMP_RPC_BATCH_ALIGN(prev->params_len);
+    }
+
+    esp_amp_rpc_pkt_t *sub = (esp_amp_rpc_pkt_t *)((uint8_t *)params_out + offset);
+    if (offset + BATCH_HDR_SIZE > params_out_len || offset + BATCH_HDR_SIZE + sub->params_len > params_out_len) {
+        return NULL;
+    }
+    return sub;
+}
+
+int esp_amp_rpc_batch_execute(void *params_in, uint32_t params_in_len, void *params_out, uint32_t params_out_cap, const esp_amp_rpc_batch_ops_t *ops)
+{
+    esp_amp_rpc_pkt_t *reqs[ESP_AMP_RPC_BATCH_MAX_REQ];
+    esp_amp_rpc_batch_item_t items[ESP_AMP_RPC_BATCH_MAX_REQ];
+
+    int num = esp_amp_rpc_batch_count(params_in, params_in_len);
+    if (num <= 0) {
+        return num;
+    }
+
+    /* each sub-response is written to its own slot first, so that runs can be executed in any grouping */
+    uint32_t slot = (params_out_cap / num) & ~3;
+    if (slot < BATCH_HDR_SIZE) {
+        return -1;
+    }
+
+    uint32_t offset = 0;
+    for (int i = 0; i < num; i++) {
+        reqs[i] = (esp_amp_rpc_pkt_t *)((uint8_t *)params_in + offset);
+        offset += BATCH_HDR_SIZE + ESP_AMP_RPC_BATCH_ALIGN(reqs[i]->params_len);
+
+        esp_amp_rpc_pkt_t *rsp = (esp_amp_rpc_pkt_t *)((uint8_t *)params_out + i * slot);
+        items[i].params_in = reqs[i]->params;
+        items[i].params_in_len = reqs[i]->params_len;
+        items[i].params_out = rsp->params;
+        items[i].params_out_len = slot - BATCH_HDR_SIZE;
+        items[i].status = ESP_AMP_RPC_STATUS_NO_SERVICE;
+    }
+
+    /* runs of consecutive sub-requests to the same service, headers of sub-responses are written while compacting */
+    for (int i = 0, j; i < num; i = j) {
+        for (j = i + 1; j < num && reqs[j]->service_id == reqs[i]->service_id; j++) {
+        }
+
+        const esp_amp_rpc_service_t *service = ops->acquire(ops->arg, reqs[i]->service_id, i, j - i);
+        if (service == NULL) {
+            continue;
+        }
+
+        for (int k = i; k < j; k++) {
+            items[k].status = ESP_AMP_RPC_STATUS_OK;
+        }
+        if (service->batch_handler != NULL) {
+            service->batch_handler(&items[i], j - i);
+        } else {
+            for (int k = i; k < j; k++) {
+                if (service->handler(items[k].params_in, items[k].params_in_len, items[k].params_out, &items[k].params_out_len) != ESP_AMP_RPC_STATUS_OK) {
+                    items[k].status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
+                }
+            }
+        }
+        for (int k = i; k < j; k++) {
+            if (items[k].status != ESP_AMP_RPC_STATUS_OK || items[k].params_out_len > slot - BATCH_HDR_SIZE) {
+                items[k].status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
+            }
+        }
+
+        ops->release(ops->arg, i, j - i);
+    }
+
+    /* compact slots into the combined response, moving towards lower addresses only */
+    uint32_t len = 0;
+    for (int i = 0; i < num; i++) {
+        esp_amp_rpc_pkt_t rsp = {
+            .req_id = reqs[i]->req_id,
+            .service_id = reqs[i]->service_id,
+            .status = items[i].status,
+            .params_len = items[i].status == ESP_AMP_RPC_STATUS_OK ? items[i].params_out_len : 0,
+        };
+        uint8_t *dst = (uint8_t *)params_out + len;
+        memmove(dst + BATCH_HDR_SIZE, items[i].params_out, rsp.params_len);
+        memcpy(dst, &rsp, BATCH_HDR_SIZE);
+        len += BATCH_HDR_SIZE + ESP_AMP_RPC_BATCH_ALIGN(rsp.params_len);
+    }
+    return len;
+}
@@ -0,0 +1,262 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "string.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_rpc_cache_priv.h"
+
+#if CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM
+
+/* true once now_ms reaches deadline, tolerating wrap around of ms counter */
+#define CACHE_EXPIRED(now, deadline) ((int32_t)((now) - (deadline)) >= 0)
+
+/* fnv-1a */
+static uint32_t esp_amp_rpc_cache_hash(const uint8_t *data, uint16_t len)
+{
+    uint32_t hash = 2166136261UL;
+    for (uint16_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+/* below helpers must be called in critical section */
+static uint32_t esp_amp_rpc_cache_ttl(esp_amp_rpc_cache_t *cache, uint16_t service_id)
+{
+    for (int i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+        if (cache->policy[i].ttl_ms != 0 && cache->policy[i].service_id == service_id) {
+            return cache->policy[i].ttl_ms;
+        }
+    }
+    return 0;
+}
+
+static void esp_amp_rpc_cache_drop(esp_amp_rpc_cache_entry_t *entry)
+{
+    entry->state = entry->refs == 0 ? CACHE_FREE : CACHE_STALE;
+}
+
+void esp_amp_rpc_cache_init(esp_amp_rpc_cache_t *cache)
+{
+    esp_amp_env_enter_critical();
+
+    memset(cache, 0, sizeof(esp_amp_rpc_cache_t));
+
+    esp_amp_env_exit_critical();
+}
+
+int esp_amp_rpc_cache_config(esp_amp_rpc_cache_t *cache, uint16_t service_id, uint32_t ttl_ms)
+{
+    int ret = 0;
+    int free_idx = -1;
+    int idx = -1;
+
+    esp_amp_env_enter_critical();
+
+    for (int i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+        if (cache->policy[i].ttl_ms == 0) {
+            free_idx = free_idx == -1 ? i : free_idx;
+        } else if (cache->policy[i].service_id == service_id) {
+            idx = i;
+        }
+    }
+
+    if (ttl_ms == 0) {
+        if (idx != -1) {
+            cache->policy[idx].ttl_ms = 0;
+        }
+    } else if (idx != -1 || free_idx != -1) {
+        idx = idx != -1 ? idx : free_idx;
+        cache->policy[idx].service_id = service_id;
+        cache->policy[idx].ttl_ms = ttl_ms;
+    } else {
+        ret = -1;
+    }
+
+    /* responses cached under the old ttl are dropped */
+    if (ret == 0) {
+        for (int i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+            esp_amp_rpc_cache_entry_t *entry = &cache->entries[i];
+            if (entry->state != CACHE_FREE && entry->service_id == service_id) {
+                esp_amp_rpc_cache_drop(entry);
+            }
+        }
+    }
+
+    esp_amp_env_exit_critical();
+
+    return ret;
+}
+
+int IRAM_ATTR esp_amp_rpc_cache_acquire(esp_amp_rpc_cache_t *cache, uint16_t service_id, const void *params, uint16_t params_len, uint32_t now_ms, bool *hit)
+{
+    *hit = false;
+    if (params_len > ESP_AMP_RPC_CACHE_DATA_LEN || (params == NULL && params_len != 0)) {
+        return -1;
+    }
+
+    uint32_t hash = esp_amp_rpc_cache_hash((const uint8_t *)params, params_len);
+    int idx = -1;
+    int victim = -1;
+    int victim_rank = 0;
+
+    esp_amp_env_enter_critical();
+
+    if (esp_amp_rpc_cache_ttl(cache, service_id) == 0) {
+        esp_amp_env_exit_critical();
+        return -1;
+    }
+
+    for (int i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+        esp_amp_rpc_cache_entry_t *entry = &cache->entries[i];
+        bool same = entry->state != CACHE_FREE && entry->service_id == service_id && entry->hash == hash
+                    && entry->params_len == params_len;
+
+        if (same && entry->state == CACHE_VALID) {
+            if (!CACHE_EXPIRED(now_ms, entry->expire_ms)) {
+                idx = i;
+                *hit = true;
+                break;
+            }
+            esp_amp_rpc_cache_drop(entry);
+        }
+
+        /* entry to take on miss: free one first, then the same request, then the least recently used one */
+        if (entry->refs != 0) {
+            continue;
+        }
+        int rank = entry->state == CACHE_FREE ? 0 : (same ? 1 : 2);
+        if (victim == -1 || rank < victim_rank || (rank == victim_rank && (int32_t)(entry->used - cache->entries[victim].used) < 0)) {
+            victim = i;
+            victim_rank = rank;
+        }
+    }
+
+    if (idx == -1 && victim != -1) {
+        esp_amp_rpc_cache_entry_t *entry = &cache->entries[victim];
+        entry->state = CACHE_FILLING;
+        entry->service_id = service_id;
+        entry->params_len = params_len;
+        entry->rsp_len = 0;
+        entry->hash = hash;
+        idx = victim;
+    }
+
+    if (idx != -1) {
+        cache->entries[idx].refs++;
+        cache->entries[idx].used = cache->clock++;
+    }
+
+    esp_amp_env_exit_critical();
+
+    if (idx == -1 || params_len == 0) {
+        return idx;
+    }
+
+    /* data of a held entry is only written by the req that took it on miss */
+    esp_amp_rpc_cache_entry_t *entry = &cache->entries[idx];
+    if (!*hit) {
+        memcpy(entry->data, params, params_len);
+    } else if (memcmp(entry->data, params, params_len) != 0) {
+        /* hash collision, request is not cached */
+        *hit = false;
+        esp_amp_rpc_cache_release(cache, idx);
+        idx = -1;
+    }
+
+    return idx;
+}
+
+void IRAM_ATTR esp_amp_rpc_cache_fill(esp_amp_rpc_cache_t *cache, int idx, const void *rsp, uint16_t rsp_len, uint32_t now_ms)
+{
+    esp_amp_rpc_cache_entry_t *entry = &cache->entries[idx];
+    uint32_t ttl_ms = 0;
+
+    esp_amp_env_enter_critical();
+
+    if (entry->state == CACHE_FILLING) {
+        ttl_ms = esp_amp_rpc_cache_ttl(cache, entry->service_id);
+        if (ttl_ms == 0 || entry->params_len + rsp_len > ESP_AMP_RPC_CACHE_DATA_LEN) {
+            ttl_ms = 0;
+            entry->state = CACHE_STALE;
+        }
+    }
+
+    esp_amp_env_exit_critical();
+
+    if (ttl_ms == 0) {
+        return;
+    }
+
+    /* entry stays filling while copied, invalidation in the meantime turns it stale */
+    if (rsp_len != 0) {
+        memcpy(&entry->data[entry->params_len], rsp, rsp_len);
+    }
+
+    esp_amp_env_enter_critical();
+
+    if (entry->state == CACHE_FILLING) {
+        entry->rsp_len = rsp_len;
+        entry->expire_ms = now_ms + ttl_ms;
+        entry->state = CACHE_VALID;
+    }
+
+    esp_amp_env_exit_critical();
+}
+
+const void *esp_amp_rpc_cache_get_rsp(esp_amp_rpc_cache_t *cache, int idx, uint16_t *rsp_len)
+{
+    /* entry held by the caller is never rewritten, no lock needed */
+    esp_amp_rpc_cache_entry_t *entry = &cache->entries[idx];
+    *rsp_len = entry->rsp_len;
+    return &entry->data[entry->params_len];
+}
+
+void IRAM_ATTR esp_amp_rpc_cache_hold(esp_amp_rpc_cache_t *cache, int idx)
+{
+    esp_amp_env_enter_critical();
+
+    cache->entries[idx].refs++;
+
+    esp_amp_env_exit_critical();
+}
+
+void IRAM_ATTR esp_amp_rpc_cache_release(esp_amp_rpc_cache_t *cache, int idx)
+{
+    esp_amp_env_enter_critical();
+
+    esp_amp_rpc_cache_entry_t *entry = &cache->entries[idx];
+    if (entry->refs > 0) {
+        entry->refs--;
+    }
+    /* response of a filling entry never came */
+    if (entry->refs == 0 && (entry->state == CACHE_FILLING || entry->state == CACHE_STALE)) {
+        entry->state = CACHE_FREE;
+    }
+
+    esp_amp_env_exit_critical();
+}
+
+void IRAM_ATTR esp_amp_rpc_cache_invalidate(esp_amp_rpc_cache_t *cache, uint16_t service_id)
+{
+    esp_amp_env_enter_critical();
+
+    for (int i = 0; i < ESP_AMP_RPC_CACHE_NUM; i++) {
+        esp_amp_rpc_cache_entry_t *entry = &cache->entries[i];
+        if (entry->state != CACHE_FREE && entry->service_id == service_id) {
+            esp_amp_rpc_cache_drop(entry);
+        }
+    }
+
+    esp_amp_env_exit_critical();
+}
+
+#endif /* CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM */
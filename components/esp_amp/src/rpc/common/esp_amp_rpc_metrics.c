@@ -0,0 +1,173 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+#include "string.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_rpc_metrics_priv.h"
+
+#if ESP_PLATFORM
+#include "esp_amp_log.h"
+#endif
+
+#if CONFIG_ESP_AMP_RPC_METRICS
+
+/* entry of service, taken on first call. must be called in critical section */
+static esp_amp_rpc_metrics_t *esp_amp_rpc_metrics_find(esp_amp_rpc_metrics_tbl_t *tbl, uint16_t service_id, bool take)
+{
+    for (int i = 0; i < tbl->num; i++) {
+        if (tbl->services[i].service_id == service_id) {
+            return &tbl->services[i];
+        }
+    }
+
+    if (!take || tbl->num == CONFIG_ESP_AMP_RPC_METRICS_SERVICE_NUM) {
+        return NULL;
+    }
+
+    esp_amp_rpc_metrics_t *metrics = &tbl->services[tbl->num++];
+    memset(metrics, 0, sizeof(esp_amp_rpc_metrics_t));
+    metrics->service_id = service_id;
+    return metrics;
+}
+
+void IRAM_ATTR esp_amp_rpc_metrics_add_time(esp_amp_rpc_metrics_tbl_t *tbl, uint16_t service_id, esp_amp_rpc_metrics_time_t which, uint32_t us)
+{
+    uint8_t idx = (us == 0) ? 0 : (32 - __builtin_clz(us));
+    if (idx >= ESP_AMP_RPC_METRICS_BUCKET_NUM) {
+        idx = ESP_AMP_RPC_METRICS_BUCKET_NUM - 1;
+    }
+
+    esp_amp_env_enter_critical();
+
+    esp_amp_rpc_metrics_t *metrics = esp_amp_rpc_metrics_find(tbl, service_id, true);
+    if (metrics == NULL) {
+        tbl->dropped++;
+    } else {
+        esp_amp_rpc_hist_t *hist = &metrics->time[which];
+        hist->count++;
+        hist->total_us += us;
+        hist->bucket[idx]++;
+        if (us > hist->max_us) {
+            hist->max_us = us;
+        }
+    }
+
+    esp_amp_env_exit_critical();
+}
+
+void IRAM_ATTR esp_amp_rpc_metrics_add_call(esp_amp_rpc_metrics_tbl_t *tbl, uint16_t service_id, esp_amp_rpc_status_t status)
+{
+    if ((unsigned)status >= ESP_AMP_RPC_METRICS_STATUS_NUM) {
+        status = ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    esp_amp_env_enter_critical();
+
+    esp_amp_rpc_metrics_t *metrics = esp_amp_rpc_metrics_find(tbl, service_id, true);
+    if (metrics == NULL) {
+        tbl->dropped++;
+    } else {
+        metrics->calls++;
+        metrics->status[status]++;
+    }
+
+    esp_amp_env_exit_critical();
+}
+
+int esp_amp_rpc_metrics_get(esp_amp_rpc_metrics_tbl_t *tbl, uint16_t service_id, esp_amp_rpc_metrics_t *metrics)
+{
+    int ret = -1;
+
+    esp_amp_env_enter_critical();
+
+    esp_amp_rpc_metrics_t *found = esp_amp_rpc_metrics_find(tbl, service_id, false);
+    if (found != NULL) {
+        memcpy(metrics, found, sizeof(esp_amp_rpc_metrics_t));
+        ret = 0;
+    }
+
+    esp_amp_env_exit_critical();
+    return ret;
+}
+
+int esp_amp_rpc_metrics_get_by_index(esp_amp_rpc_metrics_tbl_t *tbl, int idx, esp_amp_rpc_metrics_t *metrics)
+{
+    int ret = -1;
+
+    esp_amp_env_enter_critical();
+
+    if (idx >= 0 && idx < tbl->num) {
+        memcpy(metrics, &tbl->services[idx], sizeof(esp_amp_rpc_metrics_t));
+        ret = 0;
+    }
+
+    esp_amp_env_exit_critical();
+    return ret;
+}
+
+void esp_amp_rpc_metrics_reset(esp_amp_rpc_metrics_tbl_t *tbl)
+{
+    esp_amp_env_enter_critical();
+    tbl->num = 0;
+    tbl->dropped = 0;
+    esp_amp_env_exit_critical();
+}
+
+uint32_t esp_amp_rpc_metrics_percentile(const esp_amp_rpc_hist_t *hist, uint8_t percent)
+{
+    if (hist->count == 0 || percent == 0) {
+        return 0;
+    }
+    if (percent > 100) {
+        percent = 100;
+    }
+
+    // rank of the percentile sample, rounded up
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < ESP_AMP_RPC_METRICS_BUCKET_NUM - 1; i++) {
+        seen += hist->bucket[i];
+        if (seen >= rank) {
+            uint32_t upper = (i == 0) ? 0 : ((1UL << i) - 1);
+            return (upper < hist->max_us) ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+#if ESP_PLATFORM
+void esp_amp_rpc_metrics_dump(esp_amp_rpc_metrics_tbl_t *tbl, const char *tag)
+{
+    static const char *const time_names[ESP_AMP_RPC_METRICS_TIME_NUM] = { "queue", "exec", "latency" };
+    esp_amp_rpc_metrics_t metrics;
+
+    ESP_AMP_LOGI(tag, "=== rpc metrics (dropped %lu) ===", tbl->dropped);
+    for (int i = 0; esp_amp_rpc_metrics_get_by_index(tbl, i, &metrics) == 0; i++) {
+        uint32_t failed = metrics.calls - metrics.status[ESP_AMP_RPC_STATUS_OK] - metrics.status[ESP_AMP_RPC_STATUS_TIMEOUT]
+                          - metrics.status[ESP_AMP_RPC_STATUS_CANCELLED];
+        ESP_AMP_LOGI(tag, "srv(%u): calls=%lu ok=%lu timeout=%lu cancelled=%lu failed=%lu", metrics.service_id, metrics.calls,
+                     metrics.status[ESP_AMP_RPC_STATUS_OK], metrics.status[ESP_AMP_RPC_STATUS_TIMEOUT],
+                     metrics.status[ESP_AMP_RPC_STATUS_CANCELLED], failed);
+        for (int j = 0; j < ESP_AMP_RPC_METRICS_TIME_NUM; j++) {
+            const esp_amp_rpc_hist_t *hist = &metrics.time[j];
+            if (hist->count == 0) {
+                continue;
+            }
+            ESP_AMP_LOGI(tag, "  %s: n=%lu avg=%luus p50=%luus p99=%luus max=%luus", time_names[j], hist->count,
+                         (uint32_t)(hist->total_us / hist->count), esp_amp_rpc_metrics_percentile(hist, 50),
+                         esp_amp_rpc_metrics_percentile(hist, 99), hist->max_us);
+        }
+    }
+}
+#endif /* ESP_PLATFORM */
+
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
@@ -0,0 +1,86 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "esp_attr.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_rpc_pending_priv.h"
+
+/* largest generation keeping req id within ESP_AMP_RPC_REQ_ID_MAX */
+#define PENDING_GENERATION_MAX ((ESP_AMP_RPC_REQ_ID_MAX - (ESP_AMP_RPC_MAX_PENDING_REQ - 1)) / ESP_AMP_RPC_MAX_PENDING_REQ)
+
+_Static_assert(PENDING_GENERATION_MAX >= 2, "ESP_AMP_RPC_MAX_PENDING_REQ too large to tell stale responses apart");
+
+void esp_amp_rpc_pending_tbl_init(esp_amp_rpc_pending_tbl_t *tbl)
+{
+    esp_amp_env_enter_critical();
+
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        tbl->req_id[i] = ESP_AMP_RPC_INVALID_REQ_ID;
+        tbl->generation[i] = 0;
+        /* lower slots on top */
+        tbl->free_slots[i] = ESP_AMP_RPC_MAX_PENDING_REQ - 1 - i;
+    }
+    tbl->free_num = ESP_AMP_RPC_MAX_PENDING_REQ;
+
+    esp_amp_env_exit_critical();
+}
+
+uint16_t IRAM_ATTR esp_amp_rpc_pending_tbl_alloc(esp_amp_rpc_pending_tbl_t *tbl)
+{
+    uint16_t req_id = ESP_AMP_RPC_INVALID_REQ_ID;
+
+    esp_amp_env_enter_critical();
+
+    if (tbl->free_num > 0) {
+        uint16_t slot = tbl->free_slots[--tbl->free_num];
+        uint16_t generation = tbl->generation[slot] + 1;
+        if (generation > PENDING_GENERATION_MAX) { /* wrap around */
+            generation = 1;
+        }
+        tbl->generation[slot] = generation;
+        req_id = generation * ESP_AMP_RPC_MAX_PENDING_REQ + slot;
+        tbl->req_id[slot] = req_id;
+    }
+
+    esp_amp_env_exit_critical();
+
+    return req_id;
+}
+
+int IRAM_ATTR esp_amp_rpc_pending_tbl_find(esp_amp_rpc_pending_tbl_t *tbl, uint16_t req_id)
+{
+    int slot = req_id % ESP_AMP_RPC_MAX_PENDING_REQ;
+
+    /* a single 16-bit load, no lock needed */
+    if (req_id == ESP_AMP_RPC_INVALID_REQ_ID || tbl->req_id[slot] != req_id) {
+        return -1;
+    }
+    return slot;
+}
+
+int IRAM_ATTR esp_amp_rpc_pending_tbl_release(esp_amp_rpc_pending_tbl_t *tbl, uint16_t req_id)
+{
+    int slot = req_id % ESP_AMP_RPC_MAX_PENDING_REQ;
+
+    if (req_id == ESP_AMP_RPC_INVALID_REQ_ID) {
+        return -1;
+    }
+
+    esp_amp_env_enter_critical();
+
+    if (tbl->req_id[slot] != req_id) {
+        esp_amp_env_exit_critical();
+        return -1;
+    }
+    tbl->req_id[slot] = ESP_AMP_RPC_INVALID_REQ_ID;
+    tbl->free_slots[tbl->free_num++] = slot;
+
+    esp_amp_env_exit_critical();
+
+    return slot;
+}
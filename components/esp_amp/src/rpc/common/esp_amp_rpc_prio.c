@@ -0,0 +1,98 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "esp_attr.h"
+
+#include "esp_amp_rpc_prio_priv.h"
+
+void esp_amp_rpc_prio_q_init(esp_amp_rpc_prio_q_t *q, esp_amp_rpc_prio_link_t *links, uint16_t cap, uint32_t aging)
+{
+    q->links = links;
+    q->cap = cap;
+    q->num = 0;
+    q->aging = aging;
+    for (int i = 0; i < ESP_AMP_RPC_PRIORITY_NUM; i++) {
+        q->head[i] = ESP_AMP_RPC_PRIO_NONE;
+        q->tail[i] = ESP_AMP_RPC_PRIO_NONE;
+    }
+
+    /* chain all slots into free list */
+    for (uint16_t i = 0; i < cap; i++) {
+        links[i].next = (i + 1 < cap) ? i + 1 : ESP_AMP_RPC_PRIO_NONE;
+    }
+    q->free = cap > 0 ? 0 : ESP_AMP_RPC_PRIO_NONE;
+}
+
+int IRAM_ATTR esp_amp_rpc_prio_q_push(esp_amp_rpc_prio_q_t *q, uint8_t prio, uint32_t enq_time)
+{
+    uint16_t slot = q->free;
+    if (slot == ESP_AMP_RPC_PRIO_NONE) {
+        return -1;
+    }
+    if (prio > ESP_AMP_RPC_PRIORITY_MAX) {
+        prio = ESP_AMP_RPC_PRIORITY_MAX;
+    }
+
+    esp_amp_rpc_prio_link_t *link = &q->links[slot];
+    q->free = link->next;
+    link->next = ESP_AMP_RPC_PRIO_NONE;
+    link->prio = prio;
+    link->enq_time = enq_time;
+
+    if (q->tail[prio] == ESP_AMP_RPC_PRIO_NONE) {
+        q->head[prio] = slot;
+    } else {
+        q->links[q->tail[prio]].next = slot;
+    }
+    q->tail[prio] = slot;
+    q->num++;
+    return slot;
+}
+
+int IRAM_ATTR esp_amp_rpc_prio_q_pop(esp_amp_rpc_prio_q_t *q, uint32_t now)
+{
+    int best = -1;
+    uint32_t best_prio = 0;
+    uint32_t best_wait = 0;
+
+    /* the head of each level is its oldest request, hence the most promoted one of the level */
+    for (int i = ESP_AMP_RPC_PRIORITY_NUM - 1; i >= 0; i--) {
+        uint16_t slot = q->head[i];
+        if (slot == ESP_AMP_RPC_PRIO_NONE) {
+            continue;
+        }
+
+        uint32_t wait = now - q->links[slot].enq_time;
+        uint32_t prio = i;
+        if (q->aging != 0) {
+            uint32_t promoted = wait / q->aging;
+            prio = (promoted < ESP_AMP_RPC_PRIORITY_MAX - i) ? i + promoted : ESP_AMP_RPC_PRIORITY_MAX;
+        }
+
+        /* older one wins a tie, which lets promoted requests overtake at the highest level */
+        if (best == -1 || prio > best_prio || (prio == best_prio && wait > best_wait)) {
+            best = i;
+            best_prio = prio;
+            best_wait = wait;
+        }
+    }
+
+    if (best == -1) {
+        return -1;
+    }
+
+    uint16_t slot = q->head[best];
+    q->head[best] = q->links[slot].next;
+    if (q->head[best] == ESP_AMP_RPC_PRIO_NONE) {
+        q->tail[best] = ESP_AMP_RPC_PRIO_NONE;
+    }
+    q->links[slot].next = q->free;
+    q->free = slot;
+    q->num--;
+    return slot;
+}
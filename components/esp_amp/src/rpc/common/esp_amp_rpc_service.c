@@ -0,0 +1,84 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "esp_amp_rpc_service_priv.h"
+
+/* provided by linker script (subcore) or linker fragment (maincore) */
+extern esp_amp_rpc_service_t _esp_amp_rpc_service_start[];
+extern esp_amp_rpc_service_t _esp_amp_rpc_service_end[];
+
+static int esp_amp_rpc_service_static_num = -1;
+static bool esp_amp_rpc_service_static_dense;
+
+int esp_amp_rpc_service_static_init(void)
+{
+    if (esp_amp_rpc_service_static_num != -1) {
+        return esp_amp_rpc_service_static_num;
+    }
+
+    esp_amp_rpc_service_t *tbl = _esp_amp_rpc_service_start;
+    int num = _esp_amp_rpc_service_end - _esp_amp_rpc_service_start;
+
+    /* insertion sort: only a handful of entries, no extra memory */
+    for (int i = 1; i < num; i++) {
+        esp_amp_rpc_service_t srv = tbl[i];
+        int j = i - 1;
+        while (j >= 0 && tbl[j].id > srv.id) {
+            tbl[j + 1] = tbl[j];
+            j--;
+        }
+        tbl[j + 1] = srv;
+    }
+
+    /* duplicated ids also break contiguity, one of them is dispatched by binary search */
+    esp_amp_rpc_service_static_dense = true;
+    for (int i = 1; i < num; i++) {
+        if (tbl[i].id != tbl[0].id + i) {
+            esp_amp_rpc_service_static_dense = false;
+        }
+    }
+
+    esp_amp_rpc_service_static_num = num;
+    return num;
+}
+
+int esp_amp_rpc_service_static_find(esp_amp_rpc_service_id_t srv_id)
+{
+    esp_amp_rpc_service_t *tbl = _esp_amp_rpc_service_start;
+    int num = esp_amp_rpc_service_static_num;
+
+    if (num <= 0) {
+        return -1;
+    }
+
+    /* contiguous ids index the table directly */
+    if (esp_amp_rpc_service_static_dense) {
+        int idx = srv_id - tbl[0].id;
+        return (idx >= 0 && idx < num) ? idx : -1;
+    }
+
+    int lo = 0;
+    int hi = num - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (tbl[mid].id == srv_id) {
+            return mid;
+        }
+        if (tbl[mid].id < srv_id) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+esp_amp_rpc_service_t *esp_amp_rpc_service_static_get(int idx)
+{
+    return &_esp_amp_rpc_service_start[idx];
+}
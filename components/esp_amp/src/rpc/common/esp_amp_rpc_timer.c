@@ -0,0 +1,129 @@
+/*
+* SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+*
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "esp_attr.h"
+
+#include "esp_amp_env.h"
+#include "esp_amp_rpc_timer_priv.h"
+
+/* true if deadline a is earlier than b, tolerating wrap around of ms counter */
+#define TIMER_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+
+/* below helpers must be called in critical section */
+static void esp_amp_rpc_timer_place(esp_amp_rpc_timer_t *timer, uint16_t idx, uint16_t slot)
+{
+    timer->heap[idx] = slot;
+    timer->pos[slot] = idx;
+}
+
+static void esp_amp_rpc_timer_sift_up(esp_amp_rpc_timer_t *timer, uint16_t idx)
+{
+    uint16_t slot = timer->heap[idx];
+
+    while (idx > 0) {
+        uint16_t parent = (idx - 1) / 2;
+        if (!TIMER_BEFORE(timer->deadline[slot], timer->deadline[timer->heap[parent]])) {
+            break;
+        }
+        esp_amp_rpc_timer_place(timer, idx, timer->heap[parent]);
+        idx = parent;
+    }
+    esp_amp_rpc_timer_place(timer, idx, slot);
+}
+
+static void esp_amp_rpc_timer_sift_down(esp_amp_rpc_timer_t *timer, uint16_t idx)
+{
+    uint16_t slot = timer->heap[idx];
+
+    while (true) {
+        uint16_t child = idx * 2 + 1;
+        if (child >= timer->num) {
+            break;
+        }
+        if (child + 1 < timer->num && TIMER_BEFORE(timer->deadline[timer->heap[child + 1]], timer->deadline[timer->heap[child]])) {
+            child++;
+        }
+        if (!TIMER_BEFORE(timer->deadline[timer->heap[child]], timer->deadline[slot])) {
+            break;
+        }
+        esp_amp_rpc_timer_place(timer, idx, timer->heap[child]);
+        idx = child;
+    }
+    esp_amp_rpc_timer_place(timer, idx, slot);
+}
+
+static void esp_amp_rpc_timer_remove(esp_amp_rpc_timer_t *timer, uint16_t slot)
+{
+    uint16_t idx = timer->pos[slot];
+
+    timer->pos[slot] = ESP_AMP_RPC_TIMER_IDLE;
+    if (idx == --timer->num) {
+        return;
+    }
+
+    /* fill the hole with the last slot, which may belong either above or below */
+    uint16_t last = timer->heap[timer->num];
+    esp_amp_rpc_timer_place(timer, idx, last);
+    esp_amp_rpc_timer_sift_up(timer, idx);
+    if (timer->pos[last] == idx) {
+        esp_amp_rpc_timer_sift_down(timer, idx);
+    }
+}
+
+void esp_amp_rpc_timer_init(esp_amp_rpc_timer_t *timer)
+{
+    esp_amp_env_enter_critical();
+
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        timer->pos[i] = ESP_AMP_RPC_TIMER_IDLE;
+    }
+    timer->num = 0;
+
+    esp_amp_env_exit_critical();
+}
+
+void IRAM_ATTR esp_amp_rpc_timer_arm(esp_amp_rpc_timer_t *timer, uint16_t slot, uint32_t deadline_ms)
+{
+    esp_amp_env_enter_critical();
+
+    if (timer->pos[slot] != ESP_AMP_RPC_TIMER_IDLE) {
+        esp_amp_rpc_timer_remove(timer, slot);
+    }
+    timer->deadline[slot] = deadline_ms;
+    esp_amp_rpc_timer_place(timer, timer->num++, slot);
+    esp_amp_rpc_timer_sift_up(timer, timer->pos[slot]);
+
+    esp_amp_env_exit_critical();
+}
+
+void IRAM_ATTR esp_amp_rpc_timer_disarm(esp_amp_rpc_timer_t *timer, uint16_t slot)
+{
+    esp_amp_env_enter_critical();
+
+    if (timer->pos[slot] != ESP_AMP_RPC_TIMER_IDLE) {
+        esp_amp_rpc_timer_remove(timer, slot);
+    }
+
+    esp_amp_env_exit_critical();
+}
+
+int IRAM_ATTR esp_amp_rpc_timer_pop_expired(esp_amp_rpc_timer_t *timer, uint32_t now_ms)
+{
+    int slot = -1;
+
+    esp_amp_env_enter_critical();
+
+    if (timer->num > 0 && !TIMER_BEFORE(now_ms, timer->deadline[timer->heap[0]])) {
+        slot = timer->heap[0];
+        esp_amp_rpc_timer_remove(timer, slot);
+    }
+
+    esp_amp_env_exit_critical();
+
+    return slot;
+}
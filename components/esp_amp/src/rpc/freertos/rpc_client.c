@@ -6,7 +6,7 @@
 
 #include "stdint.h"
 #include "string.h"
-#include "limits.h"
+#include "stdbool.h"
 #include "stdatomic.h"
 
 #include "freertos/FreeRTOS.h"
@@ -15,36 +15,71 @@
 #include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 
+#include "esp_amp_env.h"
 #include "esp_amp_log.h"
+#include "esp_amp_platform.h"
 #include "esp_amp_rpmsg.h"
 #include "esp_amp_rpc.h"
+#include "esp_amp_rpc_pending_priv.h"
+#include "esp_amp_rpc_batch_priv.h"
+#include "esp_amp_rpc_metrics_priv.h"
+#include "esp_amp_rpc_cache_priv.h"
 
 #define CLIENT_EVENT_STOPPING ( 1 << 1 )
 #define CLIENT_EVENT_RECV_STOPPED ( 1 << 2 )
 #define CLIENT_EVENT_SEND_STOPPED (1 << 3)
 
-#define ESP_AMP_RPC_INVALID_REQ_ID 0
+#if CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND
+#define CLIENT_EVENT_ALL_STOPPED (CLIENT_EVENT_RECV_STOPPED)
+#else
+#define CLIENT_EVENT_ALL_STOPPED (CLIENT_EVENT_RECV_STOPPED | CLIENT_EVENT_SEND_STOPPED)
+#endif
 
 #define TAG "rpc_client"
 
+#define ESP_AMP_RPC_CLIENT_NOTIFY_INDEX CONFIG_ESP_AMP_RPC_CLIENT_NOTIFY_INDEX
+
+#if ESP_AMP_RPC_CLIENT_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES
+#error "CONFIG_ESP_AMP_RPC_CLIENT_NOTIFY_INDEX must be smaller than CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES"
+#endif
+#define ESP_AMP_RPC_CLIENT_INSTANCE_NUM CONFIG_ESP_AMP_RPC_CLIENT_INSTANCE_NUM
+#define ESP_AMP_RPC_CLIENT_CACHE_NUM CONFIG_ESP_AMP_RPC_CLIENT_CACHE_NUM
+
+typedef enum {
+    REQ_FREE,
+    REQ_CREATED,    /* pkt allocated, not sent yet */
+    REQ_WAITING,    /* pkt sent, caller waiting for response */
+    REQ_DONE,       /* rsp_pkt attached */
+    REQ_TIMEOUT,    /* caller gave up, late response is dropped */
+    REQ_CANCELLED,  /* cancelled by caller, late response is dropped */
+} esp_amp_rpc_req_state_t;
+
+typedef struct esp_amp_rpc_client_t esp_amp_rpc_client_t;
+
 typedef struct {
+    esp_amp_rpc_client_t *client; /* instance owning the req */
     uint16_t req_id; /* req_id & status still needed since pkt can be freed somewhere asynchronously */
     uint16_t service_id;
     uint16_t status; /* status can be updated by timer */
-    QueueHandle_t app_rsp_q;
-    esp_amp_rpc_pkt_t *pkt;
+    volatile uint8_t state; /* esp_amp_rpc_req_state_t, updated in critical section */
+    TaskHandle_t waiter; /* task notified on completion, NULL for async and submitted req */
+    esp_amp_rpc_req_async_cb_t cb; /* completion cb of async req, invoked by recv task */
+    void *cb_ctx;
+    TickType_t start_tick;
+    TickType_t timeout_tick;
+    uint32_t start_us; /* time of execute, for metrics */
+    esp_amp_rpc_pkt_t *pkt; /* request pkt, owned by server once sent. NULL if served from cache */
+    esp_amp_rpc_pkt_t *rsp_pkt; /* response pkt, released by destroy_request */
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    int cache_idx; /* cache entry held by the req, -1 if none */
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
 } esp_amp_rpc_pending_req_t;
 
 typedef struct {
-    esp_amp_rpc_pending_req_t *reqs[ESP_AMP_RPC_MAX_PENDING_REQ];
-    SemaphoreHandle_t mutex; /* lock for pending list */
+    esp_amp_rpc_pending_tbl_t tbl; /* req id allocation and lookup */
+    esp_amp_rpc_pending_req_t reqs[ESP_AMP_RPC_MAX_PENDING_REQ]; /* preallocated, indexed by slot of req id */
 } esp_amp_rpc_pending_list_t;
 
-typedef struct {
-    uint16_t val;
-    SemaphoreHandle_t mutex; /* lock for req id */
-} esp_amp_rpc_req_id_t;
-
 typedef enum {
     CLIENT_INVALID,
     CLIENT_READY,
@@ -52,7 +87,7 @@ typedef enum {
     CLIENT_STOPPED,
 } esp_amp_rpc_client_state_t;
 
-typedef struct {
+struct esp_amp_rpc_client_t {
     uint16_t server_addr;
     uint16_t client_addr;
     int task_priority;
@@ -60,141 +95,255 @@ typedef struct {
     esp_amp_rpmsg_dev_t *rpmsg_dev;
     esp_amp_rpmsg_ept_t rpmsg_ept;
     esp_amp_rpc_pending_list_t pending_list;
-    esp_amp_rpc_req_id_t req_id;
     QueueHandle_t app_req_q; /* queue for req pkt from app layer */
     QueueHandle_t rx_q; /* queue for rx pkt from transport layer */
     EventGroupHandle_t event;
     esp_amp_rpc_client_state_t state;
-} esp_amp_rpc_client_t;
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    esp_amp_rpc_cache_t cache; /* responses of idempotent services */
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
+};
 
-static esp_amp_rpc_client_t esp_amp_rpc_client;
+static esp_amp_rpc_client_t esp_amp_rpc_clients[ESP_AMP_RPC_CLIENT_INSTANCE_NUM];
+static esp_amp_rpc_client_t *esp_amp_rpc_client_default; /* instance of APIs without handle, created by esp_amp_rpc_client_init() */
 
+#if CONFIG_ESP_AMP_RPC_METRICS
+static esp_amp_rpc_metrics_tbl_t esp_amp_rpc_client_metrics; /* shared by all instances */
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
 
-__attribute__((__unused__)) static void esp_amp_rpc_pending_list_squeeze(void)
-{
-    xSemaphoreTakeRecursive(esp_amp_rpc_client.pending_list.mutex, portMAX_DELAY);
 
-    int next_avail = -1;
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        /* find empty slot */
-        if (esp_amp_rpc_client.pending_list.reqs[i] == NULL) {
-            if (next_avail == -1) {
-                next_avail = i;    /* find an empty slot and point to it by next_avail */
-            }
-        }
-        /* squeeze the filled slots */
-        else {
-            if (next_avail != -1) {
-                /* copy the filled slot to the empty one */
-                esp_amp_rpc_client.pending_list.reqs[next_avail] = esp_amp_rpc_client.pending_list.reqs[i];
-                /* set reqs[i] as empty slot */
-                esp_amp_rpc_client.pending_list.reqs[i] = NULL;
-                /* proceed to next slot */
-                next_avail++;
-            }
-        }
+static esp_amp_rpc_pending_req_t *esp_amp_rpc_pending_list_push(esp_amp_rpc_client_t *client)
+{
+    uint16_t req_id = esp_amp_rpc_pending_tbl_alloc(&client->pending_list.tbl);
+    if (req_id == ESP_AMP_RPC_INVALID_REQ_ID) {
+        return NULL;
     }
 
-    xSemaphoreGiveRecursive(esp_amp_rpc_client.pending_list.mutex);
+    esp_amp_rpc_pending_req_t *req = &client->pending_list.reqs[req_id % ESP_AMP_RPC_MAX_PENDING_REQ];
+    req->req_id = req_id;
+    req->state = REQ_CREATED;
+    req->waiter = NULL;
+    req->cb = NULL;
+    req->cb_ctx = NULL;
+    req->pkt = NULL;
+    req->rsp_pkt = NULL;
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    req->cache_idx = -1;
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
+    return req;
 }
 
-static int esp_amp_rpc_pending_list_push(esp_amp_rpc_pending_req_t *req)
+static void esp_amp_rpc_pending_list_pop(esp_amp_rpc_pending_req_t *req)
 {
-    int ret = -1;
-    xSemaphoreTakeRecursive(esp_amp_rpc_client.pending_list.mutex, portMAX_DELAY);
-
-    // esp_amp_rpc_pending_list_squeeze();
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        if (esp_amp_rpc_client.pending_list.reqs[i] == NULL) {
-            /* copy the filled slot to the empty one */
-            esp_amp_rpc_client.pending_list.reqs[i] = req;
-            ret = 0;
-            break;
-        }
+    esp_amp_env_enter_critical();
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    if (req->state != REQ_FREE && req->cache_idx != -1) {
+        esp_amp_rpc_cache_release(&req->client->cache, req->cache_idx);
     }
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
+    esp_amp_rpc_pending_tbl_release(&req->client->pending_list.tbl, req->req_id);
+    req->state = REQ_FREE;
+    esp_amp_env_exit_critical();
+}
 
-    xSemaphoreGiveRecursive(esp_amp_rpc_client.pending_list.mutex);
-    return ret;
+/* req served from cache is never sent */
+static bool esp_amp_rpc_pending_req_cached(esp_amp_rpc_pending_req_t *req)
+{
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    return req->cache_idx != -1 && req->pkt == NULL;
+#else
+    return false;
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
 }
 
-static int esp_amp_rpc_pending_list_pop(uint32_t req_id, esp_amp_rpc_pending_req_t **req_out)
+/* result of a completed req, forwarded from its rsp pkt or cache entry without copy */
+static esp_amp_rpc_status_t esp_amp_rpc_pending_req_result(esp_amp_rpc_pending_req_t *req, void **param_out, int *param_out_len)
 {
-    xSemaphoreTakeRecursive(esp_amp_rpc_client.pending_list.mutex, portMAX_DELAY);
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    if (req->rsp_pkt == NULL) {
+        uint16_t rsp_len = 0;
+        *param_out = (void *)esp_amp_rpc_cache_get_rsp(&req->client->cache, req->cache_idx, &rsp_len);
+        *param_out_len = rsp_len;
+        return ESP_AMP_RPC_STATUS_OK;
+    }
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
+    *param_out = req->rsp_pkt->params;
+    *param_out_len = req->rsp_pkt->params_len;
+    return req->rsp_pkt->status;
+}
 
-    int ret = -1;
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        esp_amp_rpc_pending_req_t *req = esp_amp_rpc_client.pending_list.reqs[i];
-        if (req && req->req_id == req_id) {
-            /* copy to req_out */
-            if (req_out != NULL) {
-                *req_out = esp_amp_rpc_client.pending_list.reqs[i];
-            }
-            /* set to empty slot */
-            esp_amp_rpc_client.pending_list.reqs[i] = NULL;
-            ret = 0;
-            break;
-        }
+/* must be called in critical section, otherwise the slot may be reused before caller accesses it */
+static esp_amp_rpc_pending_req_t *esp_amp_rpc_pending_list_peek(esp_amp_rpc_client_t *client, uint16_t req_id)
+{
+    int slot = esp_amp_rpc_pending_tbl_find(&client->pending_list.tbl, req_id);
+    if (slot == -1) {
+        return NULL;
     }
+    return &client->pending_list.reqs[slot];
+}
 
-    xSemaphoreGiveRecursive(esp_amp_rpc_client.pending_list.mutex);
-    return ret;
+/* req handle must point into pending list of an instance */
+static bool esp_amp_rpc_pending_req_valid(esp_amp_rpc_pending_req_t *req)
+{
+    for (int i = 0; i < ESP_AMP_RPC_CLIENT_INSTANCE_NUM; i++) {
+        esp_amp_rpc_pending_req_t *reqs = esp_amp_rpc_clients[i].pending_list.reqs;
+        if (req >= &reqs[0] && req < &reqs[ESP_AMP_RPC_MAX_PENDING_REQ]) {
+            return req->state != REQ_FREE;
+        }
+    }
+    return false;
 }
 
-static int esp_amp_rpc_pending_list_peek(uint32_t req_id, esp_amp_rpc_pending_req_t **req_out)
+static bool esp_amp_rpc_client_valid(esp_amp_rpc_client_t *client)
 {
-    xSemaphoreTakeRecursive(esp_amp_rpc_client.pending_list.mutex, portMAX_DELAY);
+    return client != NULL && client->state != CLIENT_INVALID;
+}
 
-    int ret = -1;
+static void esp_amp_rpc_pending_list_dump(esp_amp_rpc_client_t *client)
+{
+    ESP_AMP_LOGD(TAG, "=== pending list ===");
     for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        esp_amp_rpc_pending_req_t *req = esp_amp_rpc_client.pending_list.reqs[i];
-        if (req && req->req_id == req_id) {
-            /* copy to req_out */
-            if (req_out != NULL) {
-                *req_out = esp_amp_rpc_client.pending_list.reqs[i];
-            }
-            ret = 0;
-            break;
+        uint16_t req_id = client->pending_list.tbl.req_id[i];
+        if (req_id != ESP_AMP_RPC_INVALID_REQ_ID) {
+            ESP_AMP_LOGD(TAG, "%d\t%d", i, req_id);
         }
     }
-
-    xSemaphoreGiveRecursive(esp_amp_rpc_client.pending_list.mutex);
-    return ret;
+    ESP_AMP_LOGD(TAG, "====================");
 }
 
-static void esp_amp_rpc_pending_list_dump(void)
+/**
+ * attach incoming rsp to its pending req and wake up the waiter
+ * async req is completed only in task context since its cb may block
+ * stream chunk is handed to cb of async req without completing it. sync or polled req cannot take chunks, it is
+ * completed by the first one with status ESP_AMP_RPC_STATUS_STREAM, and the rest of the stream is dropped
+ *
+ * @retval 0 rsp consumed
+ * @retval 1 rsp belongs to async req, must be completed by recv task
+ * @retval -1 rsp belongs to no pending req, should be dropped
+ */
+static int esp_amp_rpc_client_complete_rsp(esp_amp_rpc_client_t *client, esp_amp_rpc_pkt_t *pkt_in, bool in_isr, BaseType_t *need_yield)
 {
-    int list[ESP_AMP_RPC_MAX_PENDING_REQ];
-    ESP_AMP_LOGD(TAG, "=== pending list ===");
-    xSemaphoreTakeRecursive(esp_amp_rpc_client.pending_list.mutex, portMAX_DELAY);
+    int ret = -1;
+    TaskHandle_t waiter = NULL;
+    esp_amp_rpc_req_async_cb_t cb = NULL;
+    void *cb_ctx = NULL;
+    bool stream = pkt_in->status == ESP_AMP_RPC_STATUS_STREAM;
+    bool done = false;
+    uint16_t service_id = 0;
+    uint32_t start_us = 0;
+
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    /**
+     * fill cache entry of the req before the pkt is attached to it, so that nobody else can destroy the pkt while
+     * response is copied outside of critical section. entry is held meanwhile, req may be destroyed at any time
+     */
+    if (!stream && pkt_in->status == ESP_AMP_RPC_STATUS_OK) {
+        int cache_idx = -1;
+        esp_amp_env_enter_critical();
+        esp_amp_rpc_pending_req_t *req = esp_amp_rpc_pending_list_peek(client, pkt_in->req_id);
+        if (req && req->state == REQ_WAITING && req->cache_idx != -1 && !(in_isr && req->cb)) {
+            cache_idx = req->cache_idx;
+            esp_amp_rpc_cache_hold(&client->cache, cache_idx);
+        }
+        esp_amp_env_exit_critical();
 
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        if (esp_amp_rpc_client.pending_list.reqs[i] == NULL) {
-            list[i] = 0;
+        if (cache_idx != -1) {
+            esp_amp_rpc_cache_fill(&client->cache, cache_idx, pkt_in->params, pkt_in->params_len, esp_amp_platform_get_time_ms());
+            esp_amp_rpc_cache_release(&client->cache, cache_idx);
+        }
+    }
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
+
+    /* destroyed or timeout req will not take the pkt */
+    esp_amp_env_enter_critical();
+    esp_amp_rpc_pending_req_t *pending_req = esp_amp_rpc_pending_list_peek(client, pkt_in->req_id);
+    if (pending_req && pending_req->state == REQ_WAITING) {
+        if (in_isr && pending_req->cb) {
+            ret = 1;
+        } else if (stream && pending_req->cb) {
+            /* each chunk restarts the timeout, stream is completed by the final rsp */
+            pending_req->start_tick = xTaskGetTickCount();
+            cb = pending_req->cb;
+            cb_ctx = pending_req->cb_ctx;
+            ret = 0;
         } else {
-            list[i] = esp_amp_rpc_client.pending_list.reqs[i]->req_id;
+            pending_req->rsp_pkt = pkt_in;
+            pending_req->state = REQ_DONE;
+            done = true;
+            service_id = pending_req->service_id;
+            start_us = pending_req->start_us;
+            ret = 0;
+            /* sync req may be destroyed by its caller as soon as leaving critical section */
+            waiter = pending_req->waiter;
+            cb = pending_req->cb;
+            cb_ctx = pending_req->cb_ctx;
         }
     }
-    xSemaphoreGiveRecursive(esp_amp_rpc_client.pending_list.mutex);
+    esp_amp_env_exit_critical();
 
-    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        ESP_AMP_LOGD(TAG, "%d\t%d", i, list[i]);
+    if (done) {
+        ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_client_metrics, service_id, ESP_AMP_RPC_METRICS_LATENCY, ESP_AMP_RPC_METRICS_NOW() - start_us);
+        ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_client_metrics, service_id, pkt_in->status);
     }
-    ESP_AMP_LOGD(TAG, "====================");
+
+    if (cb) {
+        /* async req: params are only valid in cb */
+        cb(pkt_in->status, pkt_in->params, pkt_in->params_len, cb_ctx);
+        if (!stream) {
+            esp_amp_rpc_pending_list_pop(pending_req);
+        }
+        esp_amp_rpmsg_destroy(client->rpmsg_dev, pkt_in);
+    } else if (waiter) {
+        /* wake up caller without copy */
+        if (in_isr) {
+            vTaskNotifyGiveIndexedFromISR(waiter, ESP_AMP_RPC_CLIENT_NOTIFY_INDEX, need_yield);
+        } else {
+            xTaskNotifyGiveIndexed(waiter, ESP_AMP_RPC_CLIENT_NOTIFY_INDEX);
+        }
+    }
+    return ret;
 }
 
 static int esp_amp_rpc_client_isr(void *pkt_in_buf, uint16_t pkt_in_size, uint16_t src_addr, void* rx_cb_data)
 {
+    esp_amp_rpc_client_t *client = (esp_amp_rpc_client_t *)rx_cb_data;
     BaseType_t need_yield = 0;
 
     if (pkt_in_size < sizeof(esp_amp_rpc_pkt_t)) {
         ESP_AMP_DRAM_LOGE(TAG, "incomplete pkt");
-        esp_amp_rpmsg_destroy(esp_amp_rpc_client.rpmsg_dev, pkt_in_buf);
+        esp_amp_rpmsg_destroy(client->rpmsg_dev, pkt_in_buf);
         return 0;
     }
 
     esp_amp_rpc_pkt_t *pkt_in = (esp_amp_rpc_pkt_t *)pkt_in_buf;
-    if (xQueueSendFromISR(esp_amp_rpc_client.rx_q, &pkt_in, &need_yield) != pdTRUE) {
-        esp_amp_rpmsg_destroy(esp_amp_rpc_client.rpmsg_dev, pkt_in_buf);
+
+    /* cache invalidation pushed by server, no pending req involved */
+    if (pkt_in->req_id == ESP_AMP_RPC_NOTIFY_REQ_ID && pkt_in->service_id == ESP_AMP_RPC_INVALIDATE_SERVICE_ID) {
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+        if (pkt_in->params_len >= sizeof(uint16_t)) {
+            uint16_t service_id;
+            memcpy(&service_id, pkt_in->params, sizeof(uint16_t));
+            esp_amp_rpc_cache_invalidate(&client->cache, service_id);
+        }
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
+        esp_amp_rpmsg_destroy(client->rpmsg_dev, pkt_in_buf);
+        return 0;
+    }
+
+#if CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND
+    /* complete sync and submitted req here, saving a hop through recv task */
+    int ret = esp_amp_rpc_client_complete_rsp(client, pkt_in, true, &need_yield);
+    if (ret == -1) {
+        esp_amp_rpmsg_destroy(client->rpmsg_dev, pkt_in_buf);
+    }
+    if (ret != 1) {
+        portYIELD_FROM_ISR(need_yield);
+        return 0;
+    }
+#endif /* CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND */
+
+    if (xQueueSendFromISR(client->rx_q, &pkt_in, &need_yield) != pdTRUE) {
+        esp_amp_rpmsg_destroy(client->rpmsg_dev, pkt_in_buf);
         ESP_AMP_DRAM_LOGE(TAG, "rx_q full. drop pkt(%u)", pkt_in->req_id);
     }
 
@@ -202,346 +351,735 @@ static int esp_amp_rpc_client_isr(void *pkt_in_buf, uint16_t pkt_in_size, uint16
     return 0;
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_client_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr, int task_priority, int stack_size)
+/* release resources of an instance and return it to the pool */
+static void esp_amp_rpc_client_release(esp_amp_rpc_client_t *client)
+{
+    if (client->rpmsg_dev) {
+        esp_amp_rpmsg_delete_endpoint(client->rpmsg_dev, client->client_addr);
+        client->rpmsg_dev = NULL;
+    }
+    if (client->rx_q) {
+        vQueueDelete(client->rx_q);
+        client->rx_q = NULL;
+    }
+    if (client->app_req_q) {
+        vQueueDelete(client->app_req_q);
+        client->app_req_q = NULL;
+    }
+    if (client->event) {
+        vEventGroupDelete(client->event);
+        client->event = NULL;
+    }
+    client->state = CLIENT_INVALID;
+}
+
+esp_amp_rpc_client_handle_t esp_amp_rpc_client_inst_create(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr, int task_priority, int stack_size)
 {
     if (!rpmsg_dev) {
         ESP_AMP_LOGE(TAG, "Invalid rpmsg_dev");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        return NULL;
     }
 
-    if (esp_amp_rpc_client.state >= CLIENT_READY) {
-        ESP_AMP_LOGE(TAG, "RPC client aleady initialized");
-        return ESP_AMP_RPC_STATUS_FAILED;
+    /* take a free instance */
+    esp_amp_rpc_client_t *client = NULL;
+    esp_amp_env_enter_critical();
+    for (int i = 0; i < ESP_AMP_RPC_CLIENT_INSTANCE_NUM; i++) {
+        if (esp_amp_rpc_clients[i].state == CLIENT_INVALID) {
+            client = &esp_amp_rpc_clients[i];
+            client->state = CLIENT_READY;
+            break;
+        }
     }
+    esp_amp_env_exit_critical();
 
-    esp_amp_rpc_client.task_priority = task_priority <= 0 ? 5 : task_priority;
-    esp_amp_rpc_client.stack_size = stack_size <= 0 ? 2048 : stack_size;
+    if (client == NULL) {
+        ESP_AMP_LOGE(TAG, "No free RPC client instance");
+        return NULL;
+    }
 
-    esp_amp_rpc_client.rpmsg_dev = rpmsg_dev;
-    esp_amp_rpc_client.client_addr = client_addr;
-    esp_amp_rpc_client.server_addr = server_addr;
+    client->task_priority = task_priority <= 0 ? 5 : task_priority;
+    client->stack_size = stack_size <= 0 ? 2048 : stack_size;
 
-    /* init rpmsg endpoint */
-    if (esp_amp_rpmsg_create_endpoint(esp_amp_rpc_client.rpmsg_dev, client_addr, esp_amp_rpc_client_isr, NULL, &esp_amp_rpc_client.rpmsg_ept) == NULL) {
-        ESP_AMP_LOGE(TAG, "Failed to create ept");
-        return ESP_AMP_RPC_STATUS_FAILED;
-    }
+    client->client_addr = client_addr;
+    client->server_addr = server_addr;
 
     /* init the pending list */
-    esp_amp_rpc_client.pending_list.mutex = xSemaphoreCreateRecursiveMutex();
-    if (!esp_amp_rpc_client.pending_list.mutex) {
-        ESP_AMP_LOGE(TAG, "Failed to create pending list mutex");
-        return ESP_AMP_RPC_STATUS_FAILED;
-    }
-
+    esp_amp_rpc_pending_tbl_init(&client->pending_list.tbl);
+    memset(client->pending_list.reqs, 0, sizeof(client->pending_list.reqs));
     for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
-        esp_amp_rpc_client.pending_list.reqs[i] = NULL;
-    }
-
-    /* init the req id */
-    esp_amp_rpc_client.req_id.mutex = xSemaphoreCreateRecursiveMutex();
-    if (!esp_amp_rpc_client.req_id.mutex) {
-        ESP_AMP_LOGE(TAG, "Failed to create req id mutex");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        client->pending_list.reqs[i].client = client;
     }
-    esp_amp_rpc_client.req_id.val = 1;
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    esp_amp_rpc_cache_init(&client->cache);
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
 
+#if !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND
     /* request queue to accept pkt from user app */
-    esp_amp_rpc_client.app_req_q = xQueueCreate(ESP_AMP_RPC_MAX_PENDING_REQ, sizeof(esp_amp_rpc_pending_req_t *));
-    if (!esp_amp_rpc_client.app_req_q) {
-        return ESP_AMP_RPC_STATUS_FAILED;
+    client->app_req_q = xQueueCreate(ESP_AMP_RPC_MAX_PENDING_REQ, sizeof(esp_amp_rpc_pending_req_t *));
+    if (!client->app_req_q) {
+        esp_amp_rpc_client_release(client);
+        return NULL;
     }
+#endif /* !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND */
 
     /* response queue to recv pkt from server */
-    esp_amp_rpc_client.rx_q = xQueueCreate(ESP_AMP_RPC_MAX_PENDING_REQ, sizeof(esp_amp_rpc_pkt_t *));
-    if (!esp_amp_rpc_client.rx_q) {
-        return ESP_AMP_RPC_STATUS_FAILED;
+    client->rx_q = xQueueCreate(ESP_AMP_RPC_MAX_PENDING_REQ, sizeof(esp_amp_rpc_pkt_t *));
+    if (!client->rx_q) {
+        esp_amp_rpc_client_release(client);
+        return NULL;
     }
 
     /* create event */
-    esp_amp_rpc_client.event = xEventGroupCreate();
-    if (!esp_amp_rpc_client.event) {
+    client->event = xEventGroupCreate();
+    if (!client->event) {
+        esp_amp_rpc_client_release(client);
+        return NULL;
+    }
+
+    /* init rpmsg endpoint last, rsp may arrive as soon as it is created */
+    client->rpmsg_dev = rpmsg_dev;
+    if (esp_amp_rpmsg_create_endpoint(rpmsg_dev, client_addr, esp_amp_rpc_client_isr, client, &client->rpmsg_ept) == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to create ept");
+        client->rpmsg_dev = NULL; /* endpoint address may belong to others, do not delete it */
+        esp_amp_rpc_client_release(client);
+        return NULL;
+    }
+
+    return client;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr, int task_priority, int stack_size)
+{
+    if (esp_amp_rpc_client_default != NULL) {
+        ESP_AMP_LOGE(TAG, "RPC client aleady initialized");
         return ESP_AMP_RPC_STATUS_FAILED;
     }
 
-    esp_amp_rpc_client.state = CLIENT_READY;
-    return ESP_AMP_RPC_STATUS_OK;
+    esp_amp_rpc_client_default = esp_amp_rpc_client_inst_create(rpmsg_dev, client_addr, server_addr, task_priority, stack_size);
+    return esp_amp_rpc_client_default ? ESP_AMP_RPC_STATUS_OK : ESP_AMP_RPC_STATUS_FAILED;
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_client_stop(void)
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_stop(esp_amp_rpc_client_handle_t client)
 {
-    if (esp_amp_rpc_client.state == CLIENT_STOPPED) {
+    if (!esp_amp_rpc_client_valid(client)) {
+        ESP_AMP_LOGE(TAG, "Invalid client");
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    if (client->state == CLIENT_STOPPED) {
         return ESP_AMP_RPC_STATUS_OK;
     }
 
-    if (esp_amp_rpc_client.state != CLIENT_RUNNING) {
+    if (client->state != CLIENT_RUNNING) {
         ESP_AMP_LOGE(TAG, "Trying to stop a client not running");
         return ESP_AMP_RPC_STATUS_FAILED;
     }
 
     esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_OK;
-    xEventGroupSetBits(esp_amp_rpc_client.event, CLIENT_EVENT_STOPPING);
-    EventBits_t event = xEventGroupWaitBits(esp_amp_rpc_client.event, (CLIENT_EVENT_RECV_STOPPED | CLIENT_EVENT_SEND_STOPPED), false, true, portMAX_DELAY);
+    xEventGroupSetBits(client->event, CLIENT_EVENT_STOPPING);
+    EventBits_t event = xEventGroupWaitBits(client->event, CLIENT_EVENT_ALL_STOPPED, false, true, portMAX_DELAY);
 
-    if ((event & (CLIENT_EVENT_SEND_STOPPED | CLIENT_EVENT_RECV_STOPPED)) != (CLIENT_EVENT_SEND_STOPPED | CLIENT_EVENT_RECV_STOPPED)) {
+    if ((event & CLIENT_EVENT_ALL_STOPPED) != CLIENT_EVENT_ALL_STOPPED) {
         ret = ESP_AMP_RPC_STATUS_FAILED;
     }
 
     if (ret == ESP_AMP_RPC_STATUS_OK) {
-        esp_amp_rpc_client.state = CLIENT_STOPPED;
+        client->state = CLIENT_STOPPED;
     }
 
-    xEventGroupClearBits(esp_amp_rpc_client.event, (CLIENT_EVENT_STOPPING | CLIENT_EVENT_SEND_STOPPED | CLIENT_EVENT_RECV_STOPPED));
+    xEventGroupClearBits(client->event, (CLIENT_EVENT_STOPPING | CLIENT_EVENT_SEND_STOPPED | CLIENT_EVENT_RECV_STOPPED));
     return ret;
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_client_deinit(void)
+esp_amp_rpc_status_t esp_amp_rpc_client_stop(void)
 {
-    esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_OK;
-    if (esp_amp_rpc_client.state == CLIENT_RUNNING) {
-        ret = esp_amp_rpc_client_stop();
+    return esp_amp_rpc_client_inst_stop(esp_amp_rpc_client_default);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_delete(esp_amp_rpc_client_handle_t client)
+{
+    if (!esp_amp_rpc_client_valid(client)) {
+        return ESP_AMP_RPC_STATUS_OK;
     }
 
-    if (ret == ESP_AMP_RPC_STATUS_OK) {
-        if (esp_amp_rpc_client.rpmsg_dev) {
-            esp_amp_rpmsg_delete_endpoint(esp_amp_rpc_client.rpmsg_dev, esp_amp_rpc_client.client_addr);
-            esp_amp_rpc_client.rpmsg_dev = NULL;
-        }
-        if (esp_amp_rpc_client.pending_list.mutex) {
-            vSemaphoreDelete(esp_amp_rpc_client.pending_list.mutex);
-            esp_amp_rpc_client.pending_list.mutex = NULL;
-        }
-        if (esp_amp_rpc_client.rx_q) {
-            vQueueDelete(esp_amp_rpc_client.rx_q);
-            esp_amp_rpc_client.rx_q = NULL;
-        }
-        if (esp_amp_rpc_client.app_req_q) {
-            vQueueDelete(esp_amp_rpc_client.app_req_q);
-            esp_amp_rpc_client.app_req_q = NULL;
-        }
-        if (esp_amp_rpc_client.req_id.mutex) {
-            vSemaphoreDelete(esp_amp_rpc_client.req_id.mutex);
-            esp_amp_rpc_client.req_id.mutex = NULL;
-        }
-        if (esp_amp_rpc_client.event) {
-            vEventGroupDelete(esp_amp_rpc_client.event);
-            esp_amp_rpc_client.event = NULL;
-        }
+    if (client->state == CLIENT_RUNNING && esp_amp_rpc_client_inst_stop(client) != ESP_AMP_RPC_STATUS_OK) {
+        ESP_AMP_LOGE(TAG, "Failed to stop client");
     }
 
-    esp_amp_rpc_client.state = CLIENT_INVALID;
+    esp_amp_rpc_client_release(client);
     return ESP_AMP_RPC_STATUS_OK;
 }
 
-static uint16_t esp_amp_rpc_get_req_id(void)
+esp_amp_rpc_status_t esp_amp_rpc_client_deinit(void)
 {
-    uint16_t req_id = 0;
-    xSemaphoreTakeRecursive(esp_amp_rpc_client.req_id.mutex, portMAX_DELAY);
-    if (esp_amp_rpc_client.req_id.val == SHRT_MAX) { /* wrap around */
-        esp_amp_rpc_client.req_id.val = 1;
-    }
-    req_id = esp_amp_rpc_client.req_id.val;
-    esp_amp_rpc_client.req_id.val += 1;
-    xSemaphoreGiveRecursive(esp_amp_rpc_client.req_id.mutex);
-    return req_id;
+    esp_amp_rpc_status_t ret = esp_amp_rpc_client_inst_delete(esp_amp_rpc_client_default);
+    esp_amp_rpc_client_default = NULL;
+    return ret;
 }
 
-esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id, void *params, uint16_t params_len)
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_inst_create_request(esp_amp_rpc_client_handle_t client, uint16_t service_id, void *params, uint16_t params_len)
 {
-    QueueHandle_t rsp_q = xQueueCreate(1, sizeof(esp_amp_rpc_pkt_t *));
-    if (rsp_q == NULL) {
-        ESP_AMP_LOGE(TAG, "Failed to create rsp_q");
+    if (!esp_amp_rpc_client_valid(client)) {
+        ESP_AMP_LOGE(TAG, "Invalid client");
         return NULL;
     }
 
-    /* construct the pending req */
-    esp_amp_rpc_pending_req_t *pending_req = malloc(sizeof(esp_amp_rpc_pending_req_t));
+    /* take a preallocated pending req, no heap operation on request path */
+    esp_amp_rpc_pending_req_t *pending_req = esp_amp_rpc_pending_list_push(client);
     if (pending_req == NULL) {
-        ESP_AMP_LOGE(TAG, "Failed to create pending req");
+        ESP_AMP_LOGE(TAG, "Failed to push to pending list");
         return NULL;
     }
 
     pending_req->status = ESP_AMP_RPC_STATUS_PENDING;
-    pending_req->app_rsp_q = rsp_q;
-    pending_req->req_id = esp_amp_rpc_get_req_id();
     pending_req->service_id = service_id;
 
-    if (esp_amp_rpc_pending_list_push(pending_req) == -1) {
-        ESP_AMP_LOGE(TAG, "Failed to push to pending list");
-        free(pending_req);
-        return NULL;
-    }
+    esp_amp_rpc_pending_list_dump(client);
 
-    esp_amp_rpc_pending_list_dump();
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+    /* hit is decided here, so that no msg buf is taken for a req which is never sent */
+    bool hit = false;
+    pending_req->cache_idx = esp_amp_rpc_cache_acquire(&client->cache, service_id, params, params_len, esp_amp_platform_get_time_ms(), &hit);
+    if (hit) {
+        ESP_AMP_LOGD(TAG, "req(%u, %u) served from cache", pending_req->req_id, service_id);
+        return pending_req;
+    }
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
 
-    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(esp_amp_rpc_client.rpmsg_dev, sizeof(esp_amp_rpc_pkt_t) + params_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(client->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t) + params_len, ESP_AMP_RPMSG_DATA_DEFAULT);
     if (pkt_out == NULL) {
         ESP_AMP_LOGE(TAG, "Failed to alloc msg buf");
-        free(pending_req);
+        esp_amp_rpc_pending_list_pop(pending_req);
         return NULL;
     }
 
-    memcpy(pkt_out->params, params, params_len);
+    if (params != NULL) {
+        memcpy(pkt_out->params, params, params_len);
+    }
     pkt_out->params_len = params_len;
     pkt_out->req_id = pending_req->req_id;
     pkt_out->service_id = service_id;
     pkt_out->status = ESP_AMP_RPC_STATUS_PENDING;
+    pkt_out->priority = ESP_AMP_RPC_PRIORITY_NORMAL;
+    pkt_out->timeout_ms = 0; /* set when sent */
 
     /* attach to pending_req */
     pending_req->pkt = pkt_out;
     return pending_req;
 }
 
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_request(uint16_t service_id, void *params, uint16_t params_len)
+{
+    return esp_amp_rpc_client_inst_create_request(esp_amp_rpc_client_default, service_id, params, params_len);
+}
+
+static TickType_t esp_amp_rpc_client_timeout_tick(uint32_t timeout_ms)
+{
+    if (timeout_ms == -1) {
+        return portMAX_DELAY;
+    }
+    return pdMS_TO_TICKS(timeout_ms);
+}
+
+static bool esp_amp_rpc_pending_req_expired(esp_amp_rpc_pending_req_t *req, TickType_t now)
+{
+    return req->timeout_tick != portMAX_DELAY && now - req->start_tick >= req->timeout_tick;
+}
+
+/* remaining time of req to be carried in its pkt, server drops the req once it expires */
+static uint32_t esp_amp_rpc_client_remaining_ms(esp_amp_rpc_pending_req_t *req)
+{
+    if (req->timeout_tick == portMAX_DELAY) {
+        return 0;
+    }
+    TickType_t elapsed = xTaskGetTickCount() - req->start_tick;
+    uint32_t remaining_ms = elapsed < req->timeout_tick ? pdTICKS_TO_MS(req->timeout_tick - elapsed) : 0;
+    return remaining_ms == 0 ? 1 : remaining_ms; /* 0 means no deadline */
+}
+
+static void esp_amp_rpc_client_send_pkt(esp_amp_rpc_pending_req_t *pending_req)
+{
+    esp_amp_rpc_client_t *client = pending_req->client;
+
+    /* time spent in app_req_q is deducted */
+    pending_req->pkt->timeout_ms = esp_amp_rpc_client_remaining_ms(pending_req);
+    ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_client_metrics, pending_req->service_id, ESP_AMP_RPC_METRICS_QUEUE,
+                             ESP_AMP_RPC_METRICS_NOW() - pending_req->start_us);
+
+    ESP_AMP_LOGD(TAG, "Executing(req_id:%u, srv_id:%u, param(%u):%p",
+                 pending_req->pkt->req_id, pending_req->pkt->service_id,
+                 pending_req->pkt->params_len, pending_req->pkt->params);
+    ESP_AMP_LOGD(TAG, "client(%u) send req(pkt=%p, req_id=%u) to server(%u)", client->rpmsg_ept.addr,
+                 pending_req->pkt, pending_req->pkt->req_id, client->server_addr);
+    ESP_AMP_LOG_BUFFER_HEXDUMP(TAG, pending_req->pkt, pending_req->pkt->params_len + sizeof(esp_amp_rpc_pkt_t), ESP_AMP_LOG_DEBUG);
+
+    if (esp_amp_rpmsg_send_nocopy(client->rpmsg_dev, &client->rpmsg_ept, client->server_addr,
+                                  pending_req->pkt, pending_req->pkt->params_len + sizeof(esp_amp_rpc_pkt_t)) != 0) {
+        ESP_AMP_LOGE(TAG, "Failed to send req(%u, %u)", pending_req->req_id, pending_req->service_id);
+    }
+}
+
+#if !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND
+static void esp_amp_rpc_client_send_once(esp_amp_rpc_client_t *client)
+{
+    esp_amp_rpc_pending_req_t *pending_req;
+
+    if (xQueueReceive(client->app_req_q, &pending_req, pdMS_TO_TICKS(500)) == pdTRUE) {
+        esp_amp_rpc_client_send_pkt(pending_req);
+    }
+}
+#endif /* !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND */
+
+/* fields accessed by rsp handler must be set before sending, since rsp can arrive at any time */
+static void esp_amp_rpc_client_send_request(esp_amp_rpc_pending_req_t *pending_req, uint32_t timeout_ms)
+{
+    pending_req->start_tick = xTaskGetTickCount();
+    pending_req->timeout_tick = esp_amp_rpc_client_timeout_tick(timeout_ms);
+    pending_req->start_us = ESP_AMP_RPC_METRICS_NOW();
+    pending_req->state = REQ_WAITING;
+
+#if CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND
+    /* send from caller's context */
+    esp_amp_rpc_client_send_pkt(pending_req);
+#else
+    ESP_AMP_LOGD(TAG, "send pending_req[%p](%u, %u) to send task", pending_req, pending_req->req_id, pending_req->service_id);
+    xQueueSend(pending_req->client->app_req_q, &pending_req, portMAX_DELAY);
+#endif /* CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND */
+}
+
 esp_amp_rpc_status_t esp_amp_rpc_client_execute_request(esp_amp_rpc_req_handle_t req, void **param_out, int *param_out_len, uint32_t timeout_ms)
 {
     esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
 
-    if (!pending_req || pending_req->req_id == ESP_AMP_RPC_INVALID_REQ_ID || !pending_req->pkt) {
+    if (!pending_req || !esp_amp_rpc_pending_req_valid(pending_req) || pending_req->state != REQ_CREATED) {
         ESP_AMP_LOGE(TAG, "Invalid req");
         return ESP_AMP_RPC_STATUS_INVALID_ARG;
     }
 
-    if (pending_req->app_rsp_q == NULL) {
-        ESP_AMP_LOGE(TAG, "Invalid app_rsp_q");
-        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    *param_out = NULL;
+    *param_out_len = 0;
+
+    if (esp_amp_rpc_pending_req_cached(pending_req)) {
+        pending_req->state = REQ_DONE;
+        return esp_amp_rpc_pending_req_result(pending_req, param_out, param_out_len);
     }
 
+    /* drop notification left by a response completed right after the previous timeout. This clears the whole
+     * value at the index, which is why the application must not share it (see CONFIG_ESP_AMP_RPC_CLIENT_NOTIFY_INDEX) */
+    ulTaskNotifyValueClearIndexed(NULL, ESP_AMP_RPC_CLIENT_NOTIFY_INDEX, UINT32_MAX);
+    pending_req->waiter = xTaskGetCurrentTaskHandle();
+
     /* send rpc request */
-    ESP_AMP_LOGD(TAG, "send pending_req[%p](%u, %u) to send task", pending_req, pending_req->req_id, pending_req->service_id);
-    xQueueSend(esp_amp_rpc_client.app_req_q, &pending_req, portMAX_DELAY);
+    esp_amp_rpc_client_send_request(pending_req, timeout_ms);
 
     /* recv rpc response */
-    uint32_t timeout_tick = pdMS_TO_TICKS(timeout_ms);
-    if (timeout_ms == -1) {
-        timeout_tick = portMAX_DELAY;
+    TickType_t timeout_tick = pending_req->timeout_tick;
+    while (pending_req->state != REQ_DONE && pending_req->state != REQ_CANCELLED) {
+        TickType_t elapsed = xTaskGetTickCount() - pending_req->start_tick;
+        if (timeout_tick != portMAX_DELAY && elapsed >= timeout_tick) {
+            bool expired = false;
+            esp_amp_env_enter_critical();
+            if (pending_req->state == REQ_WAITING) {
+                pending_req->state = REQ_TIMEOUT;
+                expired = true;
+            }
+            esp_amp_env_exit_critical();
+            if (expired) {
+                ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_client_metrics, pending_req->service_id, ESP_AMP_RPC_STATUS_TIMEOUT);
+            }
+            break;
+        }
+        ulTaskNotifyTakeIndexed(ESP_AMP_RPC_CLIENT_NOTIFY_INDEX, pdTRUE, timeout_tick == portMAX_DELAY ? portMAX_DELAY : timeout_tick - elapsed);
     }
-    if (xQueueReceive(pending_req->app_rsp_q, &pending_req->pkt, timeout_tick) != pdTRUE) {
+
+    if (pending_req->state == REQ_CANCELLED) {
+        return ESP_AMP_RPC_STATUS_CANCELLED;
+    }
+
+    if (pending_req->state != REQ_DONE) {
         ESP_AMP_LOGE(TAG, "Timeout req(%u, %u)", pending_req->req_id, pending_req->service_id);
-        *param_out = NULL;
-        *param_out_len = 0;
         return ESP_AMP_RPC_STATUS_TIMEOUT;
     }
 
-    /* if req_id not match */
-    if (pending_req->pkt->req_id != pending_req->req_id) {
-        ESP_AMP_LOGE(TAG, "Unmatched incoming rsp(%u) with req(%u, %u)", pending_req->pkt->req_id, pending_req->req_id, pending_req->service_id);
-        return ESP_AMP_RPC_STATUS_EXEC_FAILED;
+    return esp_amp_rpc_pending_req_result(pending_req, param_out, param_out_len);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_execute_async(esp_amp_rpc_req_handle_t req, esp_amp_rpc_req_async_cb_t cb, void *ctx, uint32_t timeout_ms)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+
+    if (!pending_req || !esp_amp_rpc_pending_req_valid(pending_req) || pending_req->state != REQ_CREATED || !cb) {
+        ESP_AMP_LOGE(TAG, "Invalid req");
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
     }
 
-    /* forward to params, no copy */
-    *param_out = pending_req->pkt->params;
-    *param_out_len = pending_req->pkt->params_len;
-    return pending_req->pkt->status;
+    /* cached result is delivered at once, in caller's context */
+    if (esp_amp_rpc_pending_req_cached(pending_req)) {
+        void *params_out = NULL;
+        int params_out_len = 0;
+        esp_amp_rpc_status_t status = esp_amp_rpc_pending_req_result(pending_req, &params_out, &params_out_len);
+        cb(status, params_out, params_out_len, ctx);
+        esp_amp_rpc_pending_list_pop(pending_req);
+        return ESP_AMP_RPC_STATUS_OK;
+    }
+
+    /* req is released by recv task after cb returns */
+    pending_req->cb = cb;
+    pending_req->cb_ctx = ctx;
+    esp_amp_rpc_client_send_request(pending_req, timeout_ms);
+    return ESP_AMP_RPC_STATUS_OK;
 }
 
-void esp_amp_rpc_client_destroy_request(esp_amp_rpc_req_handle_t req)
+esp_amp_rpc_status_t esp_amp_rpc_client_submit_request(esp_amp_rpc_req_handle_t req, uint32_t timeout_ms)
 {
     esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
-    if (!pending_req) {
+
+    if (!pending_req || !esp_amp_rpc_pending_req_valid(pending_req) || pending_req->state != REQ_CREATED) {
         ESP_AMP_LOGE(TAG, "Invalid req");
-        return;
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    /* cached result is ready for the first poll */
+    if (esp_amp_rpc_pending_req_cached(pending_req)) {
+        pending_req->state = REQ_DONE;
+        return ESP_AMP_RPC_STATUS_OK;
     }
 
-    esp_amp_rpmsg_destroy(esp_amp_rpc_client.rpmsg_dev, pending_req->pkt);
-    esp_amp_rpc_pending_list_pop(pending_req->req_id, NULL);
-    vQueueDelete(pending_req->app_rsp_q);
-    free(pending_req);
+    esp_amp_rpc_client_send_request(pending_req, timeout_ms);
+    return ESP_AMP_RPC_STATUS_OK;
 }
 
-static void esp_amp_rpc_client_send_once(void)
+esp_amp_rpc_status_t esp_amp_rpc_client_poll_request(esp_amp_rpc_req_handle_t req, void **param_out, int *param_out_len)
 {
-    esp_amp_rpc_pending_req_t *pending_req;
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+
+    if (!pending_req || !esp_amp_rpc_pending_req_valid(pending_req) || pending_req->state == REQ_CREATED || pending_req->cb) {
+        ESP_AMP_LOGE(TAG, "Invalid req");
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
 
-    if (xQueueReceive(esp_amp_rpc_client.app_req_q, &pending_req, pdMS_TO_TICKS(500)) == pdTRUE) {
-        ESP_AMP_LOGD(TAG, "Executing(req_id:%u, srv_id:%u, param(%u):%p",
-                     pending_req->pkt->req_id, pending_req->pkt->service_id,
-                     pending_req->pkt->params_len, pending_req->pkt->params);
-        ESP_AMP_LOGD(TAG, "client(%u) send req(pkt=%p, req_id=%u) to server(%u)", esp_amp_rpc_client.rpmsg_ept.addr,
-                     pending_req->pkt, pending_req->pkt->req_id, esp_amp_rpc_client.server_addr);
-        ESP_AMP_LOG_BUFFER_HEXDUMP(TAG, pending_req->pkt, pending_req->pkt->params_len + sizeof(esp_amp_rpc_pkt_t), ESP_AMP_LOG_DEBUG);
+    *param_out = NULL;
+    *param_out_len = 0;
 
-        esp_amp_rpmsg_send_nocopy(esp_amp_rpc_client.rpmsg_dev, &esp_amp_rpc_client.rpmsg_ept, esp_amp_rpc_client.server_addr,
-                                  pending_req->pkt, pending_req->pkt->params_len + sizeof(esp_amp_rpc_pkt_t));
+    bool expired = false;
+    esp_amp_env_enter_critical();
+    if (pending_req->state == REQ_WAITING && esp_amp_rpc_pending_req_expired(pending_req, xTaskGetTickCount())) {
+        pending_req->state = REQ_TIMEOUT;
+        expired = true;
+    }
+    esp_amp_env_exit_critical();
+
+    if (expired) {
+        ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_client_metrics, pending_req->service_id, ESP_AMP_RPC_STATUS_TIMEOUT);
+    }
+
+    switch (pending_req->state) {
+    case REQ_WAITING:
+        return ESP_AMP_RPC_STATUS_PENDING;
+    case REQ_DONE:
+        return esp_amp_rpc_pending_req_result(pending_req, param_out, param_out_len);
+    case REQ_CANCELLED:
+        return ESP_AMP_RPC_STATUS_CANCELLED;
+    default:
+        return ESP_AMP_RPC_STATUS_TIMEOUT;
     }
 }
 
-void esp_amp_rpc_client_recv_once(void)
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_inst_create_batch(esp_amp_rpc_client_handle_t client)
 {
-    esp_amp_rpc_pkt_t *pkt_in;
+    if (!esp_amp_rpc_client_valid(client)) {
+        ESP_AMP_LOGE(TAG, "Invalid client");
+        return NULL;
+    }
+
+    /* take a whole transport buffer, sub-requests are appended in place */
+    uint16_t capacity = esp_amp_rpmsg_get_max_size(client->rpmsg_dev) - sizeof(esp_amp_rpc_pkt_t);
+    esp_amp_rpc_pending_req_t *pending_req = esp_amp_rpc_client_inst_create_request(client, ESP_AMP_RPC_BATCH_SERVICE_ID, NULL, capacity);
+    if (pending_req == NULL) {
+        return NULL;
+    }
+    pending_req->pkt->params_len = 0;
+    return pending_req;
+}
+
+esp_amp_rpc_req_handle_t esp_amp_rpc_client_create_batch(void)
+{
+    return esp_amp_rpc_client_inst_create_batch(esp_amp_rpc_client_default);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_batch_add(esp_amp_rpc_req_handle_t req, uint16_t service_id, void *params, uint16_t params_len)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
 
-    if (xQueueReceive(esp_amp_rpc_client.rx_q, &pkt_in, pdMS_TO_TICKS(500)) == pdTRUE) {
-        esp_amp_rpc_pending_req_t *pending_req;
+    if (!pending_req || !esp_amp_rpc_pending_req_valid(pending_req) || pending_req->state != REQ_CREATED || pending_req->pkt == NULL || pending_req->pkt->service_id != ESP_AMP_RPC_BATCH_SERVICE_ID) {
+        ESP_AMP_LOGE(TAG, "Invalid batch req");
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
 
-        /* timeout req will be removed from pending_list */
-        if (esp_amp_rpc_pending_list_peek(pkt_in->req_id, &pending_req) == -1) {
-            esp_amp_rpmsg_destroy(esp_amp_rpc_client.rpmsg_dev, pkt_in);
-            return;
+    uint16_t capacity = esp_amp_rpmsg_get_max_size(pending_req->client->rpmsg_dev) - sizeof(esp_amp_rpc_pkt_t);
+    if (esp_amp_rpc_batch_append(pending_req->pkt, capacity, service_id, params, params_len) == -1) {
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_notify_with_priority(esp_amp_rpc_client_handle_t client, uint16_t service_id, uint8_t priority, void *params, uint16_t params_len)
+{
+    if (!esp_amp_rpc_client_valid(client)) {
+        ESP_AMP_LOGE(TAG, "Invalid client");
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    /* no pending req, sent from caller's context */
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(client->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t) + params_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_out == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to alloc msg buf");
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+
+    if (params != NULL) {
+        memcpy(pkt_out->params, params, params_len);
+    }
+    pkt_out->params_len = params_len;
+    pkt_out->req_id = ESP_AMP_RPC_NOTIFY_REQ_ID;
+    pkt_out->service_id = service_id;
+    pkt_out->status = ESP_AMP_RPC_STATUS_PENDING;
+    pkt_out->priority = priority;
+    pkt_out->timeout_ms = 0;
+
+    if (esp_amp_rpmsg_send_nocopy(client->rpmsg_dev, &client->rpmsg_ept, client->server_addr,
+                                  pkt_out, sizeof(esp_amp_rpc_pkt_t) + params_len) != 0) {
+        ESP_AMP_LOGE(TAG, "Failed to send notification(%u)", service_id);
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_notify(esp_amp_rpc_client_handle_t client, uint16_t service_id, void *params, uint16_t params_len)
+{
+    return esp_amp_rpc_client_inst_notify_with_priority(client, service_id, ESP_AMP_RPC_PRIORITY_NORMAL, params, params_len);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_notify_with_priority(uint16_t service_id, uint8_t priority, void *params, uint16_t params_len)
+{
+    return esp_amp_rpc_client_inst_notify_with_priority(esp_amp_rpc_client_default, service_id, priority, params, params_len);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_notify(uint16_t service_id, void *params, uint16_t params_len)
+{
+    return esp_amp_rpc_client_inst_notify(esp_amp_rpc_client_default, service_id, params, params_len);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_cancel_request(esp_amp_rpc_req_handle_t req)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+    TaskHandle_t waiter = NULL;
+    bool cancelled = false;
+
+    if (!pending_req || !esp_amp_rpc_pending_req_valid(pending_req)) {
+        ESP_AMP_LOGE(TAG, "Invalid req");
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    /* req completed or timeout in the meantime is not cancelled */
+    esp_amp_env_enter_critical();
+    if (pending_req->state == REQ_WAITING) {
+        pending_req->state = REQ_CANCELLED;
+        waiter = pending_req->waiter;
+        cancelled = true;
+    }
+    esp_amp_env_exit_critical();
+
+    if (!cancelled) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+    ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_client_metrics, pending_req->service_id, ESP_AMP_RPC_STATUS_CANCELLED);
+
+    /* header only, req_id tells server which req to drop */
+    esp_amp_rpc_client_t *client = pending_req->client;
+    esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_OK;
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(client->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_out == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to alloc msg buf");
+        ret = ESP_AMP_RPC_STATUS_NO_MEM;
+    } else {
+        pkt_out->req_id = pending_req->req_id;
+        pkt_out->service_id = ESP_AMP_RPC_CANCEL_SERVICE_ID;
+        pkt_out->status = ESP_AMP_RPC_STATUS_CANCELLED;
+        pkt_out->priority = ESP_AMP_RPC_PRIORITY_NORMAL;
+        pkt_out->params_len = 0;
+        pkt_out->timeout_ms = 0;
+        esp_amp_rpmsg_send_nocopy(client->rpmsg_dev, &client->rpmsg_ept, client->server_addr,
+                                  pkt_out, sizeof(esp_amp_rpc_pkt_t));
+    }
+
+    if (pending_req->cb) {
+        /* neither rsp nor timeout completes a cancelled req, so it is released here */
+        pending_req->cb(ESP_AMP_RPC_STATUS_CANCELLED, NULL, 0, pending_req->cb_ctx);
+        esp_amp_rpc_pending_list_pop(pending_req);
+    } else if (waiter) {
+        xTaskNotifyGiveIndexed(waiter, ESP_AMP_RPC_CLIENT_NOTIFY_INDEX);
+    }
+    return ret;
+}
+
+void *esp_amp_rpc_client_get_request_params(esp_amp_rpc_req_handle_t req)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+    if (pending_req == NULL || pending_req->pkt == NULL) {
+        return NULL;
+    }
+    return pending_req->pkt->params;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_set_priority(esp_amp_rpc_req_handle_t req, uint8_t priority)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+    if (!pending_req || !esp_amp_rpc_pending_req_valid(pending_req) || pending_req->state != REQ_CREATED) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    /* req served from cache is never sent */
+    if (pending_req->pkt != NULL) {
+        pending_req->pkt->priority = priority;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+void esp_amp_rpc_client_destroy_request(esp_amp_rpc_req_handle_t req)
+{
+    esp_amp_rpc_pending_req_t *pending_req = (esp_amp_rpc_pending_req_t *)req;
+    if (!pending_req || !esp_amp_rpc_pending_req_valid(pending_req)) {
+        ESP_AMP_LOGE(TAG, "Invalid req");
+        return;
+    }
+
+    if (pending_req->cb && pending_req->state != REQ_CREATED) {
+        ESP_AMP_LOGE(TAG, "Async req(%u) is released after its cb", pending_req->req_id);
+        return;
+    }
+
+    /* request pkt is released by server after it is sent. late response to timeout req is dropped by recv task */
+    esp_amp_rpc_pkt_t *rsp_pkt = pending_req->rsp_pkt;
+    esp_amp_rpc_pending_list_pop(pending_req);
+    if (rsp_pkt) {
+        esp_amp_rpmsg_destroy(pending_req->client->rpmsg_dev, rsp_pkt);
+    }
+}
+
+/* complete async req with timeout status, return ticks until the next async req expires */
+static TickType_t esp_amp_rpc_client_complete_timeout_async(esp_amp_rpc_client_t *client)
+{
+    TickType_t next_tick = pdMS_TO_TICKS(500);
+
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        esp_amp_rpc_pending_req_t *pending_req = &client->pending_list.reqs[i];
+        TickType_t now = xTaskGetTickCount();
+        bool expired = false;
+
+        esp_amp_env_enter_critical();
+        if (pending_req->state == REQ_WAITING && pending_req->cb) {
+            if (esp_amp_rpc_pending_req_expired(pending_req, now)) {
+                pending_req->state = REQ_TIMEOUT;
+                expired = true;
+            } else if (pending_req->timeout_tick != portMAX_DELAY && pending_req->timeout_tick - (now - pending_req->start_tick) < next_tick) {
+                next_tick = pending_req->timeout_tick - (now - pending_req->start_tick);
+            }
         }
+        esp_amp_env_exit_critical();
 
-        /* app_rsp_q will also be deleted */
-        if (!pending_req->app_rsp_q) {
-            esp_amp_rpmsg_destroy(esp_amp_rpc_client.rpmsg_dev, pkt_in);
-            return;
+        if (expired) {
+            ESP_AMP_LOGD(TAG, "Timeout async req(%u, %u)", pending_req->req_id, pending_req->service_id);
+            ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_client_metrics, pending_req->service_id, ESP_AMP_RPC_STATUS_TIMEOUT);
+            pending_req->cb(ESP_AMP_RPC_STATUS_TIMEOUT, NULL, 0, pending_req->cb_ctx);
+            esp_amp_rpc_pending_list_pop(pending_req);
         }
+    }
+    return next_tick;
+}
+
+static void esp_amp_rpc_client_recv_once(esp_amp_rpc_client_t *client)
+{
+    esp_amp_rpc_pkt_t *pkt_in;
+    TickType_t wait_tick = esp_amp_rpc_client_complete_timeout_async(client);
 
-        /* send pkt_in to app_rsp_q without copy */
-        if (xQueueSend(pending_req->app_rsp_q, &pkt_in, 0) != pdTRUE) {
-            ESP_AMP_LOGE(TAG, "Failed to send pkt to app_rsp_q");
-            esp_amp_rpmsg_destroy(esp_amp_rpc_client.rpmsg_dev, pkt_in);
+    if (xQueueReceive(client->rx_q, &pkt_in, wait_tick) == pdTRUE) {
+        if (esp_amp_rpc_client_complete_rsp(client, pkt_in, false, NULL) == -1) {
+            ESP_AMP_LOGD(TAG, "Drop rsp(%u) of non-pending req", pkt_in->req_id);
+            esp_amp_rpmsg_destroy(client->rpmsg_dev, pkt_in);
         }
     }
 }
 
+#if !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND
 static void esp_amp_rpc_client_send_task(void *args)
 {
+    esp_amp_rpc_client_t *client = (esp_amp_rpc_client_t *)args;
+
     while (true) {
-        EventBits_t event = xEventGroupWaitBits(esp_amp_rpc_client.event, CLIENT_EVENT_STOPPING, false, false, 0);
+        EventBits_t event = xEventGroupWaitBits(client->event, CLIENT_EVENT_STOPPING, false, false, 0);
         if (event & CLIENT_EVENT_STOPPING) {
             /* stop client as user requested */
             break;
         }
-        esp_amp_rpc_client_send_once();
+        esp_amp_rpc_client_send_once(client);
     }
-    xEventGroupSetBits(esp_amp_rpc_client.event, CLIENT_EVENT_SEND_STOPPED);
+    xEventGroupSetBits(client->event, CLIENT_EVENT_SEND_STOPPED);
     vTaskDelete(NULL);
 }
+#endif /* !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND */
 
 static void esp_amp_rpc_client_recv_task(void *args)
 {
+    esp_amp_rpc_client_t *client = (esp_amp_rpc_client_t *)args;
+
     while (true) {
-        EventBits_t event = xEventGroupWaitBits(esp_amp_rpc_client.event, CLIENT_EVENT_STOPPING, false, false, 0);
+        EventBits_t event = xEventGroupWaitBits(client->event, CLIENT_EVENT_STOPPING, false, false, 0);
         if (event & CLIENT_EVENT_STOPPING) {
             /* stop client as user requested */
             break;
         }
-        esp_amp_rpc_client_recv_once();
+        esp_amp_rpc_client_recv_once(client);
     }
-    xEventGroupSetBits(esp_amp_rpc_client.event, CLIENT_EVENT_RECV_STOPPED);
+    xEventGroupSetBits(client->event, CLIENT_EVENT_RECV_STOPPED);
     vTaskDelete(NULL);
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_client_run(void)
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_run(esp_amp_rpc_client_handle_t client)
 {
     esp_amp_rpc_status_t ret;
 
-    switch (esp_amp_rpc_client.state) {
+    if (client == NULL) {
+        ESP_AMP_LOGE(TAG, "Invalid client");
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    switch (client->state) {
     case CLIENT_RUNNING:
         ret = ESP_AMP_RPC_STATUS_OK;
         break;
     case CLIENT_READY:
     case CLIENT_STOPPED:
-        if (xTaskCreate(esp_amp_rpc_client_send_task, "rpc_send", esp_amp_rpc_client.stack_size, NULL, esp_amp_rpc_client.task_priority, NULL) != pdPASS) {
+#if !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND
+        if (xTaskCreate(esp_amp_rpc_client_send_task, "rpc_send", client->stack_size, client, client->task_priority, NULL) != pdPASS) {
             ESP_AMP_LOGE(TAG, "Failed to create rpc_send_task");
             ret = ESP_AMP_RPC_STATUS_FAILED;
             break;
         }
-        if (xTaskCreate(esp_amp_rpc_client_recv_task, "rpc_recv", esp_amp_rpc_client.stack_size, NULL, esp_amp_rpc_client.task_priority, NULL) != pdPASS) {
+#endif /* !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND */
+        if (xTaskCreate(esp_amp_rpc_client_recv_task, "rpc_recv", client->stack_size, client, client->task_priority, NULL) != pdPASS) {
             ESP_AMP_LOGE(TAG, "Failed to create rpc_recv_task");
+#if !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND
+            /* send task already running deletes itself, so that the client can be run again or deleted */
+            xEventGroupSetBits(client->event, CLIENT_EVENT_STOPPING);
+            xEventGroupWaitBits(client->event, CLIENT_EVENT_SEND_STOPPED, false, true, portMAX_DELAY);
+            xEventGroupClearBits(client->event, (CLIENT_EVENT_STOPPING | CLIENT_EVENT_SEND_STOPPED));
+#endif /* !CONFIG_ESP_AMP_RPC_CLIENT_DIRECT_SEND */
             ret = ESP_AMP_RPC_STATUS_FAILED;
             break;
         }
         ret = ESP_AMP_RPC_STATUS_OK;
-        esp_amp_rpc_client.state = CLIENT_RUNNING;
+        client->state = CLIENT_RUNNING;
         break;
     default:
         ret = ESP_AMP_RPC_STATUS_FAILED;
@@ -549,3 +1087,50 @@ esp_amp_rpc_status_t esp_amp_rpc_client_run(void)
     }
     return ret;
 }
+
+esp_amp_rpc_status_t esp_amp_rpc_client_run(void)
+{
+    return esp_amp_rpc_client_inst_run(esp_amp_rpc_client_default);
+}
+
+#if ESP_AMP_RPC_CLIENT_CACHE_NUM
+esp_amp_rpc_status_t esp_amp_rpc_client_inst_set_cache(esp_amp_rpc_client_handle_t client, uint16_t service_id, uint32_t ttl_ms)
+{
+    if (!esp_amp_rpc_client_valid(client) || service_id >= ESP_AMP_RPC_INVALIDATE_SERVICE_ID) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+    if (esp_amp_rpc_cache_config(&client->cache, service_id, ttl_ms) != 0) {
+        ESP_AMP_LOGE(TAG, "No room to cache srv(%u)", service_id);
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_client_set_cache(uint16_t service_id, uint32_t ttl_ms)
+{
+    return esp_amp_rpc_client_inst_set_cache(esp_amp_rpc_client_default, service_id, ttl_ms);
+}
+#endif /* ESP_AMP_RPC_CLIENT_CACHE_NUM */
+
+#if CONFIG_ESP_AMP_RPC_METRICS
+esp_amp_rpc_status_t esp_amp_rpc_client_metrics_get(uint16_t service_id, esp_amp_rpc_metrics_t *metrics)
+{
+    if (metrics == NULL) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+    if (esp_amp_rpc_metrics_get(&esp_amp_rpc_client_metrics, service_id, metrics) != 0) {
+        return ESP_AMP_RPC_STATUS_NO_SERVICE;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+void esp_amp_rpc_client_metrics_reset(void)
+{
+    esp_amp_rpc_metrics_reset(&esp_amp_rpc_client_metrics);
+}
+
+void esp_amp_rpc_client_metrics_dump(void)
+{
+    esp_amp_rpc_metrics_dump(&esp_amp_rpc_client_metrics, TAG);
+}
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
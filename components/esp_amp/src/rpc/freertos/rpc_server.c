@@ -5,8 +5,10 @@
 */
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "stddef.h"
 #include "string.h"
+#include "stdlib.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -14,21 +16,84 @@
 #include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 
+#include "esp_amp_env.h"
 #include "esp_amp_rpc.h"
 #include "esp_amp_rpmsg.h"
 #include "esp_amp_log.h"
+#include "esp_amp_rpc_service_priv.h"
+#include "esp_amp_rpc_batch_priv.h"
+#include "esp_amp_rpc_metrics_priv.h"
+#include "esp_amp_rpc_prio_priv.h"
 
 #define TAG "rpc_server"
 
 #define SERVER_EVENT_STOPPING ( 1 << 1 )
 #define SERVER_EVENT_STOPPED ( 1 << 2 )
+#define SERVER_EVENT_WORKER(idx) ( 1 << (8 + (idx)) ) /* worker waiting for its turn to execute */
 
 #define ESP_AMP_RPC_SERVICE_TABLE_LEN CONFIG_ESP_AMP_RPC_SERVICE_TABLE_LEN
+#define ESP_AMP_RPC_SERVER_WORKER_NUM CONFIG_ESP_AMP_RPC_SERVER_WORKER_NUM
+#define ESP_AMP_RPC_SERVER_INSTANCE_NUM CONFIG_ESP_AMP_RPC_SERVER_INSTANCE_NUM
+
+/**
+ * client timeout in ticks, rounded up and plus one tick since rx_tick is taken partway through a tick. a timeout
+ * shorter than one tick never expires a request waiting for less than a whole tick
+ */
+#define ESP_AMP_RPC_SERVER_TIMEOUT_TICKS(ms) (pdMS_TO_TICKS((uint64_t)(ms) + portTICK_PERIOD_MS - 1) + 1)
+
+#if ESP_AMP_RPC_PRIORITY_NUM > 1
+/* requests are aged in ticks, a period shorter than one tick ages by one tick */
+#define ESP_AMP_RPC_PRIORITY_AGING_TICKS (CONFIG_ESP_AMP_RPC_PRIORITY_AGING_MS == 0 ? 0 : \
+        (pdMS_TO_TICKS(CONFIG_ESP_AMP_RPC_PRIORITY_AGING_MS) > 0 ? pdMS_TO_TICKS(CONFIG_ESP_AMP_RPC_PRIORITY_AGING_MS) : 1))
+#endif /* ESP_AMP_RPC_PRIORITY_NUM > 1 */
+
+typedef struct {
+    uint8_t max_concurrency; /* 0 means unlimited */
+    uint8_t running; /* number of workers executing this service */
+    uint8_t order_key;
+    int16_t lane; /* index of the first service with the same order key, -1 if not ordered */
+    uint32_t next_ticket; /* valid on lane owner: ticket for next request dequeued */
+    uint32_t serving; /* valid on lane owner: ticket allowed to execute */
+} esp_amp_rpc_service_sched_t;
+
+/* request received, with the time it arrives to derive its deadline */
+typedef struct {
+    esp_amp_rpc_pkt_t *pkt;
+    TickType_t rx_tick;
+    uint32_t rx_seq; /* arrival order among requests and cancel messages */
+    uint32_t rx_us; /* for metrics */
+} esp_amp_rpc_server_rx_t;
+
+/**
+ * cancel message not matched yet. it only matches a request arrived before it, as req_id is reused by client.
+ * cleared once matched, once the request is answered, or once a newer request with the same req_id arrives
+ */
+typedef struct {
+    uint16_t req_id; /* ESP_AMP_RPC_NOTIFY_REQ_ID if free */
+    uint32_t rx_seq;
+} esp_amp_rpc_server_cancel_t;
+
+/* scheduling of a request, or of each sub-request of a batch, decided when it is dequeued */
+typedef struct {
+    int srv_idx; /* -1 if service not found */
+    uint32_t ticket; /* ticket of its lane, valid if service is ordered */
+} esp_amp_rpc_server_job_t;
+
+/* request dequeued while its service is busy or not its turn in the lane, picked up later by any worker */
+typedef struct {
+    esp_amp_rpc_server_rx_t rx;
+    esp_amp_rpc_server_job_t job;
+} esp_amp_rpc_server_parked_t;
 
 typedef struct {
     SemaphoreHandle_t mutex;
     int len;
     esp_amp_rpc_service_t services[ESP_AMP_RPC_SERVICE_TABLE_LEN];
+    int static_num; /* number of services defined at link time */
+    esp_amp_rpc_service_sched_t *sched; /* link-time services first, then services in table */
+    uint32_t waiting_workers; /* bit set if worker waits for a service to be released */
+    esp_amp_rpc_server_parked_t parked[ESP_AMP_RPC_MAX_PENDING_REQ]; /* in dequeue order */
+    int parked_num;
 } esp_amp_rpc_service_tbl_t;
 
 typedef enum {
@@ -38,7 +103,24 @@ typedef enum {
     SERVER_STOPPED,
 } esp_amp_rpc_server_state_t;
 
+typedef struct esp_amp_rpc_server_t esp_amp_rpc_server_t;
+
+/* request whose service handler is running, for stream_send */
+typedef struct {
+    void *params_out; /* NULL if no handler is running, or a batch is executing */
+    uint16_t req_id;
+    uint16_t service_id;
+    uint8_t priority;
+} esp_amp_rpc_server_stream_t;
+
 typedef struct {
+    esp_amp_rpc_server_t *server;
+    int idx;
+    TaskHandle_t task; /* set by the worker itself, NULL if not running */
+    esp_amp_rpc_server_stream_t stream;
+} esp_amp_rpc_server_worker_t;
+
+struct esp_amp_rpc_server_t {
     uint16_t server_addr;
     uint16_t client_addr;
     int task_priority;
@@ -47,75 +129,238 @@ typedef struct {
     esp_amp_rpmsg_ept_t rpmsg_ept;
     esp_amp_rpc_service_tbl_t service_tbl;
     QueueHandle_t rx_q;
+    SemaphoreHandle_t rx_lock; /* only one worker waits on rx_q, so requests are dequeued in order */
+#if ESP_AMP_RPC_PRIORITY_NUM > 1
+    /* requests moved out of rx_q and ordered by priority, protected by rx_lock */
+    esp_amp_rpc_prio_q_t ready_q;
+    esp_amp_rpc_prio_link_t ready_links[ESP_AMP_RPC_MAX_PENDING_REQ];
+    esp_amp_rpc_server_rx_t ready[ESP_AMP_RPC_MAX_PENDING_REQ];
+#endif /* ESP_AMP_RPC_PRIORITY_NUM > 1 */
+    esp_amp_rpc_server_cancel_t cancels[ESP_AMP_RPC_MAX_PENDING_REQ]; /* oldest is overwritten, protected by critical section */
+    int cancel_next;
+    uint32_t rx_seq; /* seq of next message received */
+    int worker_num; /* number of worker tasks alive */
+    int max_worker_num; /* number of worker tasks created by run */
+    esp_amp_rpc_server_worker_t workers[ESP_AMP_RPC_SERVER_WORKER_NUM];
     EventGroupHandle_t event;
     esp_amp_rpc_server_state_t state;
-} esp_amp_rpc_server_t;
+};
+
+static esp_amp_rpc_server_t esp_amp_rpc_servers[ESP_AMP_RPC_SERVER_INSTANCE_NUM];
+static esp_amp_rpc_server_t *esp_amp_rpc_server_default; /* instance of APIs without handle, created by esp_amp_rpc_server_init() */
 
-static esp_amp_rpc_server_t esp_amp_rpc_server;
+#if CONFIG_ESP_AMP_RPC_METRICS
+static esp_amp_rpc_metrics_tbl_t esp_amp_rpc_server_metrics; /* shared by all instances */
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
 
 static int esp_amp_rpc_server_isr(void *pkt_in_buf, uint16_t size, uint16_t src_addr, void* rx_cb_data);
 
-esp_amp_rpc_status_t esp_amp_rpc_server_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr, int task_priority, int stack_size)
+static bool esp_amp_rpc_server_valid(esp_amp_rpc_server_t *server)
+{
+    return server != NULL && server->state != SERVER_INVALID;
+}
+
+/* free resources of a server which is not running, and give the instance back */
+static void esp_amp_rpc_server_release(esp_amp_rpc_server_t *server)
+{
+    for (int i = 0; i < server->service_tbl.parked_num; i++) {
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, server->service_tbl.parked[i].rx.pkt);
+    }
+    server->service_tbl.parked_num = 0;
+#if ESP_AMP_RPC_PRIORITY_NUM > 1
+    for (int slot = esp_amp_rpc_prio_q_pop(&server->ready_q, 0); slot != -1; slot = esp_amp_rpc_prio_q_pop(&server->ready_q, 0)) {
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, server->ready[slot].pkt);
+    }
+#endif /* ESP_AMP_RPC_PRIORITY_NUM > 1 */
+    if (server->rpmsg_dev) {
+        esp_amp_rpmsg_delete_endpoint(server->rpmsg_dev, server->server_addr);
+        server->rpmsg_dev = NULL;
+    }
+    if (server->event) {
+        vEventGroupDelete(server->event);
+        server->event = NULL;
+    }
+    if (server->rx_q) {
+        vQueueDelete(server->rx_q);
+        server->rx_q = NULL;
+    }
+    if (server->service_tbl.mutex) {
+        vSemaphoreDelete(server->service_tbl.mutex);
+        server->service_tbl.mutex = NULL;
+    }
+    free(server->service_tbl.sched);
+    server->service_tbl.sched = NULL;
+    if (server->rx_lock) {
+        vSemaphoreDelete(server->rx_lock);
+        server->rx_lock = NULL;
+    }
+    server->state = SERVER_INVALID;
+}
+
+esp_amp_rpc_server_handle_t esp_amp_rpc_server_inst_create(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr, int task_priority, int stack_size, int worker_num)
 {
     if (!rpmsg_dev) {
         ESP_AMP_LOGE(TAG, "Invalid rpmsg dev");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        return NULL;
     }
 
-    if (esp_amp_rpc_server.state == SERVER_READY) {
-        ESP_AMP_LOGE(TAG, "RPC server aleady init");
-        return ESP_AMP_RPC_STATUS_FAILED;
+    if (worker_num < 0 || worker_num > ESP_AMP_RPC_SERVER_WORKER_NUM) {
+        ESP_AMP_LOGE(TAG, "Invalid worker num %d", worker_num);
+        return NULL;
     }
 
-    esp_amp_rpc_server.task_priority = task_priority <= 0 ? 5 : task_priority;
-    esp_amp_rpc_server.stack_size = stack_size <= 0 ? 2048 : stack_size;
+    /* take a free instance */
+    esp_amp_rpc_server_t *server = NULL;
+    esp_amp_env_enter_critical();
+    for (int i = 0; i < ESP_AMP_RPC_SERVER_INSTANCE_NUM; i++) {
+        if (esp_amp_rpc_servers[i].state == SERVER_INVALID) {
+            server = &esp_amp_rpc_servers[i];
+            server->state = SERVER_READY;
+            break;
+        }
+    }
+    esp_amp_env_exit_critical();
 
-    esp_amp_rpc_server.rpmsg_dev = rpmsg_dev;
-    esp_amp_rpc_server.client_addr = client_addr;
-    esp_amp_rpc_server.server_addr = server_addr;
+    if (server == NULL) {
+        ESP_AMP_LOGE(TAG, "No free RPC server instance");
+        return NULL;
+    }
 
-    /* register endpoint */
-    if (esp_amp_rpmsg_create_endpoint(esp_amp_rpc_server.rpmsg_dev, server_addr, esp_amp_rpc_server_isr, NULL, &esp_amp_rpc_server.rpmsg_ept) == NULL) {
-        ESP_AMP_LOGE(TAG, "Failed to create ept");
-        return ESP_AMP_RPC_STATUS_FAILED;
+    server->task_priority = task_priority <= 0 ? 5 : task_priority;
+    server->stack_size = stack_size <= 0 ? 2048 : stack_size;
+    server->max_worker_num = worker_num == 0 ? ESP_AMP_RPC_SERVER_WORKER_NUM : worker_num;
+    for (int i = 0; i < ESP_AMP_RPC_SERVER_WORKER_NUM; i++) {
+        server->workers[i].server = server;
+        server->workers[i].idx = i;
+        server->workers[i].task = NULL;
+        server->workers[i].stream.params_out = NULL;
     }
 
+    server->client_addr = client_addr;
+    server->server_addr = server_addr;
+
+#if ESP_AMP_RPC_PRIORITY_NUM > 1
+    esp_amp_rpc_prio_q_init(&server->ready_q, server->ready_links, ESP_AMP_RPC_MAX_PENDING_REQ, ESP_AMP_RPC_PRIORITY_AGING_TICKS);
+#endif /* ESP_AMP_RPC_PRIORITY_NUM > 1 */
+
     /* create queue */
-    esp_amp_rpc_server.rx_q = xQueueCreate(ESP_AMP_RPC_MAX_PENDING_REQ, sizeof(esp_amp_rpc_pkt_t *));
-    if (esp_amp_rpc_server.rx_q == NULL) {
+    server->rx_q = xQueueCreate(ESP_AMP_RPC_MAX_PENDING_REQ, sizeof(esp_amp_rpc_server_rx_t));
+    memset(server->cancels, 0, sizeof(server->cancels));
+    server->cancel_next = 0;
+    server->rx_seq = 0;
+    if (server->rx_q == NULL) {
         ESP_AMP_LOGE(TAG, "Failed to create rx_q");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        esp_amp_rpc_server_release(server);
+        return NULL;
     }
 
     /* init service table */
-    esp_amp_rpc_server.service_tbl.mutex = xSemaphoreCreateRecursiveMutex();
-    if (esp_amp_rpc_server.service_tbl.mutex == NULL) {
+    server->service_tbl.mutex = xSemaphoreCreateRecursiveMutex();
+    if (server->service_tbl.mutex == NULL) {
         ESP_AMP_LOGE(TAG, "Failed to create service lock");
-        return ESP_AMP_RPC_STATUS_FAILED;
+        esp_amp_rpc_server_release(server);
+        return NULL;
+    }
+    server->service_tbl.len = 0;
+    server->service_tbl.waiting_workers = 0;
+    server->service_tbl.parked_num = 0;
+
+    int static_num = esp_amp_rpc_service_static_init();
+    server->service_tbl.static_num = static_num;
+    server->service_tbl.sched = calloc(static_num + ESP_AMP_RPC_SERVICE_TABLE_LEN, sizeof(esp_amp_rpc_service_sched_t));
+    if (server->service_tbl.sched == NULL && static_num + ESP_AMP_RPC_SERVICE_TABLE_LEN > 0) {
+        ESP_AMP_LOGE(TAG, "Failed to alloc service sched");
+        esp_amp_rpc_server_release(server);
+        return NULL;
+    }
+    for (int i = 0; i < static_num; i++) {
+        server->service_tbl.sched[i].max_concurrency = 1; /* not reentrant by default */
+        server->service_tbl.sched[i].lane = -1;
+    }
+
+    server->rx_lock = xSemaphoreCreateMutex();
+    if (server->rx_lock == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to create rx lock");
+        esp_amp_rpc_server_release(server);
+        return NULL;
     }
-    esp_amp_rpc_server.service_tbl.len = 0;
 
     /* init event group */
-    esp_amp_rpc_server.event = xEventGroupCreate();
-    if (esp_amp_rpc_server.event == NULL) {
+    server->event = xEventGroupCreate();
+    if (server->event == NULL) {
         ESP_AMP_LOGE(TAG, "Failed to create event group");
+        esp_amp_rpc_server_release(server);
+        return NULL;
+    }
+
+    /* register endpoint last, requests may arrive as soon as it is created */
+    server->rpmsg_dev = rpmsg_dev;
+    if (esp_amp_rpmsg_create_endpoint(rpmsg_dev, server_addr, esp_amp_rpc_server_isr, server, &server->rpmsg_ept) == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to create ept");
+        server->rpmsg_dev = NULL; /* endpoint address may belong to others, do not delete it */
+        esp_amp_rpc_server_release(server);
+        return NULL;
+    }
+
+    return server;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_init(esp_amp_rpmsg_dev_t *rpmsg_dev, uint16_t client_addr, uint16_t server_addr, int task_priority, int stack_size)
+{
+    if (esp_amp_rpc_server_default != NULL) {
+        ESP_AMP_LOGE(TAG, "RPC server aleady init");
         return ESP_AMP_RPC_STATUS_FAILED;
     }
 
-    esp_amp_rpc_server.state = SERVER_READY;
-    return ESP_AMP_RPC_STATUS_OK;
+    esp_amp_rpc_server_default = esp_amp_rpc_server_inst_create(rpmsg_dev, client_addr, server_addr, task_priority, stack_size, ESP_AMP_RPC_SERVER_WORKER_NUM);
+    return esp_amp_rpc_server_default ? ESP_AMP_RPC_STATUS_OK : ESP_AMP_RPC_STATUS_FAILED;
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_server_add_service(esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_func_t srv_func)
+/* index of link-time service or table entry */
+static esp_amp_rpc_service_t *esp_amp_rpc_server_get_service(esp_amp_rpc_server_t *server, int idx)
+{
+    if (idx < server->service_tbl.static_num) {
+        return esp_amp_rpc_service_static_get(idx);
+    }
+    return &server->service_tbl.services[idx - server->service_tbl.static_num];
+}
+
+/* return index of service, -1 if not found. must be called with service_tbl.mutex held */
+static int esp_amp_rpc_server_find_service(esp_amp_rpc_server_t *server, esp_amp_rpc_service_id_t srv_id)
 {
+    /* link-time services first, O(1) for contiguous ids */
+    int idx = esp_amp_rpc_service_static_find(srv_id);
+    if (idx != -1) {
+        return idx;
+    }
+
+    for (int i = 0; i < server->service_tbl.len; i++) {
+        if (server->service_tbl.services[i].handler != NULL && server->service_tbl.services[i].id == srv_id) {
+            return server->service_tbl.static_num + i;
+        }
+    }
+    return -1;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_add_service(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_func_t srv_func)
+{
+    if (!esp_amp_rpc_server_valid(server)) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
     esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_OK;
-    xSemaphoreTakeRecursive(esp_amp_rpc_server.service_tbl.mutex, portMAX_DELAY);
+    xSemaphoreTakeRecursive(server->service_tbl.mutex, portMAX_DELAY);
 
     if (srv_func == NULL) {
         ret = ESP_AMP_RPC_STATUS_FAILED;
     }
 
-    int next_idx = esp_amp_rpc_server.service_tbl.len;
+    if (esp_amp_rpc_service_static_find(srv_id) != -1) {
+        ESP_AMP_LOGE(TAG, "srv(%d) already defined at link time", srv_id);
+        ret = ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    int next_idx = server->service_tbl.len;
     if (next_idx == ESP_AMP_RPC_SERVICE_TABLE_LEN) {
         ret = ESP_AMP_RPC_STATUS_FAILED;
     }
@@ -123,186 +368,764 @@ esp_amp_rpc_status_t esp_amp_rpc_server_add_service(esp_amp_rpc_service_id_t srv
     if (ret != ESP_AMP_RPC_STATUS_FAILED) {
         /* duplicated id checking: if a previous handler has the same srv_id, replace it with the new one */
         for (int i = 0; i < next_idx; i++) {
-            if (esp_amp_rpc_server.service_tbl.services[i].id == srv_id) {
+            if (server->service_tbl.services[i].id == srv_id) {
                 next_idx = i;
                 break;
             }
         }
 
-        esp_amp_rpc_server.service_tbl.services[next_idx].handler = srv_func;
-        esp_amp_rpc_server.service_tbl.services[next_idx].id = srv_id;
+        server->service_tbl.services[next_idx].handler = srv_func;
+        server->service_tbl.services[next_idx].id = srv_id;
+        server->service_tbl.services[next_idx].batch_handler = NULL;
 
         /* if a new service is added to service table, increase the service table length */
-        if (next_idx == esp_amp_rpc_server.service_tbl.len) {
-            esp_amp_rpc_server.service_tbl.len++;
+        if (next_idx == server->service_tbl.len) {
+            esp_amp_rpc_service_sched_t *sched = &server->service_tbl.sched[server->service_tbl.static_num + next_idx];
+            memset(sched, 0, sizeof(esp_amp_rpc_service_sched_t));
+            sched->max_concurrency = 1; /* not reentrant by default */
+            sched->lane = -1;
+            server->service_tbl.len++;
         }
     }
 
-    xSemaphoreGiveRecursive(esp_amp_rpc_server.service_tbl.mutex);
+    xSemaphoreGiveRecursive(server->service_tbl.mutex);
 
     ESP_AMP_LOGD(TAG, "added srv(%u, %p) to tbl[%d]", srv_id, srv_func, next_idx);
     return ret;
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_server_stop(void)
+esp_amp_rpc_status_t esp_amp_rpc_server_add_service(esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_func_t srv_func)
+{
+    return esp_amp_rpc_server_inst_add_service(esp_amp_rpc_server_default, srv_id, srv_func);
+}
+
+/* worker which is the calling task, NULL if called out of a service handler */
+static esp_amp_rpc_server_worker_t *esp_amp_rpc_server_current(void)
 {
-    if (esp_amp_rpc_server.state == SERVER_STOPPED) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < ESP_AMP_RPC_SERVER_INSTANCE_NUM; i++) {
+        esp_amp_rpc_server_t *server = &esp_amp_rpc_servers[i];
+        if (server->state != SERVER_RUNNING) {
+            continue;
+        }
+        for (int j = 0; j < server->max_worker_num; j++) {
+            if (server->workers[j].task == task) {
+                return &server->workers[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_stream_send(void *params_out, const void *data, uint16_t data_len)
+{
+    esp_amp_rpc_server_worker_t *worker = esp_amp_rpc_server_current();
+    /* sub-requests of a batch share one rsp, they cannot stream */
+    if (worker == NULL || params_out == NULL || worker->stream.params_out != params_out) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+    esp_amp_rpc_server_t *server = worker->server;
+    if (sizeof(esp_amp_rpc_pkt_t) + data_len > esp_amp_rpmsg_get_max_size(server->rpmsg_dev)) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+
+    esp_amp_rpc_pkt_t *pkt_chunk = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(server->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t) + data_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_chunk == NULL) {
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+
+    pkt_chunk->req_id = worker->stream.req_id;
+    pkt_chunk->service_id = worker->stream.service_id;
+    pkt_chunk->status = ESP_AMP_RPC_STATUS_STREAM;
+    pkt_chunk->priority = worker->stream.priority;
+    pkt_chunk->params_len = data_len;
+    pkt_chunk->timeout_ms = 0;
+    memcpy(pkt_chunk->params, data, data_len);
+
+    ESP_AMP_LOGD(TAG, "sending chunk(%u) of rsp(%u)", data_len, pkt_chunk->req_id);
+    esp_amp_rpmsg_send_nocopy(server->rpmsg_dev, &server->rpmsg_ept, server->client_addr,
+                              pkt_chunk, sizeof(esp_amp_rpc_pkt_t) + data_len);
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_set_batch_handler(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_batch_func_t batch_func)
+{
+    if (!esp_amp_rpc_server_valid(server)) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_NO_SERVICE;
+    xSemaphoreTakeRecursive(server->service_tbl.mutex, portMAX_DELAY);
+
+    int i = esp_amp_rpc_server_find_service(server, srv_id);
+    if (i != -1) {
+        esp_amp_rpc_server_get_service(server, i)->batch_handler = batch_func;
+        ret = ESP_AMP_RPC_STATUS_OK;
+    }
+
+    xSemaphoreGiveRecursive(server->service_tbl.mutex);
+    return ret;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_set_batch_handler(esp_amp_rpc_service_id_t srv_id, esp_amp_rpc_service_batch_func_t batch_func)
+{
+    return esp_amp_rpc_server_inst_set_batch_handler(esp_amp_rpc_server_default, srv_id, batch_func);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_invalidate(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id)
+{
+    if (!esp_amp_rpc_server_valid(server) || server->rpmsg_dev == NULL) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    /* notification to client, which drops cached responses of srv_id */
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(server->rpmsg_dev, sizeof(esp_amp_rpc_pkt_t) + sizeof(uint16_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_out == NULL) {
+        return ESP_AMP_RPC_STATUS_NO_MEM;
+    }
+
+    uint16_t service_id = srv_id;
+    pkt_out->req_id = ESP_AMP_RPC_NOTIFY_REQ_ID;
+    pkt_out->service_id = ESP_AMP_RPC_INVALIDATE_SERVICE_ID;
+    pkt_out->status = ESP_AMP_RPC_STATUS_OK;
+    pkt_out->priority = ESP_AMP_RPC_PRIORITY_NORMAL;
+    pkt_out->params_len = sizeof(uint16_t);
+    pkt_out->timeout_ms = 0;
+    memcpy(pkt_out->params, &service_id, sizeof(uint16_t));
+
+    ESP_AMP_LOGD(TAG, "invalidate cache of srv(%u)", service_id);
+    if (esp_amp_rpmsg_send_nocopy(server->rpmsg_dev, &server->rpmsg_ept, server->client_addr,
+                                  pkt_out, sizeof(esp_amp_rpc_pkt_t) + sizeof(uint16_t)) != 0) {
+        ESP_AMP_LOGE(TAG, "Failed to send invalidation(%u)", service_id);
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_invalidate(esp_amp_rpc_service_id_t srv_id)
+{
+    return esp_amp_rpc_server_inst_invalidate(esp_amp_rpc_server_default, srv_id);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_config_service(esp_amp_rpc_server_handle_t server, esp_amp_rpc_service_id_t srv_id, uint8_t max_concurrency, uint8_t order_key)
+{
+    if (!esp_amp_rpc_server_valid(server)) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_NO_SERVICE;
+    esp_amp_rpc_service_tbl_t *tbl = &server->service_tbl;
+    xSemaphoreTakeRecursive(tbl->mutex, portMAX_DELAY);
+
+    int i = esp_amp_rpc_server_find_service(server, srv_id);
+    if (i != -1) {
+        /* changing order key of a service being executed may break ordering */
+        if (tbl->sched[i].running != 0 || (tbl->sched[i].lane != -1 && tbl->sched[tbl->sched[i].lane].next_ticket != tbl->sched[tbl->sched[i].lane].serving)) {
+            xSemaphoreGiveRecursive(tbl->mutex);
+            return ESP_AMP_RPC_STATUS_FAILED;
+        }
+
+        tbl->sched[i].max_concurrency = max_concurrency;
+        tbl->sched[i].order_key = order_key;
+        tbl->sched[i].lane = -1;
+        if (order_key != 0) {
+            /* services sharing the order key are serialized by the ticket of the first one configured */
+            for (int j = 0; j < tbl->static_num + tbl->len; j++) {
+                if (j != i && tbl->sched[j].order_key == order_key) {
+                    tbl->sched[i].lane = tbl->sched[j].lane;
+                    break;
+                }
+            }
+            if (tbl->sched[i].lane == -1) {
+                tbl->sched[i].lane = i;
+                tbl->sched[i].next_ticket = 0;
+                tbl->sched[i].serving = 0;
+            }
+        }
+        ret = ESP_AMP_RPC_STATUS_OK;
+    }
+
+    xSemaphoreGiveRecursive(tbl->mutex);
+    return ret;
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_config_service(esp_amp_rpc_service_id_t srv_id, uint8_t max_concurrency, uint8_t order_key)
+{
+    return esp_amp_rpc_server_inst_config_service(esp_amp_rpc_server_default, srv_id, max_concurrency, order_key);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_stop(esp_amp_rpc_server_handle_t server)
+{
+    if (!esp_amp_rpc_server_valid(server)) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    if (server->state == SERVER_STOPPED) {
         return ESP_AMP_RPC_STATUS_OK;
     }
 
-    if (esp_amp_rpc_server.state != SERVER_RUNNING) {
+    if (server->state != SERVER_RUNNING) {
         return ESP_AMP_RPC_STATUS_FAILED;
     }
 
     esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_OK;
-    xEventGroupSetBits(esp_amp_rpc_server.event, SERVER_EVENT_STOPPING);
-    EventBits_t event = xEventGroupWaitBits(esp_amp_rpc_server.event, SERVER_EVENT_STOPPED, false, false, pdMS_TO_TICKS(1000));
+    xEventGroupSetBits(server->event, SERVER_EVENT_STOPPING);
+    EventBits_t event = xEventGroupWaitBits(server->event, SERVER_EVENT_STOPPED, false, false, pdMS_TO_TICKS(1000));
     if (!(event & SERVER_EVENT_STOPPED)) {
         ret = ESP_AMP_RPC_STATUS_FAILED;
     }
 
     if (ret == ESP_AMP_RPC_STATUS_OK) {
-        esp_amp_rpc_server.state = SERVER_STOPPED;
+        server->state = SERVER_STOPPED;
     }
 
-    xEventGroupClearBits(esp_amp_rpc_server.event, SERVER_EVENT_STOPPED);
-    return ESP_AMP_RPC_STATUS_OK;
+    xEventGroupClearBits(server->event, SERVER_EVENT_STOPPING | SERVER_EVENT_STOPPED);
+    return ret;
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_server_deinit(void)
+esp_amp_rpc_status_t esp_amp_rpc_server_stop(void)
 {
+    return esp_amp_rpc_server_inst_stop(esp_amp_rpc_server_default);
+}
+
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_delete(esp_amp_rpc_server_handle_t server)
+{
+    if (!esp_amp_rpc_server_valid(server)) {
+        return ESP_AMP_RPC_STATUS_OK;
+    }
+
     esp_amp_rpc_status_t ret = ESP_AMP_RPC_STATUS_OK;
-    if (esp_amp_rpc_server.state == SERVER_RUNNING) {
-        ret = esp_amp_rpc_server_stop();
+    if (server->state == SERVER_RUNNING) {
+        ret = esp_amp_rpc_server_inst_stop(server);
+    }
+
+    if (ret == ESP_AMP_RPC_STATUS_OK) {
+        esp_amp_rpc_server_release(server);
     }
+    return ret;
+}
 
+esp_amp_rpc_status_t esp_amp_rpc_server_deinit(void)
+{
+    esp_amp_rpc_status_t ret = esp_amp_rpc_server_inst_delete(esp_amp_rpc_server_default);
     if (ret == ESP_AMP_RPC_STATUS_OK) {
-        if (esp_amp_rpc_server.rpmsg_dev) {
-            esp_amp_rpmsg_delete_endpoint(esp_amp_rpc_server.rpmsg_dev, esp_amp_rpc_server.server_addr);
-            esp_amp_rpc_server.rpmsg_dev = NULL;
+        esp_amp_rpc_server_default = NULL;
+    }
+    return ret;
+}
+
+/* take a ticket of the lane of the service, must be called with service_tbl.mutex held */
+static void esp_amp_rpc_server_schedule(esp_amp_rpc_server_t *server, esp_amp_rpc_server_job_t *job, uint16_t service_id)
+{
+    esp_amp_rpc_service_tbl_t *tbl = &server->service_tbl;
+    job->srv_idx = esp_amp_rpc_server_find_service(server, service_id);
+    if (job->srv_idx != -1 && tbl->sched[job->srv_idx].lane != -1) {
+        job->ticket = tbl->sched[tbl->sched[job->srv_idx].lane].next_ticket++;
+    }
+}
+
+/* true if nobody waits for the response any more: client timeout passed or client cancelled the request */
+static bool esp_amp_rpc_server_expired(esp_amp_rpc_server_t *server, const esp_amp_rpc_server_rx_t *rx)
+{
+    esp_amp_rpc_pkt_t *pkt = rx->pkt;
+    if (pkt->timeout_ms != 0 && xTaskGetTickCount() - rx->rx_tick >= ESP_AMP_RPC_SERVER_TIMEOUT_TICKS(pkt->timeout_ms)) {
+        ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_server_metrics, pkt->service_id, ESP_AMP_RPC_STATUS_TIMEOUT);
+        return true;
+    }
+    if (pkt->req_id == ESP_AMP_RPC_NOTIFY_REQ_ID) {
+        return false;
+    }
+
+    bool cancelled = false;
+    esp_amp_env_enter_critical();
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        esp_amp_rpc_server_cancel_t *cancel = &server->cancels[i];
+        if (cancel->req_id == pkt->req_id) {
+            /* a cancel older than the request was left by a previous request with the same req_id */
+            cancelled = cancelled || (int32_t)(cancel->rx_seq - rx->rx_seq) > 0;
+            cancel->req_id = ESP_AMP_RPC_NOTIFY_REQ_ID;
         }
-        if (esp_amp_rpc_server.event) {
-            vEventGroupDelete(esp_amp_rpc_server.event);
-            esp_amp_rpc_server.event = NULL;
+    }
+    esp_amp_env_exit_critical();
+
+    if (cancelled) {
+        ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_server_metrics, pkt->service_id, ESP_AMP_RPC_STATUS_CANCELLED);
+    }
+    return cancelled;
+}
+
+/* drop cancel message of an answered request, it arrived too late to take effect */
+static void esp_amp_rpc_server_forget_cancel(esp_amp_rpc_server_t *server, uint16_t req_id)
+{
+    esp_amp_env_enter_critical();
+    for (int i = 0; i < ESP_AMP_RPC_MAX_PENDING_REQ; i++) {
+        if (server->cancels[i].req_id == req_id) {
+            server->cancels[i].req_id = ESP_AMP_RPC_NOTIFY_REQ_ID;
         }
-        if (esp_amp_rpc_server.rx_q) {
-            vQueueDelete(esp_amp_rpc_server.rx_q);
-            esp_amp_rpc_server.rx_q = NULL;
+    }
+    esp_amp_env_exit_critical();
+}
+
+#if ESP_AMP_RPC_PRIORITY_NUM > 1
+/**
+ * move requests arrived so far from rx_q into ready_q, then take the most urgent one
+ * block on rx_q only if no request is ready. must be called with rx_lock held
+ */
+static bool esp_amp_rpc_server_receive(esp_amp_rpc_server_t *server, esp_amp_rpc_server_rx_t *rx)
+{
+    TickType_t wait = server->ready_q.num == 0 ? pdMS_TO_TICKS(500) : 0;
+    esp_amp_rpc_server_rx_t in;
+
+    while (!esp_amp_rpc_prio_q_is_full(&server->ready_q) && xQueueReceive(server->rx_q, &in, wait) == pdTRUE) {
+        int slot = esp_amp_rpc_prio_q_push(&server->ready_q, in.pkt->priority, in.rx_tick);
+        server->ready[slot] = in;
+        wait = 0;
+    }
+
+    int slot = esp_amp_rpc_prio_q_pop(&server->ready_q, xTaskGetTickCount());
+    if (slot == -1) {
+        return false;
+    }
+    *rx = server->ready[slot];
+    return true;
+}
+#endif /* ESP_AMP_RPC_PRIORITY_NUM > 1 */
+
+/**
+ * dequeue a request and schedule it, or each of its sub-requests if it is a batch
+ * expired request is dropped here, before it takes any ticket
+ * return number of jobs scheduled, 0 if nothing is received or batch is malformed
+ */
+static int esp_amp_rpc_server_dequeue(esp_amp_rpc_server_t *server, esp_amp_rpc_server_rx_t *rx, esp_amp_rpc_server_job_t *jobs)
+{
+    int num = 0;
+    rx->pkt = NULL;
+
+    if (xSemaphoreTake(server->rx_lock, pdMS_TO_TICKS(500)) != pdTRUE) {
+        return 0;
+    }
+
+#if ESP_AMP_RPC_PRIORITY_NUM > 1
+    bool received = esp_amp_rpc_server_receive(server, rx);
+#else
+    bool received = xQueueReceive(server->rx_q, rx, pdMS_TO_TICKS(500)) == pdTRUE;
+#endif /* ESP_AMP_RPC_PRIORITY_NUM > 1 */
+    if (received && esp_amp_rpc_server_expired(server, rx)) {
+        ESP_AMP_LOGD(TAG, "Drop expired req(%u, %u)", rx->pkt->req_id, rx->pkt->service_id);
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, rx->pkt);
+        rx->pkt = NULL;
+    }
+
+    if (rx->pkt != NULL) {
+        esp_amp_rpc_pkt_t *pkt = rx->pkt;
+        xSemaphoreTakeRecursive(server->service_tbl.mutex, portMAX_DELAY);
+        if (pkt->service_id != ESP_AMP_RPC_BATCH_SERVICE_ID) {
+            esp_amp_rpc_server_schedule(server, &jobs[0], pkt->service_id);
+            num = 1;
+        } else if (esp_amp_rpc_batch_count(pkt->params, pkt->params_len) > 0) {
+            /* sub-requests take consecutive tickets, so that a run of them in one lane is executed at once */
+            for (esp_amp_rpc_pkt_t *sub = esp_amp_rpc_batch_next(pkt->params, pkt->params_len, NULL); sub != NULL;
+                    sub = esp_amp_rpc_batch_next(pkt->params, pkt->params_len, sub)) {
+                esp_amp_rpc_server_schedule(server, &jobs[num++], sub->service_id);
+            }
         }
-        if (esp_amp_rpc_server.service_tbl.mutex) {
-            vSemaphoreDelete(esp_amp_rpc_server.service_tbl.mutex);
-            esp_amp_rpc_server.service_tbl.mutex = NULL;
+        xSemaphoreGiveRecursive(server->service_tbl.mutex);
+    }
+
+    xSemaphoreGive(server->rx_lock);
+    return num;
+}
+
+/* true if service has a free execution slot and the request is the oldest in its lane. must be called with service_tbl.mutex held */
+static bool esp_amp_rpc_server_runnable(esp_amp_rpc_server_t *server, const esp_amp_rpc_server_job_t *job)
+{
+    esp_amp_rpc_service_tbl_t *tbl = &server->service_tbl;
+    esp_amp_rpc_service_sched_t *sched = &tbl->sched[job->srv_idx];
+    bool slot_free = sched->max_concurrency == 0 || sched->running < sched->max_concurrency;
+    bool in_turn = sched->lane == -1 || tbl->sched[sched->lane].serving == job->ticket;
+    return slot_free && in_turn;
+}
+
+/* take an execution slot of a runnable service and a copy of it. must be called with service_tbl.mutex held */
+static void esp_amp_rpc_server_take(esp_amp_rpc_server_t *server, int worker_idx, const esp_amp_rpc_server_job_t *job, esp_amp_rpc_service_t *service)
+{
+    esp_amp_rpc_service_tbl_t *tbl = &server->service_tbl;
+    tbl->sched[job->srv_idx].running++;
+    tbl->waiting_workers &= ~(1 << worker_idx);
+    *service = *esp_amp_rpc_server_get_service(server, job->srv_idx);
+}
+
+/* take the oldest parked request which can run now, return false if none */
+static bool esp_amp_rpc_server_unpark(esp_amp_rpc_server_t *server, int worker_idx, esp_amp_rpc_server_rx_t *rx, esp_amp_rpc_server_job_t *job, esp_amp_rpc_service_t *service)
+{
+    esp_amp_rpc_service_tbl_t *tbl = &server->service_tbl;
+    bool found = false;
+
+    xSemaphoreTakeRecursive(tbl->mutex, portMAX_DELAY);
+    for (int i = 0; i < tbl->parked_num; i++) {
+        if (esp_amp_rpc_server_runnable(server, &tbl->parked[i].job)) {
+            *rx = tbl->parked[i].rx;
+            *job = tbl->parked[i].job;
+            esp_amp_rpc_server_take(server, worker_idx, job, service);
+            memmove(&tbl->parked[i], &tbl->parked[i + 1], (tbl->parked_num - i - 1) * sizeof(esp_amp_rpc_server_parked_t));
+            tbl->parked_num--;
+            found = true;
+            break;
         }
     }
+    xSemaphoreGiveRecursive(tbl->mutex);
+    return found;
+}
 
-    esp_amp_rpc_server.state = SERVER_INVALID;
-    return ret;
+static void esp_amp_rpc_server_handle_pkt(esp_amp_rpc_server_t *server, int worker_idx, const esp_amp_rpc_server_job_t *jobs, int num, const esp_amp_rpc_server_rx_t *rx, const esp_amp_rpc_service_t *service);
+
+/* execute one parked request which can run now, return false if none */
+static bool esp_amp_rpc_server_run_parked(esp_amp_rpc_server_t *server, int worker_idx)
+{
+    esp_amp_rpc_server_rx_t rx;
+    esp_amp_rpc_server_job_t job;
+    esp_amp_rpc_service_t service;
+
+    if (!esp_amp_rpc_server_unpark(server, worker_idx, &rx, &job, &service)) {
+        return false;
+    }
+    esp_amp_rpc_server_handle_pkt(server, worker_idx, &job, 1, &rx, &service);
+    return true;
 }
 
-static void esp_amp_rpc_server_task(void *args)
+/**
+ * block until service has a free execution slot and the request is the oldest in its lane, then take a copy of service
+ * only used where the worker cannot give the request up: sub-requests of a batch, or no room to park.
+ * while waiting, the worker executes parked requests, as one of them may hold the turn this request waits for
+ */
+static void esp_amp_rpc_server_acquire(esp_amp_rpc_server_t *server, int worker_idx, const esp_amp_rpc_server_job_t *job, esp_amp_rpc_service_t *service)
 {
-    (void) args;
-    int ret = 0;
-    esp_amp_rpc_pkt_t *pkt_in = NULL;
-    esp_amp_rpc_pkt_t *pkt_out = NULL;
-    uint32_t rpmsg_len = esp_amp_rpmsg_get_max_size(esp_amp_rpc_server.rpmsg_dev);
+    esp_amp_rpc_service_tbl_t *tbl = &server->service_tbl;
 
     while (true) {
-        EventBits_t event = xEventGroupWaitBits(esp_amp_rpc_server.event, SERVER_EVENT_STOPPING, false, false, 0);
-        if (event & SERVER_EVENT_STOPPING) {
-            /* server stop as user required */
-            xEventGroupClearBits(esp_amp_rpc_server.event, SERVER_EVENT_STOPPING);
-            break;
+        xSemaphoreTakeRecursive(tbl->mutex, portMAX_DELAY);
+        if (esp_amp_rpc_server_runnable(server, job)) {
+            esp_amp_rpc_server_take(server, worker_idx, job, service);
+            xSemaphoreGiveRecursive(tbl->mutex);
+            return;
         }
+        tbl->waiting_workers |= (1 << worker_idx);
+        xEventGroupClearBits(server->event, SERVER_EVENT_WORKER(worker_idx));
+        xSemaphoreGiveRecursive(tbl->mutex);
 
-        /* recv from isr */
-        if (xQueueReceive(esp_amp_rpc_server.rx_q, &pkt_in, pdMS_TO_TICKS(500)) != pdTRUE) {
-            ret = -1;
+        if (esp_amp_rpc_server_run_parked(server, worker_idx)) {
+            continue;
         }
+        xEventGroupWaitBits(server->event, SERVER_EVENT_WORKER(worker_idx), true, true, portMAX_DELAY);
+    }
+}
 
-        /* alloc tx_buf (pkt_out) */
-        if (ret != -1) {
-            pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(esp_amp_rpc_server.rpmsg_dev, rpmsg_len, ESP_AMP_RPMSG_DATA_DEFAULT);
-            if (pkt_out == NULL) {
-                ESP_AMP_LOGE(TAG, "Failed to alloc tx buf for pkt_out");
-                ret = -1;
-            }
+/**
+ * take the service of a dequeued request, or park the request if it has to wait, so that the worker moves on to
+ * the next request instead of blocking behind a busy service. batches are executed by the worker dequeuing them.
+ * return false if the request is parked
+ */
+static bool esp_amp_rpc_server_admit(esp_amp_rpc_server_t *server, int worker_idx, const esp_amp_rpc_server_rx_t *rx, const esp_amp_rpc_server_job_t *job, esp_amp_rpc_service_t *service)
+{
+    esp_amp_rpc_service_tbl_t *tbl = &server->service_tbl;
+
+    memset(service, 0, sizeof(esp_amp_rpc_service_t));
+    if (rx->pkt->service_id == ESP_AMP_RPC_BATCH_SERVICE_ID || job->srv_idx == -1) {
+        return true;
+    }
+
+    xSemaphoreTakeRecursive(tbl->mutex, portMAX_DELAY);
+    if (esp_amp_rpc_server_runnable(server, job)) {
+        esp_amp_rpc_server_take(server, worker_idx, job, service);
+        xSemaphoreGiveRecursive(tbl->mutex);
+        return true;
+    }
+    if (tbl->parked_num < ESP_AMP_RPC_MAX_PENDING_REQ) {
+        tbl->parked[tbl->parked_num].rx = *rx;
+        tbl->parked[tbl->parked_num].job = *job;
+        tbl->parked_num++;
+        xSemaphoreGiveRecursive(tbl->mutex);
+        ESP_AMP_LOGD(TAG, "Park req(%u, %u)", rx->pkt->req_id, rx->pkt->service_id);
+        return false;
+    }
+    xSemaphoreGiveRecursive(tbl->mutex);
+
+    esp_amp_rpc_server_acquire(server, worker_idx, job, service);
+    return true;
+}
+
+/* release service acquired for num requests holding consecutive tickets */
+static void esp_amp_rpc_server_unacquire(esp_amp_rpc_server_t *server, int srv_idx, int num)
+{
+    esp_amp_rpc_service_tbl_t *tbl = &server->service_tbl;
+    esp_amp_rpc_service_sched_t *sched = &tbl->sched[srv_idx];
+
+    xSemaphoreTakeRecursive(tbl->mutex, portMAX_DELAY);
+    sched->running--;
+    if (sched->lane != -1) {
+        tbl->sched[sched->lane].serving += num;
+    }
+
+    /* let waiting workers recheck their turn */
+    EventBits_t wake_bits = 0;
+    for (int i = 0; i < server->max_worker_num; i++) {
+        if (tbl->waiting_workers & (1 << i)) {
+            wake_bits |= SERVER_EVENT_WORKER(i);
         }
+    }
+    xSemaphoreGiveRecursive(tbl->mutex);
 
-        /* if buffer out also ready */
-        if (ret != -1) {
-            ESP_AMP_LOGD(TAG, "pkt_in at %p, pkt_out at %p", pkt_in, pkt_out);
-            /* copy from pkt_in to pkt_out */
-            memcpy(pkt_out, pkt_in, sizeof(esp_amp_rpc_pkt_t));
-            pkt_out->params_len = rpmsg_len;
-            pkt_out->status = ESP_AMP_RPC_STATUS_NO_SERVICE;
+    if (wake_bits) {
+        xEventGroupSetBits(server->event, wake_bits);
+    }
+}
 
-            ESP_AMP_LOGD(TAG, "Executing(req_id:%u, srv_id:%u, status:%u, param_len:%u)", pkt_in->req_id, pkt_in->service_id, pkt_in->status, pkt_in->params_len);
-            /* execute service */
-            esp_amp_rpc_service_func_t service_handler = NULL;
+typedef struct {
+    esp_amp_rpc_server_t *server;
+    int worker_idx;
+    const esp_amp_rpc_server_job_t *jobs;
+    esp_amp_rpc_service_t service;
+} esp_amp_rpc_server_batch_ctx_t;
 
-            xSemaphoreTakeRecursive(esp_amp_rpc_server.service_tbl.mutex, portMAX_DELAY);
-            for (int i = 0; i < esp_amp_rpc_server.service_tbl.len; i++) {
-                if (esp_amp_rpc_server.service_tbl.services[i].handler == NULL) {
-                    continue;
-                }
-                if (esp_amp_rpc_server.service_tbl.services[i].id == pkt_in->service_id) {
-                    service_handler = esp_amp_rpc_server.service_tbl.services[i].handler;
-                    break;
-                }
-            }
-            xSemaphoreGiveRecursive(esp_amp_rpc_server.service_tbl.mutex);
+static const esp_amp_rpc_service_t *esp_amp_rpc_server_batch_acquire(void *arg, uint16_t service_id, int idx, int num)
+{
+    esp_amp_rpc_server_batch_ctx_t *ctx = (esp_amp_rpc_server_batch_ctx_t *)arg;
+    if (ctx->jobs[idx].srv_idx == -1) {
+        return NULL;
+    }
+    esp_amp_rpc_server_acquire(ctx->server, ctx->worker_idx, &ctx->jobs[idx], &ctx->service);
+    return &ctx->service;
+}
 
-            if (service_handler != NULL) {
-                if (service_handler((void **)pkt_in->params, pkt_in->params_len, (void **)pkt_out->params, &pkt_out->params_len) == 0) {
-                    pkt_out->status = ESP_AMP_RPC_STATUS_OK;
-                } else {
-                    pkt_out->status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
-                }
-            }
+static void esp_amp_rpc_server_batch_release(void *arg, int idx, int num)
+{
+    esp_amp_rpc_server_batch_ctx_t *ctx = (esp_amp_rpc_server_batch_ctx_t *)arg;
+    esp_amp_rpc_server_unacquire(ctx->server, ctx->jobs[idx].srv_idx, num);
 
-            /* release rx buffer (pkt_in) */
-            esp_amp_rpmsg_destroy(esp_amp_rpc_server.rpmsg_dev, pkt_in);
+    /* requests parked behind the service just released are not left waiting until the batch completes */
+    while (esp_amp_rpc_server_run_parked(ctx->server, ctx->worker_idx)) {
+    }
+}
 
-            if (pkt_out->status == ESP_AMP_RPC_STATUS_OK) {
-                ESP_AMP_LOGD(TAG, "Execd req(%u, %u)", pkt_out->req_id, pkt_out->service_id);
-            }
+/* execute sub-requests of a batch one service run at a time, return length of combined response or -1 */
+static int esp_amp_rpc_server_handle_batch(esp_amp_rpc_server_t *server, int worker_idx, const esp_amp_rpc_server_job_t *jobs, int num, esp_amp_rpc_pkt_t *pkt_in, esp_amp_rpc_pkt_t *pkt_out, uint32_t params_out_cap)
+{
+    esp_amp_rpc_server_batch_ctx_t ctx = {
+        .server = server,
+        .worker_idx = worker_idx,
+        .jobs = jobs,
+    };
+    esp_amp_rpc_batch_ops_t ops = {
+        .acquire = esp_amp_rpc_server_batch_acquire,
+        .release = esp_amp_rpc_server_batch_release,
+        .arg = &ctx,
+    };
 
-            if (pkt_out->status == ESP_AMP_RPC_STATUS_NO_SERVICE) {
-                ESP_AMP_LOGE(TAG, "Invalid srv id req(%u, %u)", pkt_out->req_id, pkt_out->service_id);
+    int len = -1;
+    if (pkt_out != NULL) {
+        len = esp_amp_rpc_batch_execute(pkt_in->params, pkt_in->params_len, pkt_out->params, params_out_cap, &ops);
+    }
+    if (len == -1) {
+        /* nothing is executed, but tickets must be consumed, otherwise the lanes stall */
+        for (int i = 0; i < num; i++) {
+            if (jobs[i].srv_idx != -1) {
+                esp_amp_rpc_server_acquire(server, worker_idx, &jobs[i], &ctx.service);
+                esp_amp_rpc_server_unacquire(server, jobs[i].srv_idx, 1);
             }
+        }
+    }
+    return len;
+}
+
+/* execute a request whose service is already taken by the worker (single request only), then release the service */
+static void esp_amp_rpc_server_handle_pkt(esp_amp_rpc_server_t *server, int worker_idx, const esp_amp_rpc_server_job_t *jobs, int num, const esp_amp_rpc_server_rx_t *rx, const esp_amp_rpc_service_t *service)
+{
+    uint32_t rpmsg_len = esp_amp_rpmsg_get_max_size(server->rpmsg_dev);
+    esp_amp_rpc_pkt_t *pkt_in = rx->pkt;
+    uint16_t service_id = pkt_in->service_id;
+    bool batch = service_id == ESP_AMP_RPC_BATCH_SERVICE_ID;
+    int srv_idx = batch ? -1 : jobs[0].srv_idx;
+
+    /* request may expire while parked. its ticket is consumed by the release, otherwise the lane stalls */
+    if (srv_idx != -1 && esp_amp_rpc_server_expired(server, rx)) {
+        ESP_AMP_LOGD(TAG, "Drop expired req(%u, %u)", pkt_in->req_id, pkt_in->service_id);
+        esp_amp_rpc_server_unacquire(server, srv_idx, 1);
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in);
+        return;
+    }
+    esp_amp_rpc_service_func_t service_handler = service->handler;
+
+    /* time waiting in rx_q and for its turn */
+    uint32_t exec_us = ESP_AMP_RPC_METRICS_NOW();
+    ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_server_metrics, service_id, ESP_AMP_RPC_METRICS_QUEUE, exec_us - rx->rx_us);
+
+    /* one-way notification, no tx buffer is taken */
+    if (pkt_in->req_id == ESP_AMP_RPC_NOTIFY_REQ_ID) {
+        uint16_t params_out_len = 0;
+        esp_amp_rpc_status_t status = ESP_AMP_RPC_STATUS_OK;
+        if (batch) {
+            ESP_AMP_LOGE(TAG, "Batch cannot be sent as notification");
+            esp_amp_rpc_server_handle_batch(server, worker_idx, jobs, num, pkt_in, NULL, 0);
+            status = ESP_AMP_RPC_STATUS_BAD_PACKET;
+        } else if (service_handler == NULL) {
+            ESP_AMP_LOGE(TAG, "Invalid srv id notification(%u)", pkt_in->service_id);
+            status = ESP_AMP_RPC_STATUS_NO_SERVICE;
+        } else if (service_handler(pkt_in->params, pkt_in->params_len, NULL, &params_out_len) != 0) {
+            ESP_AMP_LOGE(TAG, "Failed to execute notification(%u)", pkt_in->service_id);
+            status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
+        }
+        ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_server_metrics, service_id, ESP_AMP_RPC_METRICS_EXEC, ESP_AMP_RPC_METRICS_NOW() - exec_us);
+        ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_server_metrics, service_id, status);
+        if (srv_idx != -1) {
+            esp_amp_rpc_server_unacquire(server, srv_idx, 1);
+        }
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in);
+        return;
+    }
 
-            if (pkt_out->status == ESP_AMP_RPC_STATUS_EXEC_FAILED) {
-                ESP_AMP_LOGE(TAG, "Failed to execute req(%u, %u)", pkt_out->req_id, pkt_out->service_id);
+    /* alloc tx_buf (pkt_out) only when it is our turn, waiting workers do not hold tx buffers */
+    esp_amp_rpc_pkt_t *pkt_out = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(server->rpmsg_dev, rpmsg_len, ESP_AMP_RPMSG_DATA_DEFAULT);
+    if (pkt_out == NULL) {
+        ESP_AMP_LOGE(TAG, "Failed to alloc tx buf for pkt_out");
+    }
+
+    if (batch) {
+        int len = esp_amp_rpc_server_handle_batch(server, worker_idx, jobs, num, pkt_in, pkt_out, rpmsg_len - sizeof(esp_amp_rpc_pkt_t));
+        if (pkt_out != NULL) {
+            memcpy(pkt_out, pkt_in, sizeof(esp_amp_rpc_pkt_t));
+            pkt_out->status = len == -1 ? ESP_AMP_RPC_STATUS_BAD_PACKET : ESP_AMP_RPC_STATUS_OK;
+            pkt_out->params_len = len == -1 ? 0 : len;
+        }
+    } else if (pkt_out != NULL) {
+        /* if buffer out also ready */
+        ESP_AMP_LOGD(TAG, "pkt_in at %p, pkt_out at %p", pkt_in, pkt_out);
+        /* copy from pkt_in to pkt_out */
+        memcpy(pkt_out, pkt_in, sizeof(esp_amp_rpc_pkt_t));
+        pkt_out->params_len = rpmsg_len;
+        pkt_out->status = ESP_AMP_RPC_STATUS_NO_SERVICE;
+
+        ESP_AMP_LOGD(TAG, "Executing(req_id:%u, srv_id:%u, status:%u, param_len:%u)", pkt_in->req_id, pkt_in->service_id, pkt_in->status, pkt_in->params_len);
+        /* execute service */
+        if (service_handler != NULL) {
+            esp_amp_rpc_server_stream_t *stream = &server->workers[worker_idx].stream;
+            stream->req_id = pkt_in->req_id;
+            stream->service_id = pkt_in->service_id;
+            stream->priority = pkt_in->priority;
+            stream->params_out = pkt_out->params;
+            if (service_handler((void **)pkt_in->params, pkt_in->params_len, (void **)pkt_out->params, &pkt_out->params_len) == 0) {
+                pkt_out->status = ESP_AMP_RPC_STATUS_OK;
+            } else {
+                pkt_out->status = ESP_AMP_RPC_STATUS_EXEC_FAILED;
             }
+            stream->params_out = NULL;
         }
+    }
+    ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_server_metrics, service_id, ESP_AMP_RPC_METRICS_EXEC, ESP_AMP_RPC_METRICS_NOW() - exec_us);
+    ESP_AMP_RPC_METRICS_CALL(&esp_amp_rpc_server_metrics, service_id, pkt_out ? pkt_out->status : ESP_AMP_RPC_STATUS_NO_MEM);
+
+    if (srv_idx != -1) {
+        esp_amp_rpc_server_unacquire(server, srv_idx, 1);
+    }
+
+    /* cancel arriving while the request executed is useless now, and must not hit a later request reusing its req_id */
+    esp_amp_rpc_server_forget_cancel(server, pkt_in->req_id);
+
+    /* release rx buffer (pkt_in) */
+    esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in);
+
+    if (pkt_out == NULL) {
+        return;
+    }
+
+    if (pkt_out->status == ESP_AMP_RPC_STATUS_OK) {
+        ESP_AMP_LOGD(TAG, "Execd req(%u, %u)", pkt_out->req_id, pkt_out->service_id);
+    }
+
+    if (pkt_out->status == ESP_AMP_RPC_STATUS_NO_SERVICE) {
+        ESP_AMP_LOGE(TAG, "Invalid srv id req(%u, %u)", pkt_out->req_id, pkt_out->service_id);
+    }
+
+    if (pkt_out->status == ESP_AMP_RPC_STATUS_EXEC_FAILED) {
+        ESP_AMP_LOGE(TAG, "Failed to execute req(%u, %u)", pkt_out->req_id, pkt_out->service_id);
+    }
+
+    /* as long as decode successfully, send back the result */
+    ESP_AMP_LOGD(TAG, "sending rsp(%u)", pkt_out->req_id);
+    ESP_AMP_RPC_METRICS_TIME(&esp_amp_rpc_server_metrics, service_id, ESP_AMP_RPC_METRICS_LATENCY, ESP_AMP_RPC_METRICS_NOW() - rx->rx_us);
+    esp_amp_rpmsg_send_nocopy(server->rpmsg_dev, &server->rpmsg_ept, server->client_addr,
+                              pkt_out, pkt_out->params_len + sizeof(esp_amp_rpc_pkt_t));
+}
 
-        /* as long as decode successfully, send back the result */
-        if (ret != -1) {
-            ESP_AMP_LOGD(TAG, "sending rsp(%u)", pkt_out->req_id);
-            esp_amp_rpmsg_send_nocopy(esp_amp_rpc_server.rpmsg_dev, &esp_amp_rpc_server.rpmsg_ept, esp_amp_rpc_server.client_addr,
-                                      pkt_out, pkt_out->params_len + sizeof(esp_amp_rpc_pkt_t));
+static void esp_amp_rpc_server_task(void *args)
+{
+    esp_amp_rpc_server_worker_t *worker = (esp_amp_rpc_server_worker_t *)args;
+    esp_amp_rpc_server_t *server = worker->server;
+    int worker_idx = worker->idx;
+    esp_amp_rpc_server_rx_t rx;
+    esp_amp_rpc_service_t service;
+
+    worker->task = xTaskGetCurrentTaskHandle();
+    esp_amp_rpc_server_job_t jobs[ESP_AMP_RPC_BATCH_MAX_REQ];
+
+    while (true) {
+        EventBits_t event = xEventGroupWaitBits(server->event, SERVER_EVENT_STOPPING, false, false, 0);
+        if (event & SERVER_EVENT_STOPPING) {
+            /* server stop as user required */
+            break;
+        }
+
+        /* parked requests were dequeued before anything left in rx_q */
+        if (esp_amp_rpc_server_run_parked(server, worker_idx)) {
+            continue;
+        }
+
+        /* recv from isr */
+        int num = esp_amp_rpc_server_dequeue(server, &rx, jobs);
+        if (rx.pkt != NULL && esp_amp_rpc_server_admit(server, worker_idx, &rx, &jobs[0], &service)) {
+            esp_amp_rpc_server_handle_pkt(server, worker_idx, jobs, num, &rx, &service);
         }
     }
 
-    ESP_AMP_LOGD(TAG, "%s(): server task stopped", __func__);
-    xEventGroupSetBits(esp_amp_rpc_server.event, SERVER_EVENT_STOPPED);
+    ESP_AMP_LOGD(TAG, "%s(): server worker %d stopped", __func__, worker_idx);
+
+    /* the last worker reports server stopped */
+    xSemaphoreTakeRecursive(server->service_tbl.mutex, portMAX_DELAY);
+    worker->task = NULL;
+    int worker_num = --server->worker_num;
+    xSemaphoreGiveRecursive(server->service_tbl.mutex);
+    if (worker_num == 0) {
+        xEventGroupSetBits(server->event, SERVER_EVENT_STOPPED);
+    }
     vTaskDelete(NULL);
 }
 
-esp_amp_rpc_status_t esp_amp_rpc_server_run(void)
+esp_amp_rpc_status_t esp_amp_rpc_server_inst_run(esp_amp_rpc_server_handle_t server)
 {
     esp_amp_rpc_status_t ret;
 
-    switch (esp_amp_rpc_server.state) {
+    if (server == NULL) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+
+    switch (server->state) {
     case SERVER_READY:
     case SERVER_STOPPED:
-        if (xTaskCreate(esp_amp_rpc_server_task, "rpc_server", esp_amp_rpc_server.stack_size, NULL, esp_amp_rpc_server.task_priority, NULL) != pdPASS) {
-            ESP_AMP_LOGE(TAG, "Failed to create rpc server task");
-            ret = ESP_AMP_RPC_STATUS_FAILED;
-        } else {
-            esp_amp_rpc_server.state = SERVER_RUNNING;
-            ret = ESP_AMP_RPC_STATUS_OK;
+        ret = ESP_AMP_RPC_STATUS_OK;
+        server->worker_num = 0;
+        for (int i = 0; i < server->max_worker_num; i++) {
+            xSemaphoreTakeRecursive(server->service_tbl.mutex, portMAX_DELAY);
+            if (xTaskCreate(esp_amp_rpc_server_task, "rpc_server", server->stack_size, &server->workers[i], server->task_priority, NULL) != pdPASS) {
+                xSemaphoreGiveRecursive(server->service_tbl.mutex);
+                ESP_AMP_LOGE(TAG, "Failed to create rpc server task");
+                ret = ESP_AMP_RPC_STATUS_FAILED;
+                break;
+            }
+            server->worker_num++;
+            xSemaphoreGiveRecursive(server->service_tbl.mutex);
+        }
+        /* workers already created keep serving */
+        if (server->worker_num > 0) {
+            server->state = SERVER_RUNNING;
         }
         break;
     case SERVER_RUNNING:
@@ -319,21 +1142,68 @@ esp_amp_rpc_status_t esp_amp_rpc_server_run(void)
     return ret;
 }
 
+esp_amp_rpc_status_t esp_amp_rpc_server_run(void)
+{
+    return esp_amp_rpc_server_inst_run(esp_amp_rpc_server_default);
+}
 
 static int esp_amp_rpc_server_isr(void *pkt_in_buf, uint16_t size, uint16_t src_addr, void* rx_cb_data)
 {
+    esp_amp_rpc_server_t *server = (esp_amp_rpc_server_t *)rx_cb_data;
+
     if (size < sizeof(esp_amp_rpc_pkt_t)) {
         ESP_AMP_DRAM_LOGE(TAG, "incomplete rx buf");
-        esp_amp_rpmsg_destroy(esp_amp_rpc_server.rpmsg_dev, pkt_in_buf);
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in_buf);
         return 0;
     }
 
-    BaseType_t need_yield;
+    /* cancel message is recorded here rather than queued, as the req it cancels is queued ahead of it */
+    esp_amp_rpc_pkt_t *pkt_in = (esp_amp_rpc_pkt_t *)pkt_in_buf;
+    if (pkt_in->service_id == ESP_AMP_RPC_CANCEL_SERVICE_ID) {
+        esp_amp_env_enter_critical();
+        server->cancels[server->cancel_next].req_id = pkt_in->req_id;
+        server->cancels[server->cancel_next].rx_seq = server->rx_seq++;
+        server->cancel_next = (server->cancel_next + 1) % ESP_AMP_RPC_MAX_PENDING_REQ;
+        esp_amp_env_exit_critical();
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in_buf);
+        return 0;
+    }
+
+    BaseType_t need_yield = pdFALSE;
+    esp_amp_rpc_server_rx_t rx = {
+        .pkt = pkt_in,
+        .rx_tick = xTaskGetTickCountFromISR(),
+        .rx_seq = server->rx_seq++,
+        .rx_us = ESP_AMP_RPC_METRICS_NOW(),
+    };
     /* try to send to server */
-    if (xQueueSendFromISR(esp_amp_rpc_server.rx_q, &pkt_in_buf, &need_yield) != pdTRUE) {
-        esp_amp_rpmsg_destroy(esp_amp_rpc_server.rpmsg_dev, pkt_in_buf);
+    if (xQueueSendFromISR(server->rx_q, &rx, &need_yield) != pdTRUE) {
+        esp_amp_rpmsg_destroy(server->rpmsg_dev, pkt_in_buf);
     }
 
     portYIELD_FROM_ISR(need_yield);
     return 0;
 }
+
+#if CONFIG_ESP_AMP_RPC_METRICS
+esp_amp_rpc_status_t esp_amp_rpc_server_metrics_get(uint16_t service_id, esp_amp_rpc_metrics_t *metrics)
+{
+    if (metrics == NULL) {
+        return ESP_AMP_RPC_STATUS_INVALID_ARG;
+    }
+    if (esp_amp_rpc_metrics_get(&esp_amp_rpc_server_metrics, service_id, metrics) != 0) {
+        return ESP_AMP_RPC_STATUS_NO_SERVICE;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+void esp_amp_rpc_server_metrics_reset(void)
+{
+    esp_amp_rpc_metrics_reset(&esp_amp_rpc_server_metrics);
+}
+
+void esp_amp_rpc_server_metrics_dump(void)
+{
+    esp_amp_rpc_metrics_dump(&esp_amp_rpc_server_metrics, TAG);
+}
+#endif /* CONFIG_ESP_AMP_RPC_METRICS */
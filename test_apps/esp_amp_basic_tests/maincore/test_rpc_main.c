@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -7,6 +8,7 @@
 #include "esp_log.h"
 #include "esp_amp.h"
 #include "esp_err.h"
+#include "esp_bit_defs.h"
 
 #include "unity.h"
 #include "unity_test_runner.h"
@@ -17,6 +19,11 @@
 #define RPC_SUB_CORE_CLIENT  0x1000
 #define RPC_SUB_CORE_SERVER  0x1001
 
+/* loopback of a main-side and a sub-side rpmsg device, both polled on main-core */
+#define RPC_LOOPBACK_SYSINFO_ID     (0x0110)
+#define RPC_LOOPBACK_QUEUE_LEN      (16)
+#define RPC_LOOPBACK_ITEM_SIZE      (64)
+
 TEST_CASE("RPC client init/deinit", "[esp_amp]")
 {
     TEST_ASSERT(esp_amp_init() == 0);
@@ -156,3 +163,889 @@ TEST_CASE("RPC server add service", "[esp_amp]")
     free(rpmsg_dev);
     vTaskDelay(pdMS_TO_TICKS(500));
 }
+
+/*
+ * FreeRTOS client and server both run on main-core, the client on the main-side and the server on the sub-side
+ * rpmsg device of a loopback. A task polls both devices, so callbacks run in task context instead of interrupt.
+ */
+static esp_amp_rpmsg_dev_t rpc_loopback_main_dev;
+static esp_amp_rpmsg_dev_t rpc_loopback_sub_dev;
+static volatile bool rpc_loopback_running;
+static SemaphoreHandle_t rpc_loopback_stopped;
+
+static void rpc_loopback_poll_task(void *arg)
+{
+    while (rpc_loopback_running) {
+        while (esp_amp_rpmsg_poll(&rpc_loopback_main_dev) == 0 || esp_amp_rpmsg_poll(&rpc_loopback_sub_dev) == 0) {
+        }
+        vTaskDelay(1);
+    }
+    xSemaphoreGive(rpc_loopback_stopped);
+    vTaskDelete(NULL);
+}
+
+static void rpc_loopback_start(void)
+{
+    static esp_amp_queue_t main_vqueue[2];
+    static esp_amp_queue_t sub_vqueue[2];
+    static bool inited = false;
+
+    TEST_ASSERT(esp_amp_init() == 0);
+    if (!inited) {
+        /* shared memory of the loopback is allocated once per boot */
+        TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_main_init_by_id(&rpc_loopback_main_dev, main_vqueue, RPC_LOOPBACK_QUEUE_LEN, RPC_LOOPBACK_ITEM_SIZE, false, true, RPC_LOOPBACK_SYSINFO_ID));
+        TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_sub_init_by_id(&rpc_loopback_sub_dev, sub_vqueue, false, true, RPC_LOOPBACK_SYSINFO_ID));
+        rpc_loopback_stopped = xSemaphoreCreateBinary();
+        TEST_ASSERT_NOT_NULL(rpc_loopback_stopped);
+        inited = true;
+    }
+
+    rpc_loopback_running = true;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(rpc_loopback_poll_task, "rpc_poll", 4096, NULL, 6, NULL));
+}
+
+static void rpc_loopback_stop(void)
+{
+    rpc_loopback_running = false;
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(rpc_loopback_stopped, pdMS_TO_TICKS(1000)));
+}
+
+#define RPC_TEST_SRV_SLOW   (0x10)
+#define RPC_TEST_SRV_FAST   (0x11)
+
+static volatile uint32_t rpc_test_slow_ms;
+static volatile int rpc_test_slow_running;
+static volatile int rpc_test_slow_max_running;
+static volatile int rpc_test_slow_done;
+
+static esp_amp_rpc_status_t rpc_test_slow_service(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    int running = ++rpc_test_slow_running;
+    if (running > rpc_test_slow_max_running) {
+        rpc_test_slow_max_running = running;
+    }
+    vTaskDelay(pdMS_TO_TICKS(rpc_test_slow_ms));
+    rpc_test_slow_running--;
+    rpc_test_slow_done++;
+    *params_out_len = 0;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static volatile int rpc_test_fast_done;
+
+static esp_amp_rpc_status_t rpc_test_fast_service(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    rpc_test_fast_done++;
+    *params_out_len = 0;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+typedef struct {
+    volatile int ok;
+    volatile int failed;
+} rpc_test_async_result_t;
+
+static void rpc_test_async_cb(esp_amp_rpc_status_t status, void *params_out, uint16_t params_out_len, void *ctx)
+{
+    rpc_test_async_result_t *result = (rpc_test_async_result_t *)ctx;
+    if (status == ESP_AMP_RPC_STATUS_OK) {
+        result->ok++;
+    } else {
+        result->failed++;
+    }
+}
+
+TEST_CASE("RPC server worker serves other services while one is busy", "[esp_amp]")
+{
+    rpc_loopback_start();
+
+    esp_amp_rpc_server_handle_t server = esp_amp_rpc_server_inst_create(&rpc_loopback_sub_dev, RPC_MAIN_CORE_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096, 2);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_SLOW, rpc_test_slow_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_FAST, rpc_test_fast_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_run(server));
+
+    esp_amp_rpc_client_handle_t client = esp_amp_rpc_client_inst_create(&rpc_loopback_main_dev, RPC_MAIN_CORE_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_run(client));
+
+    /* two requests to the non-reentrant slow service: the first worker runs one, the second worker parks the other */
+    rpc_test_async_result_t result = { 0 };
+    rpc_test_slow_ms = 500;
+    rpc_test_slow_done = 0;
+    rpc_test_slow_max_running = 0;
+    for (int i = 0; i < 2; i++) {
+        esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(client, RPC_TEST_SRV_SLOW, NULL, 0);
+        TEST_ASSERT_NOT_NULL(req);
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(req, rpc_test_async_cb, &result, 3000));
+    }
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    /* the second worker is not stuck behind the slow service, the fast one completes long before it */
+    void *params_out = NULL;
+    int params_out_len = 0;
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(client, RPC_TEST_SRV_FAST, NULL, 0);
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 200));
+    esp_amp_rpc_client_destroy_request(req);
+    TEST_ASSERT_EQUAL(0, rpc_test_slow_done);
+
+    /* the parked request runs once the first one releases the service, never in parallel with it */
+    for (int i = 0; i < 30 && result.ok + result.failed < 2; i++) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    TEST_ASSERT_EQUAL(2, result.ok);
+    TEST_ASSERT_EQUAL(2, rpc_test_slow_done);
+    TEST_ASSERT_EQUAL(1, rpc_test_slow_max_running);
+
+    /* stop fails while a worker is still busy, and the server is not deleted under it */
+    rpc_test_slow_ms = 1500;
+    req = esp_amp_rpc_client_inst_create_request(client, RPC_TEST_SRV_SLOW, NULL, 0);
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(req, rpc_test_async_cb, &result, 3000));
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_FAILED, esp_amp_rpc_server_inst_stop(server));
+    for (int i = 0; i < 30 && result.ok < 3; i++) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    TEST_ASSERT_EQUAL(3, result.ok);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_stop(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_delete(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(client));
+    rpc_loopback_stop();
+}
+
+#define RPC_TEST_SRV_STREAM     (0x12)
+#define RPC_TEST_STREAM_CHUNKS  (3)
+
+static volatile esp_amp_rpc_status_t rpc_test_stream_ret; /* status of the last stream_send, for handler in batch */
+
+static esp_amp_rpc_status_t rpc_test_stream_service(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    uint8_t *out = (uint8_t *)params_out;
+
+    /* only params_out of the running request identifies it */
+    if (esp_amp_rpc_server_stream_send(out + 4, out, 1) != ESP_AMP_RPC_STATUS_INVALID_ARG) {
+        return ESP_AMP_RPC_STATUS_FAILED;
+    }
+    for (uint8_t i = 0; i < RPC_TEST_STREAM_CHUNKS; i++) {
+        out[0] = i;
+        while ((rpc_test_stream_ret = esp_amp_rpc_server_stream_send(out, out, 1)) == ESP_AMP_RPC_STATUS_NO_MEM) {
+            vTaskDelay(1);
+        }
+    }
+    out[0] = 0xff;
+    *params_out_len = 1;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+typedef struct {
+    volatile int chunks;
+    volatile int disordered;
+    volatile int done;
+    volatile esp_amp_rpc_status_t status;
+} rpc_test_stream_result_t;
+
+static void rpc_test_stream_cb(esp_amp_rpc_status_t status, void *params_out, uint16_t params_out_len, void *ctx)
+{
+    rpc_test_stream_result_t *result = (rpc_test_stream_result_t *)ctx;
+    uint8_t *out = (uint8_t *)params_out;
+
+    if (status == ESP_AMP_RPC_STATUS_STREAM) {
+        if (params_out_len != 1 || out[0] != result->chunks || result->done) {
+            result->disordered++;
+        }
+        result->chunks++;
+        return;
+    }
+    if (status == ESP_AMP_RPC_STATUS_OK && (params_out_len != 1 || out[0] != 0xff)) {
+        result->disordered++;
+    }
+    result->status = status;
+    result->done++;
+}
+
+TEST_CASE("RPC server streams chunks, rejects streaming in batch and to blocking caller", "[esp_amp]")
+{
+    rpc_loopback_start();
+
+    esp_amp_rpc_server_handle_t server = esp_amp_rpc_server_inst_create(&rpc_loopback_sub_dev, RPC_MAIN_CORE_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096, 1);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_STREAM, rpc_test_stream_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_run(server));
+
+    esp_amp_rpc_client_handle_t client = esp_amp_rpc_client_inst_create(&rpc_loopback_main_dev, RPC_MAIN_CORE_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_run(client));
+
+    /* out of a service handler */
+    uint8_t byte = 0;
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_INVALID_ARG, esp_amp_rpc_server_stream_send(&byte, &byte, 1));
+
+    /* async caller gets every chunk in order, then the final response */
+    rpc_test_stream_result_t result = { 0 };
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(client, RPC_TEST_SRV_STREAM, NULL, 0);
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(req, rpc_test_stream_cb, &result, 1000));
+    for (int i = 0; i < 20 && !result.done; i++) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    TEST_ASSERT_EQUAL(1, result.done);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, result.status);
+    TEST_ASSERT_EQUAL(RPC_TEST_STREAM_CHUNKS, result.chunks);
+    TEST_ASSERT_EQUAL(0, result.disordered);
+
+    /* blocking caller fails fast on the first chunk instead of losing the stream silently */
+    void *params_out = NULL;
+    int params_out_len = 0;
+    req = esp_amp_rpc_client_inst_create_request(client, RPC_TEST_SRV_STREAM, NULL, 0);
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_STREAM, esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 1000));
+    TEST_ASSERT_EQUAL(1, params_out_len);
+    TEST_ASSERT_EQUAL(0, ((uint8_t *)params_out)[0]);
+    esp_amp_rpc_client_destroy_request(req);
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    /* sub-requests of a batch share one rsp: stream_send is rejected, the final responses still arrive */
+    req = esp_amp_rpc_client_inst_create_batch(client);
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_batch_add(req, RPC_TEST_SRV_STREAM, NULL, 0));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_batch_add(req, RPC_TEST_SRV_STREAM, NULL, 0));
+    rpc_test_stream_ret = ESP_AMP_RPC_STATUS_OK;
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 1000));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_INVALID_ARG, rpc_test_stream_ret);
+    int sub_num = 0;
+    for (esp_amp_rpc_pkt_t *sub = esp_amp_rpc_batch_next(params_out, params_out_len, NULL); sub != NULL;
+            sub = esp_amp_rpc_batch_next(params_out, params_out_len, sub)) {
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, sub->status);
+        TEST_ASSERT_EQUAL(1, sub->params_len);
+        TEST_ASSERT_EQUAL(0xff, sub->params[0]);
+        sub_num++;
+    }
+    TEST_ASSERT_EQUAL(2, sub_num);
+    esp_amp_rpc_client_destroy_request(req);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_stop(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_delete(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(client));
+    rpc_loopback_stop();
+}
+
+/* raw client endpoint on the main-side device, forging requests and counting whatever comes back */
+#define RPC_TEST_RAW_CLIENT     (0x0002)
+#define RPC_TEST_SRV_NOTIFY     (0x13)
+
+static volatile int rpc_test_raw_rsp_num;
+static volatile uint16_t rpc_test_raw_rsp_id;
+static volatile uint32_t rpc_test_raw_rsp_mask; /* bit set by req_id of each response, for req_id below 32 */
+
+static int rpc_test_raw_cb(void *msg_data, uint16_t data_len, uint16_t src_addr, void *rx_cb_data)
+{
+    rpc_test_raw_rsp_id = ((esp_amp_rpc_pkt_t *)msg_data)->req_id;
+    rpc_test_raw_rsp_mask |= rpc_test_raw_rsp_id < 32 ? BIT(rpc_test_raw_rsp_id) : 0;
+    rpc_test_raw_rsp_num++;
+    esp_amp_rpmsg_destroy(&rpc_loopback_main_dev, msg_data);
+    return 0;
+}
+
+static void rpc_test_raw_send(esp_amp_rpmsg_ept_t *ept, uint16_t req_id, uint16_t service_id, uint32_t timeout_ms)
+{
+    esp_amp_rpc_pkt_t *pkt = NULL;
+    for (int i = 0; i < 100 && pkt == NULL; i++) {
+        pkt = (esp_amp_rpc_pkt_t *)esp_amp_rpmsg_create_message(&rpc_loopback_main_dev, sizeof(esp_amp_rpc_pkt_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+        if (pkt == NULL) {
+            vTaskDelay(1);
+        }
+    }
+    TEST_ASSERT_NOT_NULL(pkt);
+    memset(pkt, 0, sizeof(esp_amp_rpc_pkt_t));
+    pkt->req_id = req_id;
+    pkt->service_id = service_id;
+    pkt->timeout_ms = timeout_ms;
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_send_nocopy(&rpc_loopback_main_dev, ept, RPC_MAIN_CORE_SERVER, pkt, sizeof(esp_amp_rpc_pkt_t)));
+}
+
+static volatile int rpc_test_notify_num;
+static volatile int rpc_test_notify_with_buf; /* executed with a response buffer */
+static volatile int rpc_test_notify_bad; /* no response buffer, but params_out_len not 0 */
+
+static esp_amp_rpc_status_t rpc_test_notify_service(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    if (params_out != NULL) {
+        rpc_test_notify_with_buf++;
+    } else if (*params_out_len != 0) {
+        rpc_test_notify_bad++;
+    }
+    rpc_test_notify_num++;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+TEST_CASE("RPC server executes notification without taking a tx buffer", "[esp_amp]")
+{
+    rpc_loopback_start();
+
+    esp_amp_rpc_server_handle_t server = esp_amp_rpc_server_inst_create(&rpc_loopback_sub_dev, RPC_TEST_RAW_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096, 1);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_NOTIFY, rpc_test_notify_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_run(server));
+
+    static esp_amp_rpmsg_ept_t raw_ept;
+    TEST_ASSERT_NOT_NULL(esp_amp_rpmsg_create_endpoint(&rpc_loopback_main_dev, RPC_TEST_RAW_CLIENT, rpc_test_raw_cb, NULL, &raw_ept));
+    rpc_test_raw_rsp_num = 0;
+    rpc_test_notify_num = 0;
+    rpc_test_notify_with_buf = 0;
+    rpc_test_notify_bad = 0;
+
+    /* handler gets no response buffer, and nothing is sent back. more notifications than tx buffers of the server
+     * side: any tx buffer taken and not sent would be leaked, and the request below could not be answered */
+    for (int i = 0; i < 2 * RPC_LOOPBACK_QUEUE_LEN + 1; i++) {
+        rpc_test_raw_send(&raw_ept, ESP_AMP_RPC_NOTIFY_REQ_ID, RPC_TEST_SRV_NOTIFY, 0);
+        for (int j = 0; j < 100 && rpc_test_notify_num <= i; j++) {
+            vTaskDelay(1);
+        }
+    }
+    TEST_ASSERT_EQUAL(2 * RPC_LOOPBACK_QUEUE_LEN + 1, rpc_test_notify_num);
+    TEST_ASSERT_EQUAL(0, rpc_test_notify_with_buf);
+    TEST_ASSERT_EQUAL(0, rpc_test_notify_bad);
+
+    /* notifications to unknown services are dropped silently too */
+    rpc_test_raw_send(&raw_ept, ESP_AMP_RPC_NOTIFY_REQ_ID, RPC_TEST_SRV_NOTIFY + 1, 0);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(0, rpc_test_raw_rsp_num);
+
+    /* a normal request still gets its tx buffer and response */
+    rpc_test_raw_send(&raw_ept, 1, RPC_TEST_SRV_NOTIFY, 0);
+    for (int i = 0; i < 100 && rpc_test_raw_rsp_num == 0; i++) {
+        vTaskDelay(1);
+    }
+    TEST_ASSERT_EQUAL(1, rpc_test_raw_rsp_num);
+    TEST_ASSERT_EQUAL(1, rpc_test_raw_rsp_id);
+    TEST_ASSERT_EQUAL(1, rpc_test_notify_with_buf);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_stop(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_delete(server));
+    TEST_ASSERT_NOT_NULL(esp_amp_rpmsg_delete_endpoint(&rpc_loopback_main_dev, RPC_TEST_RAW_CLIENT));
+    rpc_loopback_stop();
+}
+
+static void rpc_test_raw_wait(uint32_t mask)
+{
+    for (int i = 0; i < 200 && (rpc_test_raw_rsp_mask & mask) != mask; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    TEST_ASSERT_EQUAL_HEX32(mask, rpc_test_raw_rsp_mask & mask);
+}
+
+TEST_CASE("RPC FreeRTOS server drops expired and cancelled requests, late cancel has no effect", "[esp_amp]")
+{
+    rpc_loopback_start();
+
+    /* a single worker, blocked by the slow service while requests wait in the queue */
+    esp_amp_rpc_server_handle_t server = esp_amp_rpc_server_inst_create(&rpc_loopback_sub_dev, RPC_TEST_RAW_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096, 1);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_SLOW, rpc_test_slow_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_FAST, rpc_test_fast_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_run(server));
+
+    static esp_amp_rpmsg_ept_t raw_ept;
+    TEST_ASSERT_NOT_NULL(esp_amp_rpmsg_create_endpoint(&rpc_loopback_main_dev, RPC_TEST_RAW_CLIENT, rpc_test_raw_cb, NULL, &raw_ept));
+    rpc_test_raw_rsp_mask = 0;
+    rpc_test_fast_done = 0;
+    rpc_test_slow_ms = 300;
+
+    /* req 2 expires and req 3 is cancelled while waiting, req 4 is executed */
+    rpc_test_raw_send(&raw_ept, 1, RPC_TEST_SRV_SLOW, 0);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    rpc_test_raw_send(&raw_ept, 2, RPC_TEST_SRV_FAST, 50);
+    rpc_test_raw_send(&raw_ept, 3, RPC_TEST_SRV_FAST, 0);
+    rpc_test_raw_send(&raw_ept, 3, ESP_AMP_RPC_CANCEL_SERVICE_ID, 0);
+    rpc_test_raw_send(&raw_ept, 4, RPC_TEST_SRV_FAST, 0);
+    rpc_test_raw_wait(BIT(1) | BIT(4));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL_HEX32(BIT(1) | BIT(4), rpc_test_raw_rsp_mask);
+    TEST_ASSERT_EQUAL(1, rpc_test_fast_done);
+
+    /* cancel arriving after the response does not drop the next request reusing req_id 4 */
+    rpc_test_raw_rsp_mask = 0;
+    rpc_test_raw_send(&raw_ept, 4, ESP_AMP_RPC_CANCEL_SERVICE_ID, 0);
+    rpc_test_raw_send(&raw_ept, 4, RPC_TEST_SRV_FAST, 0);
+    rpc_test_raw_wait(BIT(4));
+    TEST_ASSERT_EQUAL(2, rpc_test_fast_done);
+
+    /* neither does cancel arriving while the request executes */
+    rpc_test_raw_rsp_mask = 0;
+    rpc_test_raw_send(&raw_ept, 5, RPC_TEST_SRV_SLOW, 0);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    rpc_test_raw_send(&raw_ept, 5, ESP_AMP_RPC_CANCEL_SERVICE_ID, 0);
+    rpc_test_raw_wait(BIT(5));
+    rpc_test_raw_rsp_mask = 0;
+    rpc_test_raw_send(&raw_ept, 5, RPC_TEST_SRV_FAST, 0);
+    rpc_test_raw_wait(BIT(5));
+    TEST_ASSERT_EQUAL(3, rpc_test_fast_done);
+
+    /* timeout shorter than one tick, as sent by bare-metal client, does not expire a request executed at once */
+    rpc_test_raw_rsp_mask = 0;
+    rpc_test_raw_send(&raw_ept, 6, RPC_TEST_SRV_FAST, 1);
+    rpc_test_raw_wait(BIT(6));
+    TEST_ASSERT_EQUAL(4, rpc_test_fast_done);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_stop(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_delete(server));
+    TEST_ASSERT_NOT_NULL(esp_amp_rpmsg_delete_endpoint(&rpc_loopback_main_dev, RPC_TEST_RAW_CLIENT));
+    rpc_loopback_stop();
+}
+
+/*
+ * bare-metal rpc server on sub-core, see subcore/test_rpc. Requests are queued by rpmsg poll and executed by
+ * esp_amp_rpc_server_process() in the main loop, which can be held to let requests pile up in the run queue
+ */
+extern const uint8_t subcore_rpc_bin_start[] asm("_binary_subcore_test_rpc_bin_start");
+extern const uint8_t subcore_rpc_bin_end[]   asm("_binary_subcore_test_rpc_bin_end");
+
+#define RPC_SUB_EVENT_READY     BIT0
+#define RPC_SUB_SRV_HOLD        0x20    /* uint32_t ms: main loop stops executing queued requests for that long */
+#define RPC_SUB_SRV_LOG         0x21    /* uint8_t tag: appended to execution log */
+#define RPC_SUB_SRV_REPORT      0x22    /* response: rpc_sub_report_t, then log is cleared */
+#define RPC_SUB_BUDGET          2       /* requests executed per round of main loop */
+#define RPC_SUB_LOG_LEN         32
+
+typedef struct {
+    uint8_t log_num;
+    uint8_t max_round; /* most requests executed in one round */
+    uint8_t budget_hit; /* rounds leaving requests in run queue */
+    uint8_t reserved;
+    uint8_t log[RPC_SUB_LOG_LEN]; /* tags in execution order */
+} rpc_sub_report_t;
+
+static esp_amp_rpmsg_dev_t rpc_subcore_dev;
+
+static esp_amp_rpc_client_handle_t rpc_subcore_start(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, esp_amp_init());
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_main_init(&rpc_subcore_dev, 16, 64, false, false));
+    esp_amp_rpc_client_handle_t client = esp_amp_rpc_client_inst_create(&rpc_subcore_dev, RPC_MAIN_CORE_CLIENT, RPC_SUB_CORE_SERVER, 5, 4096);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_run(client));
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_intr_enable(&rpc_subcore_dev));
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_amp_load_sub(subcore_rpc_bin_start));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_amp_start_subcore());
+    TEST_ASSERT_EQUAL(RPC_SUB_EVENT_READY, esp_amp_event_wait(RPC_SUB_EVENT_READY, true, true, 5000) & RPC_SUB_EVENT_READY);
+    return client;
+}
+
+/* requests sent from now on are queued, not executed, for ms */
+static void rpc_subcore_hold(esp_amp_rpc_client_handle_t client, uint32_t ms)
+{
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_notify(client, RPC_SUB_SRV_HOLD, &ms, sizeof(ms)));
+    vTaskDelay(pdMS_TO_TICKS(20));
+}
+
+static esp_amp_rpc_req_handle_t rpc_subcore_log(esp_amp_rpc_client_handle_t client, uint8_t tag)
+{
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(client, RPC_SUB_SRV_LOG, &tag, sizeof(tag));
+    TEST_ASSERT_NOT_NULL(req);
+    return req;
+}
+
+static void rpc_subcore_report(esp_amp_rpc_client_handle_t client, rpc_sub_report_t *report)
+{
+    void *params_out = NULL;
+    int params_out_len = 0;
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(client, RPC_SUB_SRV_REPORT, NULL, 0);
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 2000));
+    TEST_ASSERT_EQUAL(sizeof(rpc_sub_report_t), params_out_len);
+    memcpy(report, params_out, sizeof(rpc_sub_report_t));
+    esp_amp_rpc_client_destroy_request(req);
+}
+
+typedef struct {
+    volatile int num;
+    volatile esp_amp_rpc_status_t status;
+} rpc_test_status_t;
+
+static void rpc_test_status_cb(esp_amp_rpc_status_t status, void *params_out, uint16_t params_out_len, void *ctx)
+{
+    rpc_test_status_t *result = (rpc_test_status_t *)ctx;
+    result->status = status;
+    result->num++;
+}
+
+static void rpc_test_cancel_task(void *arg)
+{
+    vTaskDelay(pdMS_TO_TICKS(50));
+    esp_amp_rpc_client_cancel_request((esp_amp_rpc_req_handle_t)arg);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("RPC bare-metal server drops expired and cancelled requests, callers get CANCELLED", "[esp_amp]")
+{
+    esp_amp_rpc_client_handle_t client = rpc_subcore_start();
+    rpc_subcore_hold(client, 500);
+
+    /* tag 1 expires in the run queue */
+    rpc_test_status_t expired = { 0 };
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(rpc_subcore_log(client, 1), rpc_test_status_cb, &expired, 50));
+
+    /* async caller gets CANCELLED before cancel returns */
+    rpc_test_status_t cancelled = { 0 };
+    esp_amp_rpc_req_handle_t req = rpc_subcore_log(client, 2);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(req, rpc_test_status_cb, &cancelled, 2000));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_cancel_request(req));
+    TEST_ASSERT_EQUAL(1, cancelled.num);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_CANCELLED, cancelled.status);
+
+    /* polling caller */
+    void *params_out = NULL;
+    int params_out_len = 0;
+    req = rpc_subcore_log(client, 3);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_submit_request(req, 2000));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_PENDING, esp_amp_rpc_client_poll_request(req, &params_out, &params_out_len));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_cancel_request(req));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_CANCELLED, esp_amp_rpc_client_poll_request(req, &params_out, &params_out_len));
+    esp_amp_rpc_client_destroy_request(req);
+
+    /* blocking caller, cancelled by another task */
+    req = rpc_subcore_log(client, 4);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(rpc_test_cancel_task, "rpc_cancel", 2048, req, 6, NULL));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_CANCELLED, esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 2000));
+    esp_amp_rpc_client_destroy_request(req);
+
+    /* tag 5 is still executed */
+    req = rpc_subcore_log(client, 5);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_submit_request(req, 2000));
+    esp_amp_rpc_status_t status = ESP_AMP_RPC_STATUS_PENDING;
+    for (int i = 0; i < 100 && status == ESP_AMP_RPC_STATUS_PENDING; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+        status = esp_amp_rpc_client_poll_request(req, &params_out, &params_out_len);
+    }
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, status);
+    esp_amp_rpc_client_destroy_request(req);
+    TEST_ASSERT_EQUAL(1, expired.num);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_TIMEOUT, expired.status);
+
+    /* only tag 5 reaches its handler */
+    rpc_sub_report_t report;
+    rpc_subcore_report(client, &report);
+    TEST_ASSERT_EQUAL(1, report.log_num);
+    TEST_ASSERT_EQUAL(5, report.log[0]);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(client));
+}
+
+#define RPC_SUB_RUN_QUEUE_LEN   8
+_Static_assert(CONFIG_ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN == RPC_SUB_RUN_QUEUE_LEN, "update the budget test for the run queue length");
+
+TEST_CASE("RPC bare-metal server runs full queue within budget, drops do not take budget", "[esp_amp]")
+{
+    esp_amp_rpc_client_handle_t client = rpc_subcore_start();
+    rpc_subcore_hold(client, 500);
+
+    /* fill the run queue: tags 1 and 5 expire, tag 3 is cancelled, the others are notifications */
+    rpc_test_status_t expired[2] = { 0 };
+    rpc_test_status_t cancelled = { 0 };
+    for (uint8_t tag = 1; tag <= RPC_SUB_RUN_QUEUE_LEN; tag++) {
+        if (tag == 1 || tag == 5) {
+            TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(rpc_subcore_log(client, tag), rpc_test_status_cb, &expired[tag / 5], 50));
+        } else if (tag == 3) {
+            esp_amp_rpc_req_handle_t req = rpc_subcore_log(client, tag);
+            TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(req, rpc_test_status_cb, &cancelled, 2000));
+            TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_cancel_request(req));
+        } else {
+            TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_notify(client, RPC_SUB_SRV_LOG, &tag, sizeof(tag)));
+        }
+    }
+    /* cancelled request keeps its slot until popped, so the queue is full and tag 9 is dropped */
+    uint8_t tag = RPC_SUB_RUN_QUEUE_LEN + 1;
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_notify(client, RPC_SUB_SRV_LOG, &tag, sizeof(tag)));
+
+    /* report request is queued behind all of them */
+    rpc_sub_report_t report;
+    rpc_subcore_report(client, &report);
+
+    /**
+     * round 1 drops 1 and 3, executes 2 and 4, leaves 4 queued; round 2 drops 5, executes 6 and 7, leaves 1 queued;
+     * round 3 executes 8 and empties the queue
+     */
+    const uint8_t expected[] = { 2, 4, 6, 7, 8 };
+    TEST_ASSERT_EQUAL(sizeof(expected), report.log_num);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, report.log, sizeof(expected));
+    TEST_ASSERT_EQUAL(RPC_SUB_BUDGET, report.max_round);
+    TEST_ASSERT_EQUAL(2, report.budget_hit);
+
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL(1, expired[i].num);
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_TIMEOUT, expired[i].status);
+    }
+    TEST_ASSERT_EQUAL(1, cancelled.num);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_CANCELLED, cancelled.status);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(client));
+}
+
+#define RPC_TEST_INST_NUM       (2)
+#define RPC_TEST_SRV_WHOAMI     (0x14)
+
+/* same service id on both servers, each answers with its own tag */
+static esp_amp_rpc_status_t rpc_test_whoami_a(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    *(uint8_t *)params_out = 'A';
+    *params_out_len = 1;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static esp_amp_rpc_status_t rpc_test_whoami_b(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    *(uint8_t *)params_out = 'B';
+    *params_out_len = 1;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+typedef struct {
+    uint8_t tag;
+    volatile int ok;
+    volatile int failed;
+} rpc_test_whoami_result_t;
+
+/* each client has its own result, so recv tasks of both clients never update the same counter */
+static void rpc_test_whoami_cb(esp_amp_rpc_status_t status, void *params_out, uint16_t params_out_len, void *ctx)
+{
+    rpc_test_whoami_result_t *result = (rpc_test_whoami_result_t *)ctx;
+    if (status == ESP_AMP_RPC_STATUS_OK && params_out_len == 1 && *(uint8_t *)params_out == result->tag) {
+        result->ok++;
+    } else {
+        result->failed++;
+    }
+}
+
+TEST_CASE("RPC client and server instances on different endpoints", "[esp_amp]")
+{
+    static const uint16_t client_addr[RPC_TEST_INST_NUM] = { 0x0004, 0x0006 };
+    static const uint16_t server_addr[RPC_TEST_INST_NUM] = { 0x0005, 0x0007 };
+    const esp_amp_rpc_service_func_t handlers[RPC_TEST_INST_NUM] = { rpc_test_whoami_a, rpc_test_whoami_b };
+    esp_amp_rpc_server_handle_t servers[RPC_TEST_INST_NUM];
+    esp_amp_rpc_client_handle_t clients[RPC_TEST_INST_NUM];
+
+    rpc_loopback_start();
+
+    for (int i = 0; i < RPC_TEST_INST_NUM; i++) {
+        servers[i] = esp_amp_rpc_server_inst_create(&rpc_loopback_sub_dev, client_addr[i], server_addr[i], 5, 4096, 1);
+        TEST_ASSERT_NOT_NULL(servers[i]);
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(servers[i], RPC_TEST_SRV_WHOAMI, handlers[i]));
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_run(servers[i]));
+        clients[i] = esp_amp_rpc_client_inst_create(&rpc_loopback_main_dev, client_addr[i], server_addr[i], 5, 4096);
+        TEST_ASSERT_NOT_NULL(clients[i]);
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_run(clients[i]));
+    }
+
+    /* all instances are taken */
+    TEST_ASSERT_NULL(esp_amp_rpc_server_inst_create(&rpc_loopback_sub_dev, 0x0008, 0x0009, 5, 4096, 1));
+    TEST_ASSERT_NULL(esp_amp_rpc_client_inst_create(&rpc_loopback_main_dev, 0x0008, 0x0009, 5, 4096));
+
+    /* each client reaches its own server, with requests of both in flight at the same time */
+    rpc_test_whoami_result_t result[RPC_TEST_INST_NUM] = { { .tag = 'A' }, { .tag = 'B' } };
+    for (int n = 0; n < 4; n++) {
+        for (int i = 0; i < RPC_TEST_INST_NUM; i++) {
+            esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(clients[i], RPC_TEST_SRV_WHOAMI, NULL, 0);
+            TEST_ASSERT_NOT_NULL(req);
+            TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(req, rpc_test_whoami_cb, &result[i], 1000));
+        }
+    }
+    for (int i = 0; i < RPC_TEST_INST_NUM; i++) {
+        void *params_out = NULL;
+        int params_out_len = 0;
+        esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(clients[i], RPC_TEST_SRV_WHOAMI, NULL, 0);
+        TEST_ASSERT_NOT_NULL(req);
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 1000));
+        TEST_ASSERT_EQUAL(1, params_out_len);
+        TEST_ASSERT_EQUAL('A' + i, ((uint8_t *)params_out)[0]);
+        esp_amp_rpc_client_destroy_request(req);
+    }
+    for (int i = 0; i < 20 && result[0].ok + result[0].failed + result[1].ok + result[1].failed < 4 * RPC_TEST_INST_NUM; i++) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    for (int i = 0; i < RPC_TEST_INST_NUM; i++) {
+        TEST_ASSERT_EQUAL(4, result[i].ok);
+        TEST_ASSERT_EQUAL(0, result[i].failed);
+    }
+
+    /* one pair going away leaves the other working, and its instances can be taken again */
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(clients[0]));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_stop(servers[0]));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_delete(servers[0]));
+    void *params_out = NULL;
+    int params_out_len = 0;
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(clients[1], RPC_TEST_SRV_WHOAMI, NULL, 0);
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 1000));
+    TEST_ASSERT_EQUAL('B', ((uint8_t *)params_out)[0]);
+    esp_amp_rpc_client_destroy_request(req);
+    clients[0] = esp_amp_rpc_client_inst_create(&rpc_loopback_main_dev, client_addr[0], server_addr[0], 5, 4096);
+    TEST_ASSERT_NOT_NULL(clients[0]);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(clients[0]));
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(clients[1]));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_stop(servers[1]));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_delete(servers[1]));
+    rpc_loopback_stop();
+}
+
+#define RPC_TEST_SRV_VALUE      (0x15)
+
+static volatile uint32_t rpc_test_value;
+static volatile int rpc_test_value_done;
+
+/* returns current value, which the test changes behind the back of the client cache */
+static esp_amp_rpc_status_t rpc_test_value_service(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    uint32_t value = rpc_test_value;
+    memcpy(params_out, &value, sizeof(value));
+    *params_out_len = sizeof(value);
+    rpc_test_value_done++;
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static uint32_t rpc_test_get_value(esp_amp_rpc_client_handle_t client, uint8_t key)
+{
+    void *params_out = NULL;
+    int params_out_len = 0;
+    uint32_t value = 0;
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(client, RPC_TEST_SRV_VALUE, &key, sizeof(key));
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_request(req, &params_out, &params_out_len, 1000));
+    TEST_ASSERT_EQUAL(sizeof(value), params_out_len);
+    memcpy(&value, params_out, sizeof(value));
+    esp_amp_rpc_client_destroy_request(req);
+    return value;
+}
+
+TEST_CASE("RPC server invalidation push drops cached responses of client", "[esp_amp]")
+{
+    rpc_loopback_start();
+
+    esp_amp_rpc_server_handle_t server = esp_amp_rpc_server_inst_create(&rpc_loopback_sub_dev, RPC_MAIN_CORE_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096, 1);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_VALUE, rpc_test_value_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_run(server));
+    esp_amp_rpc_client_handle_t client = esp_amp_rpc_client_inst_create(&rpc_loopback_main_dev, RPC_MAIN_CORE_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_set_cache(client, RPC_TEST_SRV_VALUE, 10000));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_run(client));
+
+    /* first requests of each key reach the server, repeated ones are served from cache */
+    rpc_test_value = 1;
+    rpc_test_value_done = 0;
+    TEST_ASSERT_EQUAL(1, rpc_test_get_value(client, 'a'));
+    TEST_ASSERT_EQUAL(1, rpc_test_get_value(client, 'b'));
+    rpc_test_value = 2;
+    TEST_ASSERT_EQUAL(1, rpc_test_get_value(client, 'a'));
+    TEST_ASSERT_EQUAL(1, rpc_test_get_value(client, 'b'));
+    TEST_ASSERT_EQUAL(2, rpc_test_value_done);
+
+    /* response held by a request stays readable after the push */
+    void *held = NULL;
+    int held_len = 0;
+    uint8_t key = 'a';
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(client, RPC_TEST_SRV_VALUE, &key, sizeof(key));
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_request(req, &held, &held_len, 1000));
+
+    /* push reaches client through rpmsg, every key of the service is fetched again */
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_invalidate(server, RPC_TEST_SRV_VALUE));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, rpc_test_get_value(client, 'a'));
+    TEST_ASSERT_EQUAL(2, rpc_test_get_value(client, 'b'));
+    TEST_ASSERT_EQUAL(4, rpc_test_value_done);
+    TEST_ASSERT_EQUAL(2, rpc_test_get_value(client, 'a'));
+    TEST_ASSERT_EQUAL(4, rpc_test_value_done);
+
+    TEST_ASSERT_EQUAL(sizeof(uint32_t), held_len);
+    TEST_ASSERT_EQUAL(1, *(uint32_t *)held);
+    esp_amp_rpc_client_destroy_request(req);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_stop(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_delete(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(client));
+    rpc_loopback_stop();
+}
+
+#define RPC_TEST_SRV_ORDER      (0x16)
+#define RPC_TEST_ORDER_NUM      (6)
+
+static volatile int rpc_test_order_num;
+static uint8_t rpc_test_order[RPC_TEST_ORDER_NUM]; /* tags in execution order */
+
+static esp_amp_rpc_status_t rpc_test_order_service(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    if (params_in_len == 1 && rpc_test_order_num < RPC_TEST_ORDER_NUM) {
+        rpc_test_order[rpc_test_order_num++] = *(uint8_t *)params_in;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+/* tags 1..6 sent in this order with these priorities, same priority keeps arrival order */
+static const uint8_t rpc_test_order_prio[RPC_TEST_ORDER_NUM] = { 0, 2, 1, 3, 2, 0 };
+static const uint8_t rpc_test_order_expected[RPC_TEST_ORDER_NUM] = { 4, 2, 5, 3, 1, 6 };
+
+_Static_assert(CONFIG_ESP_AMP_RPC_PRIORITY_NUM >= 4, "priority test needs 4 priority levels");
+_Static_assert(CONFIG_ESP_AMP_RPC_PRIORITY_AGING_MS >= 1000, "priority test holds requests for a few hundred ms without aging");
+
+TEST_CASE("RPC FreeRTOS server executes requests queued behind a busy worker by priority", "[esp_amp]")
+{
+    rpc_loopback_start();
+
+    esp_amp_rpc_server_handle_t server = esp_amp_rpc_server_inst_create(&rpc_loopback_sub_dev, RPC_MAIN_CORE_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096, 1);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_SLOW, rpc_test_slow_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_add_service(server, RPC_TEST_SRV_ORDER, rpc_test_order_service));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_run(server));
+    esp_amp_rpc_client_handle_t client = esp_amp_rpc_client_inst_create(&rpc_loopback_main_dev, RPC_MAIN_CORE_CLIENT, RPC_MAIN_CORE_SERVER, 5, 4096);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_run(client));
+
+    /* the only worker is busy, so the requests below wait in rx_q and are moved to ready_q together */
+    rpc_test_async_result_t result = { 0 };
+    rpc_test_slow_ms = 300;
+    esp_amp_rpc_req_handle_t req = esp_amp_rpc_client_inst_create_request(client, RPC_TEST_SRV_SLOW, NULL, 0);
+    TEST_ASSERT_NOT_NULL(req);
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_execute_async(req, rpc_test_async_cb, &result, 2000));
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    rpc_test_order_num = 0;
+    for (uint8_t tag = 1; tag <= RPC_TEST_ORDER_NUM; tag++) {
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_notify_with_priority(client, RPC_TEST_SRV_ORDER, rpc_test_order_prio[tag - 1], &tag, sizeof(tag)));
+    }
+    TEST_ASSERT_EQUAL(0, rpc_test_order_num);
+
+    for (int i = 0; i < 50 && rpc_test_order_num < RPC_TEST_ORDER_NUM; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    TEST_ASSERT_EQUAL(1, result.ok);
+    TEST_ASSERT_EQUAL(RPC_TEST_ORDER_NUM, rpc_test_order_num);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(rpc_test_order_expected, rpc_test_order, RPC_TEST_ORDER_NUM);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_stop(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_server_inst_delete(server));
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(client));
+    rpc_loopback_stop();
+}
+
+TEST_CASE("RPC bare-metal server executes held run queue by priority", "[esp_amp]")
+{
+    esp_amp_rpc_client_handle_t client = rpc_subcore_start();
+    rpc_subcore_hold(client, 300);
+
+    for (uint8_t tag = 1; tag <= RPC_TEST_ORDER_NUM; tag++) {
+        TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_notify_with_priority(client, RPC_SUB_SRV_LOG, rpc_test_order_prio[tag - 1], &tag, sizeof(tag)));
+    }
+
+    /* report request has normal priority and arrives last, so it runs after all of them */
+    rpc_sub_report_t report;
+    rpc_subcore_report(client, &report);
+    TEST_ASSERT_EQUAL(RPC_TEST_ORDER_NUM, report.log_num);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(rpc_test_order_expected, report.log, RPC_TEST_ORDER_NUM);
+
+    TEST_ASSERT_EQUAL(ESP_AMP_RPC_STATUS_OK, esp_amp_rpc_client_inst_delete(client));
+}
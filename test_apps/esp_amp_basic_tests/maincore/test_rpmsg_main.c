@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -195,3 +196,206 @@ TEST_CASE("rpmsg transport layer test between main-core and sub-core", "[esp_amp
     /* wait for idle task to recycle task stack */
     vTaskDelay(pdMS_TO_TICKS(1000));
 }
+
+TEST_CASE("rpmsg multi-lane init and endpoint lane binding", "[esp_amp]")
+{
+    TEST_ASSERT_EQUAL_INT(0, esp_amp_init());
+
+    esp_amp_rpmsg_dev_t* rpmsg_dev = (esp_amp_rpmsg_dev_t*)(malloc(sizeof(esp_amp_rpmsg_dev_t)));
+    TEST_ASSERT_NOT_NULL(rpmsg_dev);
+    static esp_amp_queue_t vqueue[4];
+    const esp_amp_rpmsg_lane_conf_t lane_conf[2] = {
+        { .queue_len = 4, .queue_item_size = 32 },    /* control lane */
+        { .queue_len = 16, .queue_item_size = 128 },  /* bulk lane */
+    };
+
+    TEST_ASSERT_EQUAL(-1, esp_amp_rpmsg_main_init_with_lanes(rpmsg_dev, vqueue, lane_conf, 0, false, true, 0x100));
+    TEST_ASSERT_EQUAL(-1, esp_amp_rpmsg_main_init_with_lanes(rpmsg_dev, vqueue, lane_conf, ESP_AMP_RPMSG_LANE_NUM_MAX + 1, false, true, 0x100));
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_main_init_with_lanes(rpmsg_dev, vqueue, lane_conf, 2, false, true, 0x100));
+    TEST_ASSERT_EQUAL(32 - sizeof(esp_amp_rpmsg_head_t), esp_amp_rpmsg_get_lane_max_size(rpmsg_dev, 0));
+    TEST_ASSERT_EQUAL(128 - sizeof(esp_amp_rpmsg_head_t), esp_amp_rpmsg_get_lane_max_size(rpmsg_dev, 1));
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_get_lane_max_size(rpmsg_dev, 2));
+
+    esp_amp_rpmsg_ept_t ept;
+    TEST_ASSERT_EQUAL_HEX32(&ept, esp_amp_rpmsg_create_endpoint(rpmsg_dev, 0, NULL, NULL, &ept));
+    TEST_ASSERT_EQUAL(0, ept.lane);
+    TEST_ASSERT_EQUAL(-1, esp_amp_rpmsg_endpoint_set_lane(rpmsg_dev, &ept, 2));
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_endpoint_set_lane(rpmsg_dev, &ept, 1));
+
+    /* bulk lane is exhausted while control lane still has free buffers */
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_send(rpmsg_dev, &ept, 1, &i, sizeof(i)));
+    }
+    TEST_ASSERT_NULL(esp_amp_rpmsg_create_message_by_ept(rpmsg_dev, &ept, sizeof(int), ESP_AMP_RPMSG_DATA_DEFAULT));
+    void* data = esp_amp_rpmsg_create_message(rpmsg_dev, sizeof(int), ESP_AMP_RPMSG_DATA_DEFAULT);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_send_nocopy(rpmsg_dev, &ept, 1, data, sizeof(int)));
+
+    TEST_ASSERT_EQUAL_HEX32(&ept, esp_amp_rpmsg_delete_endpoint(rpmsg_dev, 0));
+    free(rpmsg_dev);
+}
+
+static int rpmsg_test_adaptive_sched_cb(void* sched_arg)
+{
+    return 0;
+}
+
+TEST_CASE("rpmsg adaptive receive mode enable", "[esp_amp]")
+{
+    TEST_ASSERT_EQUAL_INT(0, esp_amp_init());
+
+    esp_amp_rpmsg_dev_t* rpmsg_dev = (esp_amp_rpmsg_dev_t*)(malloc(sizeof(esp_amp_rpmsg_dev_t)));
+    TEST_ASSERT_NOT_NULL(rpmsg_dev);
+
+    /* adaptive mode is not allowed in polling mode */
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_main_init(rpmsg_dev, 16, 64, false, true));
+    TEST_ASSERT_EQUAL(-1, esp_amp_rpmsg_adaptive_enable(rpmsg_dev, 0, 0, rpmsg_test_adaptive_sched_cb, NULL));
+
+    TEST_ASSERT_EQUAL_INT(0, esp_amp_init());
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_main_init(rpmsg_dev, 16, 64, false, false));
+    TEST_ASSERT_EQUAL(-1, esp_amp_rpmsg_adaptive_enable(rpmsg_dev, 0, 0, NULL, NULL));
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_adaptive_enable(rpmsg_dev, 0, 4, rpmsg_test_adaptive_sched_cb, NULL));
+    TEST_ASSERT_EQUAL(CONFIG_ESP_AMP_RPMSG_ADAPTIVE_INTR_BUDGET, rpmsg_dev->adaptive.intr_budget);
+    TEST_ASSERT_EQUAL(4, rpmsg_dev->adaptive.poll_budget);
+
+    /* starts in interrupt mode, nothing to poll */
+    TEST_ASSERT_FALSE(rpmsg_dev->adaptive.polling);
+    TEST_ASSERT_EQUAL(-1, esp_amp_rpmsg_adaptive_poll(rpmsg_dev));
+
+    free(rpmsg_dev);
+}
+
+#define ADAPTIVE_TEST_EPT_ADDR      (3)
+#define ADAPTIVE_TEST_INTR_BUDGET   (4)
+#define ADAPTIVE_TEST_POLL_BUDGET   (4)
+#define ADAPTIVE_TEST_BURST_NUM     (12)
+#define ADAPTIVE_TEST_FLOOD_NUM     (256)
+
+typedef struct adaptive_test_ctx_t {
+    esp_amp_rpmsg_dev_t* rpmsg_dev;
+    SemaphoreHandle_t sched_sem;
+    SemaphoreHandle_t done_sem;
+    volatile uint32_t expected;
+    volatile uint32_t rx_cnt;
+    volatile uint32_t rx_seq;
+    volatile uint32_t out_of_order;
+    volatile uint32_t sched_cnt;
+    volatile uint32_t poll_batch_cnt;
+    volatile uint32_t rearm_cnt;
+} adaptive_test_ctx_t;
+
+static int IRAM_ATTR adaptive_test_ept_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    adaptive_test_ctx_t* ctx = (adaptive_test_ctx_t*)rx_cb_data;
+    if (*(uint32_t*)msg_data != ctx->rx_seq) {
+        ctx->out_of_order++;
+    }
+    ctx->rx_seq++;
+    esp_amp_rpmsg_destroy(ctx->rpmsg_dev, msg_data);
+
+    if (++ctx->rx_cnt == ctx->expected) {
+        BaseType_t need_yield = pdFALSE;
+        if (esp_amp_env_in_isr()) {
+            xSemaphoreGiveFromISR(ctx->done_sem, &need_yield);
+            portYIELD_FROM_ISR(need_yield);
+        } else {
+            xSemaphoreGive(ctx->done_sem);
+        }
+    }
+    return 0;
+}
+
+static int IRAM_ATTR adaptive_test_sched_cb(void* sched_arg)
+{
+    adaptive_test_ctx_t* ctx = (adaptive_test_ctx_t*)sched_arg;
+    BaseType_t need_yield = pdFALSE;
+    ctx->sched_cnt++;
+    xSemaphoreGiveFromISR(ctx->sched_sem, &need_yield);
+    return need_yield == pdTRUE;
+}
+
+static void adaptive_test_poller(void* arg)
+{
+    adaptive_test_ctx_t* ctx = (adaptive_test_ctx_t*)arg;
+    for (;;) {
+        xSemaphoreTake(ctx->sched_sem, portMAX_DELAY);
+        while (esp_amp_rpmsg_adaptive_poll(ctx->rpmsg_dev) == 0) {
+            ctx->poll_batch_cnt++;
+        }
+        ctx->rearm_cnt++;
+    }
+}
+
+static void adaptive_test_request(adaptive_test_ctx_t* ctx, esp_amp_rpmsg_ept_t* ept, uint32_t num)
+{
+    ctx->expected = num;
+    ctx->rx_cnt = 0;
+    ctx->rx_seq = 0;
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_send(ctx->rpmsg_dev, ept, ADAPTIVE_TEST_EPT_ADDR, &num, sizeof(num)));
+}
+
+TEST_CASE("rpmsg adaptive receive mode switches to polling under load and back", "[esp_amp]")
+{
+    TEST_ASSERT_EQUAL_INT(0, esp_amp_init());
+
+    esp_amp_rpmsg_dev_t* rpmsg_dev = (esp_amp_rpmsg_dev_t*)(malloc(sizeof(esp_amp_rpmsg_dev_t)));
+    TEST_ASSERT_NOT_NULL(rpmsg_dev);
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_main_init(rpmsg_dev, 16, 64, false, false));
+
+    static adaptive_test_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.rpmsg_dev = rpmsg_dev;
+    ctx.sched_sem = xSemaphoreCreateBinary();
+    ctx.done_sem = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(ctx.sched_sem);
+    TEST_ASSERT_NOT_NULL(ctx.done_sem);
+
+    static esp_amp_rpmsg_ept_t ept;
+    TEST_ASSERT_EQUAL_HEX32(&ept, esp_amp_rpmsg_create_endpoint(rpmsg_dev, ADAPTIVE_TEST_EPT_ADDR, adaptive_test_ept_cb, &ctx, &ept));
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_adaptive_enable(rpmsg_dev, ADAPTIVE_TEST_INTR_BUDGET, ADAPTIVE_TEST_POLL_BUDGET, adaptive_test_sched_cb, &ctx));
+    TEST_ASSERT_EQUAL_INT(0, esp_amp_rpmsg_intr_enable(rpmsg_dev));
+
+    TaskHandle_t poller = NULL;
+    TEST_ASSERT_NOT_EQUAL(pdFAIL, xTaskCreate(adaptive_test_poller, "poller", 2048, &ctx, tskIDLE_PRIORITY + 2, &poller));
+
+    subcore_rpmsg_test_subcore_init();
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    /* single rpmsg is handled in the interrupt */
+    adaptive_test_request(&ctx, &ept, 1);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(ctx.done_sem, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(0, ctx.sched_cnt);
+
+    /* hold off the doorbell while the sub-core queues a burst, the interrupt then exceeds its budget */
+    esp_amp_env_enter_critical();
+    adaptive_test_request(&ctx, &ept, ADAPTIVE_TEST_BURST_NUM);
+    esp_amp_platform_delay_us(5000);
+    esp_amp_env_exit_critical();
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(ctx.done_sem, pdMS_TO_TICKS(1000)));
+    vTaskDelay(pdMS_TO_TICKS(10));
+    TEST_ASSERT_EQUAL(1, ctx.sched_cnt);
+    TEST_ASSERT_EQUAL(1, ctx.rearm_cnt);
+    TEST_ASSERT_EQUAL((ADAPTIVE_TEST_BURST_NUM - ADAPTIVE_TEST_INTR_BUDGET) / ADAPTIVE_TEST_POLL_BUDGET, ctx.poll_batch_cnt);
+    TEST_ASSERT_FALSE(rpmsg_dev->adaptive.polling);
+
+    /* back in interrupt mode, the re-armed doorbell is delivered again */
+    adaptive_test_request(&ctx, &ept, 1);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(ctx.done_sem, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(1, ctx.sched_cnt);
+
+    /* sustained flood switches back and forth, the sub-core races the doorbell re-arm, nothing may be stranded */
+    adaptive_test_request(&ctx, &ept, ADAPTIVE_TEST_FLOOD_NUM);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(ctx.done_sem, pdMS_TO_TICKS(5000)));
+    vTaskDelay(pdMS_TO_TICKS(10));
+    TEST_ASSERT_EQUAL(ctx.sched_cnt, ctx.rearm_cnt);
+    TEST_ASSERT_FALSE(rpmsg_dev->adaptive.polling);
+    TEST_ASSERT_EQUAL(0, ctx.out_of_order);
+
+    adaptive_test_request(&ctx, &ept, 1);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(ctx.done_sem, pdMS_TO_TICKS(1000)));
+
+    vTaskDelete(poller);
+    vSemaphoreDelete(ctx.sched_sem);
+    vSemaphoreDelete(ctx.done_sem);
+    free(rpmsg_dev);
+}
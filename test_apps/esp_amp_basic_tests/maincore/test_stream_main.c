@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_amp.h"
+#include "esp_err.h"
+
+#include "unity.h"
+#include "unity_test_runner.h"
+
+/*
+ * Both ends of the stream run on main-core: a main-side and a sub-side rpmsg device in polling mode
+ * share one virtqueue pair, so every frame on the wire can be observed step by step.
+ */
+
+#define STREAM_TEST_SYSINFO_ID      (0x0100)
+#define STREAM_TEST_QUEUE_LEN       (8)
+#define STREAM_TEST_ITEM_SIZE       (64)
+#define STREAM_TEST_WRITER_ADDR     (0x0010)
+#define STREAM_TEST_READER_ADDR     (0x0011)
+#define STREAM_TEST_FRAME_HEAD_LEN  (4)     /* type, reserved, seq */
+#define STREAM_TEST_WINDOW          CONFIG_ESP_AMP_STREAM_WINDOW_SIZE
+
+typedef struct stream_test_events_t {
+    int readable;
+    int writable;
+    int closed;
+} stream_test_events_t;
+
+static int stream_test_notify_cb(esp_amp_stream_t* stream, uint32_t events, void* notify_arg)
+{
+    stream_test_events_t* cnt = (stream_test_events_t*)notify_arg;
+    cnt->readable += (events & ESP_AMP_STREAM_EVENT_READABLE) ? 1 : 0;
+    cnt->writable += (events & ESP_AMP_STREAM_EVENT_WRITABLE) ? 1 : 0;
+    cnt->closed += (events & ESP_AMP_STREAM_EVENT_CLOSED) ? 1 : 0;
+    return 0;
+}
+
+static void stream_test_poll(esp_amp_rpmsg_dev_t* rpmsg_dev)
+{
+    while (esp_amp_rpmsg_poll(rpmsg_dev) == 0) {
+    }
+}
+
+static uint8_t stream_test_byte(uint32_t pos)
+{
+    return (uint8_t)(pos * 7 + 3);
+}
+
+static int stream_test_write(esp_amp_stream_t* stream, uint32_t* pos, size_t len, size_t chunk)
+{
+    uint8_t buf[256];
+    int total = 0;
+
+    while (len > 0) {
+        size_t n = len < chunk ? len : chunk;
+        for (size_t i = 0; i < n; i++) {
+            buf[i] = stream_test_byte(*pos + i);
+        }
+        int ret = esp_amp_stream_write(stream, buf, n);
+        if (ret < 0) {
+            return ret;
+        }
+        *pos += ret;
+        total += ret;
+        len -= ret;
+        if ((size_t)ret < n) {
+            break;
+        }
+    }
+    return total;
+}
+
+/* read `len` bytes in chunks of `chunk` bytes, check byte order across frame boundaries */
+static void stream_test_read(esp_amp_stream_t* stream, uint32_t* pos, size_t len, size_t chunk)
+{
+    uint8_t buf[256];
+
+    while (len > 0) {
+        size_t n = len < chunk ? len : chunk;
+        int ret = esp_amp_stream_read(stream, buf, n);
+        TEST_ASSERT_GREATER_THAN(0, ret);
+        for (int i = 0; i < ret; i++) {
+            TEST_ASSERT_EQUAL_HEX8(stream_test_byte(*pos + i), buf[i]);
+        }
+        *pos += ret;
+        len -= ret;
+    }
+}
+
+TEST_CASE("stream windowed pipelining, coalescing, partial read and close", "[esp_amp]")
+{
+    TEST_ASSERT_EQUAL_INT(0, esp_amp_init());
+
+    static esp_amp_rpmsg_dev_t main_dev;
+    static esp_amp_rpmsg_dev_t sub_dev;
+    static esp_amp_queue_t main_vqueue[2];
+    static esp_amp_queue_t sub_vqueue[2];
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_main_init_by_id(&main_dev, main_vqueue, STREAM_TEST_QUEUE_LEN, STREAM_TEST_ITEM_SIZE, false, true, STREAM_TEST_SYSINFO_ID));
+    TEST_ASSERT_EQUAL(0, esp_amp_rpmsg_sub_init_by_id(&sub_dev, sub_vqueue, false, true, STREAM_TEST_SYSINFO_ID));
+
+    static esp_amp_stream_t writer;
+    static esp_amp_stream_t reader;
+    stream_test_events_t writer_events = { 0 };
+    stream_test_events_t reader_events = { 0 };
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_open(&writer, &main_dev, STREAM_TEST_WRITER_ADDR, STREAM_TEST_READER_ADDR, stream_test_notify_cb, &writer_events));
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_open(&reader, &sub_dev, STREAM_TEST_READER_ADDR, STREAM_TEST_WRITER_ADDR, stream_test_notify_cb, &reader_events));
+    static esp_amp_stream_t dup;
+    TEST_ASSERT_EQUAL(-1, esp_amp_stream_open(&dup, &sub_dev, STREAM_TEST_READER_ADDR, STREAM_TEST_WRITER_ADDR, NULL, NULL));
+
+    const size_t frame_cap = esp_amp_rpmsg_get_lane_max_size(&main_dev, 0) - STREAM_TEST_FRAME_HEAD_LEN;
+    uint32_t tx_pos = 0;
+    uint32_t rx_pos = 0;
+    uint8_t byte;
+
+    /* small writes are coalesced and held back until flush */
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(1, stream_test_write(&writer, &tx_pos, 1, 1));
+    }
+    stream_test_poll(&sub_dev);
+    TEST_ASSERT_EQUAL(0, reader_events.readable);
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_read(&reader, &byte, 1));
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_flush(&writer));
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_flush(&writer));
+    stream_test_poll(&sub_dev);
+    TEST_ASSERT_EQUAL(1, reader_events.readable);
+    TEST_ASSERT_EQUAL(10, reader.rx_frame_len[0]);
+    stream_test_read(&reader, &rx_pos, 10, 64);
+    stream_test_poll(&main_dev);
+    TEST_ASSERT_EQUAL(1, writer.tx_acked);
+
+    /* odd-sized writes are packed into max-size frames, a full frame is sent without waiting for flush */
+    TEST_ASSERT_EQUAL(2 * frame_cap + 5, stream_test_write(&writer, &tx_pos, 2 * frame_cap + 5, 7));
+    stream_test_poll(&sub_dev);
+    TEST_ASSERT_EQUAL(3, reader_events.readable);
+    TEST_ASSERT_EQUAL(frame_cap, reader.rx_frame_len[1 % STREAM_TEST_WINDOW]);
+    TEST_ASSERT_EQUAL(frame_cap, reader.rx_frame_len[2 % STREAM_TEST_WINDOW]);
+    TEST_ASSERT_EQUAL(5, writer.tx_len);
+    stream_test_read(&reader, &rx_pos, 2 * frame_cap, 64);
+    stream_test_poll(&main_dev);
+    TEST_ASSERT_EQUAL(3, writer.tx_acked);
+
+    /* without any ACK the writer keeps a whole window of frames in flight, plus one full frame held locally */
+    int accepted = stream_test_write(&writer, &tx_pos, (STREAM_TEST_WINDOW + 2) * frame_cap, 64);
+    TEST_ASSERT_EQUAL((STREAM_TEST_WINDOW + 1) * frame_cap - 5, accepted);
+    TEST_ASSERT_EQUAL(STREAM_TEST_WINDOW, (uint16_t)(writer.tx_seq - writer.tx_acked));
+    TEST_ASSERT_EQUAL(0, stream_test_write(&writer, &tx_pos, 1, 1));
+    TEST_ASSERT_EQUAL(-1, esp_amp_stream_flush(&writer));
+    stream_test_poll(&sub_dev);
+    TEST_ASSERT_EQUAL(3 + STREAM_TEST_WINDOW, reader_events.readable);
+    TEST_ASSERT_EQUAL(STREAM_TEST_WINDOW, (uint16_t)(reader.rx_tail - reader.rx_head));
+
+    /* partial read keeps the frame, nothing is acknowledged */
+    stream_test_read(&reader, &rx_pos, 1, 1);
+    TEST_ASSERT_EQUAL(STREAM_TEST_WINDOW, (uint16_t)(reader.rx_tail - reader.rx_head));
+    stream_test_poll(&main_dev);
+    int writable = writer_events.writable;
+    TEST_ASSERT_EQUAL(STREAM_TEST_WINDOW, (uint16_t)(writer.tx_seq - writer.tx_acked));
+
+    /* reads crossing frame boundaries, ACKs are batched and reopen the window */
+    stream_test_read(&reader, &rx_pos, 2 * frame_cap - 1, 5);
+    TEST_ASSERT_EQUAL(STREAM_TEST_WINDOW - 2, (uint16_t)(reader.rx_tail - reader.rx_head));
+    stream_test_poll(&main_dev);
+    TEST_ASSERT_EQUAL(writable + 1, writer_events.writable);
+    TEST_ASSERT_EQUAL(STREAM_TEST_WINDOW - 2, (uint16_t)(writer.tx_seq - writer.tx_acked));
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_flush(&writer));
+    TEST_ASSERT_EQUAL(frame_cap, stream_test_write(&writer, &tx_pos, frame_cap, 64));
+    TEST_ASSERT_EQUAL(STREAM_TEST_WINDOW, (uint16_t)(writer.tx_seq - writer.tx_acked));
+    stream_test_poll(&sub_dev);
+    stream_test_read(&reader, &rx_pos, tx_pos - rx_pos - writer.tx_len, 13);
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_read(&reader, &byte, 1));
+    stream_test_poll(&main_dev);
+    TEST_ASSERT_EQUAL(writer.tx_seq, writer.tx_acked);
+
+    /* close flushes pending data, reader gets the tail, then end of stream */
+    TEST_ASSERT_EQUAL(3, stream_test_write(&writer, &tx_pos, 3, 1));
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_close(&writer));
+    TEST_ASSERT_EQUAL(-1, esp_amp_stream_write(&writer, &byte, 1));
+    stream_test_poll(&sub_dev);
+    TEST_ASSERT_EQUAL(1, reader_events.closed);
+    TEST_ASSERT_EQUAL(ESP_AMP_STREAM_STATE_PEER_CLOSED, reader.state);
+    stream_test_read(&reader, &rx_pos, tx_pos - rx_pos, 64);
+    TEST_ASSERT_EQUAL(-1, esp_amp_stream_read(&reader, &byte, 1));
+    TEST_ASSERT_EQUAL(0, esp_amp_stream_close(&reader));
+    TEST_ASSERT_NULL(esp_amp_rpmsg_search_endpoint(&main_dev, STREAM_TEST_WRITER_ADDR));
+    TEST_ASSERT_NULL(esp_amp_rpmsg_search_endpoint(&sub_dev, STREAM_TEST_READER_ADDR));
+}
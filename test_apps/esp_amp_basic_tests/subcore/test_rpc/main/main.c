@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_amp.h"
+#include "esp_amp_platform.h"
+#include "esp_bit_defs.h"
+
+#if !CONFIG_ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN
+#error "bare-metal rpc server test needs CONFIG_ESP_AMP_RPC_SERVER_RUN_QUEUE_LEN"
+#endif
+
+/* keep in sync with maincore/test_rpc_main.c */
+#define RPC_MAIN_CORE_CLIENT    0x0000
+#define RPC_SUB_CORE_SERVER     0x1001
+#define EVENT_SUBCORE_READY     BIT0
+
+#define RPC_SUB_SRV_HOLD        0x20    /* uint32_t ms: main loop stops executing queued requests for that long */
+#define RPC_SUB_SRV_LOG         0x21    /* uint8_t tag: appended to execution log */
+#define RPC_SUB_SRV_REPORT      0x22    /* response: rpc_sub_report_t, then log is cleared */
+#define RPC_SUB_BUDGET          2       /* requests executed per round of main loop */
+#define RPC_SUB_LOG_LEN         32
+
+typedef struct {
+    uint8_t log_num;
+    uint8_t max_round; /* most requests executed in one round */
+    uint8_t budget_hit; /* rounds leaving requests in run queue */
+    uint8_t reserved;
+    uint8_t log[RPC_SUB_LOG_LEN]; /* tags in execution order */
+} rpc_sub_report_t;
+
+static esp_amp_rpmsg_dev_t rpmsg_dev;
+static uint32_t hold_until;
+static int round_exec;
+static rpc_sub_report_t report;
+
+static esp_amp_rpc_status_t rpc_sub_hold(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    uint32_t ms;
+    if (params_in_len != sizeof(ms)) {
+        return ESP_AMP_RPC_STATUS_BAD_PACKET;
+    }
+    memcpy(&ms, params_in, sizeof(ms));
+    hold_until = esp_amp_platform_get_time_ms() + ms;
+    if (params_out != NULL) {
+        *params_out_len = 0;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static esp_amp_rpc_status_t rpc_sub_log(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    if (params_in_len != 1) {
+        return ESP_AMP_RPC_STATUS_BAD_PACKET;
+    }
+    if (report.log_num < RPC_SUB_LOG_LEN) {
+        report.log[report.log_num++] = *(uint8_t *)params_in;
+    }
+    round_exec++;
+    if (params_out != NULL) {
+        *params_out_len = 0;
+    }
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+static esp_amp_rpc_status_t rpc_sub_report(void *params_in, uint16_t params_in_len, void *params_out, uint16_t *params_out_len)
+{
+    if (params_out == NULL || *params_out_len < sizeof(report)) {
+        return ESP_AMP_RPC_STATUS_BAD_PACKET;
+    }
+    memcpy(params_out, &report, sizeof(report));
+    *params_out_len = sizeof(report);
+    memset(&report, 0, sizeof(report));
+    return ESP_AMP_RPC_STATUS_OK;
+}
+
+int main(void)
+{
+    printf("Hello from the Sub-core!!\r\n");
+
+    assert(esp_amp_init() == 0);
+    assert(esp_amp_rpmsg_sub_init(&rpmsg_dev, true, true) == 0);
+    assert(esp_amp_rpc_server_init(&rpmsg_dev, RPC_MAIN_CORE_CLIENT, RPC_SUB_CORE_SERVER) == 0);
+    assert(esp_amp_rpc_server_add_service(RPC_SUB_SRV_HOLD, rpc_sub_hold) == 0);
+    assert(esp_amp_rpc_server_add_service(RPC_SUB_SRV_LOG, rpc_sub_log) == 0);
+    assert(esp_amp_rpc_server_add_service(RPC_SUB_SRV_REPORT, rpc_sub_report) == 0);
+
+    esp_amp_event_notify(EVENT_SUBCORE_READY);
+
+    while (true) {
+        /* requests are only queued here, and stay queued while held */
+        while (esp_amp_rpmsg_poll(&rpmsg_dev) == 0);
+
+        if ((int32_t)(esp_amp_platform_get_time_ms() - hold_until) >= 0) {
+            round_exec = 0;
+            if (esp_amp_rpc_server_process(RPC_SUB_BUDGET) > 0) {
+                report.budget_hit++;
+            }
+            if (round_exec > report.max_round) {
+                report.max_round = round_exec;
+            }
+        }
+        esp_amp_platform_delay_us(100);
+    }
+
+    printf("Bye from the Sub core!!\r\n");
+    abort();
+}
@@ -10,7 +10,7 @@
 #include "esp_amp.h"
 
 esp_amp_rpmsg_dev_t rpmsg_dev;
-esp_amp_rpmsg_ept_t rpmsg_ept[3];
+esp_amp_rpmsg_ept_t rpmsg_ept[4];
 
 int ept0_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
 {
@@ -72,6 +72,24 @@ int ept2_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_da
 
 }
 
+int ept3_cb(void* msg_data, uint16_t data_len, uint16_t src_addr, void* rx_cb_data)
+{
+    uint32_t num = *(uint32_t*)msg_data;
+    esp_amp_rpmsg_destroy(&rpmsg_dev, msg_data);
+
+    // send a burst back-to-back, wait for free buffer if main-core falls behind
+    for (uint32_t seq = 0; seq < num; seq++) {
+        uint32_t* msg = NULL;
+        while (msg == NULL) {
+            msg = (uint32_t*)esp_amp_rpmsg_create_message(&rpmsg_dev, sizeof(uint32_t), ESP_AMP_RPMSG_DATA_DEFAULT);
+        }
+        *msg = seq;
+        assert(esp_amp_rpmsg_send_nocopy(&rpmsg_dev, &rpmsg_ept[3], src_addr, msg, sizeof(uint32_t)) == 0);
+    }
+
+    return 0;
+}
+
 void send_normal_msg(void)
 {
     static int count = 0;
@@ -97,6 +115,7 @@ int main(void)
     esp_amp_rpmsg_create_endpoint(&rpmsg_dev, 0, ept0_cb, NULL, &rpmsg_ept[0]);
     esp_amp_rpmsg_create_endpoint(&rpmsg_dev, 1, ept1_cb, NULL, &rpmsg_ept[1]);
     esp_amp_rpmsg_create_endpoint(&rpmsg_dev, 2, ept2_cb, NULL, &rpmsg_ept[2]);
+    esp_amp_rpmsg_create_endpoint(&rpmsg_dev, 3, ept3_cb, NULL, &rpmsg_ept[3]);
     printf("Sub started!\r\n");
     send_normal_msg();
     for (;;) {